@@ -0,0 +1,197 @@
+#include "libprogman/pch.h"
+#include "libprogman/AppSearchIndex.h"
+
+namespace libprogman {
+
+// Tiers keep every name prefix match ahead of every word prefix match, and those ahead of every subsequence match.
+constexpr int kNamePrefixScore = 2'000'000;
+constexpr int kWordPrefixScore = 1'000'000;
+
+static std::wstring normalize(const std::wstring& text, std::vector<bool>* isWordStart = nullptr) {
+    std::wstring normalized;
+    normalized.reserve(text.size());
+
+    wchar_t previous = L' ';
+    for (wchar_t ch : text) {
+        if (std::iswalnum(ch)) {
+            if (isWordStart) {
+                bool startsWord = !std::iswalnum(previous) || (std::iswupper(ch) && std::iswlower(previous)) ||
+                    (std::iswdigit(ch) != 0) != (std::iswdigit(previous) != 0);
+                isWordStart->push_back(startsWord);
+            }
+            normalized.push_back(static_cast<wchar_t>(std::towlower(ch)));
+        }
+        previous = ch;
+    }
+
+    return normalized;
+}
+
+AppSearchIndex::AppSearchIndex(const immer::vector<std::shared_ptr<Shortcut>>& apps) {
+    names_.reserve(apps.size());
+    trie_.emplace_back();
+
+    for (int app = 0; app < static_cast<int>(apps.size()); app++) {
+        Name name;
+        name.normalized = normalize(apps[app]->name(), &name.isWordStart);
+
+        for (size_t start = 0; start < name.normalized.size(); start++) {
+            if (!name.isWordStart[start]) {
+                continue;
+            }
+
+            // Add the word, and what follows it up to kMaxTrieDepth, so a query can run on into the next word.
+            int node = 0;
+            size_t end = std::min(name.normalized.size(), start + kMaxTrieDepth);
+            for (size_t i = start; i < end; i++) {
+                wchar_t ch = name.normalized[i];
+                auto& children = trie_[node].children;
+                auto child = std::find_if(
+                    children.begin(), children.end(), [ch](const std::pair<wchar_t, int>& c) { return c.first == ch; });
+                if (child != children.end()) {
+                    node = child->second;
+                } else {
+                    int newNode = static_cast<int>(trie_.size());
+                    children.emplace_back(ch, newNode);
+                    trie_.emplace_back();
+                    node = newNode;
+                }
+
+                // Apps are added in ascending order, so a second word of this app with the same prefix is at the back.
+                auto& nodeApps = trie_[node].apps;
+                if (nodeApps.empty() || nodeApps.back() != app) {
+                    nodeApps.push_back(app);
+                }
+            }
+        }
+
+        names_.push_back(std::move(name));
+    }
+}
+
+std::vector<int> AppSearchIndex::search(const std::wstring& query) {
+    std::wstring normalizedQuery = normalize(query);
+    if (normalizedQuery.empty()) {
+        lastQuery_.clear();
+        lastMatches_.clear();
+
+        std::vector<int> all(names_.size());
+        for (int app = 0; app < static_cast<int>(all.size()); app++) {
+            all[app] = app;
+        }
+        return all;
+    }
+
+    // Adding characters to a query only ever takes matches away, so only the last query's matches need checking.
+    bool narrowing = !lastQuery_.empty() && normalizedQuery.compare(0, lastQuery_.size(), lastQuery_) == 0;
+    std::vector<int> candidates;
+    if (narrowing) {
+        candidates = std::move(lastMatches_);
+    } else {
+        candidates.resize(names_.size());
+        for (int app = 0; app < static_cast<int>(candidates.size()); app++) {
+            candidates[app] = app;
+        }
+    }
+
+    // The trie finds the apps with a word starting with the query, or the first kMaxTrieDepth characters of it.
+    std::vector<bool> isWordPrefixMatch(names_.size());
+    int node = findTrieNode(normalizedQuery);
+    if (node != -1) {
+        for (int app : trie_[node].apps) {
+            isWordPrefixMatch[app] =
+                normalizedQuery.size() <= kMaxTrieDepth || hasWordStartingWith(app, normalizedQuery);
+        }
+    }
+
+    std::vector<std::pair<int, int>> matches;  // Score and app.
+    lastMatches_.clear();
+    for (int app : candidates) {
+        const auto& name = names_[app].normalized;
+        int score;
+        if (name.compare(0, normalizedQuery.size(), normalizedQuery) == 0) {
+            score = kNamePrefixScore;
+        } else if (isWordPrefixMatch[app]) {
+            score = kWordPrefixScore;
+        } else {
+            score = subsequenceScore(app, normalizedQuery);
+            if (score < 0) {
+                continue;
+            }
+        }
+
+        // Within a tier, shorter names are closer matches.
+        score -= static_cast<int>(std::min<size_t>(name.size(), 1000));
+        matches.emplace_back(score, app);
+        lastMatches_.push_back(app);
+    }
+    lastQuery_ = std::move(normalizedQuery);
+
+    // candidates were in ascending order, so a stable sort keeps equal matches in their original order.
+    std::stable_sort(matches.begin(), matches.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        return a.first > b.first;
+    });
+
+    std::vector<int> results;
+    results.reserve(matches.size());
+    for (const auto& [score, app] : matches) {
+        results.push_back(app);
+    }
+    return results;
+}
+
+int AppSearchIndex::findTrieNode(const std::wstring& prefix) const {
+    int node = 0;
+    size_t depth = std::min(prefix.size(), kMaxTrieDepth);
+    for (size_t i = 0; i < depth; i++) {
+        const auto& children = trie_[node].children;
+        auto child = std::find_if(children.begin(), children.end(), [ch = prefix[i]](const std::pair<wchar_t, int>& c) {
+            return c.first == ch;
+        });
+        if (child == children.end()) {
+            return -1;
+        }
+        node = child->second;
+    }
+    return node;
+}
+
+bool AppSearchIndex::hasWordStartingWith(int app, const std::wstring& query) const {
+    const auto& name = names_[app];
+    for (size_t start = 0; start + query.size() <= name.normalized.size(); start++) {
+        if (name.isWordStart[start] && name.normalized.compare(start, query.size(), query) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int AppSearchIndex::subsequenceScore(int app, const std::wstring& query) const {
+    const auto& name = names_[app];
+
+    // Match each query character to its first occurrence after the previous one.
+    int score = 0;
+    size_t position = 0;
+    size_t previousMatch = std::wstring::npos;
+    for (wchar_t ch : query) {
+        size_t match = name.normalized.find(ch, position);
+        if (match == std::wstring::npos) {
+            return -1;
+        }
+
+        if (name.isWordStart[match]) {
+            score += 100;
+        } else if (previousMatch != std::wstring::npos && match == previousMatch + 1) {
+            score += 50;
+        } else {
+            score -= static_cast<int>(std::min<size_t>(match - position, 50));
+        }
+
+        previousMatch = match;
+        position = match + 1;
+    }
+
+    return std::max(score + 10'000, 0);
+}
+
+}  // namespace libprogman
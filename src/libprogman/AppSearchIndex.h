@@ -0,0 +1,51 @@
+#pragma once
+
+#include "libprogman/pch.h"
+#include "libprogman/Shortcut.h"
+
+namespace libprogman {
+
+// Finds installed apps by name as the user types. Names are normalized once up front: lowercased, with anything that
+// isn't a letter or digit dropped. Each word of each name goes into a prefix trie; a word starts after a space or
+// punctuation, at a capital letter following a lowercase one, and where letters and digits meet.
+// Apps whose name starts with the query rank first, then apps with a word that starts with it, then apps whose name
+// contains the query's characters in order, scored by how many of them start words or follow each other.
+// Remembers the last query, so a query that extends it only rechecks the apps the last one matched.
+// Not thread-safe.
+class AppSearchIndex {
+   public:
+    explicit AppSearchIndex(const immer::vector<std::shared_ptr<Shortcut>>& apps);
+
+    // Returns the indices of the apps matching query, best match first; equally good matches keep their original
+    // order. A query with no letters or digits matches every app.
+    std::vector<int> search(const std::wstring& query);
+
+   private:
+    struct Name {
+        std::wstring normalized;
+        std::vector<bool> isWordStart;  // One flag per character of normalized.
+    };
+
+    struct TrieNode {
+        std::vector<std::pair<wchar_t, int>> children;  // Character and index into trie_.
+        std::vector<int> apps;                          // Apps with a word starting with this node's prefix, ascending.
+    };
+
+    // Returns the trie node for prefix, or -1 if no word starts with it. Walks no deeper than kMaxTrieDepth.
+    int findTrieNode(const std::wstring& prefix) const;
+
+    bool hasWordStartingWith(int app, const std::wstring& query) const;
+
+    // Scores a match of query's characters in order anywhere in the app's name, or returns -1 if there's none.
+    int subsequenceScore(int app, const std::wstring& query) const;
+
+    // Words longer than this are only in the trie up to this length; longer queries are checked against the names.
+    static constexpr size_t kMaxTrieDepth = 8;
+
+    std::vector<Name> names_;
+    std::vector<TrieNode> trie_;    // trie_[0] is the root.
+    std::wstring lastQuery_;        // Normalized.
+    std::vector<int> lastMatches_;  // The apps lastQuery_ matched, ascending.
+};
+
+}  // namespace libprogman
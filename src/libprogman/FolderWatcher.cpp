@@ -3,19 +3,67 @@
 
 namespace libprogman {
 
+// How long to wait for more changes before the burst in progress is due. Rounded up, so the wait never ends early.
+static int64_t millisecondsUntil(std::chrono::steady_clock::time_point deadline) {
+    auto remaining = deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero()) {
+        return 0;
+    }
+    return std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+}
+
+static FolderChange::Kind changeKind(DWORD action) {
+    switch (action) {
+        case FILE_ACTION_ADDED:
+            return FolderChange::Kind::kAdded;
+        case FILE_ACTION_REMOVED:
+            return FolderChange::Kind::kRemoved;
+        case FILE_ACTION_RENAMED_OLD_NAME:
+            return FolderChange::Kind::kRenamedFrom;
+        case FILE_ACTION_RENAMED_NEW_NAME:
+            return FolderChange::Kind::kRenamedTo;
+        default:
+            return FolderChange::Kind::kModified;
+    }
+}
+
+// Turns the FILE_NOTIFY_INFORMATION records that ReadDirectoryChangesW filled the buffer with into changes.
+static std::vector<FolderChange> parseChanges(
+    const std::filesystem::path& folderPath,
+    const std::vector<BYTE>& buffer,
+    DWORD bytesTransferred) {
+    std::vector<FolderChange> changes;
+
+    DWORD offset = 0;
+    while (offset + offsetof(FILE_NOTIFY_INFORMATION, FileName) <= bytesTransferred) {
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer.data() + offset);
+        std::wstring relativePath(info->FileName, info->FileNameLength / sizeof(WCHAR));
+        changes.push_back({ changeKind(info->Action), folderPath / relativePath });
+
+        if (info->NextEntryOffset == 0) {
+            break;
+        }
+        offset += info->NextEntryOffset;
+    }
+
+    return changes;
+}
+
 FolderWatcher::FolderWatcher(
     std::filesystem::path folderPath,
-    std::function<void()> onChange,
-    std::function<void(std::wstring)> onError)
+    std::function<void(const std::vector<FolderChange>&)> onChange,
+    std::function<void(std::wstring)> onError,
+    FolderWatcherOptions options)
     : folderPath_(std::move(folderPath)),
       onChange_(std::move(onChange)),
       onError_(std::move(onError)),
-      running_(true),
+      options_(options),
+      stopEvent_(wil::EventOptions::ManualReset),
       watchThread_([this]() { this->WatchThreadProc(); }) {}
 
 FolderWatcher::~FolderWatcher() noexcept {
     // Signal thread to exit
-    running_ = false;
+    stopEvent_.SetEvent();
 
     // Join the thread if it's joinable
     if (watchThread_.joinable()) {
@@ -23,6 +71,49 @@ FolderWatcher::~FolderWatcher() noexcept {
     }
 }
 
+void FolderWatcher::addPendingChanges(std::vector<FolderChange> changes) {
+    if (pendingChanges_.empty()) {
+        pendingDeadline_ = std::chrono::steady_clock::now() + options_.coalesceWindow;
+    }
+
+    for (auto& change : changes) {
+        if (!pendingChanges_.empty() && pendingChanges_.front().kind == FolderChange::Kind::kOverflow) {
+            // Everything is being reported as changed already.
+            break;
+        }
+
+        if (change.kind == FolderChange::Kind::kOverflow) {
+            pendingChanges_.assign(1, std::move(change));
+            pendingTouchedPaths_.clear();
+            break;
+        }
+
+        // A file written in several chunks is reported modified once per chunk. Once is enough.
+        if (change.kind == FolderChange::Kind::kAdded || change.kind == FolderChange::Kind::kModified) {
+            bool alreadyPending = !pendingTouchedPaths_.insert(change.path).second;
+            if (alreadyPending && change.kind == FolderChange::Kind::kModified) {
+                continue;
+            }
+        }
+
+        pendingChanges_.push_back(std::move(change));
+    }
+}
+
+void FolderWatcher::reportPendingChanges() {
+    if (pendingChanges_.empty()) {
+        return;
+    }
+
+    auto changes = std::move(pendingChanges_);
+    pendingChanges_.clear();
+    pendingTouchedPaths_.clear();
+
+    if (onChange_) {
+        onChange_(changes);
+    }
+}
+
 void FolderWatcher::WatchThreadProc() {
     // Open the directory for monitoring with overlapped I/O
     wil::unique_handle dirHandle(CreateFileW(
@@ -47,23 +138,25 @@ void FolderWatcher::WatchThreadProc() {
     }
 
     // Buffer for file change information
-    constexpr DWORD bufferSize = 4096;
-    std::vector<BYTE> buffer(bufferSize);
+    std::vector<BYTE> buffer(options_.bufferSize);
 
     // Overlapped structure for I/O
     OVERLAPPED overlapped = {};
     overlapped.hEvent = ioEvent.get();
 
+    auto startRead = [&]() {
+        return ReadDirectoryChangesW(
+                   dirHandle.get(), buffer.data(), static_cast<DWORD>(buffer.size()),
+                   TRUE,  // Include subdirectories
+                   FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES |
+                       FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                   nullptr,  // bytesReturned not used for async
+                   &overlapped, nullptr) ||
+            GetLastError() == ERROR_IO_PENDING;
+    };
+
     // Start the initial async operation
-    BOOL readResult = ReadDirectoryChangesW(
-        dirHandle.get(), buffer.data(), static_cast<DWORD>(buffer.size()),
-        TRUE,  // Include subdirectories
-        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES |
-            FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
-        nullptr,  // bytesReturned not used for async
-        &overlapped, nullptr);
-
-    if (!readResult && GetLastError() != ERROR_IO_PENDING) {
+    if (!startRead()) {
         // Failed to start monitoring
         DWORD error = GetLastError();
         std::wstring errorMsg = L"Failed to start directory monitoring. Error code: " + std::to_wstring(error);
@@ -71,41 +164,41 @@ void FolderWatcher::WatchThreadProc() {
         return;
     }
 
-    while (running_) {
-        // Wait for either the I/O to complete or a short timeout to check running_ flag
-        DWORD waitResult = WaitForSingleObject(ioEvent.get(), 100);
+    HANDLE handles[] = { stopEvent_.get(), ioEvent.get() };
+    while (true) {
+        // Sleep until we're stopped, the read completes, or the burst in progress is due
+        DWORD timeout = pendingChanges_.empty() ? INFINITE : static_cast<DWORD>(millisecondsUntil(pendingDeadline_));
+        DWORD waitResult = WaitForMultipleObjects(ARRAYSIZE(handles), handles, FALSE, timeout);
 
-        if (!running_) {
-            // Cleanup: cancel any pending operations
+        if (waitResult == WAIT_OBJECT_0) {
+            // Cancel the read and wait for it to let go of the buffer
+            DWORD bytesTransferred = 0;
             CancelIoEx(dirHandle.get(), &overlapped);
+            GetOverlappedResult(dirHandle.get(), &overlapped, &bytesTransferred, TRUE);
             break;
         }
 
-        if (waitResult == WAIT_OBJECT_0) {
+        if (waitResult == WAIT_TIMEOUT) {
+            reportPendingChanges();
+        } else if (waitResult == WAIT_OBJECT_0 + 1) {
             // Read completed, check results
             DWORD bytesTransferred = 0;
             BOOL result = GetOverlappedResult(dirHandle.get(), &overlapped, &bytesTransferred, FALSE);
 
-            if (result && bytesTransferred > 0) {
-                // Changes detected, invoke callback
-                if (onChange_) {
-                    onChange_();
+            if (result) {
+                if (bytesTransferred > 0) {
+                    addPendingChanges(parseChanges(folderPath_, buffer, bytesTransferred));
+                } else {
+                    // The changes didn't fit in the buffer and were dropped
+                    addPendingChanges({ { FolderChange::Kind::kOverflow, {} } });
                 }
             }
 
             // Reset event for the next operation
             ResetEvent(ioEvent.get());
 
-            // Start the next async operation
-            readResult = ReadDirectoryChangesW(
-                dirHandle.get(), buffer.data(), static_cast<DWORD>(buffer.size()),
-                TRUE,  // Include subdirectories
-                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES |
-                    FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
-                nullptr,  // bytesReturned not used for async
-                &overlapped, nullptr);
-
-            if (!readResult && GetLastError() != ERROR_IO_PENDING) {
+            // Start the next async operation right away, so changes made while the callback runs are buffered
+            if (!startRead()) {
                 // Failed to restart monitoring
                 DWORD error = GetLastError();
                 std::wstring errorMsg =
@@ -113,7 +206,7 @@ void FolderWatcher::WatchThreadProc() {
                 onError_(errorMsg);
                 break;
             }
-        } else if (waitResult == WAIT_FAILED) {
+        } else {
             // Wait operation failed
             DWORD error = GetLastError();
             std::wstring errorMsg =
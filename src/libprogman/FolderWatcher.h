@@ -4,24 +4,60 @@
 
 namespace libprogman {
 
+// One change that FolderWatcher saw in its folder or a subfolder.
+struct FolderChange {
+    enum class Kind {
+        kAdded,
+        kRemoved,
+        kModified,
+        kRenamedFrom,  // The old name of a renamed file or folder. The new name follows as kRenamedTo.
+        kRenamedTo,
+        kOverflow,     // Too much changed at once to report it all. Anything under the folder may have changed.
+    };
+
+    Kind kind;
+    std::filesystem::path path;  // The full path of the file or folder. Empty for kOverflow.
+};
+
+struct FolderWatcherOptions {
+    // Bytes of change records the OS can hold for us between reads. When more than this piles up, the changes are
+    // lost and reported as one kOverflow. ReadDirectoryChangesW refuses more than 64 KB for network folders.
+    size_t bufferSize = 64 * 1024;
+
+    // How long to keep collecting changes after the first one of a burst before reporting them all in one callback.
+    // Copying or deleting many shortcuts at once then causes one refresh rather than one per file.
+    std::chrono::milliseconds coalesceWindow{ 100 };
+};
+
 // Monitors a folder for file and subfolder changes (new, modified, deleted).
-// Calls a simple callback when any change is detected.
+// Calls the callback with the changes each time some are detected.
 // Stops monitoring when the object is destroyed.
 class FolderWatcher {
    public:
     FolderWatcher(
         std::filesystem::path folderPath,
-        std::function<void()> onChange,
-        std::function<void(std::wstring)> onError = [](std::wstring) {});
+        std::function<void(const std::vector<FolderChange>&)> onChange,
+        std::function<void(std::wstring)> onError = [](std::wstring) {},
+        FolderWatcherOptions options = {});
     ~FolderWatcher() noexcept;
 
    private:
     void WatchThreadProc();
 
+    // Adds changes to the burst waiting to be reported.
+    void addPendingChanges(std::vector<FolderChange> changes);
+
+    // Calls onChange_ with the burst, if there is one, and starts a new one.
+    void reportPendingChanges();
+
     std::filesystem::path folderPath_;
-    std::function<void()> onChange_;
+    std::function<void(const std::vector<FolderChange>&)> onChange_;
     std::function<void(std::wstring)> onError_;
-    std::atomic<bool> running_;
+    FolderWatcherOptions options_;
+    std::vector<FolderChange> pendingChanges_;               // Only touched by the watch thread.
+    std::set<std::filesystem::path> pendingTouchedPaths_;    // Paths in pendingChanges_ as kAdded or kModified.
+    std::chrono::steady_clock::time_point pendingDeadline_;  // When to report pendingChanges_.
+    wil::unique_event stopEvent_;
     std::thread watchThread_;
 };
 
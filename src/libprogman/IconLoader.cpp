@@ -0,0 +1,105 @@
+#include "libprogman/pch.h"
+#include "libprogman/IconLoader.h"
+
+namespace libprogman {
+
+IconLoader::IconLoader(ShortcutFactory* shortcutFactory, size_t threadCount)
+    : IconLoader([shortcutFactory](Shortcut* shortcut) { shortcutFactory->loadDeferred(shortcut); }, threadCount) {}
+
+IconLoader::IconLoader(LoadFunction load, size_t threadCount)
+    : load_(std::move(load)), queue_(), stopping_(false), threads_() {
+    for (size_t i = 0; i < std::max<size_t>(threadCount, 1); i++) {
+        threads_.emplace_back([this]() {
+            try {
+                auto com = wil::CoInitializeEx(COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+                work();
+            } catch (...) {
+                // COM couldn't start on this thread. The other threads take the queue.
+            }
+        });
+    }
+}
+
+IconLoader::~IconLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    wakeUp_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void IconLoader::load(const std::vector<std::shared_ptr<Shortcut>>& shortcuts, std::function<void()> onLoaded) {
+    auto sharedOnLoaded = std::make_shared<std::function<void()>>(std::move(onLoaded));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& shortcut : shortcuts) {
+            if (!shortcut->isLoaded()) {
+                queue_.push_back({ shortcut, sharedOnLoaded });
+            }
+        }
+    }
+    wakeUp_.notify_all();
+}
+
+void IconLoader::prioritize(const std::vector<const Shortcut*>& shortcuts) {
+    std::unordered_map<const Shortcut*, size_t> ranks;
+    for (size_t i = 0; i < shortcuts.size(); i++) {
+        ranks.emplace(shortcuts[i], i);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Pull the requests for these shortcuts out of the queue, then put them back at the front in the order given.
+    std::vector<Request> prioritized;
+    for (auto it = queue_.begin(); it != queue_.end();) {
+        if (ranks.find(it->shortcut.get()) != ranks.end()) {
+            prioritized.push_back(std::move(*it));
+            it = queue_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::stable_sort(prioritized.begin(), prioritized.end(), [&ranks](const Request& a, const Request& b) {
+        return ranks[a.shortcut.get()] < ranks[b.shortcut.get()];
+    });
+    queue_.insert(
+        queue_.begin(), std::make_move_iterator(prioritized.begin()), std::make_move_iterator(prioritized.end()));
+}
+
+void IconLoader::work() {
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeUp_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            request = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        // The same shortcut can be queued by more than one window; only the first request loads it.
+        if (!request.shortcut->isLoaded()) {
+            try {
+                load_(request.shortcut.get());
+            } catch (...) {
+                // Leave the placeholder icon. Don't try it again until the file changes and it's reopened.
+            }
+            if (!request.shortcut->isLoaded()) {
+                request.shortcut->finishLoading(wil::shared_hicon{}, std::wstring(), std::wstring());
+            }
+        }
+
+        (*request.onLoaded)();
+    }
+}
+
+}  // namespace libprogman
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "libprogman/pch.h"
+#include "libprogman/ShortcutFactory.h"
+#include "libprogman/Shortcut.h"
+
+namespace libprogman {
+
+// Finishes loading the shortcuts that ShortcutFactory::openDeferred() returned without an icon, on background
+// threads that each have their own COM apartment. Windows queue the shortcuts they show, show a placeholder icon
+// until each one is loaded, and move the ones scrolled into view to the front of the queue.
+class IconLoader {
+   public:
+    // Finishes loading one shortcut. Throwing leaves it loaded without an icon.
+    using LoadFunction = std::function<void(Shortcut* shortcut)>;
+
+    static constexpr size_t kDefaultThreadCount = 4;
+
+    IconLoader(ShortcutFactory* shortcutFactory, size_t threadCount = kDefaultThreadCount);
+    IconLoader(LoadFunction load, size_t threadCount);
+    IconLoader(const IconLoader&) = delete;
+    IconLoader& operator=(const IconLoader&) = delete;
+
+    // Lets the shortcut being loaded on each thread finish, drops the rest of the queue, and joins the threads.
+    ~IconLoader();
+
+    // Queues the shortcuts that aren't loaded yet, behind what is already queued. onLoaded is called on a worker
+    // thread after each of them is loaded, so the caller can post itself a message to swap the icon in.
+    void load(const std::vector<std::shared_ptr<Shortcut>>& shortcuts, std::function<void()> onLoaded);
+
+    // Moves the queued ones among these shortcuts to the front of the queue, in this order.
+    void prioritize(const std::vector<const Shortcut*>& shortcuts);
+
+   private:
+    struct Request {
+        std::shared_ptr<Shortcut> shortcut;
+        std::shared_ptr<std::function<void()>> onLoaded;  // Shared by the requests from one load() call.
+    };
+
+    void work();
+
+    LoadFunction load_;
+    std::mutex mutex_;                   // Protects queue_ and stopping_.
+    std::condition_variable wakeUp_;     // Signaled when a request is queued or the loader is stopping.
+    std::deque<Request> queue_;
+    bool stopping_;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace libprogman
@@ -0,0 +1,69 @@
+#include "libprogman/pch.h"
+#include "libprogman/IconStore.h"
+
+namespace libprogman {
+
+bool IconStore::Key::operator==(const Key& other) const noexcept {
+    return index == other.index && size == other.size && path == other.path;
+}
+
+size_t IconStore::KeyHash::operator()(const Key& key) const noexcept {
+    size_t hash = std::hash<std::wstring>()(key.path);
+    hash = hash * 31 + std::hash<int>()(key.index);
+    hash = hash * 31 + std::hash<int>()(key.size);
+    return hash;
+}
+
+wil::shared_hicon IconStore::get(const Key& key, const std::function<wil::unique_hicon()>& load) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = icons_.find(key);
+        if (it != icons_.end()) {
+            auto icon = it->second.lock();
+            if (icon) {
+                return icon;
+            }
+        }
+    }
+
+    wil::shared_hicon loaded{ load() };
+    if (!loaded) {
+        return loaded;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Another thread may have loaded the same icon meanwhile. Use theirs, so there is only ever one.
+    auto& entry = icons_[key];
+    auto icon = entry.lock();
+    if (icon) {
+        return icon;
+    }
+    entry = loaded;
+
+    // Sweep out icons nobody uses anymore once the map has doubled, so lookups stay cheap without a sweep per call.
+    if (icons_.size() >= pruneAt_) {
+        prune();
+        pruneAt_ = std::max<size_t>(icons_.size() * 2, 64);
+    }
+
+    return loaded;
+}
+
+size_t IconStore::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    prune();
+    return icons_.size();
+}
+
+void IconStore::prune() {
+    for (auto it = icons_.begin(); it != icons_.end();) {
+        if (it->second.expired()) {
+            it = icons_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+}  // namespace libprogman
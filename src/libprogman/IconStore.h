@@ -0,0 +1,43 @@
+#pragma once
+
+#include "libprogman/pch.h"
+
+namespace libprogman {
+
+// Hands out one HICON per icon source, shared by every shortcut whose icon comes from there. Many shortcuts point at
+// the same executable or icon resource; without this, each of them would extract its own copy.
+// The store only holds weak references. Each wil::shared_hicon it returns counts as one reference, and the icon is
+// destroyed when the last shortcut using it lets go. Thread-safe, since IconLoader threads call it at once.
+class IconStore {
+   public:
+    // Key index for the shell's icon for a file itself, as opposed to an icon resource at some index in the file.
+    static constexpr int kFileIconIndex = INT_MIN;
+
+    struct Key {
+        std::wstring path;  // The file the icon is extracted from.
+        int index = 0;      // The icon's index in that file, or kFileIconIndex.
+        int size = 0;       // The size it was rendered at.
+
+        bool operator==(const Key& other) const noexcept;
+    };
+
+    // Returns the icon for key if one is still in use; otherwise calls load and keeps what it returns for the next
+    // caller. load is called without the store locked, so it may be slow. A null icon from load is not kept.
+    wil::shared_hicon get(const Key& key, const std::function<wil::unique_hicon()>& load);
+
+    // The number of icons still in use.
+    size_t size();
+
+   private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    void prune();
+
+    std::mutex mutex_;                                         // Protects everything below.
+    std::unordered_map<Key, wil::weak_hicon, KeyHash> icons_;  // Expired entries linger until the next prune().
+    size_t pruneAt_ = 64;                                      // Map size that triggers the next prune().
+};
+
+}  // namespace libprogman
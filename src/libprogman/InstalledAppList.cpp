@@ -5,17 +5,27 @@
 namespace libprogman {
 
 InstalledAppList::InstalledAppList(ShortcutFactory* shortcutFactory, immer::vector<std::filesystem::path> foldersToScan)
-    : shortcutFactory_(shortcutFactory), foldersToScan_(std::move(foldersToScan)), apps_() {}
+    : InstalledAppList(
+          [shortcutFactory](
+              const std::filesystem::path& path, std::filesystem::file_time_type lastWriteTime, uintmax_t fileSize) {
+              // Only the cheap part; IconLoader reads the files when NewShortcutDialog shows them.
+              return shortcutFactory->openDeferred(path, lastWriteTime, fileSize);
+          },
+          std::move(foldersToScan)) {}
+
+InstalledAppList::InstalledAppList(LoadFunction load, immer::vector<std::filesystem::path> foldersToScan)
+    : load_(std::move(load)), foldersToScan_(std::move(foldersToScan)), cache_(), apps_() {}
 
 immer::vector<std::shared_ptr<Shortcut>> InstalledAppList::apps(libheirloom::CancellationToken cancel) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    // Keep track of file paths we've processed in this pass
-    std::set<std::filesystem::path> processedPaths;
+    // The .lnk files found in this pass, by path, and whether any of them had to be loaded
+    std::unordered_map<std::wstring, CacheEntry> found;
+    found.reserve(cache_.size());
+    bool loadedAny = false;
 
-    // First, create a new vector to hold our updated list
-    auto newApps = immer::vector<std::shared_ptr<Shortcut>>{};
-    auto newAppsTransient = newApps.transient();
+    // Folders that couldn't be scanned in full; what we had from them is kept
+    std::vector<std::wstring> failedFolders;
 
     // Scan folders for shortcuts
     for (const auto& folder : foldersToScan_) {
@@ -29,66 +39,63 @@ immer::vector<std::shared_ptr<Shortcut>> InstalledAppList::apps(libheirloom::Can
             }
 
             // Recursively scan for .lnk files
-            for (const auto& entry : std::filesystem::recursive_directory_iterator(folderPath)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(
+                     folderPath, std::filesystem::directory_options::skip_permission_denied)) {
                 if (!entry.is_regular_file() || entry.path().extension() != L".lnk") {
                     continue;
                 }
 
                 cancel.throwIfCancellationRequested();
 
+                // The directory entry already holds the last write time from the listing
                 const auto& filePath = entry.path();
-                const auto lastWriteTime = std::filesystem::last_write_time(filePath);
-
-                // Add the path to our processed set
-                processedPaths.insert(filePath);
-
-                // Check if we already have this shortcut and it's up to date
-                bool needsUpdate = true;
-                for (size_t i = 0; i < apps_.size(); ++i) {
-                    if (apps_[i]->path() == filePath) {
-                        if (apps_[i]->lastWriteTime() == lastWriteTime) {
-                            // The shortcut hasn't changed, add it to our new vector
-                            newAppsTransient.push_back(apps_[i]);
-                            needsUpdate = false;
-                        }
-                        break;
-                    }
+                const auto lastWriteTime = entry.last_write_time();
+
+                if (found.find(filePath.native()) != found.end()) {
+                    continue;
                 }
 
-                // If we need to update the shortcut, load it from disk
-                if (needsUpdate) {
-                    try {
-                        auto shortcut = shortcutFactory_->open(filePath, lastWriteTime);
-                        if (shortcut) {
-                            newAppsTransient.push_back(shortcut);
-                        }
-                    } catch (const std::exception&) {
-                        // Skip shortcuts that fail to load
-                    }
+                // Keep the shortcut we have if it's up to date
+                auto cached = cache_.find(filePath.native());
+                if (cached != cache_.end() && cached->second.lastWriteTime == lastWriteTime) {
+                    found.emplace(filePath.native(), cached->second);
+                    continue;
                 }
+
+                // Otherwise load it. Shortcuts that fail to load stay null and are skipped.
+                auto shortcut = load_(filePath, lastWriteTime, entry.file_size());
+                found.emplace(filePath.native(), CacheEntry{ lastWriteTime, std::move(shortcut) });
+                loadedAny = true;
             }
-        } catch (const std::exception&) {
-            // Skip folders that fail to scan
+        } catch (const std::system_error&) {
+            // Skip folders that fail to scan; cancellation still goes through
+            failedFolders.push_back(folder.native());
         }
     }
 
-    // Add existing shortcuts that weren't found in the scan
-    // (they might be from other directories we're not scanning now)
-    for (size_t i = 0; i < apps_.size(); ++i) {
-        cancel.throwIfCancellationRequested();
-
-        auto shortcut = apps_[i];
-        const auto& path = shortcut->path();
-
-        // Only keep shortcuts that weren't processed in this scan
-        if (processedPaths.find(path) == processedPaths.end()) {
-            newAppsTransient.push_back(shortcut);
+    for (const auto& failedFolder : failedFolders) {
+        for (const auto& [path, cacheEntry] : cache_) {
+            if (path.size() > failedFolder.size() && path.compare(0, failedFolder.size(), failedFolder) == 0 &&
+                (path[failedFolder.size()] == L'\\' || path[failedFolder.size()] == L'/')) {
+                found.emplace(path, cacheEntry);
+            }
         }
     }
 
+    // Every file found was cached and up to date, and none went away: the list is the same as last time
+    if (!loadedAny && found.size() == cache_.size()) {
+        return apps_;
+    }
+
     // Sort the apps alphabetically by name
     cancel.throwIfCancellationRequested();
-    std::vector<std::shared_ptr<Shortcut>> sortedAppsVector(newAppsTransient.begin(), newAppsTransient.end());
+    std::vector<std::shared_ptr<Shortcut>> sortedAppsVector;
+    sortedAppsVector.reserve(found.size());
+    for (const auto& [path, cacheEntry] : found) {
+        if (cacheEntry.shortcut) {
+            sortedAppsVector.push_back(cacheEntry.shortcut);
+        }
+    }
 
     std::sort(
         sortedAppsVector.begin(), sortedAppsVector.end(),
@@ -99,7 +106,9 @@ immer::vector<std::shared_ptr<Shortcut>> InstalledAppList::apps(libheirloom::Can
         sortedAppsTransient.push_back(app);
     }
 
-    return sortedAppsTransient.persistent();
+    cache_ = std::move(found);
+    apps_ = sortedAppsTransient.persistent();
+    return apps_;
 }
 
 }  // namespace libprogman
@@ -11,18 +11,33 @@ namespace libprogman {
 // Then the shortcuts are loaded with ShortcutFactory.
 class InstalledAppList {
    public:
+    // Opens the .lnk file at a path. Returns null to leave it out of the list; throwing fails the whole scan.
+    using LoadFunction = std::function<std::shared_ptr<Shortcut>(
+        const std::filesystem::path& path,
+        std::filesystem::file_time_type lastWriteTime,
+        uintmax_t fileSize)>;
+
     InstalledAppList(ShortcutFactory* shortcutFactory, immer::vector<std::filesystem::path> foldersToScan);
+    InstalledAppList(LoadFunction load, immer::vector<std::filesystem::path> foldersToScan);
 
-    // Updates apps_ to account for newly installed/updated applications and then returns the complete list.
-    // Last write time is used to decide whether a .lnk file we've loaded previously needs to be reloaded.
+    // Updates apps_ to account for newly installed/updated/removed applications and then returns the complete list.
+    // Last write time is used to decide whether a .lnk file we've loaded previously needs to be reloaded; unchanged
+    // files are looked up by path, and when nothing changed the previous list is returned as is. The files that need
+    // loading are opened with ShortcutFactory::openDeferred(), so their icons come later, from IconLoader.
     // Holds the mutex the whole time.
     immer::vector<std::shared_ptr<Shortcut>> apps(libheirloom::CancellationToken cancel);
 
    private:
-    ShortcutFactory* shortcutFactory_;
+    struct CacheEntry {
+        std::filesystem::file_time_type lastWriteTime;
+        std::shared_ptr<Shortcut> shortcut;  // Null if the file failed to load; tried again once it changes.
+    };
+
+    LoadFunction load_;
     immer::vector<std::filesystem::path> foldersToScan_;
-    std::mutex mutex_;  // Protects apps_ and the scanning process.
-    immer::vector<std::shared_ptr<Shortcut>> apps_;
+    std::mutex mutex_;                                    // Protects cache_, apps_ and the scanning process.
+    std::unordered_map<std::wstring, CacheEntry> cache_;  // Every .lnk file the last scan found, by path.
+    immer::vector<std::shared_ptr<Shortcut>> apps_;       // The shortcuts in cache_, sorted by name.
 };
 
 }  // namespace libprogman
@@ -0,0 +1,91 @@
+#include "libprogman/pch.h"
+#include "libprogman/InstalledAppMonitor.h"
+
+namespace libprogman {
+
+InstalledAppMonitor::InstalledAppMonitor(
+    InstalledAppList* installedAppList,
+    immer::vector<std::filesystem::path> foldersToWatch,
+    std::chrono::milliseconds coalesceWindow)
+    : installedAppList_(installedAppList),
+      cancel_(),
+      refreshRequested_(true),
+      stopping_(false),
+      apps_(),
+      thread_([this]() { work(); }),
+      watchers_() {
+    FolderWatcherOptions options;
+    options.coalesceWindow = coalesceWindow;
+
+    // Which files changed doesn't matter; InstalledAppList works out what to reload by itself
+    for (const auto& folder : foldersToWatch) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(folder, ec)) {
+            watchers_.push_back(std::make_unique<FolderWatcher>(
+                folder, [this](const std::vector<FolderChange>&) { refresh(); }, [](std::wstring) {}, options));
+        }
+    }
+}
+
+InstalledAppMonitor::~InstalledAppMonitor() {
+    // Stop the watchers first so they don't request scans while we're stopping
+    watchers_.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cancel_.cancel();
+    wakeUp_.notify_all();
+
+    thread_.join();
+}
+
+std::optional<immer::vector<std::shared_ptr<Shortcut>>> InstalledAppMonitor::apps() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return apps_;
+}
+
+void InstalledAppMonitor::refresh() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refreshRequested_ = true;
+    }
+    wakeUp_.notify_all();
+}
+
+void InstalledAppMonitor::hurry() {
+    SetThreadPriority(thread_.native_handle(), THREAD_PRIORITY_NORMAL);
+}
+
+void InstalledAppMonitor::work() {
+    auto cancel = cancel_.createToken();
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeUp_.wait(lock, [this]() { return refreshRequested_ || stopping_; });
+            if (stopping_) {
+                return;
+            }
+            refreshRequested_ = false;
+        }
+
+        // Scan without getting in the way of anything the user is doing, unless hurry() says they're waiting on us
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
+
+        try {
+            auto apps = installedAppList_->apps(cancel);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            apps_ = std::move(apps);
+        } catch (const libheirloom::OperationCanceledException&) {
+            return;
+        } catch (const std::exception&) {
+            // Keep the apps from the last scan. The next change tries again, and until the first scan succeeds, the
+            // New Shortcut dialog scans by itself and shows the error.
+        }
+    }
+}
+
+}  // namespace libprogman
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "libprogman/pch.h"
+#include "libprogman/FolderWatcher.h"
+#include "libprogman/InstalledAppList.h"
+#include "libheirloom/cancel.h"
+
+namespace libprogman {
+
+// Keeps an InstalledAppList scanned in the background, so the New Shortcut dialog can open with the apps right away
+// instead of waiting on a scan. Scans once at startup on an idle-priority thread, then again whenever the watchers on
+// the Start Menu folders see changes.
+class InstalledAppMonitor {
+   public:
+    // Installers touch many files in a row; wait for them to settle before scanning again.
+    static constexpr std::chrono::milliseconds kDefaultCoalesceWindow{ 2000 };
+
+    InstalledAppMonitor(
+        InstalledAppList* installedAppList,
+        immer::vector<std::filesystem::path> foldersToWatch,
+        std::chrono::milliseconds coalesceWindow = kDefaultCoalesceWindow);
+    InstalledAppMonitor(const InstalledAppMonitor&) = delete;
+    InstalledAppMonitor& operator=(const InstalledAppMonitor&) = delete;
+
+    // Stops watching, cancels the scan in progress, and joins the thread.
+    ~InstalledAppMonitor();
+
+    // The apps the last scan found, without waiting for the next one. Empty until the first scan is done.
+    std::optional<immer::vector<std::shared_ptr<Shortcut>>> apps();
+
+    // Schedules another scan, after the one in progress if there is one.
+    void refresh();
+
+    // Raises the thread to normal priority until the scan in progress is done. For when the user is waiting on it.
+    void hurry();
+
+   private:
+    void work();
+
+    InstalledAppList* installedAppList_;
+    libheirloom::CancellationTokenSource cancel_;
+    std::mutex mutex_;                // Protects refreshRequested_, stopping_ and apps_.
+    std::condition_variable wakeUp_;  // Signaled when a scan is requested or the monitor is stopping.
+    bool refreshRequested_;
+    bool stopping_;
+    std::optional<immer::vector<std::shared_ptr<Shortcut>>> apps_;
+    std::thread thread_;
+    std::vector<std::unique_ptr<FolderWatcher>> watchers_;
+};
+
+}  // namespace libprogman
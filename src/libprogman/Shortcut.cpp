@@ -6,8 +6,20 @@ namespace libprogman {
 Shortcut::Shortcut(
     std::filesystem::path path,
     wil::shared_hicon icon,
-    std::filesystem::file_time_type lastWriteTime) noexcept
-    : path_(std::move(path)), icon_(std::move(icon)), lastWriteTime_(lastWriteTime) {
+    std::filesystem::file_time_type lastWriteTime,
+    std::wstring target,
+    std::wstring arguments) noexcept
+    : path_(std::move(path)),
+      lastWriteTime_(lastWriteTime),
+      isLoaded_(true),
+      icon_(std::move(icon)),
+      target_(std::move(target)),
+      arguments_(std::move(arguments)) {
+    name_ = path_.stem().wstring();
+}
+
+Shortcut::Shortcut(std::filesystem::path path, std::filesystem::file_time_type lastWriteTime) noexcept
+    : path_(std::move(path)), lastWriteTime_(lastWriteTime), isLoaded_(false), icon_(), target_(), arguments_() {
     name_ = path_.stem().wstring();
 }
 
@@ -19,12 +31,36 @@ const std::wstring& Shortcut::name() const noexcept {
     return name_;
 }
 
+std::filesystem::file_time_type Shortcut::lastWriteTime() const noexcept {
+    return lastWriteTime_;
+}
+
+bool Shortcut::isLoaded() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return isLoaded_;
+}
+
 wil::shared_hicon Shortcut::icon() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
     return icon_;
 }
 
-std::filesystem::file_time_type Shortcut::lastWriteTime() const noexcept {
-    return lastWriteTime_;
+std::wstring Shortcut::target() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return target_;
+}
+
+std::wstring Shortcut::arguments() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return arguments_;
+}
+
+void Shortcut::finishLoading(wil::shared_hicon icon, std::wstring target, std::wstring arguments) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    icon_ = std::move(icon);
+    target_ = std::move(target);
+    arguments_ = std::move(arguments);
+    isLoaded_ = true;
 }
 
 void Shortcut::showPropertiesWindow() const {
@@ -5,16 +5,32 @@
 namespace libprogman {
 
 // Represents a .lnk file.
+// A shortcut can be created before the .lnk file has been read, with just its path and last write time; the icon,
+// target and arguments are filled in by finishLoading(), usually from an IconLoader thread, while the UI shows it.
 class Shortcut {
    public:
+    // A fully loaded shortcut.
     Shortcut(
         std::filesystem::path path,
         wil::shared_hicon icon,
-        std::filesystem::file_time_type lastWriteTime) noexcept;
+        std::filesystem::file_time_type lastWriteTime,
+        std::wstring target = {},
+        std::wstring arguments = {}) noexcept;
+
+    // A shortcut whose .lnk file hasn't been read yet.
+    Shortcut(std::filesystem::path path, std::filesystem::file_time_type lastWriteTime) noexcept;
+
     const std::filesystem::path& path() const noexcept;
     const std::wstring& name() const noexcept;
-    wil::shared_hicon icon() const noexcept;
     std::filesystem::file_time_type lastWriteTime() const noexcept;
+
+    // Until isLoaded(), icon() is null and target() and arguments() are empty.
+    bool isLoaded() const noexcept;
+    wil::shared_hicon icon() const noexcept;  // Null if the icon couldn't be loaded.
+    std::wstring target() const;              // Empty if the shortcut has no file system target.
+    std::wstring arguments() const;
+    void finishLoading(wil::shared_hicon icon, std::wstring target, std::wstring arguments) noexcept;
+
     void showPropertiesWindow() const;
     void launch() const;
     void deleteFile() const;
@@ -22,8 +38,12 @@ class Shortcut {
    private:
     std::wstring name_;
     std::filesystem::path path_;
-    wil::shared_hicon icon_;
     std::filesystem::file_time_type lastWriteTime_;
+    mutable std::mutex mutex_;  // Protects the fields below, which finishLoading() sets from another thread.
+    bool isLoaded_;
+    wil::shared_hicon icon_;
+    std::wstring target_;
+    std::wstring arguments_;
 };
 
 }  // namespace libprogman
@@ -0,0 +1,392 @@
+#include "libprogman/pch.h"
+#include "libprogman/ShortcutCache.h"
+
+namespace libprogman {
+
+// The cache file is a header followed by one record per .lnk file, packed with no padding:
+//   Header: uint32 magic, uint32 version, uint32 record count, uint32 reserved
+//   Record: uint32 path length, uint32 target length, uint32 arguments length, uint32 icon path length,
+//           int32 icon index, uint32 image count, int64 last write time, uint64 file size,
+//           path, target, arguments and icon path as UTF-16 without terminators,
+//           then per image: uint32 size, uint32 width, uint32 height, width * height * 4 bytes of BGRA pixels
+constexpr uint32_t kMagic = 0x43535048;  // "HPSC"
+constexpr uint32_t kVersion = 2;
+constexpr uint32_t kMaxIconDimension = 256;
+constexpr LONGLONG kMaxFileSize = 512LL * 1024 * 1024;
+
+// Reads fields from the mapped cache file in order. Every read fails once it would run past the end.
+class CacheFileReader {
+   public:
+    CacheFileReader(const uint8_t* data, size_t size) noexcept : data_(data), size_(size), offset_(0) {}
+
+    template <typename T>
+    bool read(T* value) noexcept {
+        if (size_ - offset_ < sizeof(T)) {
+            return false;
+        }
+        std::copy(data_ + offset_, data_ + offset_ + sizeof(T), reinterpret_cast<uint8_t*>(value));
+        offset_ += sizeof(T);
+        return true;
+    }
+
+    bool readString(uint32_t length, std::wstring* value) {
+        if ((size_ - offset_) / sizeof(wchar_t) < length) {
+            return false;
+        }
+        value->resize(length);
+        std::copy(
+            data_ + offset_, data_ + offset_ + length * sizeof(wchar_t), reinterpret_cast<uint8_t*>(value->data()));
+        offset_ += length * sizeof(wchar_t);
+        return true;
+    }
+
+    // Returns a pointer to the next count bytes and moves past them, or nullptr if there aren't that many.
+    const uint8_t* skip(size_t count) noexcept {
+        if (size_ - offset_ < count) {
+            return nullptr;
+        }
+        const uint8_t* bytes = data_ + offset_;
+        offset_ += count;
+        return bytes;
+    }
+
+   private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;
+};
+
+template <typename T>
+static void writeField(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void writeString(std::ostream& out, const std::wstring& value) {
+    out.write(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(wchar_t));
+}
+
+static BITMAPINFO topDownBitmapInfo(uint32_t width, uint32_t height) {
+    BITMAPINFO bitmapInfo = {};
+    bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bitmapInfo.bmiHeader.biWidth = static_cast<LONG>(width);
+    bitmapInfo.bmiHeader.biHeight = -static_cast<LONG>(height);
+    bitmapInfo.bmiHeader.biPlanes = 1;
+    bitmapInfo.bmiHeader.biBitCount = 32;
+    bitmapInfo.bmiHeader.biCompression = BI_RGB;
+    return bitmapInfo;
+}
+
+// Copies an icon's pixels out as 32bpp top-down BGRA. Icons without an alpha channel get one from their mask.
+// Returns false for icons that can't be read back this way, such as monochrome ones.
+static bool copyIconPixels(HICON icon, uint32_t* width, uint32_t* height, std::vector<uint8_t>* pixels) {
+    ICONINFO iconInfo = {};
+    if (!GetIconInfo(icon, &iconInfo)) {
+        return false;
+    }
+    wil::unique_hbitmap color(iconInfo.hbmColor);
+    wil::unique_hbitmap mask(iconInfo.hbmMask);
+    if (!color || !mask) {
+        return false;
+    }
+
+    BITMAP bitmap = {};
+    if (!GetObjectW(color.get(), sizeof(bitmap), &bitmap) || bitmap.bmWidth <= 0 || bitmap.bmHeight <= 0 ||
+        static_cast<uint32_t>(bitmap.bmWidth) > kMaxIconDimension ||
+        static_cast<uint32_t>(bitmap.bmHeight) > kMaxIconDimension) {
+        return false;
+    }
+    *width = static_cast<uint32_t>(bitmap.bmWidth);
+    *height = static_cast<uint32_t>(bitmap.bmHeight);
+
+    wil::unique_hdc dc(CreateCompatibleDC(nullptr));
+    if (!dc) {
+        return false;
+    }
+
+    pixels->assign(size_t(*width) * *height * 4, 0);
+    auto bitmapInfo = topDownBitmapInfo(*width, *height);
+    if (GetDIBits(dc.get(), color.get(), 0, *height, pixels->data(), &bitmapInfo, DIB_RGB_COLORS) !=
+        static_cast<int>(*height)) {
+        return false;
+    }
+
+    for (size_t i = 3; i < pixels->size(); i += 4) {
+        if ((*pixels)[i] != 0) {
+            return true;
+        }
+    }
+
+    // No alpha channel, so transparency comes from the mask: black is opaque, white is transparent.
+    std::vector<uint8_t> maskPixels(pixels->size());
+    bitmapInfo = topDownBitmapInfo(*width, *height);
+    if (GetDIBits(dc.get(), mask.get(), 0, *height, maskPixels.data(), &bitmapInfo, DIB_RGB_COLORS) !=
+        static_cast<int>(*height)) {
+        return false;
+    }
+    for (size_t i = 0; i < pixels->size(); i += 4) {
+        if (maskPixels[i] == 0) {
+            (*pixels)[i + 3] = 255;
+        } else {
+            std::fill(pixels->begin() + i, pixels->begin() + i + 4, uint8_t(0));
+        }
+    }
+    return true;
+}
+
+// Makes an icon from 32bpp top-down BGRA pixels. Returns nullptr on failure.
+static HICON createIcon(uint32_t width, uint32_t height, const uint8_t* pixels) {
+    auto bitmapInfo = topDownBitmapInfo(width, height);
+    void* bits = nullptr;
+    wil::unique_hbitmap color(CreateDIBSection(nullptr, &bitmapInfo, DIB_RGB_COLORS, &bits, nullptr, 0));
+    if (!color || !bits) {
+        return nullptr;
+    }
+    std::copy(pixels, pixels + size_t(width) * height * 4, static_cast<uint8_t*>(bits));
+
+    // The alpha channel decides what is transparent, so the mask is left all opaque. Mask rows are WORD-aligned.
+    std::vector<uint8_t> maskBits(size_t((width + 15) / 16) * 2 * height, 0);
+    wil::unique_hbitmap mask(CreateBitmap(width, height, 1, 1, maskBits.data()));
+    if (!mask) {
+        return nullptr;
+    }
+
+    ICONINFO iconInfo = { TRUE, 0, 0, mask.get(), color.get() };
+    return CreateIconIndirect(&iconInfo);
+}
+
+const uint8_t* ShortcutCache::Image::data() const noexcept {
+    return pixels.empty() ? mappedPixels : pixels.data();
+}
+
+ShortcutCache::ShortcutCache(std::filesystem::path cacheFilePath, IconStore* iconStore)
+    : cacheFilePath_(std::move(cacheFilePath)), iconStore_(iconStore), view_(), records_(), dirty_(false) {
+    load();
+}
+
+void ShortcutCache::load() {
+    wil::unique_hfile file(CreateFileW(
+        cacheFilePath_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+        nullptr));
+    if (!file) {
+        return;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file.get(), &fileSize) || fileSize.QuadPart < LONGLONG(4 * sizeof(uint32_t)) ||
+        fileSize.QuadPart > kMaxFileSize) {
+        return;
+    }
+
+    // The view keeps the file mapped after both handles are closed.
+    wil::unique_handle mapping(CreateFileMappingW(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+    if (!mapping) {
+        return;
+    }
+    wil::unique_mapview_ptr<uint8_t> view(static_cast<uint8_t*>(MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0)));
+    if (!view) {
+        return;
+    }
+
+    CacheFileReader reader(view.get(), static_cast<size_t>(fileSize.QuadPart));
+    uint32_t magic = 0, version = 0, recordCount = 0, reserved = 0;
+    if (!reader.read(&magic) || !reader.read(&version) || !reader.read(&recordCount) || !reader.read(&reserved) ||
+        magic != kMagic || version != kVersion) {
+        return;
+    }
+
+    // Anything that doesn't add up means the file is damaged, and none of it is used.
+    std::unordered_map<std::wstring, Record> records;
+    records.reserve(recordCount);
+    for (uint32_t i = 0; i < recordCount; i++) {
+        uint32_t pathLength = 0, targetLength = 0, argumentsLength = 0, iconPathLength = 0, imageCount = 0;
+        std::wstring path;
+        Record record = {};
+        if (!reader.read(&pathLength) || !reader.read(&targetLength) || !reader.read(&argumentsLength) ||
+            !reader.read(&iconPathLength) || !reader.read(&record.iconIndex) || !reader.read(&imageCount) ||
+            !reader.read(&record.lastWriteTime) || !reader.read(&record.fileSize) ||
+            !reader.readString(pathLength, &path) || !reader.readString(targetLength, &record.target) ||
+            !reader.readString(argumentsLength, &record.arguments) ||
+            !reader.readString(iconPathLength, &record.iconPath)) {
+            return;
+        }
+
+        for (uint32_t j = 0; j < imageCount; j++) {
+            Image image = {};
+            if (!reader.read(&image.size) || !reader.read(&image.width) || !reader.read(&image.height) ||
+                image.width == 0 || image.height == 0 || image.width > kMaxIconDimension ||
+                image.height > kMaxIconDimension) {
+                return;
+            }
+            image.mappedPixels = reader.skip(size_t(image.width) * image.height * 4);
+            if (image.mappedPixels == nullptr) {
+                return;
+            }
+            record.images.push_back(std::move(image));
+        }
+
+        records[std::move(path)] = std::move(record);
+    }
+
+    view_ = std::move(view);
+    records_ = std::move(records);
+}
+
+std::optional<ShortcutCache::Entry> ShortcutCache::find(
+    const std::filesystem::path& lnkFilePath,
+    std::filesystem::file_time_type lastWriteTime,
+    uintmax_t fileSize,
+    int iconSize) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = records_.find(lnkFilePath.native());
+    if (it == records_.end()) {
+        return std::nullopt;
+    }
+
+    auto& record = it->second;
+    if (record.lastWriteTime != static_cast<int64_t>(lastWriteTime.time_since_epoch().count()) ||
+        record.fileSize != fileSize) {
+        return std::nullopt;
+    }
+
+    for (const auto& image : record.images) {
+        if (image.size != static_cast<uint32_t>(iconSize)) {
+            continue;
+        }
+
+        // Another shortcut with the same icon source may have its icon in use already; then this one shares it.
+        auto makeIcon = [&image]() { return wil::unique_hicon(createIcon(image.width, image.height, image.data())); };
+        wil::shared_hicon icon = iconStore_ != nullptr && !record.iconPath.empty()
+                                     ? iconStore_->get({ record.iconPath, record.iconIndex, iconSize }, makeIcon)
+                                     : wil::shared_hicon{ makeIcon() };
+        if (!icon) {
+            return std::nullopt;
+        }
+
+        record.used = true;
+        return Entry{ record.target, record.arguments, std::move(icon) };
+    }
+
+    return std::nullopt;
+}
+
+void ShortcutCache::store(
+    const std::filesystem::path& lnkFilePath,
+    std::filesystem::file_time_type lastWriteTime,
+    uintmax_t fileSize,
+    int iconSize,
+    std::wstring target,
+    std::wstring arguments,
+    HICON icon,
+    std::wstring iconPath,
+    int iconIndex) {
+    Image image = { static_cast<uint32_t>(iconSize), 0, 0, nullptr, {} };
+    bool hasImage = icon != nullptr && copyIconPixels(icon, &image.width, &image.height, &image.pixels);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto& record = records_[lnkFilePath.native()];
+    auto lastWriteTicks = static_cast<int64_t>(lastWriteTime.time_since_epoch().count());
+    if (record.lastWriteTime != lastWriteTicks || record.fileSize != fileSize) {
+        // New or changed since it was cached; icons at other sizes are out of date too.
+        record.images.clear();
+    }
+
+    record.lastWriteTime = lastWriteTicks;
+    record.fileSize = fileSize;
+    record.target = std::move(target);
+    record.arguments = std::move(arguments);
+    record.iconPath = std::move(iconPath);
+    record.iconIndex = iconIndex;
+    record.used = true;
+
+    record.images.erase(
+        std::remove_if(
+            record.images.begin(), record.images.end(),
+            [iconSize](const Image& existing) { return existing.size == static_cast<uint32_t>(iconSize); }),
+        record.images.end());
+    if (hasImage) {
+        record.images.push_back(std::move(image));
+    }
+
+    dirty_ = true;
+}
+
+void ShortcutCache::save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Forget shortcuts that weren't seen this session and have since been deleted.
+    for (auto it = records_.begin(); it != records_.end();) {
+        std::error_code ec;
+        if (!it->second.used && !std::filesystem::exists(it->first, ec)) {
+            it = records_.erase(it);
+            dirty_ = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if (!dirty_) {
+        return;
+    }
+
+    auto tempPath = cacheFilePath_;
+    tempPath += L".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Failed to create the shortcut cache file.");
+        }
+
+        writeField(out, kMagic);
+        writeField(out, kVersion);
+        writeField(out, static_cast<uint32_t>(records_.size()));
+        writeField(out, uint32_t(0));
+
+        for (const auto& [path, record] : records_) {
+            writeField(out, static_cast<uint32_t>(path.size()));
+            writeField(out, static_cast<uint32_t>(record.target.size()));
+            writeField(out, static_cast<uint32_t>(record.arguments.size()));
+            writeField(out, static_cast<uint32_t>(record.iconPath.size()));
+            writeField(out, record.iconIndex);
+            writeField(out, static_cast<uint32_t>(record.images.size()));
+            writeField(out, record.lastWriteTime);
+            writeField(out, record.fileSize);
+            writeString(out, path);
+            writeString(out, record.target);
+            writeString(out, record.arguments);
+            writeString(out, record.iconPath);
+
+            for (const auto& image : record.images) {
+                writeField(out, image.size);
+                writeField(out, image.width);
+                writeField(out, image.height);
+                out.write(reinterpret_cast<const char*>(image.data()), size_t(image.width) * image.height * 4);
+            }
+        }
+
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Failed to write the shortcut cache file.");
+        }
+    }
+
+    // The old file can't be replaced while it's mapped, so take copies of the pixels still in it first.
+    for (auto& [path, record] : records_) {
+        for (auto& image : record.images) {
+            if (image.pixels.empty()) {
+                image.pixels.assign(image.mappedPixels, image.mappedPixels + size_t(image.width) * image.height * 4);
+                image.mappedPixels = nullptr;
+            }
+        }
+    }
+    view_.reset();
+
+    if (!MoveFileExW(tempPath.c_str(), cacheFilePath_.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        THROW_LAST_ERROR();
+    }
+
+    dirty_ = false;
+}
+
+}  // namespace libprogman
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "libprogman/pch.h"
+#include "libprogman/IconStore.h"
+
+namespace libprogman {
+
+// Persists what ShortcutFactory reads out of .lnk files from one run to the next: the target, the arguments, and the
+// icon pixels at each size it has been rendered at. An entry is only used while the .lnk file's path, last write
+// time and size all match what was cached, so an edited shortcut is read again.
+// The cache file is memory-mapped when the cache is constructed; icons are made from the mapped pixels as they are
+// asked for. Entries remember where their icon came from, so that with an IconStore, shortcuts that share an icon
+// source also share one icon. Thread-safe, since IconLoader's worker threads and the background scan of installed apps
+// use it alongside the UI thread.
+class ShortcutCache {
+   public:
+    struct Entry {
+        std::wstring target;
+        std::wstring arguments;
+        wil::shared_hicon icon;
+    };
+
+    // Maps cacheFilePath if it exists. A missing, unreadable or damaged file leaves the cache empty.
+    explicit ShortcutCache(std::filesystem::path cacheFilePath, IconStore* iconStore = nullptr);
+
+    // Returns the entry for lnkFilePath with its icon at iconSize, or nullopt if the file has changed since it was
+    // cached or its icon was never cached at that size.
+    std::optional<Entry> find(
+        const std::filesystem::path& lnkFilePath,
+        std::filesystem::file_time_type lastWriteTime,
+        uintmax_t fileSize,
+        int iconSize);
+
+    // Records what was read from lnkFilePath. The icon's pixels are copied; the caller keeps ownership of icon.
+    // Icons cached at other sizes are kept as long as the file hasn't changed. iconPath and iconIndex are where the
+    // icon was extracted from, as in IconStore::Key; leave iconPath empty if the icon can't be shared.
+    void store(
+        const std::filesystem::path& lnkFilePath,
+        std::filesystem::file_time_type lastWriteTime,
+        uintmax_t fileSize,
+        int iconSize,
+        std::wstring target,
+        std::wstring arguments,
+        HICON icon,
+        std::wstring iconPath = {},
+        int iconIndex = 0);
+
+    // Writes the cache file if anything changed. Entries that were not used this session are dropped once their .lnk
+    // file is gone. The file is written next to the old one and then swapped in. Throws on failure.
+    void save();
+
+   private:
+    struct Image {
+        uint32_t size;                // The icon size it was rendered for, which is what find() matches on.
+        uint32_t width;               // The icon's actual width and height, usually both the same as size.
+        uint32_t height;
+        const uint8_t* mappedPixels;  // 32bpp top-down BGRA, in view_...
+        std::vector<uint8_t> pixels;  // ...or here, if it was stored this session.
+
+        const uint8_t* data() const noexcept;
+    };
+
+    struct Record {
+        int64_t lastWriteTime;
+        uint64_t fileSize;
+        std::wstring target;
+        std::wstring arguments;
+        std::wstring iconPath;  // Empty if the icon isn't shared through the IconStore.
+        int32_t iconIndex;
+        std::vector<Image> images;
+        bool used;  // Found or stored this session.
+    };
+
+    void load();
+
+    std::filesystem::path cacheFilePath_;
+    IconStore* iconStore_;
+    std::mutex mutex_;                                  // Protects everything below.
+    wil::unique_mapview_ptr<uint8_t> view_;             // The cache file as it was at startup.
+    std::unordered_map<std::wstring, Record> records_;  // By .lnk path.
+    bool dirty_;                                        // Something changed since the file was written.
+};
+
+}  // namespace libprogman
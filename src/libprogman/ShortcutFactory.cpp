@@ -26,6 +26,96 @@ static wil::com_ptr<IPersistFile> newPersistFile(const wil::com_ptr<IShellLink>&
     return persistFile;
 }
 
+// Gets the appropriate icon size based on current DPI scaling
+static int getScaledIconSize(HWND hwnd = nullptr) {
+    // Get the DPI for the window or primary monitor
+    UINT dpi = hwnd ? GetDpiForWindow(hwnd) : GetDpiForSystem();
+
+    // Calculate scaling factor (96 is the baseline DPI)
+    double scalingFactor = static_cast<double>(dpi) / 96.0;
+
+    // Base icon size is 32x32, scale it based on DPI
+    int scaledSize = static_cast<int>(32 * scalingFactor);
+
+    // Round to common icon sizes (16, 32, 48, 64, 128, 256)
+    if (scaledSize <= 16)
+        return 16;
+    if (scaledSize <= 32)
+        return 32;
+    if (scaledSize <= 48)
+        return 48;
+    if (scaledSize <= 64)
+        return 64;
+    if (scaledSize <= 128)
+        return 128;
+    return 256;
+}
+
+// Extracts the icon at iconIndex in iconPath, an icon, executable or DLL file. Returns null if there isn't one.
+static wil::unique_hicon extractIcon(const wchar_t* iconPath, int iconIndex, int iconSize) {
+    // Try to load the icon at the appropriate size
+    HICON hIcon = static_cast<HICON>(
+        LoadImage(nullptr, iconPath, IMAGE_ICON, iconSize, iconSize, LR_LOADFROMFILE | LR_LOADMAP3DCOLORS));
+
+    if (!hIcon) {
+        // If failed, try SHDefExtractIcon which can scale icons
+        HRESULT hr = SHDefExtractIconW(iconPath, iconIndex, 0, &hIcon, nullptr, iconSize);
+
+        if (FAILED(hr) || !hIcon) {
+            // If that fails, fall back to ExtractIconEx
+            hIcon = nullptr;
+            ExtractIconExW(iconPath, iconIndex, nullptr, &hIcon, 1);
+        }
+    }
+
+    return wil::unique_hicon{ hIcon };
+}
+
+// Gets the shell's icon for targetPath, as Explorer would show the file. Returns null if there isn't one.
+static wil::unique_hicon extractFileIcon(const wchar_t* targetPath, int iconSize) {
+    // Use SHGetFileInfo to get the icon with proper scaling
+    SHFILEINFOW sfi = { 0 };
+    DWORD_PTR result = SHGetFileInfoW(
+        targetPath, 0, &sfi, sizeof(sfi), SHGFI_ICON | SHGFI_LARGEICON | SHGFI_USEFILEATTRIBUTES);
+
+    if (!result || !sfi.hIcon) {
+        return wil::unique_hicon{};
+    }
+    wil::unique_hicon hIcon{ sfi.hIcon };
+
+    // For better high-DPI handling, try to get a better size using IExtractIcon
+    wil::com_ptr<IShellItemImageFactory> psiif;
+    HRESULT hr = SHCreateItemFromParsingName(targetPath, nullptr, IID_PPV_ARGS(&psiif));
+
+    if (SUCCEEDED(hr)) {
+        HBITMAP hBitmap = nullptr;
+        SIZE size = { iconSize, iconSize };
+
+        // Try to get higher quality icon at the right size
+        hr = psiif->GetImage(size, SIIGBF_ICONONLY, &hBitmap);
+        if (SUCCEEDED(hr) && hBitmap) {
+            // Convert HBITMAP to HICON
+            ICONINFO iconInfo = { 0 };
+            iconInfo.fIcon = TRUE;
+            iconInfo.hbmMask = hBitmap;
+            iconInfo.hbmColor = hBitmap;
+
+            HICON hBetterIcon = CreateIconIndirect(&iconInfo);
+            if (hBetterIcon) {
+                hIcon.reset(hBetterIcon);  // Destroys the previous icon
+            }
+
+            // Clean up the bitmap
+            DeleteObject(hBitmap);
+        }
+    }
+
+    return hIcon;
+}
+
+ShortcutFactory::ShortcutFactory(ShortcutCache* cache, IconStore* iconStore) noexcept
+    : cache_(cache), iconStore_(iconStore) {}
+
 void ShortcutFactory::create(std::filesystem::path lnkFilePath, std::filesystem::path targetPath) {
     auto shellLink = newShellLink();
     auto persistFile = newPersistFile(shellLink);
@@ -44,123 +134,108 @@ void ShortcutFactory::create(std::filesystem::path lnkFilePath, std::filesystem:
 
 std::shared_ptr<Shortcut> ShortcutFactory::open(
     std::filesystem::path lnkFilePath,
-    std::filesystem::file_time_type lastWriteTime) {
-    auto shellLink = newShellLink();
-    auto persistFile = newPersistFile(shellLink);
-
-    auto wstrPath = lnkFilePath.wstring();
+    std::filesystem::file_time_type lastWriteTime,
+    uintmax_t fileSize) {
+    auto shortcut = openDeferred(std::move(lnkFilePath), lastWriteTime, fileSize);
+    if (!shortcut->isLoaded()) {
+        loadDeferred(shortcut.get());
+    }
+    return shortcut;
+}
 
-    THROW_IF_FAILED(persistFile->Load(wstrPath.c_str(), STGM_READ));
-    auto icon = loadIcon(shellLink.get());
+std::shared_ptr<Shortcut> ShortcutFactory::openDeferred(
+    std::filesystem::path lnkFilePath,
+    std::filesystem::file_time_type lastWriteTime,
+    uintmax_t fileSize) {
+    // If an earlier run already read this exact file, skip the shell link and icon extraction entirely.
+    if (cache_ != nullptr) {
+        auto cached = cache_->find(lnkFilePath, lastWriteTime, fileSize, getScaledIconSize());
+        if (cached.has_value()) {
+            return std::make_shared<Shortcut>(
+                lnkFilePath.wstring(), std::move(cached->icon), lastWriteTime, std::move(cached->target),
+                std::move(cached->arguments));
+        }
+    }
 
-    return std::make_shared<Shortcut>(wstrPath, icon, lastWriteTime);
+    return std::make_shared<Shortcut>(lnkFilePath.wstring(), lastWriteTime);
 }
 
-// Gets the appropriate icon size based on current DPI scaling
-static int getScaledIconSize(HWND hwnd = nullptr) {
-    // Get the DPI for the window or primary monitor
-    UINT dpi = hwnd ? GetDpiForWindow(hwnd) : GetDpiForSystem();
+void ShortcutFactory::loadDeferred(Shortcut* shortcut) {
+    int iconSize = getScaledIconSize();
+    auto wstrPath = shortcut->path().wstring();
 
-    // Calculate scaling factor (96 is the baseline DPI)
-    double scalingFactor = static_cast<double>(dpi) / 96.0;
+    auto shellLink = newShellLink();
+    auto persistFile = newPersistFile(shellLink);
 
-    // Base icon size is 32x32, scale it based on DPI
-    int scaledSize = static_cast<int>(32 * scalingFactor);
+    THROW_IF_FAILED(persistFile->Load(wstrPath.c_str(), STGM_READ));
+    IconStore::Key iconKey;
+    auto icon = loadIcon(shellLink.get(), iconSize, &iconKey);
 
-    // Round to common icon sizes (16, 32, 48, 64, 128, 256)
-    if (scaledSize <= 16)
-        return 16;
-    if (scaledSize <= 32)
-        return 32;
-    if (scaledSize <= 48)
-        return 48;
-    if (scaledSize <= 64)
-        return 64;
-    if (scaledSize <= 128)
-        return 128;
-    return 256;
+    // Advertised shortcuts have no target path, and most shortcuts have no arguments; leave those empty.
+    WCHAR target[MAX_PATH] = { 0 };
+    if (FAILED(shellLink->GetPath(target, MAX_PATH, nullptr, 0))) {
+        target[0] = L'\0';
+    }
+    WCHAR arguments[INFOTIPSIZE] = { 0 };
+    if (FAILED(shellLink->GetArguments(arguments, INFOTIPSIZE))) {
+        arguments[0] = L'\0';
+    }
+
+    // Cache it under the size the file has now; if it changed since it was listed, the entry just won't match.
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(shortcut->path(), ec);
+    if (cache_ != nullptr && !ec) {
+        cache_->store(
+            shortcut->path(), shortcut->lastWriteTime(), fileSize, iconSize, target, arguments, icon.get(),
+            std::move(iconKey.path), iconKey.index);
+    }
+
+    shortcut->finishLoading(std::move(icon), target, arguments);
 }
 
-wil::shared_hicon ShortcutFactory::loadIcon(IShellLink* shellLink) {
-    HICON hIcon = nullptr;
-    int iconSize = getScaledIconSize();
+wil::shared_hicon ShortcutFactory::shareIcon(
+    const IconStore::Key& key,
+    const std::function<wil::unique_hicon()>& load) {
+    if (iconStore_ == nullptr) {
+        return wil::shared_hicon{ load() };
+    }
+    return iconStore_->get(key, load);
+}
 
+wil::shared_hicon ShortcutFactory::loadIcon(IShellLink* shellLink, int iconSize, IconStore::Key* key) {
     // First try to get the icon from the shortcut
     WCHAR iconPath[MAX_PATH] = { 0 };
     int iconIndex = 0;
     HRESULT hr = shellLink->GetIconLocation(iconPath, MAX_PATH, &iconIndex);
 
     if (SUCCEEDED(hr) && iconPath[0] != L'\0') {
-        // Try to load the icon at the appropriate size
-        hIcon = static_cast<HICON>(
-            LoadImage(nullptr, iconPath, IMAGE_ICON, iconSize, iconSize, LR_LOADFROMFILE | LR_LOADMAP3DCOLORS));
-
-        if (!hIcon) {
-            // If failed, try SHDefExtractIcon which can scale icons
-            hr = SHDefExtractIconW(iconPath, iconIndex, 0, &hIcon, nullptr, iconSize);
-
-            if (FAILED(hr) || !hIcon) {
-                // If that fails, fall back to ExtractIconEx
-                ExtractIconExW(iconPath, iconIndex, nullptr, &hIcon, 1);
-            }
+        *key = { iconPath, iconIndex, iconSize };
+        auto icon = shareIcon(*key, [&]() { return extractIcon(iconPath, iconIndex, iconSize); });
+        if (icon) {
+            return icon;
         }
     }
 
     // If we still don't have an icon, try to get it from the target file
-    if (!hIcon) {
-        WCHAR targetPath[MAX_PATH] = { 0 };
-        WIN32_FIND_DATAW findData = { 0 };
-        hr = shellLink->GetPath(targetPath, MAX_PATH, &findData, SLGP_RAWPATH);
-
-        if (SUCCEEDED(hr) && targetPath[0] != L'\0') {
-            // Use SHGetFileInfo to get the icon with proper scaling
-            SHFILEINFOW sfi = { 0 };
-            DWORD_PTR result = SHGetFileInfoW(
-                targetPath, 0, &sfi, sizeof(sfi), SHGFI_ICON | SHGFI_LARGEICON | SHGFI_USEFILEATTRIBUTES);
-
-            if (result && sfi.hIcon) {
-                hIcon = sfi.hIcon;
-
-                // For better high-DPI handling, try to get a better size using IExtractIcon
-                wil::com_ptr<IShellItemImageFactory> psiif;
-                hr = SHCreateItemFromParsingName(targetPath, nullptr, IID_PPV_ARGS(&psiif));
-
-                if (SUCCEEDED(hr)) {
-                    HBITMAP hBitmap = nullptr;
-                    SIZE size = { iconSize, iconSize };
-
-                    // Try to get higher quality icon at the right size
-                    hr = psiif->GetImage(size, SIIGBF_ICONONLY, &hBitmap);
-                    if (SUCCEEDED(hr) && hBitmap) {
-                        // Convert HBITMAP to HICON
-                        ICONINFO iconInfo = { 0 };
-                        iconInfo.fIcon = TRUE;
-                        iconInfo.hbmMask = hBitmap;
-                        iconInfo.hbmColor = hBitmap;
-
-                        HICON hBetterIcon = CreateIconIndirect(&iconInfo);
-                        if (hBetterIcon) {
-                            DestroyIcon(hIcon);  // Destroy the previous icon
-                            hIcon = hBetterIcon;
-                        }
-
-                        // Clean up the bitmap
-                        DeleteObject(hBitmap);
-                    }
-                }
-            }
+    WCHAR targetPath[MAX_PATH] = { 0 };
+    WIN32_FIND_DATAW findData = { 0 };
+    hr = shellLink->GetPath(targetPath, MAX_PATH, &findData, SLGP_RAWPATH);
+
+    if (SUCCEEDED(hr) && targetPath[0] != L'\0') {
+        *key = { targetPath, IconStore::kFileIconIndex, iconSize };
+        auto icon = shareIcon(*key, [&]() { return extractFileIcon(targetPath, iconSize); });
+        if (icon) {
+            return icon;
         }
     }
 
     // If we still don't have an icon, use default icon from shell32.dll
-    if (!hIcon) {
-        // Load shell32.dll default icon with appropriate scaling
-        hIcon = static_cast<HICON>(LoadImage(nullptr, IDI_APPLICATION, IMAGE_ICON, iconSize, iconSize, LR_SHARED));
+    *key = {};
+    HICON hIcon = static_cast<HICON>(LoadImage(nullptr, IDI_APPLICATION, IMAGE_ICON, iconSize, iconSize, LR_SHARED));
 
-        if (!hIcon) {
-            // Last resort, try shell32.dll
-            SHDefExtractIconW(L"shell32.dll", 0, 0, &hIcon, nullptr, iconSize);
-        }
+    if (!hIcon) {
+        // Last resort, try shell32.dll
+        SHDefExtractIconW(L"shell32.dll", 0, 0, &hIcon, nullptr, iconSize);
     }
 
     return wil::shared_hicon{ hIcon };
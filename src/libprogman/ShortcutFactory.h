@@ -1,6 +1,8 @@
 #pragma once
 
 #include "libprogman/pch.h"
+#include "libprogman/IconStore.h"
+#include "libprogman/ShortcutCache.h"
 
 namespace libprogman {
 
@@ -8,11 +10,36 @@ class Shortcut;
 
 class ShortcutFactory {
    public:
+    // With a cache, open() reuses what an earlier run read from unchanged .lnk files, and records what it reads.
+    // With an icon store, shortcuts whose icons come from the same file and index share one HICON.
+    explicit ShortcutFactory(ShortcutCache* cache = nullptr, IconStore* iconStore = nullptr) noexcept;
+
     void create(std::filesystem::path lnkFilePath, std::filesystem::path targetPath);
-    std::shared_ptr<Shortcut> open(std::filesystem::path lnkFilePath, std::filesystem::file_time_type lastWriteTime);
+
+    // Opens a shortcut and loads it fully: openDeferred(), then loadDeferred() if the cache didn't have it.
+    std::shared_ptr<Shortcut> open(
+        std::filesystem::path lnkFilePath,
+        std::filesystem::file_time_type lastWriteTime,
+        uintmax_t fileSize);
+
+    // Returns right away without reading the .lnk file. If the cache has the file as it is now, the shortcut comes
+    // back fully loaded from there; otherwise it has only its name, path and last write time until loadDeferred().
+    std::shared_ptr<Shortcut> openDeferred(
+        std::filesystem::path lnkFilePath,
+        std::filesystem::file_time_type lastWriteTime,
+        uintmax_t fileSize);
+
+    // Reads the .lnk file of a shortcut from openDeferred() and finishes loading it with the icon, target and
+    // arguments. Needs COM initialized on the calling thread. Throws if the file can't be read.
+    void loadDeferred(Shortcut* shortcut);
 
    private:
-    wil::shared_hicon loadIcon(IShellLink* shellLink);
+    // Sets key to where the icon came from, with an empty path if it can't be shared.
+    wil::shared_hicon loadIcon(IShellLink* shellLink, int iconSize, IconStore::Key* key);
+    wil::shared_hicon shareIcon(const IconStore::Key& key, const std::function<wil::unique_hicon()>& load);
+
+    ShortcutCache* cache_;
+    IconStore* iconStore_;
 };
 
 }  // namespace libprogman
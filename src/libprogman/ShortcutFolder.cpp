@@ -40,4 +40,19 @@ std::shared_ptr<Shortcut> ShortcutFolder::shortcutOrNull(std::wstring name) cons
     return *ptr;
 }
 
+ShortcutFolderDiff ShortcutFolder::diff(
+    const immer::map<std::wstring, std::shared_ptr<Shortcut>>& before,
+    const immer::map<std::wstring, std::shared_ptr<Shortcut>>& after) {
+    ShortcutFolderDiff result;
+    immer::diff(
+        before, after,
+        immer::make_differ(
+            [&result](const auto& added) { result.added.push_back(added.second); },
+            [&result](const auto& removed) { result.removed.push_back(removed.second); },
+            [&result](const auto& oldEntry, const auto& newEntry) {
+                result.changed.emplace_back(oldEntry.second, newEntry.second);
+            }));
+    return result;
+}
+
 }  // namespace libprogman
@@ -5,6 +5,13 @@
 
 namespace libprogman {
 
+// How a folder's shortcuts changed from one version of the folder to the next, matched up by name.
+struct ShortcutFolderDiff {
+    std::vector<std::shared_ptr<Shortcut>> added;
+    std::vector<std::shared_ptr<Shortcut>> removed;
+    std::vector<std::pair<std::shared_ptr<Shortcut>, std::shared_ptr<Shortcut>>> changed;  // Old and new.
+};
+
 class ShortcutFolder {
    public:
     ShortcutFolder(std::filesystem::path path, immer::map<std::wstring, std::shared_ptr<Shortcut>> shortcuts);
@@ -14,6 +21,13 @@ class ShortcutFolder {
     std::shared_ptr<Shortcut> shortcut(std::wstring name) const;
     std::shared_ptr<Shortcut> shortcutOrNull(std::wstring name) const noexcept;
 
+    // Compares two versions of shortcuts(). A shortcut counts as changed when the name maps to a different Shortcut
+    // object, which ShortcutManager only creates when the .lnk file changed. Parts of the maps that are still shared
+    // between the two versions are skipped without being visited.
+    static ShortcutFolderDiff diff(
+        const immer::map<std::wstring, std::shared_ptr<Shortcut>>& before,
+        const immer::map<std::wstring, std::shared_ptr<Shortcut>>& after);
+
    private:
     std::wstring name_;
     std::filesystem::path path_;
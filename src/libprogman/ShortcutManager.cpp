@@ -162,12 +162,14 @@ std::shared_ptr<ShortcutFolder> ShortcutManager::refreshFolder(std::filesystem::
                     continue;
                 }
 
-                try {
-                    auto shortcut = refreshShortcut(path, entry.last_write_time(), existingFolder);
-                    shortcuts.insert({ shortcut->name(), shortcut });
-                } catch (...) {
-                    // Ignore the file entirely. Nothing we can do about it.
+                // New and changed shortcuts are opened without reading the file; the window that shows them has
+                // IconLoader finish loading them.
+                auto lastWriteTime = entry.last_write_time();
+                auto shortcut = reusableShortcut(path, lastWriteTime, existingFolder);
+                if (shortcut == nullptr) {
+                    shortcut = shortcutFactory_->openDeferred(path, lastWriteTime, entry.file_size());
                 }
+                shortcuts.insert({ shortcut->name(), shortcut });
             }
         }
     } catch (...) {
@@ -178,21 +180,122 @@ std::shared_ptr<ShortcutFolder> ShortcutManager::refreshFolder(std::filesystem::
     return std::make_shared<ShortcutFolder>(std::move(folderPath), shortcuts.persistent());
 }
 
-std::shared_ptr<Shortcut> ShortcutManager::refreshShortcut(
-    std::filesystem::path shortcutPath,
+void ShortcutManager::applyChanges(const std::vector<FolderChange>& changes) {
+    bool overflowed = std::any_of(changes.begin(), changes.end(), [](const FolderChange& change) {
+        return change.kind == FolderChange::Kind::kOverflow;
+    });
+    if (overflowed) {
+        // Anything may have changed, so check everything.
+        refresh();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(refreshMutex_);
+
+        // Sort the changes by folder. A folder that was itself added, removed or renamed is reread whole; otherwise
+        // only the .lnk files that changed in it are.
+        std::filesystem::path root(rootPath_);
+        std::set<std::wstring> foldersToReread;
+        std::unordered_map<std::wstring, std::vector<std::filesystem::path>> shortcutsToReread;
+        for (const auto& change : changes) {
+            auto relativePath = change.path.lexically_relative(root);
+            if (relativePath.empty() || relativePath == L"." || *relativePath.begin() == L"..") {
+                continue;
+            }
+
+            auto it = relativePath.begin();
+            std::wstring folderName = (it++)->wstring();
+            if (it == relativePath.end()) {
+                // The folder itself. A "modified" folder is just one whose contents changed, which are reported too.
+                if (change.kind != FolderChange::Kind::kModified) {
+                    foldersToReread.insert(folderName);
+                }
+            } else if (std::next(it) == relativePath.end() && change.path.extension() == L".lnk") {
+                shortcutsToReread[folderName].push_back(change.path);
+            }
+        }
+
+        auto folders = folders_.transient();
+
+        for (const auto& folderName : foldersToReread) {
+            std::error_code ec;
+            if (std::filesystem::is_directory(root / folderName, ec)) {
+                folders.set(folderName, refreshFolder(root / folderName));
+            } else {
+                folders.erase(folderName);
+            }
+        }
+
+        for (const auto& [folderName, shortcutPaths] : shortcutsToReread) {
+            if (foldersToReread.count(folderName) != 0) {
+                continue;
+            }
+
+            // A folder the map doesn't have yet is read whole; the change that added it may not have been seen.
+            const auto* existingFolder = folders.find(folderName);
+            if (existingFolder != nullptr) {
+                folders.set(folderName, refreshShortcuts(**existingFolder, shortcutPaths));
+            } else {
+                std::error_code ec;
+                if (std::filesystem::is_directory(root / folderName, ec)) {
+                    folders.set(folderName, refreshFolder(root / folderName));
+                }
+            }
+        }
+
+        // Cut over to the new map.
+        folders_ = folders.persistent();
+    }
+
+    if (folders_.empty()) {
+        // Every folder is gone. Let refresh() put the initial shortcuts back, as it does at startup.
+        refresh();
+    }
+}
+
+std::shared_ptr<ShortcutFolder> ShortcutManager::refreshShortcuts(
+    const ShortcutFolder& folder,
+    const std::vector<std::filesystem::path>& shortcutPaths) const {
+    auto shortcuts = folder.shortcuts().transient();
+
+    for (const auto& path : shortcutPaths) {
+        // Whatever the change was, the file as it is now decides: it's gone, unchanged, or new or changed.
+        std::error_code ec;
+        std::filesystem::directory_entry entry(path, ec);
+        bool isFile = !ec && entry.is_regular_file(ec);
+        auto lastWriteTime = isFile ? entry.last_write_time(ec) : std::filesystem::file_time_type{};
+        auto fileSize = isFile && !ec ? entry.file_size(ec) : 0;
+        if (!isFile || ec) {
+            shortcuts.erase(path.stem().wstring());
+            continue;
+        }
+
+        auto shortcut = reusableShortcut(path, lastWriteTime, &folder);
+        if (shortcut == nullptr) {
+            shortcut = shortcutFactory_->openDeferred(path, lastWriteTime, fileSize);
+        }
+        shortcuts.set(shortcut->name(), shortcut);
+    }
+
+    return std::make_shared<ShortcutFolder>(folder.path(), shortcuts.persistent());
+}
+
+std::shared_ptr<Shortcut> ShortcutManager::reusableShortcut(
+    const std::filesystem::path& shortcutPath,
     std::filesystem::file_time_type lastWriteTime,
     const ShortcutFolder* existingFolder) const {
     // If we have an existing folder, try to reuse one of its shortcuts.
     if (existingFolder != nullptr) {
-        auto shortcut = existingFolder->shortcutOrNull(shortcutPath.filename().wstring());
+        auto shortcut = existingFolder->shortcutOrNull(shortcutPath.stem().wstring());
         if (shortcut != nullptr && shortcut->lastWriteTime() >= lastWriteTime) {
             // The file has not changed, so we can reuse the existing shortcut.
             return shortcut;
         }
     }
 
-    // Otherwise, load the shortcut from disk.
-    return shortcutFactory_->open(shortcutPath, lastWriteTime);
+    // Otherwise, it has to be opened again.
+    return nullptr;
 }
 
 ShortcutFactory* ShortcutManager::shortcutFactory() const noexcept {
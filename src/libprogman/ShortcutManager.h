@@ -1,6 +1,7 @@
 #pragma once
 
 #include "libprogman/pch.h"
+#include "libprogman/FolderWatcher.h"
 #include "libprogman/ShortcutFactory.h"
 #include "libprogman/ShortcutFolder.h"
 #include "libprogman/Shortcut.h"
@@ -36,6 +37,11 @@ class ShortcutManager {
     // Loads changes from disk.
     void refresh();
 
+    // Loads only what the changes from a FolderWatcher on the root path touched: a folder that was added, removed or
+    // renamed is read or dropped whole, and a .lnk file that changed is updated in its folder without reading the
+    // folder's other files. Falls back to refresh() for an overflow.
+    void applyChanges(const std::vector<FolderChange>& changes);
+
     // Gets the ShortcutFactory instance
     ShortcutFactory* shortcutFactory() const noexcept;
 
@@ -43,13 +49,16 @@ class ShortcutManager {
     void refreshCore();
     void setupInitialShortcuts();
     std::shared_ptr<ShortcutFolder> refreshFolder(std::filesystem::path folderPath) const;
-    std::shared_ptr<Shortcut> refreshShortcut(
-        std::filesystem::path shortcutPath,
+    std::shared_ptr<ShortcutFolder> refreshShortcuts(
+        const ShortcutFolder& folder,
+        const std::vector<std::filesystem::path>& shortcutPaths) const;
+    std::shared_ptr<Shortcut> reusableShortcut(
+        const std::filesystem::path& shortcutPath,
         std::filesystem::file_time_type lastWriteTime,
         const ShortcutFolder* existingFolder) const;
 
     std::wstring rootPath_;
-    immer::map<std::wstring, std::shared_ptr<ShortcutFolder>> folders_;  // Only updated in refresh()
+    immer::map<std::wstring, std::shared_ptr<ShortcutFolder>> folders_;  // Only updated under refreshMutex_
     ShortcutFactory* shortcutFactory_;
     std::mutex refreshMutex_;
 };
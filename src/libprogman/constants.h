@@ -14,4 +14,7 @@ constexpr UINT WM_DISPLAY_ERROR = WM_APP + 3;
 // ProgramManagerWindow: Sent from worker thread to UI thread to trigger sync of folder windows.
 constexpr UINT WM_SYNC_FOLDER_WINDOWS = WM_APP + 4;
 
+// FolderWindow, NewShortcutDialog: Posted from IconLoader threads when shortcut icons are ready to swap in.
+constexpr UINT WM_SHORTCUT_ICONS_LOADED = WM_APP + 5;
+
 }  // namespace libprogman
@@ -10,15 +10,24 @@
 // C++ Standard Library
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cwctype>
+#include <deque>
 #include <filesystem>
+#include <fstream>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <system_error>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -29,6 +38,7 @@
 // Immer
 #pragma warning(push)
 #pragma warning(disable : 4267)  // conversion from 'size_t' to 'immer::detail::rbts::count_t', possible loss of data
+#include <immer/algorithm.hpp>
 #include <immer/map_transient.hpp>
 #include <immer/map.hpp>
 #include <immer/vector_transient.hpp>
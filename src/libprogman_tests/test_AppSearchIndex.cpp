@@ -0,0 +1,111 @@
+#include "pch.h"
+#include "libprogman/AppSearchIndex.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace libprogman;
+
+namespace libprogman_tests {
+
+TEST_CLASS (AppSearchIndexTests) {
+    static immer::vector<std::shared_ptr<Shortcut>> NewApps(const std::vector<std::wstring>& names) {
+        auto apps = immer::vector<std::shared_ptr<Shortcut>>().transient();
+        for (const auto& name : names) {
+            apps.push_back(std::make_shared<Shortcut>(
+                L"C:\\Start Menu\\" + name + L".lnk", std::filesystem::file_time_type{}));
+        }
+        return apps.persistent();
+    }
+
+    static std::vector<std::wstring> Search(
+        AppSearchIndex* index,
+        const immer::vector<std::shared_ptr<Shortcut>>& apps,
+        const std::wstring& query) {
+        std::vector<std::wstring> names;
+        for (int app : index->search(query)) {
+            names.push_back(apps[app]->name());
+        }
+        return names;
+    }
+
+   public:
+    TEST_METHOD (EmptyQueryMatchesEverythingInOrder) {
+        auto apps = NewApps({ L"Calculator", L"Notepad", L"Paint" });
+        AppSearchIndex index(apps);
+
+        auto results = index.search(L"");
+        Assert::AreEqual(size_t(3), results.size());
+        Assert::AreEqual(0, results[0]);
+        Assert::AreEqual(1, results[1]);
+        Assert::AreEqual(2, results[2]);
+
+        Assert::AreEqual(size_t(3), index.search(L" - ").size());
+    }
+
+    TEST_METHOD (NamePrefixesRankAboveWordPrefixesAboveSubsequences) {
+        auto apps = NewApps({ L"Microsoft Word", L"Notepad", L"Windows Media Player", L"WordPad", L"Wild Ordered" });
+        AppSearchIndex index(apps);
+
+        auto results = Search(&index, apps, L"word");
+
+        Assert::AreEqual(size_t(3), results.size());
+        Assert::AreEqual(std::wstring(L"WordPad"), results[0]);
+        Assert::AreEqual(std::wstring(L"Microsoft Word"), results[1]);
+        Assert::AreEqual(std::wstring(L"Wild Ordered"), results[2]);
+    }
+
+    TEST_METHOD (CaseAndPunctuationAreIgnored) {
+        auto apps = NewApps({ L"Notepad++", L"Paint" });
+        AppSearchIndex index(apps);
+
+        Assert::AreEqual(size_t(1), index.search(L"NOTEPAD").size());
+        Assert::AreEqual(size_t(1), index.search(L"note pad").size());
+        Assert::AreEqual(size_t(1), index.search(L"notepad++").size());
+    }
+
+    TEST_METHOD (CapitalLettersAndDigitsStartWords) {
+        auto apps = NewApps({ L"Aardvark Shellfish", L"PowerShell 7", L"Python3.12" });
+        AppSearchIndex index(apps);
+
+        auto results = Search(&index, apps, L"shell");
+        Assert::AreEqual(size_t(2), results.size());
+        Assert::AreEqual(std::wstring(L"PowerShell 7"), results[0]);
+
+        results = Search(&index, apps, L"12");
+        Assert::AreEqual(size_t(1), results.size());
+        Assert::AreEqual(std::wstring(L"Python3.12"), results[0]);
+    }
+
+    TEST_METHOD (WordStartsScoreHigherInSubsequences) {
+        auto apps = NewApps({ L"Avast Secure Browser", L"Visual Studio Code" });
+        AppSearchIndex index(apps);
+
+        auto results = Search(&index, apps, L"vsc");
+
+        Assert::AreEqual(size_t(2), results.size());
+        Assert::AreEqual(std::wstring(L"Visual Studio Code"), results[0]);
+    }
+
+    TEST_METHOD (QueriesLongerThanTheTrieAreChecked) {
+        auto apps = NewApps({ L"Microsoft Visual Studio", L"Microsoft Visual Basic Studio" });
+        AppSearchIndex index(apps);
+
+        auto results = Search(&index, apps, L"visualstudio");
+
+        Assert::AreEqual(size_t(2), results.size());
+        Assert::AreEqual(std::wstring(L"Microsoft Visual Studio"), results[0]);
+    }
+
+    TEST_METHOD (ShorteningTheQueryFindsEverythingAgain) {
+        auto apps = NewApps({ L"Calculator", L"Camera", L"Clock" });
+        AppSearchIndex index(apps);
+
+        Assert::AreEqual(size_t(3), index.search(L"c").size());
+        Assert::AreEqual(size_t(2), index.search(L"ca").size());
+        Assert::AreEqual(size_t(1), index.search(L"cal").size());
+        Assert::AreEqual(size_t(2), index.search(L"ca").size());
+        Assert::AreEqual(size_t(2), index.search(L"cl").size());
+    }
+};
+
+}  // namespace libprogman_tests
@@ -45,20 +45,23 @@ class TestFolder {
 // Helper class to set up and wait for file change notifications
 class ChangeDetector {
    public:
-    ChangeDetector(const std::filesystem::path& folderPath)
+    ChangeDetector(const std::filesystem::path& folderPath, libprogman::FolderWatcherOptions options = {})
         : folderPath_(folderPath),
           watcher_(
               folderPath,
-              [this]() { this->onChangeDetected(); },
-              [](std::wstring errorMsg) { Logger::WriteMessage((L"Error in FolderWatcher: " + errorMsg).c_str()); }),
+              [this](const std::vector<libprogman::FolderChange>& changes) { this->onChangeDetected(changes); },
+              [](std::wstring errorMsg) { Logger::WriteMessage((L"Error in FolderWatcher: " + errorMsg).c_str()); },
+              options),
           changeDetected_(false) {
         // Allow watcher to initialize
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
 
-    void onChangeDetected() {
+    void onChangeDetected(const std::vector<libprogman::FolderChange>& changes) {
         std::lock_guard<std::mutex> lock(mutex_);
         changeDetected_ = true;
+        callbackCount_++;
+        changes_.insert(changes_.end(), changes.begin(), changes.end());
         cv_.notify_all();
     }
 
@@ -67,6 +70,31 @@ class ChangeDetector {
         return cv_.wait_for(lock, timeout, [this]() { return changeDetected_; });
     }
 
+    // Waits for a change of this kind to this path to be reported.
+    bool waitForChange(
+        libprogman::FolderChange::Kind kind,
+        const std::filesystem::path& path,
+        std::chrono::seconds timeout = std::chrono::seconds(5)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this, kind, &path]() {
+            return std::any_of(changes_.begin(), changes_.end(), [kind, &path](const libprogman::FolderChange& change) {
+                return change.kind == kind && change.path == path;
+            });
+        });
+    }
+
+    int callbackCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return callbackCount_;
+    }
+
+    size_t changeCount(libprogman::FolderChange::Kind kind, const std::filesystem::path& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::count_if(changes_.begin(), changes_.end(), [kind, &path](const libprogman::FolderChange& change) {
+            return change.kind == kind && change.path == path;
+        });
+    }
+
     void reset() {
         std::lock_guard<std::mutex> lock(mutex_);
         changeDetected_ = false;
@@ -76,6 +104,8 @@ class ChangeDetector {
     std::filesystem::path folderPath_;
     libprogman::FolderWatcher watcher_;
     bool changeDetected_;
+    int callbackCount_ = 0;
+    std::vector<libprogman::FolderChange> changes_;
     std::mutex mutex_;
     std::condition_variable cv_;
 };
@@ -222,6 +252,69 @@ TEST_CLASS (test_FolderWatcher) {
         bool changeDetected = detector.waitForChange();
         Assert::IsTrue(changeDetected, L"Folder deletion should be detected");
     }
+
+    TEST_METHOD (TestChangesReportKindAndPath) {
+        TestFolder testFolder;
+        std::filesystem::path subfolder = testFolder.path() / L"subfolder";
+        std::filesystem::create_directory(subfolder);
+        ChangeDetector detector(testFolder.path());
+
+        std::filesystem::path createdFile = subfolder / L"created.txt";
+        std::filesystem::path renamedFile = subfolder / L"renamed.txt";
+        {
+            std::ofstream file(createdFile.string());
+            file << "File content";
+        }
+        Assert::IsTrue(
+            detector.waitForChange(libprogman::FolderChange::Kind::kAdded, createdFile),
+            L"Creation should be reported with the file's full path");
+
+        std::filesystem::rename(createdFile, renamedFile);
+        Assert::IsTrue(detector.waitForChange(libprogman::FolderChange::Kind::kRenamedFrom, createdFile));
+        Assert::IsTrue(detector.waitForChange(libprogman::FolderChange::Kind::kRenamedTo, renamedFile));
+
+        std::filesystem::remove(renamedFile);
+        Assert::IsTrue(detector.waitForChange(libprogman::FolderChange::Kind::kRemoved, renamedFile));
+    }
+
+    TEST_METHOD (TestBurstIsReportedInOneCallback) {
+        TestFolder testFolder;
+        libprogman::FolderWatcherOptions options;
+        options.coalesceWindow = std::chrono::seconds(1);
+        ChangeDetector detector(testFolder.path(), options);
+
+        std::filesystem::path lastFile;
+        for (int i = 0; i < 20; i++) {
+            lastFile = testFolder.path() / (L"file" + std::to_wstring(i) + L".txt");
+            std::ofstream file(lastFile.string());
+            file << "File content";
+        }
+
+        Assert::IsTrue(detector.waitForChange(libprogman::FolderChange::Kind::kAdded, lastFile));
+        Assert::AreEqual(1, detector.callbackCount(), L"The whole burst should be reported at once");
+    }
+
+    TEST_METHOD (TestRepeatedWritesAreReportedOnce) {
+        TestFolder testFolder;
+        std::filesystem::path testFile = testFolder.path() / L"existingFile.txt";
+        {
+            std::ofstream file(testFile.string());
+            file << "Initial content";
+        }
+        libprogman::FolderWatcherOptions options;
+        options.coalesceWindow = std::chrono::seconds(1);
+        ChangeDetector detector(testFolder.path(), options);
+
+        {
+            std::ofstream file(testFile.string(), std::ios::app);
+            for (int i = 0; i < 10; i++) {
+                file << "More content" << std::flush;
+            }
+        }
+
+        Assert::IsTrue(detector.waitForChange(libprogman::FolderChange::Kind::kModified, testFile));
+        Assert::AreEqual(size_t(1), detector.changeCount(libprogman::FolderChange::Kind::kModified, testFile));
+    }
 };
 
 }  // namespace libprogman_tests
@@ -0,0 +1,145 @@
+#include "pch.h"
+#include "libprogman/IconLoader.h"
+#include "libprogman/Shortcut.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <condition_variable>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace libprogman;
+
+namespace libprogman_tests {
+
+TEST_CLASS (IconLoaderTests) {
+    // Counts onLoaded callbacks and lets a test wait for a number of them.
+    struct Callbacks {
+        std::mutex mutex;
+        std::condition_variable changed;
+        int count = 0;
+
+        std::function<void()> onLoaded() {
+            return [this]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                count++;
+                changed.notify_all();
+            };
+        }
+
+        void waitFor(int expected) {
+            std::unique_lock<std::mutex> lock(mutex);
+            bool done =
+                changed.wait_for(lock, std::chrono::seconds(10), [this, expected]() { return count >= expected; });
+            Assert::IsTrue(done, L"Timed out waiting for icons to load");
+        }
+    };
+
+    static std::vector<std::shared_ptr<Shortcut>> UnloadedShortcuts(int count) {
+        std::vector<std::shared_ptr<Shortcut>> shortcuts;
+        for (int i = 0; i < count; i++) {
+            shortcuts.push_back(std::make_shared<Shortcut>(
+                L"C:\\Shortcuts\\App" + std::to_wstring(i) + L".lnk", std::filesystem::file_time_type{}));
+        }
+        return shortcuts;
+    }
+
+   public:
+    TEST_METHOD (LoadsQueuedShortcutsAndCallsBackForEach) {
+        Callbacks callbacks;
+        IconLoader loader(
+            [](Shortcut* shortcut) { shortcut->finishLoading(wil::shared_hicon{}, L"C:\\App\\app.exe", L""); }, 2);
+
+        auto shortcuts = UnloadedShortcuts(10);
+        loader.load(shortcuts, callbacks.onLoaded());
+        callbacks.waitFor(10);
+
+        for (const auto& shortcut : shortcuts) {
+            Assert::IsTrue(shortcut->isLoaded());
+            Assert::AreEqual(std::wstring(L"C:\\App\\app.exe"), shortcut->target());
+        }
+    }
+
+    TEST_METHOD (SkipsShortcutsThatAreAlreadyLoaded) {
+        Callbacks callbacks;
+        std::atomic<int> loads{ 0 };
+        IconLoader loader(
+            [&loads](Shortcut* shortcut) {
+                loads++;
+                shortcut->finishLoading(wil::shared_hicon{}, L"", L"");
+            },
+            1);
+
+        auto shortcuts = UnloadedShortcuts(2);
+        shortcuts.push_back(std::make_shared<Shortcut>(
+            L"C:\\Shortcuts\\Loaded.lnk", wil::shared_hicon{}, std::filesystem::file_time_type{}));
+        loader.load(shortcuts, callbacks.onLoaded());
+        callbacks.waitFor(2);
+
+        // The same shortcuts queued again by a second window are already loaded.
+        loader.load(shortcuts, callbacks.onLoaded());
+        Assert::AreEqual(2, loads.load());
+    }
+
+    TEST_METHOD (PrioritizedShortcutsLoadFirst) {
+        Callbacks callbacks;
+        std::mutex mutex;
+        std::condition_variable released;
+        bool isReleased = false;
+        std::vector<std::wstring> order;
+
+        // The one thread holds on to the first shortcut until the rest are queued and prioritized.
+        IconLoader loader(
+            [&](Shortcut* shortcut) {
+                std::unique_lock<std::mutex> lock(mutex);
+                released.wait(lock, [&isReleased]() { return isReleased; });
+                order.push_back(shortcut->name());
+                shortcut->finishLoading(wil::shared_hicon{}, L"", L"");
+            },
+            1);
+
+        auto shortcuts = UnloadedShortcuts(6);
+        loader.load({ shortcuts[0] }, callbacks.onLoaded());
+        loader.load({ shortcuts.begin() + 1, shortcuts.end() }, callbacks.onLoaded());
+        loader.prioritize({ shortcuts[5].get(), shortcuts[3].get() });
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isReleased = true;
+        }
+        released.notify_all();
+        callbacks.waitFor(6);
+
+        // App0 may or may not have been taken off the queue before the rest arrived.
+        order.erase(std::remove(order.begin(), order.end(), L"App0"), order.end());
+        Assert::IsTrue((std::vector<std::wstring>{ L"App5", L"App3", L"App1", L"App2", L"App4" }) == order);
+    }
+
+    TEST_METHOD (ShortcutsThatFailToLoadAreLoadedWithoutAnIcon) {
+        Callbacks callbacks;
+        IconLoader loader([](Shortcut*) { throw std::runtime_error("Broken shortcut"); }, 1);
+
+        auto shortcuts = UnloadedShortcuts(1);
+        loader.load(shortcuts, callbacks.onLoaded());
+        callbacks.waitFor(1);
+
+        Assert::IsTrue(shortcuts[0]->isLoaded());
+        Assert::IsTrue(shortcuts[0]->icon().get() == nullptr);
+    }
+
+    TEST_METHOD (DestroyingTheLoaderDropsTheQueue) {
+        std::atomic<int> loads{ 0 };
+        auto shortcuts = UnloadedShortcuts(100);
+        {
+            IconLoader loader(
+                [&loads](Shortcut* shortcut) {
+                    loads++;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    shortcut->finishLoading(wil::shared_hicon{}, L"", L"");
+                },
+                1);
+            loader.load(shortcuts, []() {});
+        }
+
+        Assert::IsTrue(loads.load() < 100);
+    }
+};
+
+}  // namespace libprogman_tests
@@ -0,0 +1,117 @@
+#include "pch.h"
+#include "libprogman/IconStore.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace libprogman;
+
+namespace libprogman_tests {
+
+TEST_CLASS (IconStoreTests) {
+    // A 16x16 icon with an alpha channel.
+    static wil::unique_hicon CreateTestIcon() {
+        BITMAPINFO bitmapInfo = {};
+        bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bitmapInfo.bmiHeader.biWidth = 16;
+        bitmapInfo.bmiHeader.biHeight = -16;
+        bitmapInfo.bmiHeader.biPlanes = 1;
+        bitmapInfo.bmiHeader.biBitCount = 32;
+        bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+        void* bits = nullptr;
+        wil::unique_hbitmap color(CreateDIBSection(nullptr, &bitmapInfo, DIB_RGB_COLORS, &bits, nullptr, 0));
+        Assert::IsTrue(color && bits);
+
+        std::vector<uint8_t> maskBits(2 * 16, 0);
+        wil::unique_hbitmap mask(CreateBitmap(16, 16, 1, 1, maskBits.data()));
+        ICONINFO iconInfo = { TRUE, 0, 0, mask.get(), color.get() };
+        wil::unique_hicon icon(CreateIconIndirect(&iconInfo));
+        Assert::IsTrue(icon.is_valid());
+        return icon;
+    }
+
+   public:
+    TEST_METHOD (SameKeySharesOneIcon) {
+        IconStore store;
+        int loads = 0;
+        auto load = [&loads]() {
+            loads++;
+            return CreateTestIcon();
+        };
+
+        auto first = store.get({ L"C:\\App\\app.exe", 0, 32 }, load);
+        auto second = store.get({ L"C:\\App\\app.exe", 0, 32 }, load);
+
+        Assert::AreEqual(1, loads);
+        Assert::IsTrue(first.get() != nullptr);
+        Assert::IsTrue(first.get() == second.get());
+        Assert::AreEqual(size_t(1), store.size());
+    }
+
+    TEST_METHOD (DifferentIndexesAndSizesLoadSeparately) {
+        IconStore store;
+        int loads = 0;
+        auto load = [&loads]() {
+            loads++;
+            return CreateTestIcon();
+        };
+
+        auto icon = store.get({ L"C:\\App\\app.exe", 0, 32 }, load);
+        auto otherIndex = store.get({ L"C:\\App\\app.exe", 1, 32 }, load);
+        auto otherSize = store.get({ L"C:\\App\\app.exe", 0, 48 }, load);
+        auto fileIcon = store.get({ L"C:\\App\\app.exe", IconStore::kFileIconIndex, 32 }, load);
+
+        Assert::AreEqual(4, loads);
+        Assert::IsTrue(icon.get() != otherIndex.get());
+        Assert::IsTrue(icon.get() != otherSize.get());
+        Assert::IsTrue(icon.get() != fileIcon.get());
+        Assert::AreEqual(size_t(4), store.size());
+    }
+
+    TEST_METHOD (IconIsForgottenWhenTheLastReferenceIsReleased) {
+        IconStore store;
+        int loads = 0;
+        auto load = [&loads]() {
+            loads++;
+            return CreateTestIcon();
+        };
+
+        auto first = store.get({ L"C:\\App\\app.exe", 0, 32 }, load);
+        auto second = store.get({ L"C:\\App\\app.exe", 0, 32 }, load);
+        first.reset();
+        Assert::AreEqual(size_t(1), store.size());
+
+        second.reset();
+        Assert::AreEqual(size_t(0), store.size());
+
+        auto third = store.get({ L"C:\\App\\app.exe", 0, 32 }, load);
+        Assert::AreEqual(2, loads);
+        Assert::IsTrue(third.get() != nullptr);
+    }
+
+    TEST_METHOD (FailedLoadIsNotKept) {
+        IconStore store;
+        int loads = 0;
+        auto load = [&loads]() {
+            loads++;
+            return wil::unique_hicon();
+        };
+
+        Assert::IsTrue(store.get({ L"C:\\Missing.exe", 0, 32 }, load).get() == nullptr);
+        Assert::IsTrue(store.get({ L"C:\\Missing.exe", 0, 32 }, load).get() == nullptr);
+        Assert::AreEqual(2, loads);
+        Assert::AreEqual(size_t(0), store.size());
+    }
+
+    TEST_METHOD (ManyReleasedIconsDoNotAccumulate) {
+        IconStore store;
+        for (int i = 0; i < 1000; i++) {
+            store.get({ L"C:\\App" + std::to_wstring(i) + L".exe", 0, 32 }, CreateTestIcon);
+        }
+
+        auto kept = store.get({ L"C:\\Kept.exe", 0, 32 }, CreateTestIcon);
+        Assert::AreEqual(size_t(1), store.size());
+    }
+};
+
+}  // namespace libprogman_tests
@@ -4,6 +4,9 @@
 #include "libprogman/Shortcut.h"
 #include "libheirloom/cancel.h"
 #include "CppUnitTest.h"
+#include "test_util.h"
+#include <chrono>
+#include <fstream>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace libprogman;
@@ -12,6 +15,29 @@ using namespace libheirloom;
 namespace libprogman_tests {
 
 TEST_CLASS (InstalledAppListTests) {
+    // Loads shortcuts without reading them, counting the loads.
+    static InstalledAppList::LoadFunction CountingLoader(int* loads) {
+        return [loads](
+                   const std::filesystem::path& path, std::filesystem::file_time_type lastWriteTime, uintmax_t) {
+            (*loads)++;
+            return std::make_shared<Shortcut>(path, wil::shared_hicon{}, lastWriteTime);
+        };
+    }
+
+    static bool SameShortcuts(
+        const immer::vector<std::shared_ptr<Shortcut>>& a,
+        const immer::vector<std::shared_ptr<Shortcut>>& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i] != b[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
    public:
     TEST_METHOD (ConstructorInitializesFields) {
         ShortcutFactory factory;
@@ -153,6 +179,99 @@ TEST_CLASS (InstalledAppListTests) {
         // Clean up
         std::filesystem::remove_all(testDir);
     }
+
+    TEST_METHOD (ReloadsOnlyChangedShortcutsAndDropsRemovedOnes) {
+        auto testDir = std::filesystem::temp_directory_path() / L"InstalledAppListTest";
+        std::filesystem::remove_all(testDir);
+        std::filesystem::create_directories(testDir / L"Sub");
+        WriteFile(testDir / L"A.lnk");
+        WriteFile(testDir / L"Sub" / L"B.lnk");
+        WriteFile(testDir / L"C.lnk");
+        WriteFile(testDir / L"NotAShortcut.txt");
+
+        int loads = 0;
+        InstalledAppList appList(CountingLoader(&loads), { testDir });
+        CancellationToken token;
+
+        auto first = appList.apps(token);
+        Assert::AreEqual(3, loads);
+        Assert::AreEqual(size_t(3), first.size());
+        Assert::IsTrue(first[0]->name() < first[1]->name() && first[1]->name() < first[2]->name());
+
+        // Nothing changed: nothing is loaded, and the same shortcuts come back
+        auto second = appList.apps(token);
+        Assert::AreEqual(3, loads);
+        Assert::IsTrue(SameShortcuts(first, second));
+
+        // Only the shortcut written since is loaded again
+        auto bPath = testDir / L"Sub" / L"B.lnk";
+        std::filesystem::last_write_time(bPath, std::filesystem::last_write_time(bPath) + std::chrono::hours(1));
+        auto third = appList.apps(token);
+        Assert::AreEqual(4, loads);
+        Assert::AreEqual(size_t(3), third.size());
+
+        // A shortcut that was deleted is gone from the list
+        std::filesystem::remove(testDir / L"C.lnk");
+        auto fourth = appList.apps(token);
+        Assert::AreEqual(4, loads);
+        Assert::AreEqual(size_t(2), fourth.size());
+        for (const auto& app : fourth) {
+            Assert::IsTrue(app->path() != testDir / L"C.lnk");
+        }
+
+        std::filesystem::remove_all(testDir);
+    }
+
+    TEST_METHOD (RescansTenThousandShortcutsIncrementally) {
+        const int kFolders = 100;
+        const int kShortcutsPerFolder = 100;
+        auto testDir = std::filesystem::temp_directory_path() / L"InstalledAppListBenchmark";
+        std::filesystem::remove_all(testDir);
+        for (int i = 0; i < kFolders; i++) {
+            auto folder = testDir / (L"Folder" + std::to_wstring(i));
+            std::filesystem::create_directories(folder);
+            for (int j = 0; j < kShortcutsPerFolder; j++) {
+                WriteFile(folder / (L"App" + std::to_wstring(j) + L".lnk"));
+            }
+        }
+
+        int loads = 0;
+        InstalledAppList appList(CountingLoader(&loads), { testDir });
+        CancellationToken token;
+
+        auto start = std::chrono::steady_clock::now();
+        auto first = appList.apps(token);
+        auto full = std::chrono::steady_clock::now() - start;
+        Assert::AreEqual(kFolders * kShortcutsPerFolder, loads);
+        Assert::AreEqual(size_t(kFolders * kShortcutsPerFolder), first.size());
+
+        start = std::chrono::steady_clock::now();
+        auto second = appList.apps(token);
+        auto unchanged = std::chrono::steady_clock::now() - start;
+        Assert::AreEqual(kFolders * kShortcutsPerFolder, loads);
+        Assert::IsTrue(SameShortcuts(first, second));
+
+        // One shortcut changed in every folder
+        for (int i = 0; i < kFolders; i++) {
+            auto path = testDir / (L"Folder" + std::to_wstring(i)) / L"App0.lnk";
+            std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::hours(1));
+        }
+        start = std::chrono::steady_clock::now();
+        auto third = appList.apps(token);
+        auto changed = std::chrono::steady_clock::now() - start;
+        Assert::AreEqual(kFolders * kShortcutsPerFolder + kFolders, loads);
+        Assert::AreEqual(first.size(), third.size());
+
+        auto millis = [](std::chrono::steady_clock::duration d) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+        };
+        std::wstring message = std::to_wstring(first.size()) + L" shortcuts: first scan " +
+            std::to_wstring(millis(full)) + L" ms, unchanged rescan " + std::to_wstring(millis(unchanged)) +
+            L" ms, rescan with " + std::to_wstring(kFolders) + L" changed " + std::to_wstring(millis(changed)) + L" ms";
+        Logger::WriteMessage(message.c_str());
+
+        std::filesystem::remove_all(testDir);
+    }
 };
 
 }  // namespace libprogman_tests
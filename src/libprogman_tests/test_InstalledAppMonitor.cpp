@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "libprogman/InstalledAppMonitor.h"
+#include "libprogman/Shortcut.h"
+#include "CppUnitTest.h"
+#include "test_util.h"
+#include <chrono>
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace libprogman;
+
+namespace libprogman_tests {
+
+TEST_CLASS (InstalledAppMonitorTests) {
+    std::filesystem::path folderPath_;
+
+    // Loads a shortcut without reading it.
+    static std::shared_ptr<Shortcut> FakeLoad(
+        const std::filesystem::path& path,
+        std::filesystem::file_time_type lastWriteTime,
+        uintmax_t) {
+        return std::make_shared<Shortcut>(path, wil::shared_hicon{}, lastWriteTime);
+    }
+
+    // Waits for the monitor to have this many apps.
+    static bool WaitForAppCount(InstalledAppMonitor* monitor, size_t count) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            auto apps = monitor->apps();
+            if (apps && apps->size() == count) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        folderPath_ = std::filesystem::temp_directory_path() / L"InstalledAppMonitorTest";
+        std::filesystem::remove_all(folderPath_);
+        std::filesystem::create_directories(folderPath_);
+        WriteFile(folderPath_ / L"First.lnk");
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        std::filesystem::remove_all(folderPath_, ec);
+    }
+
+   public:
+    TEST_METHOD (ScansAtStartup) {
+        InstalledAppList appList(FakeLoad, { folderPath_ });
+        InstalledAppMonitor monitor(&appList, { folderPath_ }, std::chrono::milliseconds(50));
+
+        Assert::IsTrue(WaitForAppCount(&monitor, 1), L"The first scan should find the existing shortcut");
+    }
+
+    TEST_METHOD (ScansAgainWhenTheFolderChanges) {
+        InstalledAppList appList(FakeLoad, { folderPath_ });
+        InstalledAppMonitor monitor(&appList, { folderPath_ }, std::chrono::milliseconds(50));
+        Assert::IsTrue(WaitForAppCount(&monitor, 1));
+
+        WriteFile(folderPath_ / L"Second.lnk");
+
+        Assert::IsTrue(WaitForAppCount(&monitor, 2), L"A new shortcut should be found without asking");
+    }
+
+    TEST_METHOD (KeepsTheLastAppsWhenAScanFails) {
+        auto fail = std::make_shared<std::atomic<bool>>(false);
+        InstalledAppList appList(
+            [fail](
+                const std::filesystem::path& path, std::filesystem::file_time_type lastWriteTime, uintmax_t fileSize) {
+                if (*fail) {
+                    throw std::runtime_error("Scan failed");
+                }
+                return FakeLoad(path, lastWriteTime, fileSize);
+            },
+            { folderPath_ });
+        InstalledAppMonitor monitor(&appList, { folderPath_ }, std::chrono::milliseconds(50));
+        Assert::IsTrue(WaitForAppCount(&monitor, 1));
+
+        *fail = true;
+        WriteFile(folderPath_ / L"Second.lnk");
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        auto apps = monitor.apps();
+        Assert::IsTrue(apps.has_value());
+        Assert::AreEqual(size_t(1), apps->size());
+    }
+
+    TEST_METHOD (DestructorCancelsTheScanInProgress) {
+        // Enough slow shortcuts that the scan is still going when the monitor is destroyed
+        const int kShortcuts = 1000;
+        for (int i = 0; i < kShortcuts; i++) {
+            WriteFile(folderPath_ / (L"App" + std::to_wstring(i) + L".lnk"));
+        }
+
+        auto loads = std::make_shared<std::atomic<int>>(0);
+        InstalledAppList appList(
+            [loads](
+                const std::filesystem::path& path, std::filesystem::file_time_type lastWriteTime, uintmax_t fileSize) {
+                (*loads)++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                return FakeLoad(path, lastWriteTime, fileSize);
+            },
+            { folderPath_ });
+
+        {
+            InstalledAppMonitor monitor(&appList, { folderPath_ });
+            while (*loads == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            Assert::IsFalse(monitor.apps().has_value());
+        }
+
+        Assert::IsTrue(*loads < kShortcuts, L"The scan should stop between shortcuts once cancelled");
+    }
+};
+
+}  // namespace libprogman_tests
@@ -0,0 +1,185 @@
+#include "pch.h"
+#include "libprogman/ShortcutCache.h"
+#include "CppUnitTest.h"
+#include "test_util.h"
+#include <chrono>
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace libprogman;
+
+namespace libprogman_tests {
+
+TEST_CLASS (ShortcutCacheTests) {
+    std::filesystem::path testDir_;
+    std::filesystem::path cacheFilePath_;
+    std::filesystem::path lnkPath_;
+    std::filesystem::file_time_type lastWriteTime_;
+    uintmax_t fileSize_;
+
+    // A 32x32 icon with an alpha channel.
+    static wil::unique_hicon CreateTestIcon() {
+        BITMAPINFO bitmapInfo = {};
+        bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bitmapInfo.bmiHeader.biWidth = 32;
+        bitmapInfo.bmiHeader.biHeight = -32;
+        bitmapInfo.bmiHeader.biPlanes = 1;
+        bitmapInfo.bmiHeader.biBitCount = 32;
+        bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+        void* bits = nullptr;
+        wil::unique_hbitmap color(CreateDIBSection(nullptr, &bitmapInfo, DIB_RGB_COLORS, &bits, nullptr, 0));
+        Assert::IsTrue(color && bits);
+        auto* pixels = static_cast<uint32_t*>(bits);
+        for (int i = 0; i < 32 * 32; i++) {
+            pixels[i] = (static_cast<uint32_t>(i / 4) << 24) | 0x00204080;
+        }
+
+        std::vector<uint8_t> maskBits(4 * 32, 0);
+        wil::unique_hbitmap mask(CreateBitmap(32, 32, 1, 1, maskBits.data()));
+        ICONINFO iconInfo = { TRUE, 0, 0, mask.get(), color.get() };
+        wil::unique_hicon icon(CreateIconIndirect(&iconInfo));
+        Assert::IsTrue(icon.is_valid());
+        return icon;
+    }
+
+    static int IconWidth(HICON icon) {
+        ICONINFO iconInfo = {};
+        Assert::IsTrue(GetIconInfo(icon, &iconInfo) != FALSE);
+        wil::unique_hbitmap color(iconInfo.hbmColor);
+        wil::unique_hbitmap mask(iconInfo.hbmMask);
+        BITMAP bitmap = {};
+        GetObjectW(color.get(), sizeof(bitmap), &bitmap);
+        return bitmap.bmWidth;
+    }
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        testDir_ = std::filesystem::temp_directory_path() / L"ShortcutCacheTest";
+        std::filesystem::remove_all(testDir_);
+        std::filesystem::create_directories(testDir_);
+        cacheFilePath_ = testDir_ / L"shortcut_cache.bin";
+
+        lnkPath_ = testDir_ / L"App.lnk";
+        WriteFile(lnkPath_, "lnk");
+        lastWriteTime_ = std::filesystem::last_write_time(lnkPath_);
+        fileSize_ = std::filesystem::file_size(lnkPath_);
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        std::filesystem::remove_all(testDir_, ec);
+    }
+
+   public:
+    TEST_METHOD (StoredEntryIsFoundAfterSaveAndReload) {
+        auto icon = CreateTestIcon();
+        {
+            ShortcutCache cache(cacheFilePath_);
+            cache.store(lnkPath_, lastWriteTime_, fileSize_, 32, L"C:\\App\\app.exe", L"/start", icon.get());
+            cache.save();
+        }
+
+        ShortcutCache cache(cacheFilePath_);
+        auto entry = cache.find(lnkPath_, lastWriteTime_, fileSize_, 32);
+
+        Assert::IsTrue(entry.has_value());
+        Assert::AreEqual(std::wstring(L"C:\\App\\app.exe"), entry->target);
+        Assert::AreEqual(std::wstring(L"/start"), entry->arguments);
+        Assert::IsTrue(entry->icon.get() != nullptr);
+        Assert::AreEqual(32, IconWidth(entry->icon.get()));
+    }
+
+    TEST_METHOD (ChangedFileIsNotFound) {
+        auto icon = CreateTestIcon();
+        ShortcutCache cache(cacheFilePath_);
+        cache.store(lnkPath_, lastWriteTime_, fileSize_, 32, L"C:\\App\\app.exe", L"", icon.get());
+
+        Assert::IsFalse(cache.find(lnkPath_, lastWriteTime_ + std::chrono::seconds(1), fileSize_, 32).has_value());
+        Assert::IsFalse(cache.find(lnkPath_, lastWriteTime_, fileSize_ + 1, 32).has_value());
+        Assert::IsFalse(cache.find(testDir_ / L"Other.lnk", lastWriteTime_, fileSize_, 32).has_value());
+        Assert::IsTrue(cache.find(lnkPath_, lastWriteTime_, fileSize_, 32).has_value());
+    }
+
+    TEST_METHOD (IconsAreCachedPerSize) {
+        auto icon = CreateTestIcon();
+        ShortcutCache cache(cacheFilePath_);
+        cache.store(lnkPath_, lastWriteTime_, fileSize_, 32, L"C:\\App\\app.exe", L"", icon.get());
+
+        Assert::IsFalse(cache.find(lnkPath_, lastWriteTime_, fileSize_, 48).has_value());
+
+        cache.store(lnkPath_, lastWriteTime_, fileSize_, 48, L"C:\\App\\app.exe", L"", icon.get());
+        Assert::IsTrue(cache.find(lnkPath_, lastWriteTime_, fileSize_, 32).has_value());
+        Assert::IsTrue(cache.find(lnkPath_, lastWriteTime_, fileSize_, 48).has_value());
+    }
+
+    TEST_METHOD (DamagedFileIsIgnored) {
+        auto icon = CreateTestIcon();
+        {
+            ShortcutCache cache(cacheFilePath_);
+            cache.store(lnkPath_, lastWriteTime_, fileSize_, 32, L"C:\\App\\app.exe", L"", icon.get());
+            cache.save();
+        }
+
+        // Cut the file off partway through the icon's pixels.
+        std::filesystem::resize_file(cacheFilePath_, std::filesystem::file_size(cacheFilePath_) - 100);
+
+        ShortcutCache cache(cacheFilePath_);
+        Assert::IsFalse(cache.find(lnkPath_, lastWriteTime_, fileSize_, 32).has_value());
+
+        cache.store(lnkPath_, lastWriteTime_, fileSize_, 32, L"C:\\App\\app.exe", L"", icon.get());
+        cache.save();
+        Assert::IsTrue(ShortcutCache(cacheFilePath_).find(lnkPath_, lastWriteTime_, fileSize_, 32).has_value());
+    }
+
+    TEST_METHOD (EntriesWithTheSameIconSourceShareOneIcon) {
+        auto icon = CreateTestIcon();
+        auto otherLnkPath = testDir_ / L"Other.lnk";
+        WriteFile(otherLnkPath, "lnk");
+        auto otherLastWriteTime = std::filesystem::last_write_time(otherLnkPath);
+        {
+            ShortcutCache cache(cacheFilePath_);
+            cache.store(
+                lnkPath_, lastWriteTime_, fileSize_, 32, L"C:\\App\\app.exe", L"", icon.get(), L"C:\\App\\app.exe", 0);
+            cache.store(
+                otherLnkPath, otherLastWriteTime, fileSize_, 32, L"C:\\App\\app.exe", L"/other", icon.get(),
+                L"C:\\App\\app.exe", 0);
+            cache.save();
+        }
+
+        IconStore iconStore;
+        ShortcutCache cache(cacheFilePath_, &iconStore);
+        auto entry = cache.find(lnkPath_, lastWriteTime_, fileSize_, 32);
+        auto otherEntry = cache.find(otherLnkPath, otherLastWriteTime, fileSize_, 32);
+
+        Assert::IsTrue(entry.has_value() && otherEntry.has_value());
+        Assert::IsTrue(entry->icon.get() != nullptr);
+        Assert::IsTrue(entry->icon.get() == otherEntry->icon.get());
+        Assert::AreEqual(std::wstring(L"/other"), otherEntry->arguments);
+    }
+
+    TEST_METHOD (SaveDropsUnusedEntriesForDeletedFiles) {
+        auto icon = CreateTestIcon();
+        auto goneLnkPath = testDir_ / L"Gone.lnk";
+        WriteFile(goneLnkPath, "lnk");
+        auto goneLastWriteTime = std::filesystem::last_write_time(goneLnkPath);
+        {
+            ShortcutCache cache(cacheFilePath_);
+            cache.store(lnkPath_, lastWriteTime_, fileSize_, 32, L"C:\\App\\app.exe", L"", icon.get());
+            cache.store(goneLnkPath, goneLastWriteTime, fileSize_, 32, L"C:\\Gone\\gone.exe", L"", icon.get());
+            cache.save();
+        }
+
+        // Saving again after the file is deleted keeps only the entry whose .lnk is still there.
+        std::filesystem::remove(goneLnkPath);
+        {
+            ShortcutCache cache(cacheFilePath_);
+            cache.save();
+        }
+
+        ShortcutCache cache(cacheFilePath_);
+        Assert::IsTrue(cache.find(lnkPath_, lastWriteTime_, fileSize_, 32).has_value());
+        Assert::IsFalse(cache.find(goneLnkPath, goneLastWriteTime, fileSize_, 32).has_value());
+    }
+};
+
+}  // namespace libprogman_tests
@@ -0,0 +1,76 @@
+#include "pch.h"
+#include "libprogman/ShortcutFolder.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace libprogman;
+
+namespace libprogman_tests {
+
+TEST_CLASS (ShortcutFolderTests) {
+    using ShortcutMap = immer::map<std::wstring, std::shared_ptr<Shortcut>>;
+
+    static std::shared_ptr<Shortcut> NewShortcut(const std::wstring& name) {
+        return std::make_shared<Shortcut>(L"C:\\Shortcuts\\Main\\" + name + L".lnk", std::filesystem::file_time_type{});
+    }
+
+   public:
+    TEST_METHOD (DiffOfTheSameMapIsEmpty) {
+        auto app = NewShortcut(L"App");
+        ShortcutMap shortcuts = ShortcutMap().set(L"App", app);
+
+        auto diff = ShortcutFolder::diff(shortcuts, shortcuts);
+
+        Assert::IsTrue(diff.added.empty());
+        Assert::IsTrue(diff.removed.empty());
+        Assert::IsTrue(diff.changed.empty());
+    }
+
+    TEST_METHOD (DiffFindsAddedRemovedAndChangedShortcuts) {
+        auto kept = NewShortcut(L"Kept");
+        auto removed = NewShortcut(L"Removed");
+        auto oldChanged = NewShortcut(L"Changed");
+        auto newChanged = NewShortcut(L"Changed");
+        auto added = NewShortcut(L"Added");
+
+        ShortcutMap before = ShortcutMap().set(L"Kept", kept).set(L"Removed", removed).set(L"Changed", oldChanged);
+        ShortcutMap after = before.erase(L"Removed").set(L"Changed", newChanged).set(L"Added", added);
+
+        auto diff = ShortcutFolder::diff(before, after);
+
+        Assert::AreEqual(size_t(1), diff.added.size());
+        Assert::IsTrue(diff.added[0] == added);
+        Assert::AreEqual(size_t(1), diff.removed.size());
+        Assert::IsTrue(diff.removed[0] == removed);
+        Assert::AreEqual(size_t(1), diff.changed.size());
+        Assert::IsTrue(diff.changed[0].first == oldChanged);
+        Assert::IsTrue(diff.changed[0].second == newChanged);
+    }
+
+    TEST_METHOD (DiffFromEmptyAddsEverything) {
+        ShortcutMap after = ShortcutMap().set(L"One", NewShortcut(L"One")).set(L"Two", NewShortcut(L"Two"));
+
+        auto diff = ShortcutFolder::diff(ShortcutMap(), after);
+
+        Assert::AreEqual(size_t(2), diff.added.size());
+        Assert::IsTrue(diff.removed.empty());
+        Assert::IsTrue(diff.changed.empty());
+    }
+
+    TEST_METHOD (ShortcutsRebuiltFromTheSameObjectsAreUnchanged) {
+        auto one = NewShortcut(L"One");
+        auto two = NewShortcut(L"Two");
+
+        // ShortcutManager builds each version of a folder from scratch, reusing Shortcut objects for unchanged files.
+        ShortcutMap before = ShortcutMap().set(L"One", one).set(L"Two", two);
+        ShortcutMap after = ShortcutMap().set(L"Two", two).set(L"One", one);
+
+        auto diff = ShortcutFolder::diff(before, after);
+
+        Assert::IsTrue(diff.added.empty());
+        Assert::IsTrue(diff.removed.empty());
+        Assert::IsTrue(diff.changed.empty());
+    }
+};
+
+}  // namespace libprogman_tests
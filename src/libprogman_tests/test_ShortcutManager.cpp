@@ -0,0 +1,136 @@
+#include "pch.h"
+#include "libprogman/ShortcutManager.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace libprogman;
+
+namespace libprogman_tests {
+
+TEST_CLASS (ShortcutManagerTests) {
+    std::filesystem::path rootPath_;
+    std::filesystem::path mainPath_;
+    std::filesystem::path otherPath_;
+
+    // openDeferred() doesn't read the .lnk file, so any file with the extension will do.
+    static void WriteShortcut(const std::filesystem::path& path) {
+        std::ofstream file(path, std::ios::binary);
+        Assert::IsTrue(file.is_open(), L"Failed to create test file");
+        file << "lnk";
+    }
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        rootPath_ = std::filesystem::temp_directory_path() / L"ShortcutManagerTest";
+        std::filesystem::remove_all(rootPath_);
+        mainPath_ = rootPath_ / L"Main";
+        otherPath_ = rootPath_ / L"Other";
+        std::filesystem::create_directories(mainPath_);
+        std::filesystem::create_directories(otherPath_);
+        WriteShortcut(mainPath_ / L"First.lnk");
+        WriteShortcut(mainPath_ / L"Second.lnk");
+        WriteShortcut(otherPath_ / L"Third.lnk");
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        std::filesystem::remove_all(rootPath_, ec);
+    }
+
+   public:
+    TEST_METHOD (AddedShortcutIsOpenedAndTheRestAreKept) {
+        ShortcutFactory factory;
+        ShortcutManager manager(rootPath_.wstring(), &factory);
+        auto first = manager.folder(L"Main")->shortcut(L"First");
+        auto other = manager.folder(L"Other");
+
+        WriteShortcut(mainPath_ / L"New.lnk");
+        manager.applyChanges({ { FolderChange::Kind::kAdded, mainPath_ / L"New.lnk" } });
+
+        auto main = manager.folder(L"Main");
+        Assert::AreEqual(size_t(3), main->shortcuts().size());
+        Assert::IsTrue(main->shortcutOrNull(L"New") != nullptr);
+        Assert::IsTrue(main->shortcut(L"First") == first);
+        Assert::IsTrue(manager.folder(L"Other") == other);
+    }
+
+    TEST_METHOD (RemovedAndRenamedShortcutsAreUpdated) {
+        ShortcutFactory factory;
+        ShortcutManager manager(rootPath_.wstring(), &factory);
+
+        std::filesystem::remove(mainPath_ / L"First.lnk");
+        std::filesystem::rename(mainPath_ / L"Second.lnk", mainPath_ / L"Renamed.lnk");
+        manager.applyChanges({
+            { FolderChange::Kind::kRemoved, mainPath_ / L"First.lnk" },
+            { FolderChange::Kind::kRenamedFrom, mainPath_ / L"Second.lnk" },
+            { FolderChange::Kind::kRenamedTo, mainPath_ / L"Renamed.lnk" },
+        });
+
+        auto main = manager.folder(L"Main");
+        Assert::AreEqual(size_t(1), main->shortcuts().size());
+        Assert::IsTrue(main->shortcutOrNull(L"Renamed") != nullptr);
+    }
+
+    TEST_METHOD (ModifiedShortcutIsReopened) {
+        ShortcutFactory factory;
+        ShortcutManager manager(rootPath_.wstring(), &factory);
+        auto first = manager.folder(L"Main")->shortcut(L"First");
+        auto second = manager.folder(L"Main")->shortcut(L"Second");
+
+        auto path = mainPath_ / L"First.lnk";
+        std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::hours(1));
+        manager.applyChanges({ { FolderChange::Kind::kModified, path } });
+
+        auto main = manager.folder(L"Main");
+        Assert::IsTrue(main->shortcut(L"First") != first);
+        Assert::IsTrue(main->shortcut(L"Second") == second);
+    }
+
+    TEST_METHOD (AddedAndRemovedFoldersAreReadWhole) {
+        ShortcutFactory factory;
+        ShortcutManager manager(rootPath_.wstring(), &factory);
+        auto main = manager.folder(L"Main");
+
+        auto gamesPath = rootPath_ / L"Games";
+        std::filesystem::create_directory(gamesPath);
+        WriteShortcut(gamesPath / L"Solitaire.lnk");
+        std::filesystem::remove_all(otherPath_);
+        manager.applyChanges({
+            { FolderChange::Kind::kAdded, gamesPath },
+            { FolderChange::Kind::kAdded, gamesPath / L"Solitaire.lnk" },
+            { FolderChange::Kind::kRemoved, otherPath_ / L"Third.lnk" },
+            { FolderChange::Kind::kRemoved, otherPath_ },
+        });
+
+        Assert::IsTrue(manager.folderOrNull(L"Games") != nullptr);
+        Assert::IsTrue(manager.folder(L"Games")->shortcutOrNull(L"Solitaire") != nullptr);
+        Assert::IsTrue(manager.folderOrNull(L"Other") == nullptr);
+        Assert::IsTrue(manager.folder(L"Main") == main);
+    }
+
+    TEST_METHOD (FilesThatAreNotShortcutsAreIgnored) {
+        ShortcutFactory factory;
+        ShortcutManager manager(rootPath_.wstring(), &factory);
+        auto main = manager.folder(L"Main");
+
+        manager.applyChanges({
+            { FolderChange::Kind::kModified, mainPath_ / L"window.ini" },
+            { FolderChange::Kind::kModified, mainPath_ },
+        });
+
+        Assert::IsTrue(manager.folder(L"Main") == main);
+    }
+
+    TEST_METHOD (OverflowRereadsEverything) {
+        ShortcutFactory factory;
+        ShortcutManager manager(rootPath_.wstring(), &factory);
+
+        WriteShortcut(otherPath_ / L"Unreported.lnk");
+        manager.applyChanges({ { FolderChange::Kind::kOverflow, {} } });
+
+        Assert::IsTrue(manager.folder(L"Other")->shortcutOrNull(L"Unreported") != nullptr);
+    }
+};
+
+}  // namespace libprogman_tests
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "CppUnitTest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace libprogman_tests {
+
+// Creates the file at path, or replaces it, holding contents.
+inline void WriteFile(const std::filesystem::path& path, const std::string& contents = std::string()) {
+    std::ofstream file(path, std::ios::binary);
+    Microsoft::VisualStudio::CppUnitTestFramework::Assert::IsTrue(file.is_open(), L"Failed to create test file");
+    file.write(contents.data(), contents.size());
+}
+
+}  // namespace libprogman_tests
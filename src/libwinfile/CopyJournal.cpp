@@ -0,0 +1,217 @@
+#include "libwinfile/pch.h"
+#include "CopyJournal.h"
+#include "PathCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+
+namespace libwinfile {
+
+namespace {
+
+// One record per line, fields separated by tabs, paths in UTF-8, the path last so that nothing in it is mistaken for
+// a separator:
+//
+//   heirloom copy journal 1
+//   from <sources>
+//   to <destination>
+//   done <destination file>
+//   partial <source size> <source last write time> <offset> <destination file>
+//
+// A partial record at offset 0 clears the one before it.
+constexpr char kHeader[] = "heirloom copy journal 1";
+constexpr char kFrom[] = "from";
+constexpr char kTo[] = "to";
+constexpr char kDone[] = "done";
+constexpr char kPartial[] = "partial";
+
+std::string toUtf8(const std::wstring& text) {
+    return std::filesystem::path(text).u8string();
+}
+
+std::wstring fromUtf8(const std::string& text) {
+    return std::filesystem::u8path(text).wstring();
+}
+
+// Splits line into at most count fields; the last takes the rest of the line, tabs and all.
+std::vector<std::string> split(const std::string& line, size_t count) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (fields.size() + 1 < count) {
+        size_t tab = line.find('\t', start);
+        if (tab == std::string::npos) {
+            break;
+        }
+        fields.push_back(line.substr(start, tab - start));
+        start = tab + 1;
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+}
+
+uint64_t toNumber(const std::string& text) {
+    return std::strtoull(text.c_str(), nullptr, 10);
+}
+
+}  // namespace
+
+CopyJournal::CopyJournal(const std::filesystem::path& path, const std::wstring& from, const std::wstring& to)
+    : path_(path), from_(from), to_(to) {
+    file_.open(path_, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        throw std::runtime_error("Failed to create the copy journal.");
+    }
+    append(kHeader);
+    append(std::string(kFrom) + '\t' + toUtf8(from_));
+    append(std::string(kTo) + '\t' + toUtf8(to_));
+}
+
+CopyJournal::CopyJournal(const std::filesystem::path& path) : path_(path) {
+    std::string contents;
+    {
+        std::ifstream in(path_, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Failed to open the copy journal.");
+        }
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Only whole lines count; anything after the last newline was cut off mid-write.
+    std::vector<std::string> lines;
+    size_t start = 0;
+    for (size_t end; (end = contents.find('\n', start)) != std::string::npos; start = end + 1) {
+        lines.push_back(contents.substr(start, end - start));
+    }
+
+    if (lines.size() < 3 || lines[0] != kHeader) {
+        throw std::runtime_error("Not a copy journal.");
+    }
+    auto from = split(lines[1], 2);
+    auto to = split(lines[2], 2);
+    if (from.size() != 2 || from[0] != kFrom || to.size() != 2 || to[0] != kTo) {
+        throw std::runtime_error("Not a copy journal.");
+    }
+    from_ = fromUtf8(from[1]);
+    to_ = fromUtf8(to[1]);
+
+    for (size_t i = 3; i < lines.size(); i++) {
+        apply(lines[i]);
+    }
+
+    // A torn record is cut off, so that the next one starts on a line of its own.
+    if (start != contents.size()) {
+        std::error_code error;
+        std::filesystem::resize_file(path_, start, error);
+    }
+    file_.open(path_, std::ios::binary | std::ios::app);
+    if (!file_) {
+        throw std::runtime_error("Failed to open the copy journal.");
+    }
+}
+
+void CopyJournal::recordDone(const std::wstring& destination) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[pathKey(destination)].done = true;
+    append(std::string(kDone) + '\t' + toUtf8(destination));
+}
+
+void CopyJournal::recordPartial(const std::wstring& destination, Source source, uint64_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = entries_[pathKey(destination)];
+    entry.destination = destination;
+    entry.done = false;
+    entry.source = source;
+    entry.offset = offset;
+    append(
+        std::string(kPartial) + '\t' + std::to_string(source.size) + '\t' + std::to_string(source.lastWriteTime) +
+        '\t' + std::to_string(offset) + '\t' + toUtf8(destination));
+}
+
+void CopyJournal::clearPartial(const std::wstring& destination) {
+    recordPartial(destination, Source{}, 0);
+}
+
+bool CopyJournal::isDone(const std::wstring& destination) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(pathKey(destination));
+    return it != entries_.end() && it->second.done;
+}
+
+bool CopyJournal::partial(const std::wstring& destination, Source* source, uint64_t* offset) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(pathKey(destination));
+    if (it == entries_.end() || it->second.done || it->second.offset == 0) {
+        return false;
+    }
+    *source = it->second.source;
+    *offset = it->second.offset;
+    return true;
+}
+
+std::vector<std::wstring> CopyJournal::partialDestinations() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::wstring> destinations;
+    for (auto& entry : entries_) {
+        if (!entry.second.done && entry.second.offset) {
+            destinations.push_back(entry.second.destination);
+        }
+    }
+    return destinations;
+}
+
+void CopyJournal::remove() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.close();
+    std::error_code error;
+    std::filesystem::remove(path_, error);
+}
+
+std::vector<std::filesystem::path> CopyJournal::list(const std::filesystem::path& directory) {
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> journals;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        if (it->path().extension() == kExtension) {
+            std::error_code timeError;
+            journals.emplace_back(it->last_write_time(timeError), it->path());
+        }
+    }
+    std::sort(journals.begin(), journals.end());
+
+    std::vector<std::filesystem::path> paths;
+    for (auto& journal : journals) {
+        paths.push_back(std::move(journal.second));
+    }
+    return paths;
+}
+
+void CopyJournal::append(const std::string& line) {
+    // A journal that can no longer be written only means less can be resumed; the copy itself goes on.
+    if (file_.is_open()) {
+        file_ << line << '\n';
+        file_.flush();
+    }
+}
+
+void CopyJournal::apply(const std::string& line) {
+    auto kind = split(line, 2);
+    if (kind[0] == kDone) {
+        if (kind.size() == 2) {
+            entries_[pathKey(fromUtf8(kind[1]))].done = true;
+        }
+    } else if (kind[0] == kPartial) {
+        auto fields = split(line, 5);
+        if (fields.size() == 5) {
+            auto destination = fromUtf8(fields[4]);
+            auto& entry = entries_[pathKey(destination)];
+            entry.destination = destination;
+            entry.done = false;
+            entry.source.size = toNumber(fields[1]);
+            entry.source.lastWriteTime = toNumber(fields[2]);
+            entry.offset = toNumber(fields[3]);
+        }
+    }
+}
+
+}  // namespace libwinfile
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libwinfile {
+
+// A record, kept on disk as a copy job runs, of what it was asked to copy and how far it got, so that a job cut short
+// by the app closing or the network dropping can be resumed rather than started over. Each record is appended and
+// flushed as it is made; a record torn by a crash is ignored when the journal is read back.
+//
+// Files are recorded by destination path. A finished file is marked done; a huge file part way through has the offset
+// up to which its destination is known to be written, with the size and last write time its source had then, since a
+// source that has changed since must be copied again from the start. Thread-safe.
+class CopyJournal {
+   public:
+    static constexpr wchar_t kExtension[] = L".journal";
+
+    // The version of a source file that a partial copy was taken from. lastWriteTime is in FILETIME units.
+    struct Source {
+        uint64_t size = 0;
+        uint64_t lastWriteTime = 0;
+    };
+
+    // Starts a new journal at path for a job copying from, a list of sources, to to. Throws std::runtime_error if the
+    // file cannot be created.
+    CopyJournal(const std::filesystem::path& path, const std::wstring& from, const std::wstring& to);
+
+    // Reads back the journal at path, to add to as the job resumes. Throws std::runtime_error if it cannot be read or
+    // is not a journal.
+    explicit CopyJournal(const std::filesystem::path& path);
+
+    CopyJournal(const CopyJournal&) = delete;
+    CopyJournal& operator=(const CopyJournal&) = delete;
+
+    const std::filesystem::path& path() const { return path_; }
+    const std::wstring& from() const { return from_; }
+    const std::wstring& to() const { return to_; }
+
+    void recordDone(const std::wstring& destination);
+    void recordPartial(const std::wstring& destination, Source source, uint64_t offset);
+
+    // Drops the partial record for destination, whose source has changed since, so the copy starts over.
+    void clearPartial(const std::wstring& destination);
+
+    bool isDone(const std::wstring& destination) const;
+
+    // Copies the partial record for destination into *source and *offset. Returns false if there is none.
+    bool partial(const std::wstring& destination, Source* source, uint64_t* offset) const;
+
+    // The destinations with partial records, which are left half written if the job is not resumed.
+    std::vector<std::wstring> partialDestinations() const;
+
+    // Closes and deletes the journal once the job is over.
+    void remove();
+
+    // The journals in directory, oldest first, such as those left by jobs that did not finish.
+    static std::vector<std::filesystem::path> list(const std::filesystem::path& directory);
+
+   private:
+    struct Entry {
+        std::wstring destination;
+        bool done = false;
+        Source source;
+        uint64_t offset = 0;
+    };
+
+    void append(const std::string& line);
+    void apply(const std::string& line);
+
+    std::filesystem::path path_;
+    std::wstring from_;
+    std::wstring to_;
+    mutable std::mutex mutex_;
+    std::ofstream file_;
+    std::unordered_map<std::wstring, Entry> entries_;  // By pathKey().
+};
+
+}  // namespace libwinfile
@@ -0,0 +1,111 @@
+#include "libwinfile/pch.h"
+#include "CopyPipeline.h"
+
+namespace libwinfile {
+
+CopyPipeline::CopyPipeline(size_t threadCount, CopyFunction copyFile, size_t queueCapacity)
+    : copyFile_(std::move(copyFile)), queueCapacity_(queueCapacity), stopping_(false), running_(0) {
+    if (!copyFile_) {
+        throw std::invalid_argument("CopyPipeline requires a copy function.");
+    }
+    if (queueCapacity_ == 0) {
+        queueCapacity_ = 1;
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+CopyPipeline::~CopyPipeline() {
+    cancel();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void CopyPipeline::enqueue(const std::wstring& from, const std::wstring& to, uint64_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return queue_.size() < queueCapacity_; });
+
+    std::wstring key = pathKey(to);
+    targets_[key]++;
+    queue_.push_back(Request{from, to, size, std::move(key)});
+    lock.unlock();
+    work_.notify_one();
+}
+
+void CopyPipeline::waitFor(const std::wstring& path) {
+    std::wstring key = pathKey(path);
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this, &key]() { return targets_.find(key) == targets_.end(); });
+}
+
+void CopyPipeline::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return queue_.empty() && running_ == 0; });
+}
+
+void CopyPipeline::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& request : queue_) {
+            release(request.key);
+        }
+        queue_.clear();
+    }
+    done_.notify_all();
+}
+
+bool CopyPipeline::busy() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !queue_.empty() || running_ != 0;
+}
+
+std::vector<CopyResult> CopyPipeline::takeFinished() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<CopyResult> results;
+    results.swap(finished_);
+    return results;
+}
+
+void CopyPipeline::release(const std::wstring& key) {
+    auto it = targets_.find(key);
+    if (--it->second == 0) {
+        targets_.erase(it);
+    }
+}
+
+void CopyPipeline::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        work_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+
+        Request request = std::move(queue_.front());
+        queue_.pop_front();
+        running_++;
+        lock.unlock();
+        done_.notify_all();
+
+        uint32_t error = copyFile_(request.from, request.to, request.size);
+
+        lock.lock();
+        running_--;
+        release(request.key);
+        finished_.push_back(CopyResult{std::move(request.from), std::move(request.to), request.size, error});
+        done_.notify_all();
+    }
+}
+
+}  // namespace libwinfile
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "PathCache.h"
+
+namespace libwinfile {
+
+// A file copy that a worker has finished, successfully or not.
+struct CopyResult {
+    std::wstring from;
+    std::wstring to;
+    uint64_t size;   // As given to enqueue(), so that a retry can queue it again.
+    uint32_t error;  // As returned by the copy function; zero on success.
+};
+
+// Copies files on a bounded pool of worker threads while one thread walks the source tree and feeds them. Copying
+// many small files is dominated by per-file latency (opening, creating and closing handles, and on a share a round
+// trip for each), so several copies in flight at once finish much sooner than one after the other.
+//
+// The feeding thread keeps everything that must happen in order: it creates each directory before queuing the files
+// that go in it, and asks about conflicts before queuing the copy that would resolve them. Workers never talk to the
+// user; the feeding thread collects what they did with takeFinished() and reports failures itself. The queue holds at
+// most queueCapacity copies, and enqueue() blocks when it is full, so a walk of a huge tree doesn't run ahead of the
+// copying.
+class CopyPipeline {
+   public:
+    // Copies one file, returning zero or an error code. Runs on a worker thread. size is as given to enqueue().
+    using CopyFunction = std::function<uint32_t(const std::wstring& from, const std::wstring& to, uint64_t size)>;
+
+    static constexpr size_t kDefaultQueueCapacity = 256;
+
+    CopyPipeline(size_t threadCount, CopyFunction copyFile, size_t queueCapacity = kDefaultQueueCapacity);
+
+    // Drops the copies that haven't started and waits for the running ones.
+    ~CopyPipeline();
+
+    CopyPipeline(const CopyPipeline&) = delete;
+    CopyPipeline& operator=(const CopyPipeline&) = delete;
+
+    // Queues a copy, first waiting for room in the queue. size is the source's size as the walk found it, which lets
+    // the copy function choose how to copy without asking the file system again.
+    void enqueue(const std::wstring& from, const std::wstring& to, uint64_t size = 0);
+
+    // Waits until no queued or running copy writes to path, so that whether it exists can be checked.
+    void waitFor(const std::wstring& path);
+
+    // Waits until every queued copy has finished.
+    void drain();
+
+    // Drops the copies that haven't started. They are not reported by takeFinished().
+    void cancel();
+
+    // True while copies are queued or running.
+    bool busy();
+
+    // Removes and returns the copies finished since the last call, in completion order.
+    std::vector<CopyResult> takeFinished();
+
+   private:
+    struct Request {
+        std::wstring from;
+        std::wstring to;
+        uint64_t size;
+        std::wstring key;  // pathKey(to)
+    };
+
+    void release(const std::wstring& key);
+    void workerLoop();
+
+    CopyFunction copyFile_;
+    size_t queueCapacity_;
+
+    std::mutex mutex_;
+    std::condition_variable work_;  // Signalled when a copy is queued or the pipeline is stopping.
+    std::condition_variable done_;  // Signalled when a copy leaves the queue or finishes.
+    bool stopping_;
+    std::deque<Request> queue_;
+    size_t running_;
+    std::unordered_map<std::wstring, size_t> targets_;  // Queued and running copies by pathKey() of destination.
+    std::vector<CopyResult> finished_;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace libwinfile
@@ -0,0 +1,128 @@
+#include "libwinfile/pch.h"
+#include "CopyProgress.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace libwinfile {
+
+CopyProgress::CopyProgress(double smoothingSeconds)
+    : smoothingSeconds_(smoothingSeconds),
+      filesScanned_(0),
+      bytesScanned_(0),
+      filesSkipped_(0),
+      bytesSkipped_(0),
+      filesDone_(0),
+      bytesDone_(0),
+      scanned_(false),
+      nextId_(1),
+      sampled_(false),
+      lastBytesDone_(0),
+      bytesPerSecond_(-1) {
+    if (!(smoothingSeconds_ > 0)) {
+        throw std::invalid_argument("CopyProgress smoothing must be positive.");
+    }
+}
+
+void CopyProgress::addScanned(uint64_t files, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    filesScanned_ += files;
+    bytesScanned_ += bytes;
+}
+
+void CopyProgress::finishScan() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    scanned_ = true;
+}
+
+CopyProgress::FileId CopyProgress::beginFile(const std::wstring& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FileId id = nextId_++;
+    files_.emplace(id, File{path, 0, 0});
+    return id;
+}
+
+void CopyProgress::updateFile(FileId id, uint64_t done, uint64_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(id);
+    if (it == files_.end()) {
+        return;
+    }
+    // Progress only moves forward; a late report from a routine that raced another is ignored.
+    if (done > it->second.done) {
+        bytesDone_ += done - it->second.done;
+        it->second.done = done;
+    }
+    it->second.size = size;
+}
+
+void CopyProgress::endFile(FileId id, bool copied) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(id);
+    if (it == files_.end()) {
+        return;
+    }
+    if (copied) {
+        filesDone_++;
+    } else {
+        bytesDone_ -= it->second.done;
+        filesSkipped_++;
+        bytesSkipped_ += it->second.size;
+    }
+    files_.erase(it);
+}
+
+void CopyProgress::skip(uint64_t files, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    filesSkipped_ += files;
+    bytesSkipped_ += bytes;
+}
+
+CopyProgressSnapshot CopyProgress::sample(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!sampled_) {
+        sampled_ = true;
+        lastSample_ = now;
+        lastBytesDone_ = bytesDone_;
+    } else if (now > lastSample_) {
+        double seconds = std::chrono::duration<double>(now - lastSample_).count();
+        double bytes = bytesDone_ > lastBytesDone_ ? static_cast<double>(bytesDone_ - lastBytesDone_) : 0;
+        double rate = bytes / seconds;
+
+        if (bytesPerSecond_ < 0) {
+            bytesPerSecond_ = rate;
+        } else {
+            double weight = 1 - std::exp(-seconds / smoothingSeconds_);
+            bytesPerSecond_ += weight * (rate - bytesPerSecond_);
+        }
+        lastSample_ = now;
+        lastBytesDone_ = bytesDone_;
+    }
+
+    CopyProgressSnapshot snapshot;
+    snapshot.filesDone = filesDone_;
+    snapshot.filesTotal = std::max(filesScanned_ > filesSkipped_ ? filesScanned_ - filesSkipped_ : 0, filesDone_);
+    snapshot.bytesDone = bytesDone_;
+    snapshot.bytesTotal = std::max(bytesScanned_ > bytesSkipped_ ? bytesScanned_ - bytesSkipped_ : 0, bytesDone_);
+    snapshot.scanned = scanned_;
+    snapshot.bytesPerSecond = std::max(bytesPerSecond_, 0.0);
+
+    if (scanned_ && snapshot.bytesDone == snapshot.bytesTotal) {
+        snapshot.secondsLeft = 0;
+    } else if (scanned_ && bytesPerSecond_ > 0) {
+        snapshot.secondsLeft = (snapshot.bytesTotal - snapshot.bytesDone) / bytesPerSecond_;
+    }
+
+    for (const auto& [id, file] : files_) {
+        if (file.size > snapshot.largestFileSize) {
+            snapshot.largestFile = file.path;
+            snapshot.largestFileDone = file.done;
+            snapshot.largestFileSize = file.size;
+        }
+    }
+
+    return snapshot;
+}
+
+}  // namespace libwinfile
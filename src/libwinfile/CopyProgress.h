@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace libwinfile {
+
+// What the progress dialog shows at one moment of a copy.
+struct CopyProgressSnapshot {
+    uint64_t filesDone = 0;
+    uint64_t filesTotal = 0;  // Counted so far, until scanned is true.
+    uint64_t bytesDone = 0;
+    uint64_t bytesTotal = 0;  // Likewise. Never less than bytesDone.
+    bool scanned = false;     // The totals are final.
+    double bytesPerSecond = 0;
+    double secondsLeft = -1;  // Negative until the totals are final and the rate is known.
+
+    // The largest file being copied right now, so that a huge file shows it is moving. Empty if there is none.
+    std::wstring largestFile;
+    uint64_t largestFileDone = 0;
+    uint64_t largestFileSize = 0;
+};
+
+// Byte-accurate progress of a copy, fed by three kinds of threads: one that counts what there is to copy (the
+// scan, which runs alongside the copy rather than before it), the workers copying files, which report bytes from
+// their CopyFileEx progress routines, and the dialog, which samples it on a timer.
+//
+// The rate is an exponential moving average weighted by time, so the ETA it gives doesn't jump around when one file
+// is slow and the next is fast, however often the dialog samples.
+class CopyProgress {
+   public:
+    using Clock = std::chrono::steady_clock;
+    using FileId = uint64_t;
+
+    // After this long, a change in speed has mostly (1 - 1/e) replaced the old rate.
+    static constexpr double kDefaultSmoothingSeconds = 5.0;
+
+    explicit CopyProgress(double smoothingSeconds = kDefaultSmoothingSeconds);
+
+    CopyProgress(const CopyProgress&) = delete;
+    CopyProgress& operator=(const CopyProgress&) = delete;
+
+    // The scan found more to copy.
+    void addScanned(uint64_t files, uint64_t bytes);
+
+    // The scan has finished; the totals are final.
+    void finishScan();
+
+    // A worker started copying path. Its size is learned from updateFile().
+    FileId beginFile(const std::wstring& path);
+
+    // done of size bytes of the file have been copied.
+    void updateFile(FileId id, uint64_t done, uint64_t size);
+
+    // The worker is finished with the file. If it wasn't copied, its bytes are taken back out of the totals along
+    // with the bytes done.
+    void endFile(FileId id, bool copied);
+
+    // Files that the scan counted but won't be copied, such as ones the user chose not to replace.
+    void skip(uint64_t files, uint64_t bytes);
+
+    // Returns the progress at now, updating the rate with what was copied since the last call.
+    CopyProgressSnapshot sample(Clock::time_point now);
+
+   private:
+    struct File {
+        std::wstring path;
+        uint64_t done;
+        uint64_t size;
+    };
+
+    double smoothingSeconds_;
+
+    std::mutex mutex_;
+    uint64_t filesScanned_;
+    uint64_t bytesScanned_;
+    uint64_t filesSkipped_;
+    uint64_t bytesSkipped_;
+    uint64_t filesDone_;
+    uint64_t bytesDone_;
+    bool scanned_;
+    FileId nextId_;
+    std::unordered_map<FileId, File> files_;  // Being copied.
+
+    // Touched only by sample().
+    bool sampled_;
+    Clock::time_point lastSample_;
+    uint64_t lastBytesDone_;
+    double bytesPerSecond_;
+};
+
+}  // namespace libwinfile
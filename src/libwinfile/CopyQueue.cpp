@@ -0,0 +1,205 @@
+#include "libwinfile/pch.h"
+#include "CopyQueue.h"
+#include "PathCache.h"
+
+#include <algorithm>
+#include <winioctl.h>
+
+namespace libwinfile {
+
+namespace {
+
+bool shareDevice(const std::vector<std::wstring>& a, const std::vector<std::wstring>& b) {
+    for (const auto& device : a) {
+        if (std::find(b.begin(), b.end(), device) != b.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The disks a volume such as "\\?\Volume{GUID}\" lies on, or nothing if the volume won't say.
+std::vector<std::wstring> disksOf(std::wstring volume) {
+    std::vector<std::wstring> disks;
+
+    // The volume device itself, rather than its root directory. No access is needed to ask for its extents.
+    if (!volume.empty() && volume.back() == L'\\') {
+        volume.pop_back();
+    }
+    HANDLE handle = CreateFileW(
+        volume.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return disks;
+    }
+
+    // A volume spanning more disks than fit in the first try says so, and is asked again with room for them all.
+    std::vector<uint8_t> buffer(sizeof(VOLUME_DISK_EXTENTS) + 7 * sizeof(DISK_EXTENT));
+    DWORD returned;
+    BOOL ok = DeviceIoControl(
+        handle, IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS, nullptr, 0, buffer.data(), static_cast<DWORD>(buffer.size()),
+        &returned, nullptr);
+    if (!ok && GetLastError() == ERROR_MORE_DATA) {
+        auto extents = reinterpret_cast<VOLUME_DISK_EXTENTS*>(buffer.data());
+        buffer.resize(sizeof(VOLUME_DISK_EXTENTS) + extents->NumberOfDiskExtents * sizeof(DISK_EXTENT));
+        ok = DeviceIoControl(
+            handle, IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS, nullptr, 0, buffer.data(),
+            static_cast<DWORD>(buffer.size()), &returned, nullptr);
+    }
+    CloseHandle(handle);
+
+    if (ok) {
+        auto extents = reinterpret_cast<VOLUME_DISK_EXTENTS*>(buffer.data());
+        for (DWORD i = 0; i < extents->NumberOfDiskExtents; i++) {
+            std::wstring disk = L"\\\\.\\PhysicalDrive" + std::to_wstring(extents->Extents[i].DiskNumber);
+            if (std::find(disks.begin(), disks.end(), disk) == disks.end()) {
+                disks.push_back(std::move(disk));
+            }
+        }
+    }
+    return disks;
+}
+
+}  // namespace
+
+CopyQueue::JobId CopyQueue::add(const std::vector<std::wstring>& devices) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    JobId id = nextId_++;
+    jobs_[id].devices = devices;
+    order_.push_back(id);
+    return id;
+}
+
+bool CopyQueue::waitTurn(JobId id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return false;
+    }
+    Job& job = it->second;
+    changed_.wait(lock, [this, id, &job]() { return job.cancelled || mayStart(id); });
+    if (job.cancelled) {
+        return false;
+    }
+    job.running = true;
+    lock.unlock();
+    changed_.notify_all();
+    return true;
+}
+
+bool CopyQueue::checkpoint(JobId id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return false;
+    }
+    Job& job = it->second;
+    changed_.wait(lock, [&job]() { return job.cancelled || !job.paused; });
+    return !job.cancelled;
+}
+
+void CopyQueue::finish(JobId id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.erase(id);
+        order_.remove(id);
+    }
+    changed_.notify_all();
+}
+
+void CopyQueue::pause(JobId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it != jobs_.end()) {
+        it->second.paused = true;
+    }
+}
+
+void CopyQueue::resume(JobId id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it != jobs_.end()) {
+            it->second.paused = false;
+        }
+    }
+    changed_.notify_all();
+}
+
+void CopyQueue::cancel(JobId id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it != jobs_.end()) {
+            it->second.cancelled = true;
+        }
+    }
+    changed_.notify_all();
+}
+
+void CopyQueue::moveToFront(JobId id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end() || it->second.running) {
+            return;
+        }
+        order_.remove(id);
+        auto firstQueued =
+            std::find_if(order_.begin(), order_.end(), [this](JobId other) { return !jobs_.at(other).running; });
+        order_.insert(firstQueued, id);
+    }
+    changed_.notify_all();
+}
+
+CopyQueue::State CopyQueue::state(JobId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return State::Finished;
+    }
+    if (it->second.paused) {
+        return State::Paused;
+    }
+    return it->second.running ? State::Running : State::Queued;
+}
+
+std::vector<std::wstring> CopyQueue::devicesOf(const std::wstring& path) {
+    std::vector<wchar_t> root(path.size() + MAX_PATH);
+    if (!GetVolumePathNameW(path.c_str(), root.data(), static_cast<DWORD>(root.size()))) {
+        return {};
+    }
+
+    wchar_t volume[MAX_PATH];
+    if (!GetVolumeNameForVolumeMountPointW(root.data(), volume, MAX_PATH)) {
+        // A share, or something else without a volume of its own.
+        return {pathKey(root.data())};
+    }
+
+    auto disks = disksOf(volume);
+    if (disks.empty()) {
+        disks.push_back(pathKey(volume));
+    }
+    return disks;
+}
+
+bool CopyQueue::mayStart(JobId id) const {
+    const Job& job = jobs_.at(id);
+    for (JobId other : order_) {
+        if (other == id) {
+            break;
+        }
+        if (shareDevice(job.devices, jobs_.at(other).devices)) {
+            return false;
+        }
+    }
+
+    // Running jobs later in the order are those a queued job was moved in front of.
+    for (const auto& other : jobs_) {
+        if (other.first != id && other.second.running && shareDevice(job.devices, other.second.devices)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace libwinfile
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libwinfile {
+
+// Schedules copy jobs so that jobs sharing a disk run one after another, in queue order, while jobs on separate disks
+// run at once. Two copies interleaved on one spinning disk spend their time seeking back and forth between them and
+// finish later together than they would one after the other; copies between separate disks don't get in each other's
+// way.
+//
+// The queue doesn't run anything itself. Each job runs on a thread of its own, which calls waitTurn() before it starts
+// work, checkpoint() between pieces of it, and finish() when it is over, however it ends. A paused job stops at its
+// next checkpoint but keeps its disks, so that nothing else starts on them in the meantime. Thread-safe.
+class CopyQueue {
+   public:
+    using JobId = uint64_t;
+
+    enum class State {
+        Queued,    // Waiting for its turn
+        Running,
+        Paused,    // Stopped, or to stop, at its next checkpoint
+        Finished,  // Or never added
+    };
+
+    CopyQueue() = default;
+    CopyQueue(const CopyQueue&) = delete;
+    CopyQueue& operator=(const CopyQueue&) = delete;
+
+    // Adds a job at the back of the queue that reads or writes devices, such as devicesOf() gives. A job with no
+    // devices never waits.
+    JobId add(const std::vector<std::wstring>& devices);
+
+    // Blocks until the job may start: until no running job, and no job queued ahead of it, shares a device with it.
+    // Returns false if it was cancelled first.
+    bool waitTurn(JobId id);
+
+    // Blocks while the job is paused. Returns false once it has been cancelled.
+    bool checkpoint(JobId id);
+
+    // Removes the job, letting the jobs that wait for its devices go.
+    void finish(JobId id);
+
+    void pause(JobId id);
+    void resume(JobId id);
+
+    // Makes waitTurn() and checkpoint() return false, releasing the job if it is waiting or paused.
+    void cancel(JobId id);
+
+    // Moves a queued job ahead of every other queued job, so it runs as soon as the running jobs on its devices end.
+    void moveToFront(JobId id);
+
+    State state(JobId id) const;
+
+    // The physical disks holding path, as "\\.\PhysicalDriveN", one for each disk its volume spans. For a share, or a
+    // volume whose disks can't be found, the volume or share itself; empty if even that can't be found.
+    static std::vector<std::wstring> devicesOf(const std::wstring& path);
+
+   private:
+    struct Job {
+        std::vector<std::wstring> devices;
+        bool running = false;
+        bool paused = false;
+        bool cancelled = false;
+    };
+
+    bool mayStart(JobId id) const;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;  // Signalled when any job changes.
+    JobId nextId_ = 1;
+    std::unordered_map<JobId, Job> jobs_;
+    std::list<JobId> order_;  // Unfinished jobs, running and queued, in the order they are to start.
+};
+
+}  // namespace libwinfile
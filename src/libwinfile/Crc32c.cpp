@@ -0,0 +1,128 @@
+#include "libwinfile/pch.h"
+#include "Crc32c.h"
+
+#include <cstring>
+#include <intrin.h>
+
+namespace libwinfile {
+
+namespace {
+
+constexpr uint32_t kPolynomial = 0x82F63B78;  // Castagnoli, bit-reversed.
+
+// Table t gives the effect of a byte followed by t zero bytes, so eight bytes can be folded in at once.
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Tables makeTables() {
+    Tables tables{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (kPolynomial & (0 - (crc & 1)));
+        }
+        tables[0][i] = crc;
+    }
+    for (size_t t = 1; t < tables.size(); t++) {
+        for (uint32_t i = 0; i < 256; i++) {
+            tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr Tables kTables = makeTables();
+
+#if defined(_M_X64) || defined(_M_IX86)
+
+bool detectHardware() {
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;  // SSE4.2
+}
+
+uint32_t updateHardware(uint32_t state, const uint8_t* bytes, size_t size) {
+#if defined(_M_X64)
+    uint64_t state64 = state;
+    for (; size >= 8; bytes += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        state64 = _mm_crc32_u64(state64, word);
+    }
+    state = static_cast<uint32_t>(state64);
+#endif
+    for (; size >= 4; bytes += 4, size -= 4) {
+        uint32_t word;
+        memcpy(&word, bytes, sizeof(word));
+        state = _mm_crc32_u32(state, word);
+    }
+    for (; size > 0; bytes++, size--) {
+        state = _mm_crc32_u8(state, *bytes);
+    }
+    return state;
+}
+
+#elif defined(_M_ARM64)
+
+bool detectHardware() {
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) != FALSE;
+}
+
+uint32_t updateHardware(uint32_t state, const uint8_t* bytes, size_t size) {
+    for (; size >= 8; bytes += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        state = __crc32cd(state, word);
+    }
+    for (; size > 0; bytes++, size--) {
+        state = __crc32cb(state, *bytes);
+    }
+    return state;
+}
+
+#else
+
+bool detectHardware() {
+    return false;
+}
+
+uint32_t updateHardware(uint32_t state, const uint8_t* bytes, size_t size) {
+    return Crc32c::updateSoftware(state, bytes, size);
+}
+
+#endif
+
+}  // namespace
+
+bool Crc32c::hardware() {
+    static const bool available = detectHardware();
+    return available;
+}
+
+void Crc32c::update(const void* data, size_t size) {
+    if (hardware()) {
+        state_ = updateHardware(state_, static_cast<const uint8_t*>(data), size);
+    } else {
+        state_ = updateSoftware(state_, data, size);
+    }
+}
+
+uint32_t Crc32c::updateSoftware(uint32_t state, const void* data, size_t size) {
+    auto bytes = static_cast<const uint8_t*>(data);
+
+    for (; size >= 8; bytes += 8, size -= 8) {
+        uint32_t low;
+        uint32_t high;
+        memcpy(&low, bytes, sizeof(low));
+        memcpy(&high, bytes + 4, sizeof(high));
+        low ^= state;
+        state = kTables[7][low & 0xFF] ^ kTables[6][(low >> 8) & 0xFF] ^ kTables[5][(low >> 16) & 0xFF] ^
+            kTables[4][low >> 24] ^ kTables[3][high & 0xFF] ^ kTables[2][(high >> 8) & 0xFF] ^
+            kTables[1][(high >> 16) & 0xFF] ^ kTables[0][high >> 24];
+    }
+    for (; size > 0; bytes++, size--) {
+        state = (state >> 8) ^ kTables[0][(state ^ *bytes) & 0xFF];
+    }
+    return state;
+}
+
+}  // namespace libwinfile
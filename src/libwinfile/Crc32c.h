@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace libwinfile {
+
+// CRC-32C (Castagnoli), the checksum of iSCSI, ext4 and Btrfs, used to check that a copied file matches its source.
+// It is computed with the processor's CRC32 instructions where it has them (SSE4.2 on x86 and x64, the CRC32
+// extension on ARM64), which keep well ahead of any disk, and otherwise with slicing-by-8 tables.
+class Crc32c {
+   public:
+    Crc32c() : state_(kInitialState) {}
+
+    void update(const void* data, size_t size);
+
+    uint32_t value() const { return ~state_; }
+
+    // Whether update() uses the processor's CRC32 instructions.
+    static bool hardware();
+
+    // The table-driven code alone, so that the two can be checked against each other. state starts at kInitialState;
+    // the checksum is its complement.
+    static constexpr uint32_t kInitialState = 0xFFFFFFFF;
+    static uint32_t updateSoftware(uint32_t state, const void* data, size_t size);
+
+   private:
+    uint32_t state_;
+};
+
+}  // namespace libwinfile
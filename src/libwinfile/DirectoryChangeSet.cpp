@@ -0,0 +1,193 @@
+#include "libwinfile/pch.h"
+#include "DirectoryChangeSet.h"
+#include "PathCache.h"
+
+namespace libwinfile {
+
+DirectoryChangeSet::DirectoryChangeSet(size_t maxChanges)
+    : maxChanges_(maxChanges), overflow_(false), liveCount_(0) {}
+
+DirectoryChangeSet::Entry* DirectoryChangeSet::entryFor(const std::wstring& name) {
+    if (overflow_) {
+        return nullptr;
+    }
+
+    std::wstring key = pathKey(name);
+    auto it = indexByKey_.find(key);
+    if (it != indexByKey_.end()) {
+        return &entries_[it->second];
+    }
+
+    if (entries_.size() >= maxChanges_) {
+        markOverflowed();
+        return nullptr;
+    }
+
+    indexByKey_.emplace(std::move(key), entries_.size());
+    entries_.push_back(Entry{DirectoryChange{DirectoryChangeKind::Modified, name}, true});
+    return &entries_.back();
+}
+
+void DirectoryChangeSet::added(const std::wstring& name) {
+    Entry* entry = entryFor(name);
+    if (!entry) {
+        return;
+    }
+
+    if (entry->cancelled) {
+        entry->change.kind = DirectoryChangeKind::Added;
+        entry->cancelled = false;
+        liveCount_++;
+    } else if (entry->change.kind == DirectoryChangeKind::Removed) {
+        // Deleted and created again: still in the listing, but with new details.
+        entry->change.kind = DirectoryChangeKind::Modified;
+    }
+    entry->change.name = name;
+}
+
+void DirectoryChangeSet::removed(const std::wstring& name) {
+    Entry* entry = entryFor(name);
+    if (!entry) {
+        return;
+    }
+
+    if (!entry->cancelled && entry->change.kind == DirectoryChangeKind::Added) {
+        // Came and went since the last refresh; the listing never had it.
+        entry->cancelled = true;
+        liveCount_--;
+        return;
+    }
+
+    if (entry->cancelled) {
+        liveCount_++;
+    }
+    entry->change.kind = DirectoryChangeKind::Removed;
+    entry->cancelled = false;
+}
+
+void DirectoryChangeSet::modified(const std::wstring& name) {
+    Entry* entry = entryFor(name);
+    if (!entry) {
+        return;
+    }
+
+    if (entry->cancelled) {
+        entry->change.kind = DirectoryChangeKind::Modified;
+        entry->cancelled = false;
+        liveCount_++;
+    } else if (entry->change.kind == DirectoryChangeKind::Removed) {
+        entry->change.kind = DirectoryChangeKind::Modified;
+    }
+}
+
+void DirectoryChangeSet::renamed(const std::wstring& oldName, const std::wstring& newName) {
+    removed(oldName);
+    added(newName);
+}
+
+void DirectoryChangeSet::markOverflowed() {
+    overflow_ = true;
+    entries_.clear();
+    indexByKey_.clear();
+    liveCount_ = 0;
+}
+
+void DirectoryChangeSet::addNotifications(const void* buffer, size_t size) {
+    const auto* start = static_cast<const BYTE*>(buffer);
+    size_t offset = 0;
+    std::wstring oldName;
+    bool haveOldName = false;
+
+    if (size == 0 || !buffer) {
+        markOverflowed();
+        return;
+    }
+
+    while (true) {
+        if (size - offset < offsetof(FILE_NOTIFY_INFORMATION, FileName)) {
+            markOverflowed();
+            return;
+        }
+
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(start + offset);
+        size_t nameOffset = offset + offsetof(FILE_NOTIFY_INFORMATION, FileName);
+        if (info->FileNameLength > size - nameOffset) {
+            markOverflowed();
+            return;
+        }
+
+        std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+
+        switch (info->Action) {
+            case FILE_ACTION_ADDED:
+                added(name);
+                break;
+            case FILE_ACTION_REMOVED:
+                removed(name);
+                break;
+            case FILE_ACTION_MODIFIED:
+                modified(name);
+                break;
+            case FILE_ACTION_RENAMED_OLD_NAME:
+                if (haveOldName) {
+                    removed(oldName);
+                }
+                oldName = std::move(name);
+                haveOldName = true;
+                break;
+            case FILE_ACTION_RENAMED_NEW_NAME:
+                if (haveOldName) {
+                    renamed(oldName, name);
+                    haveOldName = false;
+                } else {
+                    added(name);
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (info->NextEntryOffset == 0) {
+            break;
+        }
+        if (info->NextEntryOffset > size - offset) {
+            markOverflowed();
+            return;
+        }
+        offset += info->NextEntryOffset;
+    }
+
+    // The new name of a rename into this directory from elsewhere arrives without an old name, and the old name of a
+    // rename out of it without a new one.
+    if (haveOldName) {
+        removed(oldName);
+    }
+}
+
+bool DirectoryChangeSet::overflowed() const {
+    return overflow_;
+}
+
+bool DirectoryChangeSet::empty() const {
+    return !overflow_ && liveCount_ == 0;
+}
+
+std::vector<DirectoryChange> DirectoryChangeSet::changes() const {
+    std::vector<DirectoryChange> result;
+    result.reserve(liveCount_);
+    for (const auto& entry : entries_) {
+        if (!entry.cancelled) {
+            result.push_back(entry.change);
+        }
+    }
+    return result;
+}
+
+void DirectoryChangeSet::clear() {
+    overflow_ = false;
+    entries_.clear();
+    indexByKey_.clear();
+    liveCount_ = 0;
+}
+
+}  // namespace libwinfile
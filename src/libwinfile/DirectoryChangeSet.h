@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libwinfile {
+
+enum class DirectoryChangeKind {
+    Added,     // Not in the listing before; read its details and add it.
+    Removed,   // Take it out of the listing.
+    Modified,  // Read its details again. It may or may not be in the listing already.
+};
+
+struct DirectoryChange {
+    DirectoryChangeKind kind;
+    std::wstring name;  // File or directory name only, as reported by the watcher.
+};
+
+// Collects the per-file events reported for one watched directory between two refreshes and boils them down to the
+// net change per name, so a file that was created, written to a hundred times and deleted again before the refresh
+// costs nothing. Names are compared case-insensitively. A rename is a removal of the old name and an addition of the
+// new one.
+//
+// When events were lost, or so many names changed that applying them one by one would cost more than reading the
+// directory again, overflowed() says so and the owner should fall back to a full read.
+class DirectoryChangeSet {
+   public:
+    static constexpr size_t kDefaultMaxChanges = 1000;
+
+    explicit DirectoryChangeSet(size_t maxChanges = kDefaultMaxChanges);
+
+    void added(const std::wstring& name);
+    void removed(const std::wstring& name);
+    void modified(const std::wstring& name);
+    void renamed(const std::wstring& oldName, const std::wstring& newName);
+
+    // Events were lost; only a full read will do.
+    void markOverflowed();
+
+    // Records the FILE_NOTIFY_INFORMATION records in buffer, as filled in by ReadDirectoryChangesW. A size of zero
+    // (the system's way of reporting that its own buffer overflowed) or a malformed buffer counts as an overflow.
+    void addNotifications(const void* buffer, size_t size);
+
+    bool overflowed() const;
+
+    // True if there is nothing to apply and no overflow.
+    bool empty() const;
+
+    // The net changes, in the order each name first changed.
+    std::vector<DirectoryChange> changes() const;
+
+    void clear();
+
+   private:
+    struct Entry {
+        DirectoryChange change;
+        bool cancelled;  // Added and removed again; nothing to apply.
+    };
+
+    Entry* entryFor(const std::wstring& name);
+
+    size_t maxChanges_;
+    bool overflow_;
+    size_t liveCount_;
+    std::vector<Entry> entries_;
+    std::unordered_map<std::wstring, size_t> indexByKey_;
+};
+
+}  // namespace libwinfile
@@ -0,0 +1,179 @@
+#include "libwinfile/pch.h"
+#include "DirectoryLevelLoader.h"
+
+namespace libwinfile {
+
+DirectoryLevelLoader::DirectoryLevelLoader(
+    size_t threadCount,
+    Enumerator enumerator,
+    CompletionCallback onCompleted,
+    size_t cacheCapacity)
+    : enumerator_(std::move(enumerator)),
+      onCompleted_(std::move(onCompleted)),
+      stopping_(false),
+      cache_(cacheCapacity) {
+    if (!enumerator_) {
+        throw std::invalid_argument("DirectoryLevelLoader requires an enumerator.");
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+DirectoryLevelLoader::~DirectoryLevelLoader() {
+    stop();
+}
+
+void DirectoryLevelLoader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+std::wstring DirectoryLevelLoader::key(const std::wstring& path) {
+    return pathKey(path);
+}
+
+std::shared_ptr<const DirectoryLevel> DirectoryLevelLoader::cached(const std::wstring& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<const DirectoryLevel> level;
+    cache_.get(key(path), &level);
+    return level;
+}
+
+void DirectoryLevelLoader::store(const std::wstring& path, DirectoryLevel level) {
+    auto shared = std::make_shared<const DirectoryLevel>(std::move(level));
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.put(key(path), std::move(shared));
+}
+
+void DirectoryLevelLoader::request(Owner owner, const std::wstring& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::wstring jobKey = key(path);
+
+        auto it = jobs_.find(jobKey);
+        if (it != jobs_.end()) {
+            auto& owners = it->second->owners;
+            if (std::find(owners.begin(), owners.end(), owner) == owners.end()) {
+                owners.push_back(owner);
+            }
+            return;
+        }
+
+        auto job = std::make_shared<Job>();
+        job->path = path;
+        job->key = jobKey;
+        job->owners.push_back(owner);
+        jobs_.emplace(std::move(jobKey), job);
+        queue_.push_back(std::move(job));
+    }
+    wake_.notify_one();
+}
+
+std::vector<DirectoryLevelResult> DirectoryLevelLoader::takeCompleted(Owner owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = completed_.find(owner);
+    if (it == completed_.end()) {
+        return {};
+    }
+    auto results = std::move(it->second);
+    completed_.erase(it);
+    return results;
+}
+
+void DirectoryLevelLoader::cancel(Owner owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    completed_.erase(owner);
+
+    for (auto it = queue_.begin(); it != queue_.end();) {
+        auto& owners = (*it)->owners;
+        owners.erase(std::remove(owners.begin(), owners.end(), owner), owners.end());
+        if (owners.empty()) {
+            jobs_.erase((*it)->key);
+            it = queue_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto& [jobKey, job] : jobs_) {
+        if (job->running) {
+            job->owners.erase(std::remove(job->owners.begin(), job->owners.end(), owner), job->owners.end());
+        }
+    }
+}
+
+void DirectoryLevelLoader::invalidate(const std::wstring& path, bool subtree) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::wstring parentKey = key(path);
+
+    cache_.erase(parentKey, subtree);
+
+    for (auto& [jobKey, job] : jobs_) {
+        if (job->running && pathKeyIsWithin(jobKey, parentKey, subtree)) {
+            job->stale = true;
+        }
+    }
+}
+
+void DirectoryLevelLoader::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        wake_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            return;
+        }
+
+        auto job = queue_.front();
+        queue_.pop_front();
+        job->running = true;
+        job->stale = false;
+
+        lock.unlock();
+        DirectoryLevel level;
+        std::shared_ptr<const DirectoryLevel> result;
+        if (enumerator_(job->path, &level)) {
+            result = std::make_shared<const DirectoryLevel>(std::move(level));
+        }
+        lock.lock();
+
+        job->running = false;
+
+        if (job->stale && !stopping_) {
+            // The directory changed while we were reading it; read it again rather than deliver a stale listing.
+            queue_.push_back(job);
+            continue;
+        }
+
+        jobs_.erase(job->key);
+        if (result) {
+            cache_.put(job->key, result);
+        }
+        for (Owner owner : job->owners) {
+            completed_[owner].push_back(DirectoryLevelResult{job->path, result});
+        }
+
+        if (onCompleted_ && !job->owners.empty()) {
+            auto owners = job->owners;
+            lock.unlock();
+            for (Owner owner : owners) {
+                onCompleted_(owner);
+            }
+            lock.lock();
+        }
+    }
+}
+
+}  // namespace libwinfile
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "PathCache.h"
+
+namespace libwinfile {
+
+// One subdirectory found while reading a level of the directory tree.
+struct DirectoryLevelEntry {
+    std::wstring name;        // Directory name only, no path.
+    uint32_t attributes = 0;  // Attribute flags, passed through untouched from the enumerator.
+};
+
+// The subdirectories of one directory, in the order the enumerator returned them.
+using DirectoryLevel = std::vector<DirectoryLevelEntry>;
+
+// A finished background read, handed back to the owner that requested it.
+struct DirectoryLevelResult {
+    std::wstring path;                            // As passed to request().
+    std::shared_ptr<const DirectoryLevel> level;  // Null if the directory could not be read.
+};
+
+// Reads levels of the directory tree on a small pool of background threads and caches them by path, so the tree
+// window never blocks on the disk and collapsing then re-expanding a node does not touch the disk at all.
+//
+// An owner is an opaque value (winfile uses the tree control's HWND). When a read finishes, its result is queued for
+// every owner that asked for it, and the completion callback runs on the worker thread with each of those owners. The
+// owner then calls takeCompleted() from its own thread; the callback is only a wake-up, so a dropped or coalesced
+// notification never loses a result. Concurrent requests for the same path share one read.
+class DirectoryLevelLoader {
+   public:
+    using Owner = uintptr_t;
+
+    // Fills *level with the subdirectories of path. Returns false if the directory could not be read.
+    using Enumerator = std::function<bool(const std::wstring& path, DirectoryLevel* level)>;
+
+    using CompletionCallback = std::function<void(Owner owner)>;
+
+    // The cache keeps at most this many levels, evicting the least recently used.
+    static constexpr size_t kDefaultCacheCapacity = 16384;
+
+    DirectoryLevelLoader(
+        size_t threadCount,
+        Enumerator enumerator,
+        CompletionCallback onCompleted,
+        size_t cacheCapacity = kDefaultCacheCapacity);
+
+    // Calls stop().
+    ~DirectoryLevelLoader();
+
+    DirectoryLevelLoader(const DirectoryLevelLoader&) = delete;
+    DirectoryLevelLoader& operator=(const DirectoryLevelLoader&) = delete;
+
+    // The cached level for path, or null if it has not been read or has been invalidated.
+    std::shared_ptr<const DirectoryLevel> cached(const std::wstring& path);
+
+    // Adds a level that the caller read itself (on the UI thread, say) to the cache.
+    void store(const std::wstring& path, DirectoryLevel level);
+
+    // Queues a background read of path on behalf of owner. A second request for a path that is already queued or
+    // running joins that read instead of starting another.
+    void request(Owner owner, const std::wstring& path);
+
+    // Removes and returns the reads finished for owner, in completion order.
+    std::vector<DirectoryLevelResult> takeCompleted(Owner owner);
+
+    // Drops owner's queued reads and undelivered results. Reads already running still finish and fill the cache.
+    void cancel(Owner owner);
+
+    // Forgets the cached level for path and, if subtree is true, every level below it. A read of an affected path
+    // that is running right now is repeated once it finishes, so its possibly stale listing is never delivered.
+    void invalidate(const std::wstring& path, bool subtree);
+
+    // Drops the queued reads and joins the threads, after the reads already running have called back. Later requests
+    // are never read. Calling it again does nothing.
+    void stop();
+
+    // Case-insensitive cache key for path, without trailing backslashes.
+    static std::wstring key(const std::wstring& path);
+
+   private:
+    struct Job {
+        std::wstring path;
+        std::wstring key;
+        std::vector<Owner> owners;
+        bool running = false;
+        bool stale = false;
+    };
+
+    void workerLoop();
+
+    Enumerator enumerator_;
+    CompletionCallback onCompleted_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_;
+    std::deque<std::shared_ptr<Job>> queue_;
+    std::unordered_map<std::wstring, std::shared_ptr<Job>> jobs_;  // Queued or running, by key.
+    PathCache<std::shared_ptr<const DirectoryLevel>> cache_;
+    std::unordered_map<Owner, std::vector<DirectoryLevelResult>> completed_;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace libwinfile
@@ -0,0 +1,246 @@
+#include "libwinfile/pch.h"
+#include "DirectoryWatcher.h"
+#include "PathCache.h"
+
+namespace libwinfile {
+
+struct DirectoryWatcher::Watch {
+    std::wstring key;
+    HANDLE directory = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped{};
+    uint32_t filter = 0;
+    bool pending = false;  // A read is in flight; the system may still write to buffer.
+    std::vector<DWORD> buffer;
+    std::vector<Owner> owners;
+
+    ~Watch() {
+        if (directory != INVALID_HANDLE_VALUE) {
+            CloseHandle(directory);
+        }
+    }
+};
+
+DirectoryWatcher::DirectoryWatcher(CompletionCallback onChanged, uint32_t bufferSize)
+    : onChanged_(std::move(onChanged)), bufferSize_(bufferSize), port_(nullptr), stopping_(false) {
+    if (bufferSize_ < sizeof(DWORD)) {
+        throw std::invalid_argument("DirectoryWatcher buffer is too small.");
+    }
+
+    port_ = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if (!port_) {
+        throw std::runtime_error("Failed to create the directory watcher's completion port.");
+    }
+
+    thread_ = std::thread([this]() { ioLoop(); });
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        owners_.clear();
+        while (!watches_.empty()) {
+            close(watches_.begin()->second.get());
+        }
+    }
+
+    // The thread exits once every cancelled read has completed and nothing can write to a buffer any more.
+    PostQueuedCompletionStatus(port_, 0, 0, nullptr);
+    thread_.join();
+    CloseHandle(port_);
+}
+
+bool DirectoryWatcher::watch(Owner owner, const std::wstring& path, uint32_t filter) {
+    std::wstring key = pathKey(path);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto ownerIt = owners_.find(owner);
+        if (ownerIt != owners_.end() && ownerIt->second.watch && ownerIt->second.watch->key == key) {
+            // Watching it already; whatever is pending was caused by whatever made the owner read it again.
+            ownerIt->second.watch->filter |= filter;
+            ownerIt->second.changes.clear();
+            return true;
+        }
+        if (ownerIt != owners_.end()) {
+            release(owner, &ownerIt->second);
+            owners_.erase(ownerIt);
+        }
+
+        auto it = watches_.find(key);
+        if (it != watches_.end()) {
+            // The next read picks up any filter flags this owner adds.
+            it->second->filter |= filter;
+            it->second->owners.push_back(owner);
+            owners_.emplace(owner, OwnerState{it->second.get(), DirectoryChangeSet()});
+            return true;
+        }
+    }
+
+    // Opening a directory on a network drive can take a while; don't hold the lock for it.
+    HANDLE directory = CreateFileW(
+        path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (directory == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    auto watch = std::make_unique<Watch>();
+    watch->key = key;
+    watch->directory = directory;
+    watch->filter = filter;
+    watch->buffer.resize(bufferSize_ / sizeof(DWORD));
+
+    if (CreateIoCompletionPort(directory, port_, reinterpret_cast<ULONG_PTR>(watch.get()), 0) != port_) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto ownerIt = owners_.find(owner);
+    if (ownerIt != owners_.end()) {
+        release(owner, &ownerIt->second);
+        owners_.erase(ownerIt);
+    }
+
+    auto it = watches_.find(key);
+    if (it != watches_.end()) {
+        // Another caller opened it in the meantime; nothing was read on ours, so it can simply be closed.
+        it->second->filter |= filter;
+        it->second->owners.push_back(owner);
+        owners_.emplace(owner, OwnerState{it->second.get(), DirectoryChangeSet()});
+        return true;
+    }
+
+    if (!startRead(watch.get())) {
+        return false;
+    }
+
+    watch->owners.push_back(owner);
+    owners_.emplace(owner, OwnerState{watch.get(), DirectoryChangeSet()});
+    watches_.emplace(key, std::move(watch));
+    return true;
+}
+
+void DirectoryWatcher::unwatch(Owner owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = owners_.find(owner);
+    if (it == owners_.end()) {
+        return;
+    }
+    release(owner, &it->second);
+    owners_.erase(it);
+}
+
+DirectoryChangeSet DirectoryWatcher::takeChanges(Owner owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = owners_.find(owner);
+    if (it == owners_.end()) {
+        return DirectoryChangeSet();
+    }
+
+    DirectoryChangeSet changes = std::move(it->second.changes);
+    it->second.changes = DirectoryChangeSet();
+    if (!it->second.watch) {
+        owners_.erase(it);
+    }
+    return changes;
+}
+
+size_t DirectoryWatcher::pathCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return watches_.size();
+}
+
+bool DirectoryWatcher::startRead(Watch* watch) {
+    watch->overlapped = OVERLAPPED{};
+    watch->pending = ReadDirectoryChangesW(
+        watch->directory, watch->buffer.data(), static_cast<DWORD>(watch->buffer.size() * sizeof(DWORD)), FALSE,
+        watch->filter, nullptr, &watch->overlapped, nullptr);
+    return watch->pending;
+}
+
+void DirectoryWatcher::release(Owner owner, OwnerState* state) {
+    Watch* watch = state->watch;
+    if (!watch) {
+        return;
+    }
+    state->watch = nullptr;
+
+    auto& owners = watch->owners;
+    owners.erase(std::remove(owners.begin(), owners.end(), owner), owners.end());
+    if (owners.empty()) {
+        close(watch);
+    }
+}
+
+void DirectoryWatcher::close(Watch* watch) {
+    auto it = watches_.find(watch->key);
+    std::unique_ptr<Watch> owned = std::move(it->second);
+    watches_.erase(it);
+
+    for (Owner owner : owned->owners) {
+        auto ownerIt = owners_.find(owner);
+        if (ownerIt != owners_.end()) {
+            ownerIt->second.watch = nullptr;
+        }
+    }
+    owned->owners.clear();
+
+    if (owned->pending) {
+        // Freed when the cancelled read completes.
+        CancelIoEx(owned->directory, &owned->overlapped);
+        closing_.emplace(watch, std::move(owned));
+    }
+}
+
+void DirectoryWatcher::ioLoop() {
+    while (true) {
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        LPOVERLAPPED overlapped = nullptr;
+        BOOL succeeded = GetQueuedCompletionStatus(port_, &bytes, &key, &overlapped, INFINITE);
+        DWORD error = succeeded ? ERROR_SUCCESS : GetLastError();
+
+        std::vector<Owner> changed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            if (overlapped) {
+                auto* watch = reinterpret_cast<Watch*>(key);
+                watch->pending = false;
+
+                if (closing_.erase(watch) == 0) {
+                    for (Owner owner : watch->owners) {
+                        auto& changes = owners_.at(owner).changes;
+                        if (succeeded) {
+                            changes.addNotifications(watch->buffer.data(), bytes);
+                        } else {
+                            changes.markOverflowed();
+                        }
+                    }
+                    changed = watch->owners;
+
+                    // ERROR_NOTIFY_ENUM_DIR is the system's buffer overflowing; anything else means the directory is
+                    // gone or can no longer be read. Its owners see an overflow, read it again, and watch whatever
+                    // they end up showing.
+                    if ((!succeeded && error != ERROR_NOTIFY_ENUM_DIR) || !startRead(watch)) {
+                        close(watch);
+                    }
+                }
+            }
+
+            if (stopping_ && closing_.empty()) {
+                return;
+            }
+        }
+
+        if (onChanged_) {
+            for (Owner owner : changed) {
+                onChanged_(owner);
+            }
+        }
+    }
+}
+
+}  // namespace libwinfile
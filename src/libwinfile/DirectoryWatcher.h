@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "DirectoryChangeSet.h"
+
+namespace libwinfile {
+
+// Watches directories for changes on behalf of owners (directory windows). Each distinct path is opened and read with
+// ReadDirectoryChangesW once, however many owners watch it, and there is no limit on the number of paths: the reads
+// complete on an I/O completion port serviced by one thread, rather than each taking one of the 64 handles a wait can
+// take.
+//
+// Owners and completion work as in DirectoryLevelLoader: the callback runs on the watcher's thread as a wake-up and
+// the owner collects what changed with takeChanges(). An owner watches one path at a time.
+class DirectoryWatcher {
+   public:
+    using Owner = uintptr_t;
+    using CompletionCallback = std::function<void(Owner owner)>;
+
+    // Network redirectors fail reads with larger buffers.
+    static constexpr uint32_t kDefaultBufferSize = 64 * 1024;
+
+    explicit DirectoryWatcher(CompletionCallback onChanged, uint32_t bufferSize = kDefaultBufferSize);
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Starts watching path for owner with the FILE_NOTIFY_CHANGE_* flags in filter, replacing owner's previous watch
+    // and dropping its uncollected changes. Returns false if the directory can't be watched; owner then watches
+    // nothing.
+    bool watch(Owner owner, const std::wstring& path, uint32_t filter);
+
+    void unwatch(Owner owner);
+
+    // Removes and returns what changed in owner's directory since the last call. If the directory went away or could
+    // no longer be read, the set has overflowed() and owner no longer watches anything.
+    DirectoryChangeSet takeChanges(Owner owner);
+
+    // Number of directories open, for tests.
+    size_t pathCount();
+
+   private:
+    struct Watch;
+
+    struct OwnerState {
+        Watch* watch;
+        DirectoryChangeSet changes;
+    };
+
+    bool startRead(Watch* watch);
+    void release(Owner owner, OwnerState* state);
+    void close(Watch* watch);
+    void ioLoop();
+
+    CompletionCallback onChanged_;
+    uint32_t bufferSize_;
+    void* port_;
+
+    std::mutex mutex_;
+    bool stopping_;
+    std::unordered_map<std::wstring, std::unique_ptr<Watch>> watches_;  // Open directories, by pathKey().
+    std::unordered_map<Watch*, std::unique_ptr<Watch>> closing_;        // Cancelled reads not yet completed.
+    std::unordered_map<Owner, OwnerState> owners_;
+    std::thread thread_;
+};
+
+}  // namespace libwinfile
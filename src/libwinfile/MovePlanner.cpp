@@ -0,0 +1,108 @@
+#include "libwinfile/pch.h"
+#include "MovePlanner.h"
+#include "PathCache.h"
+
+namespace libwinfile {
+
+namespace {
+
+bool isDotDirectory(const wchar_t* name) {
+    return name[0] == L'.' && (name[1] == L'\0' || (name[1] == L'.' && name[2] == L'\0'));
+}
+
+bool isDirectory(DWORD attributes) {
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+// The directory holding path, keeping the backslash of a drive's root.
+std::wstring parentOf(std::wstring path) {
+    while (path.size() > 1 && (path.back() == L'\\' || path.back() == L'/')) {
+        path.pop_back();
+    }
+    size_t slash = path.find_last_of(L"\\/");
+    if (slash == std::wstring::npos) {
+        return std::wstring();
+    }
+    if (slash > 0 && path[slash - 1] == L':') {
+        slash++;
+    }
+    return path.substr(0, slash);
+}
+
+}  // namespace
+
+MovePlanner::MovePlanner(VolumeFunction volumeOf) : volumeOf_(volumeOf ? std::move(volumeOf) : systemVolumeOf) {}
+
+MovePlanner::Action MovePlanner::decide(const std::wstring& source, const std::wstring& destination) {
+    if (!sameVolume(source, destination)) {
+        return Action::CopyDelete;
+    }
+
+    // A link or junction is renamed itself, never merged through.
+    DWORD sourceAttributes = GetFileAttributesW(source.c_str());
+    if (isDirectory(sourceAttributes) && !(sourceAttributes & FILE_ATTRIBUTE_REPARSE_POINT) &&
+        isDirectory(GetFileAttributesW(destination.c_str()))) {
+        return Action::Merge;
+    }
+    return Action::Rename;
+}
+
+std::vector<MovePlanner::Step> MovePlanner::plan(const std::wstring& source, const std::wstring& destination) {
+    std::vector<Step> steps;
+    planInto(source, destination, &steps);
+    return steps;
+}
+
+bool MovePlanner::sameVolume(const std::wstring& a, const std::wstring& b) {
+    const std::wstring& volumeA = volumeOfParent(a);
+    return !volumeA.empty() && volumeA == volumeOfParent(b);
+}
+
+std::wstring MovePlanner::systemVolumeOf(const std::wstring& path) {
+    std::vector<wchar_t> root(path.size() + MAX_PATH);
+    if (!GetVolumePathNameW(path.c_str(), root.data(), static_cast<DWORD>(root.size()))) {
+        return std::wstring();
+    }
+
+    wchar_t volume[MAX_PATH];
+    if (!GetVolumeNameForVolumeMountPointW(root.data(), volume, MAX_PATH)) {
+        // A share, or something else without a volume of its own.
+        return pathKey(root.data());
+    }
+    return pathKey(volume);
+}
+
+const std::wstring& MovePlanner::volumeOfParent(const std::wstring& path) {
+    // The entries of a merged directory all share its volume, so each directory is looked up once.
+    std::wstring parent = parentOf(path);
+    std::wstring key = pathKey(parent);
+    auto it = volumes_.find(key);
+    if (it == volumes_.end()) {
+        it = volumes_.emplace(std::move(key), parent.empty() ? std::wstring() : volumeOf_(parent)).first;
+    }
+    return it->second;
+}
+
+void MovePlanner::planInto(const std::wstring& source, const std::wstring& destination, std::vector<Step>* steps) {
+    Action action = decide(source, destination);
+    steps->push_back(Step{action, source, destination});
+    if (action != Action::Merge) {
+        return;
+    }
+
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileExW(
+        (source + L"\\*").c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, nullptr,
+        FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    do {
+        if (!isDotDirectory(data.cFileName)) {
+            planInto(source + L'\\' + data.cFileName, destination + L'\\' + data.cFileName, steps);
+        }
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+}
+
+}  // namespace libwinfile
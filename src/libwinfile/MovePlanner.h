@@ -0,0 +1,63 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libwinfile {
+
+// Decides how each part of a move is to be done. Moving within a volume is a rename, which takes a whole subtree in one
+// step however big it is, so a directory is renamed whole wherever nothing is in its way. Only where the destination
+// already has the directory is it merged, one entry at a time, each of which is decided the same way; only across
+// volumes is anything copied and then deleted.
+//
+// Volumes are told apart by their volume GUID, so two drive letters, or a drive letter and a folder, that mount the
+// same volume are one volume, and a volume mounted in a folder on another is not. A move is on one volume if the
+// directories holding the source and the destination are, since those are what a rename changes. Not thread-safe.
+class MovePlanner {
+   public:
+    enum class Action {
+        Rename,      // One rename moves it and everything in it. A file in the way is replaced.
+        Merge,       // Both are directories on one volume. What is in the source is moved in one entry at a time.
+        CopyDelete,  // Another volume, or one that can't be told. It is copied, then the source deleted.
+    };
+
+    struct Step {
+        Action action;
+        std::wstring source;
+        std::wstring destination;
+    };
+
+    // Names the volume a path lies on; equal names are the same volume, and an empty name is an unknown one.
+    using VolumeFunction = std::function<std::wstring(const std::wstring& path)>;
+
+    // Finds volumes with volumeOf(), by default the system's.
+    explicit MovePlanner(VolumeFunction volumeOf = nullptr);
+
+    MovePlanner(const MovePlanner&) = delete;
+    MovePlanner& operator=(const MovePlanner&) = delete;
+
+    // How to move source, a file or directory, to destination.
+    Action decide(const std::wstring& source, const std::wstring& destination);
+
+    // Every step of moving source to destination, source first. Only merged directories have steps for what is in
+    // them, so a tree renamed or copied whole is one step.
+    std::vector<Step> plan(const std::wstring& source, const std::wstring& destination);
+
+    // True if the directories holding a and b are on one volume that can be told.
+    bool sameVolume(const std::wstring& a, const std::wstring& b);
+
+    // The volume GUID path of the volume path lies on, such as "\\?\Volume{GUID}\"; for a share, its root. Empty if
+    // even that can't be found.
+    static std::wstring systemVolumeOf(const std::wstring& path);
+
+   private:
+    const std::wstring& volumeOfParent(const std::wstring& path);
+    void planInto(const std::wstring& source, const std::wstring& destination, std::vector<Step>* steps);
+
+    VolumeFunction volumeOf_;
+    std::unordered_map<std::wstring, std::wstring> volumes_;  // pathKey() of a directory to its volume.
+};
+
+}  // namespace libwinfile
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cwctype>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace libwinfile {
+
+// Case-insensitive cache key for a directory path: upper case, backslashes only, no trailing backslash.
+inline std::wstring pathKey(const std::wstring& path) {
+    std::wstring result;
+    result.reserve(path.size());
+    for (wchar_t ch : path) {
+        result.push_back(ch == L'/' ? L'\\' : static_cast<wchar_t>(towupper(ch)));
+    }
+    while (!result.empty() && result.back() == L'\\') {
+        result.pop_back();
+    }
+    return result;
+}
+
+// True if key names parentKey itself or, when subtree is true, anything below it.
+inline bool pathKeyIsWithin(const std::wstring& key, const std::wstring& parentKey, bool subtree) {
+    if (key.size() == parentKey.size()) {
+        return key == parentKey;
+    }
+    return subtree && key.size() > parentKey.size() && key[parentKey.size()] == L'\\' &&
+        key.compare(0, parentKey.size(), parentKey) == 0;
+}
+
+// A least-recently-used map from pathKey() keys to T that can forget a whole subtree at once. Not thread-safe; owners
+// lock around it.
+template <typename T>
+class PathCache {
+   public:
+    explicit PathCache(size_t capacity) : capacity_(capacity) {}
+
+    // Copies the value for key into *value and marks it recently used. Returns false if there is none.
+    bool get(const std::wstring& key, T* value) {
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second.lruPosition);
+        *value = it->second.value;
+        return true;
+    }
+
+    void put(const std::wstring& key, T value) {
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            it->second.value = std::move(value);
+            lru_.splice(lru_.begin(), lru_, it->second.lruPosition);
+            return;
+        }
+
+        lru_.push_front(key);
+        entries_.emplace(key, Entry{std::move(value), lru_.begin()});
+
+        while (entries_.size() > capacity_) {
+            entries_.erase(lru_.back());
+            lru_.pop_back();
+        }
+    }
+
+    // Forgets key and, if subtree is true, every key below it.
+    void erase(const std::wstring& key, bool subtree) {
+        if (!subtree) {
+            auto it = entries_.find(key);
+            if (it != entries_.end()) {
+                lru_.erase(it->second.lruPosition);
+                entries_.erase(it);
+            }
+            return;
+        }
+
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            if (pathKeyIsWithin(it->first, key, true)) {
+                lru_.erase(it->second.lruPosition);
+                it = entries_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    size_t size() const { return entries_.size(); }
+
+   private:
+    struct Entry {
+        T value;
+        std::list<std::wstring>::iterator lruPosition;
+    };
+
+    size_t capacity_;
+    std::unordered_map<std::wstring, Entry> entries_;
+    std::list<std::wstring> lru_;  // Keys, most recently used first.
+};
+
+}  // namespace libwinfile
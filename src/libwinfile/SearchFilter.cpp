@@ -0,0 +1,361 @@
+#include "libwinfile/pch.h"
+#include "SearchFilter.h"
+
+namespace libwinfile {
+
+namespace {
+
+constexpr uint64_t kTicksPerMinute = 60ull * 10000000ull;
+constexpr uint64_t kTicksPerDay = 24ull * 60ull * kTicksPerMinute;
+
+enum class CompareOp { Less, LessEqual, Equal, GreaterEqual, Greater };
+
+// UTF-8, as exception messages are.
+std::string narrow(std::wstring_view text) {
+    if (text.empty()) {
+        return std::string();
+    }
+    int size =
+        WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+    std::string result(size, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &result[0], size, nullptr, nullptr);
+    return result;
+}
+
+[[noreturn]] void throwBadTerm(std::wstring_view term, const char* reason) {
+    throw std::invalid_argument("Invalid filter term \"" + narrow(term) + "\": " + reason);
+}
+
+// Splits on whitespace. Double quotes group characters (including spaces) and are removed.
+std::vector<std::wstring> tokenize(std::wstring_view expression) {
+    std::vector<std::wstring> tokens;
+    std::wstring current;
+    bool inQuotes = false;
+    bool hasToken = false;
+
+    for (wchar_t ch : expression) {
+        if (ch == L'"') {
+            inQuotes = !inQuotes;
+            hasToken = true;
+        } else if (!inQuotes && iswspace(ch)) {
+            if (hasToken) {
+                tokens.push_back(std::move(current));
+                current.clear();
+                hasToken = false;
+            }
+        } else {
+            current.push_back(ch);
+            hasToken = true;
+        }
+    }
+
+    if (inQuotes) {
+        throw std::invalid_argument("Invalid filter: unterminated quote.");
+    }
+    if (hasToken) {
+        tokens.push_back(std::move(current));
+    }
+    return tokens;
+}
+
+bool startsWithNoCase(std::wstring_view text, std::wstring_view prefix) {
+    if (text.size() < prefix.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < prefix.size(); i++) {
+        if (towlower(text[i]) != towlower(prefix[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Parses the comparison operator at the start of text and returns the remaining value.
+std::wstring_view parseOp(std::wstring_view term, std::wstring_view text, CompareOp* op) {
+    if (text.size() >= 2 && text[0] == L'<' && text[1] == L'=') {
+        *op = CompareOp::LessEqual;
+        return text.substr(2);
+    }
+    if (text.size() >= 2 && text[0] == L'>' && text[1] == L'=') {
+        *op = CompareOp::GreaterEqual;
+        return text.substr(2);
+    }
+    if (!text.empty() && text[0] == L'<') {
+        *op = CompareOp::Less;
+        return text.substr(1);
+    }
+    if (!text.empty() && text[0] == L'>') {
+        *op = CompareOp::Greater;
+        return text.substr(1);
+    }
+    if (!text.empty() && (text[0] == L'=' || text[0] == L':')) {
+        *op = CompareOp::Equal;
+        return text.substr(1);
+    }
+    throwBadTerm(term, "expected one of < <= = >= >");
+}
+
+bool parseUnsigned(std::wstring_view text, uint64_t* value, size_t* consumed) {
+    uint64_t result = 0;
+    size_t i = 0;
+    while (i < text.size() && text[i] >= L'0' && text[i] <= L'9') {
+        uint64_t digit = text[i] - L'0';
+        if (result > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+            return false;
+        }
+        result = result * 10 + digit;
+        i++;
+    }
+    *value = result;
+    *consumed = i;
+    return i > 0;
+}
+
+uint64_t parseSize(std::wstring_view term, std::wstring_view text) {
+    uint64_t value = 0;
+    size_t consumed = 0;
+    if (!parseUnsigned(text, &value, &consumed)) {
+        throwBadTerm(term, "expected a size such as 512, 64K or 10M");
+    }
+
+    std::wstring_view suffix = text.substr(consumed);
+    int shift = 0;
+    if (!suffix.empty()) {
+        switch (towupper(suffix[0])) {
+            case L'K':
+                shift = 10;
+                break;
+            case L'M':
+                shift = 20;
+                break;
+            case L'G':
+                shift = 30;
+                break;
+            case L'T':
+                shift = 40;
+                break;
+            case L'B':
+                break;
+            default:
+                throwBadTerm(term, "unknown size suffix");
+        }
+        if (shift != 0) {
+            suffix.remove_prefix(1);
+        }
+        if (!suffix.empty() && towupper(suffix[0]) == L'B') {
+            suffix.remove_prefix(1);
+        }
+        if (!suffix.empty()) {
+            throwBadTerm(term, "unknown size suffix");
+        }
+    }
+
+    if (shift != 0 && value > (std::numeric_limits<uint64_t>::max() >> shift)) {
+        throwBadTerm(term, "size is too large");
+    }
+    return value << shift;
+}
+
+// Parses YYYY-MM-DD or YYYY-MM-DDTHH:MM in local time. Returns UTC FILETIME ticks, and the length of the span the
+// value names (a whole day or a whole minute) so that "=" can match the entire span.
+uint64_t parseLocalDate(std::wstring_view term, std::wstring_view text, uint64_t* span) {
+    std::wstring value(text);
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    int consumed = 0;
+    if (swscanf_s(value.c_str(), L"%4d-%2d-%2d%n", &year, &month, &day, &consumed) == 3 &&
+        consumed == static_cast<int>(value.size())) {
+        *span = kTicksPerDay;
+    } else if (
+        swscanf_s(value.c_str(), L"%4d-%2d-%2dT%2d:%2d%n", &year, &month, &day, &hour, &minute, &consumed) == 5 &&
+        consumed == static_cast<int>(value.size())) {
+        *span = kTicksPerMinute;
+    } else {
+        throwBadTerm(term, "expected a date such as 2024-01-31 or 2024-01-31T13:45");
+    }
+
+    SYSTEMTIME st{};
+    st.wYear = static_cast<WORD>(year);
+    st.wMonth = static_cast<WORD>(month);
+    st.wDay = static_cast<WORD>(day);
+    st.wHour = static_cast<WORD>(hour);
+    st.wMinute = static_cast<WORD>(minute);
+
+    FILETIME ftLocal;
+    FILETIME ftUtc;
+    if (year < 1601 || hour > 23 || minute > 59 || !SystemTimeToFileTime(&st, &ftLocal) ||
+        !LocalFileTimeToFileTime(&ftLocal, &ftUtc)) {
+        throwBadTerm(term, "not a valid date");
+    }
+
+    return (static_cast<uint64_t>(ftUtc.dwHighDateTime) << 32) | ftUtc.dwLowDateTime;
+}
+
+// Narrows the inclusive range [*min, *max] by "x op value". An impossible range is left with *min > *max.
+// spanEnd is the last value that "= value" covers; for plain numbers it is the value itself.
+template <typename T>
+void applyRange(CompareOp op, T value, T spanEnd, T* min, T* max) {
+    switch (op) {
+        case CompareOp::Less:
+            if (value == std::numeric_limits<T>::min()) {
+                *min = std::numeric_limits<T>::max();
+                *max = std::numeric_limits<T>::min();
+            } else {
+                *max = std::min(*max, static_cast<T>(value - 1));
+            }
+            break;
+        case CompareOp::LessEqual:
+            *max = std::min(*max, spanEnd);
+            break;
+        case CompareOp::Equal:
+            *min = std::max(*min, value);
+            *max = std::min(*max, spanEnd);
+            break;
+        case CompareOp::GreaterEqual:
+            *min = std::max(*min, value);
+            break;
+        case CompareOp::Greater:
+            if (spanEnd == std::numeric_limits<T>::max()) {
+                *min = std::numeric_limits<T>::max();
+                *max = std::numeric_limits<T>::min();
+            } else {
+                *min = std::max(*min, static_cast<T>(spanEnd + 1));
+            }
+            break;
+    }
+}
+
+uint32_t attributeFromLetter(std::wstring_view term, wchar_t letter) {
+    switch (towlower(letter)) {
+        case L'r':
+            return FILE_ATTRIBUTE_READONLY;
+        case L'h':
+            return FILE_ATTRIBUTE_HIDDEN;
+        case L's':
+            return FILE_ATTRIBUTE_SYSTEM;
+        case L'a':
+            return FILE_ATTRIBUTE_ARCHIVE;
+        case L'd':
+            return FILE_ATTRIBUTE_DIRECTORY;
+        case L'c':
+            return FILE_ATTRIBUTE_COMPRESSED;
+        case L'e':
+            return FILE_ATTRIBUTE_ENCRYPTED;
+        case L'l':
+            return FILE_ATTRIBUTE_REPARSE_POINT;
+        default:
+            throwBadTerm(term, "unknown attribute letter; use r h s a d c e l");
+    }
+}
+
+}  // anonymous namespace
+
+SearchFilter::SearchFilter()
+    : empty_(true),
+      attributesRequired_(0),
+      attributesExcluded_(0),
+      depthMin_(0),
+      depthMax_(std::numeric_limits<int>::max()),
+      sizeMin_(0),
+      sizeMax_(std::numeric_limits<uint64_t>::max()),
+      timeMin_(0),
+      timeMax_(std::numeric_limits<uint64_t>::max()) {}
+
+SearchFilter SearchFilter::parse(std::wstring_view expression) {
+    SearchFilter filter;
+
+    for (const auto& token : tokenize(expression)) {
+        std::wstring_view term(token);
+        CompareOp op;
+
+        if (startsWithNoCase(term, L"regex:")) {
+            std::wstring pattern(term.substr(6));
+            if (pattern.empty()) {
+                throwBadTerm(term, "the regular expression is empty");
+            }
+            try {
+                filter.nameRegexes_.emplace_back(
+                    pattern, std::regex_constants::ECMAScript | std::regex_constants::icase |
+                        std::regex_constants::optimize);
+            } catch (const std::regex_error& e) {
+                throwBadTerm(term, e.what());
+            }
+        } else if (startsWithNoCase(term, L"attr:")) {
+            std::wstring_view letters = term.substr(5);
+            if (letters.empty()) {
+                throwBadTerm(term, "expected attribute letters such as +h-r");
+            }
+            bool exclude = false;
+            for (wchar_t ch : letters) {
+                if (ch == L'+') {
+                    exclude = false;
+                } else if (ch == L'-') {
+                    exclude = true;
+                } else if (exclude) {
+                    filter.attributesExcluded_ |= attributeFromLetter(term, ch);
+                } else {
+                    filter.attributesRequired_ |= attributeFromLetter(term, ch);
+                }
+            }
+        } else if (startsWithNoCase(term, L"size")) {
+            uint64_t value = parseSize(term, parseOp(term, term.substr(4), &op));
+            applyRange(op, value, value, &filter.sizeMin_, &filter.sizeMax_);
+        } else if (startsWithNoCase(term, L"modified")) {
+            uint64_t span = 0;
+            uint64_t value = parseLocalDate(term, parseOp(term, term.substr(8), &op), &span);
+            // "<=" and "=" include the whole day (or minute) named; "<" and ">=" start at its beginning.
+            applyRange(op, value, value + span - 1, &filter.timeMin_, &filter.timeMax_);
+        } else if (startsWithNoCase(term, L"depth")) {
+            std::wstring_view text = parseOp(term, term.substr(5), &op);
+            uint64_t value = 0;
+            size_t consumed = 0;
+            if (!parseUnsigned(text, &value, &consumed) || consumed != text.size() || value > 1000000) {
+                throwBadTerm(term, "expected a folder depth such as 2");
+            }
+            int depth = static_cast<int>(value);
+            applyRange(op, depth, depth, &filter.depthMin_, &filter.depthMax_);
+        } else {
+            throwBadTerm(term, "expected size, modified, depth, attr: or regex:");
+        }
+
+        filter.empty_ = false;
+    }
+
+    return filter;
+}
+
+bool SearchFilter::empty() const {
+    return empty_;
+}
+
+bool SearchFilter::matches(const SearchCandidate& candidate) const {
+    if (empty_) {
+        return true;
+    }
+
+    // Cheapest first: bit tests and integer compares, then regular expressions.
+    if ((candidate.attributes & attributesRequired_) != attributesRequired_ ||
+        (candidate.attributes & attributesExcluded_) != 0) {
+        return false;
+    }
+    if (candidate.depth < depthMin_ || candidate.depth > depthMax_) {
+        return false;
+    }
+    if (candidate.size < sizeMin_ || candidate.size > sizeMax_) {
+        return false;
+    }
+    if (candidate.lastWriteTime < timeMin_ || candidate.lastWriteTime > timeMax_) {
+        return false;
+    }
+    for (const auto& regex : nameRegexes_) {
+        if (!std::regex_search(candidate.name.begin(), candidate.name.end(), regex)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int SearchFilter::maxDepth() const {
+    return depthMax_;
+}
+
+}  // namespace libwinfile
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace libwinfile {
+
+// One enumerated directory entry, built from the WIN32_FIND_DATA that the search walk already has in hand.
+// Everything a SearchFilter looks at lives here, so evaluating a filter never costs an extra stat call.
+struct SearchCandidate {
+    std::wstring_view name;      // File name only, no path.
+    uint32_t attributes = 0;     // FILE_ATTRIBUTE_* flags.
+    uint64_t size = 0;           // In bytes.
+    uint64_t lastWriteTime = 0;  // FILETIME ticks (100 ns since 1601-01-01 UTC).
+    int depth = 0;               // 0 for entries directly inside the search root.
+};
+
+// A compiled search filter expression. The expression is a whitespace-separated list of terms, all of which must
+// match. Values containing spaces may be double-quoted.
+//
+//   size>10M  size<=4096  size=0         Size in bytes, with optional K/M/G/T suffix (1024-based).
+//   modified>=2024-01-31                 Last write time, local time. Also accepts 2024-01-31T13:45.
+//   modified<2024-06-01  modified=2024-03-15
+//   depth<=2                             Folder depth below the search root; 0 is directly inside it.
+//   attr:+h-r  attr:hs                   Require (+ or no sign) or exclude (-) attributes: r h s a d c e l.
+//   regex:^report.*\.xlsx?$             ECMAScript regular expression on the name, case-insensitive.
+//
+// Terms are folded into ranges and bit masks at parse time and evaluated cheapest first: attributes, depth, size,
+// date, and finally the regular expressions.
+class SearchFilter {
+   public:
+    // An empty filter that matches everything.
+    SearchFilter();
+
+    // Throws std::invalid_argument describing the offending term, in UTF-8, if the expression is malformed.
+    static SearchFilter parse(std::wstring_view expression);
+
+    // True if the filter has no terms.
+    bool empty() const;
+
+    bool matches(const SearchCandidate& candidate) const;
+
+    // The deepest folder depth that can still produce matches. Walkers should not descend past this.
+    int maxDepth() const;
+
+   private:
+    bool empty_;
+    uint32_t attributesRequired_;
+    uint32_t attributesExcluded_;
+    int depthMin_;
+    int depthMax_;
+    uint64_t sizeMin_;
+    uint64_t sizeMax_;
+    uint64_t timeMin_;
+    uint64_t timeMax_;
+    std::vector<std::wregex> nameRegexes_;
+};
+
+}  // namespace libwinfile
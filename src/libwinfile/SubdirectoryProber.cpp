@@ -0,0 +1,164 @@
+#include "libwinfile/pch.h"
+#include "SubdirectoryProber.h"
+
+namespace libwinfile {
+
+SubdirectoryProber::SubdirectoryProber(
+    size_t threadCount,
+    Probe probe,
+    CompletionCallback onCompleted,
+    size_t cacheCapacity)
+    : probe_(std::move(probe)), onCompleted_(std::move(onCompleted)), stopping_(false), cache_(cacheCapacity) {
+    if (!probe_) {
+        throw std::invalid_argument("SubdirectoryProber requires a probe function.");
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+SubdirectoryProber::~SubdirectoryProber() {
+    stop();
+}
+
+void SubdirectoryProber::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queue_.clear();
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+bool SubdirectoryProber::cached(const std::wstring& path, bool* hasSubdirectories) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_.get(pathKey(path), hasSubdirectories);
+}
+
+void SubdirectoryProber::store(const std::wstring& path, bool hasSubdirectories) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.put(pathKey(path), hasSubdirectories);
+}
+
+void SubdirectoryProber::probe(Owner owner, const std::vector<std::wstring>& paths) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        queue_.erase(
+            std::remove_if(
+                queue_.begin(), queue_.end(), [owner](const Request& request) { return request.owner == owner; }),
+            queue_.end());
+
+        // Insert in reverse at the front so the first path is probed first.
+        for (auto it = paths.rbegin(); it != paths.rend(); ++it) {
+            queue_.push_front(Request{owner, *it, pathKey(*it)});
+        }
+    }
+    wake_.notify_all();
+}
+
+std::vector<SubdirectoryProbeResult> SubdirectoryProber::takeCompleted(Owner owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = completed_.find(owner);
+    if (it == completed_.end()) {
+        return {};
+    }
+    auto results = std::move(it->second);
+    completed_.erase(it);
+    return results;
+}
+
+void SubdirectoryProber::cancel(Owner owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    completed_.erase(owner);
+
+    auto isOwners = [owner](const Request& request) { return request.owner == owner; };
+    queue_.erase(std::remove_if(queue_.begin(), queue_.end(), isOwners), queue_.end());
+    for (auto& [key, waiters] : running_) {
+        waiters.erase(std::remove_if(waiters.begin(), waiters.end(), isOwners), waiters.end());
+    }
+}
+
+void SubdirectoryProber::invalidate(const std::wstring& path, bool subtree) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::wstring parentKey = pathKey(path);
+
+    cache_.erase(parentKey, subtree);
+
+    for (const auto& [key, waiters] : running_) {
+        if (pathKeyIsWithin(key, parentKey, subtree)) {
+            staleRunning_.insert(key);
+        }
+    }
+}
+
+void SubdirectoryProber::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        wake_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            return;
+        }
+
+        Request request = std::move(queue_.front());
+        queue_.pop_front();
+
+        bool hasSubdirectories = false;
+        std::vector<Owner> owners;
+
+        if (cache_.get(request.key, &hasSubdirectories)) {
+            // Answered while it waited in the queue.
+            completed_[request.owner].push_back(SubdirectoryProbeResult{request.path, hasSubdirectories});
+            owners.push_back(request.owner);
+        } else {
+            auto running = running_.find(request.key);
+            if (running != running_.end()) {
+                running->second.push_back(std::move(request));
+                continue;
+            }
+
+            std::wstring key = request.key;
+            std::wstring path = request.path;
+            running_[key].push_back(std::move(request));
+
+            lock.unlock();
+            bool readable = probe_(path, &hasSubdirectories);
+            lock.lock();
+
+            if (!readable) {
+                hasSubdirectories = false;
+            }
+
+            auto waiters = std::move(running_[key]);
+            running_.erase(key);
+            if (staleRunning_.erase(key) == 0 && readable) {
+                cache_.put(key, hasSubdirectories);
+            }
+
+            for (auto& waiter : waiters) {
+                completed_[waiter.owner].push_back(SubdirectoryProbeResult{waiter.path, hasSubdirectories});
+                if (std::find(owners.begin(), owners.end(), waiter.owner) == owners.end()) {
+                    owners.push_back(waiter.owner);
+                }
+            }
+        }
+
+        if (onCompleted_ && !owners.empty()) {
+            lock.unlock();
+            for (Owner owner : owners) {
+                onCompleted_(owner);
+            }
+            lock.lock();
+        }
+    }
+}
+
+}  // namespace libwinfile
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "PathCache.h"
+
+namespace libwinfile {
+
+// The answer to "does this directory have any subdirectories?" for one path.
+struct SubdirectoryProbeResult {
+    std::wstring path;       // As passed to probe().
+    bool hasSubdirectories;  // False as well if the directory could not be read.
+};
+
+// Answers "does this directory have subdirectories?" in the background, so the tree can draw its nodes at once in an
+// unknown state and fill in the expand markers as the answers arrive. On a network drive each answer is a round trip,
+// so only what is on screen is asked for, and each owner's newest request jumps the queue: after a scroll, the nodes
+// now in view are probed before the ones that scrolled away.
+//
+// Owners and completion work as in DirectoryLevelLoader: the callback runs on a worker thread as a wake-up and the
+// owner collects its answers with takeCompleted(). Answers are cached by path.
+class SubdirectoryProber {
+   public:
+    using Owner = uintptr_t;
+
+    // Sets *hasSubdirectories for path. Returns false if the directory could not be read.
+    using Probe = std::function<bool(const std::wstring& path, bool* hasSubdirectories)>;
+
+    using CompletionCallback = std::function<void(Owner owner)>;
+
+    static constexpr size_t kDefaultCacheCapacity = 65536;
+
+    SubdirectoryProber(
+        size_t threadCount,
+        Probe probe,
+        CompletionCallback onCompleted,
+        size_t cacheCapacity = kDefaultCacheCapacity);
+
+    // Calls stop().
+    ~SubdirectoryProber();
+
+    SubdirectoryProber(const SubdirectoryProber&) = delete;
+    SubdirectoryProber& operator=(const SubdirectoryProber&) = delete;
+
+    // If the answer for path is cached, stores it in *hasSubdirectories and returns true.
+    bool cached(const std::wstring& path, bool* hasSubdirectories);
+
+    // Records an answer the caller learned some other way, such as by reading the whole directory.
+    void store(const std::wstring& path, bool hasSubdirectories);
+
+    // Replaces owner's unanswered probes with paths, which are probed in the order given, ahead of other owners' older
+    // requests. Paths that are already being probed are not probed twice.
+    void probe(Owner owner, const std::vector<std::wstring>& paths);
+
+    // Removes and returns the answers ready for owner.
+    std::vector<SubdirectoryProbeResult> takeCompleted(Owner owner);
+
+    // Drops owner's queued probes and undelivered answers.
+    void cancel(Owner owner);
+
+    // Forgets the answer for path and, if subtree is true, for everything below it. An affected probe that is running
+    // right now is still delivered but not cached.
+    void invalidate(const std::wstring& path, bool subtree);
+
+    // Drops the queued probes and joins the threads, after the probes already running have called back. Later probes
+    // never run. Calling it again does nothing.
+    void stop();
+
+   private:
+    struct Request {
+        Owner owner;
+        std::wstring path;
+        std::wstring key;
+    };
+
+    void workerLoop();
+
+    Probe probe_;
+    CompletionCallback onCompleted_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_;
+    std::deque<Request> queue_;
+    std::unordered_map<std::wstring, std::vector<Request>> running_;  // Requests waiting on a running probe, by key.
+    std::unordered_set<std::wstring> staleRunning_;                   // Running probes invalidated since they started.
+    PathCache<bool> cache_;
+    std::unordered_map<Owner, std::vector<SubdirectoryProbeResult>> completed_;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace libwinfile
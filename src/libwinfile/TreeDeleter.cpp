@@ -0,0 +1,264 @@
+#include "libwinfile/pch.h"
+#include "TreeDeleter.h"
+#include "TreeWalker.h"
+
+#include <chrono>
+#include <thread>
+
+namespace libwinfile {
+
+namespace {
+
+// How often the caller hears how far the deletion has got.
+constexpr auto kProgressInterval = std::chrono::milliseconds(100);
+
+}  // namespace
+
+TreeDeleter::TreeDeleter(size_t threadCount, size_t queueCapacity)
+    : threadCount_(threadCount ? threadCount : 1), queueCapacity_(queueCapacity ? queueCapacity : 1) {}
+
+uint32_t TreeDeleter::deleteTree(
+    const std::wstring& directory,
+    uint32_t keepAttributes,
+    ProgressFunction progress,
+    KeepFunction keep) {
+    std::wstring path = directory;
+    while (path.size() > 3 && path.back() == L'\\') {
+        path.pop_back();
+    }
+
+    failures_.clear();
+    directories_.clear();
+    queue_.clear();
+    finished_ = false;
+    stopping_ = false;
+    deleted_ = 0;
+    keepAttributes_ = keepAttributes;
+    keep_ = std::move(keep);
+
+    DWORD attributes = GetFileAttributesW(path.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES) {
+        uint32_t error = GetLastError();
+        failures_.push_back(Failure{path, error});
+        return error;
+    }
+    if (attributes & keepAttributes_) {
+        return 0;
+    }
+
+    directories_.push_back(std::make_unique<Directory>());
+    Directory* root = directories_.back().get();
+    root->parent = nullptr;
+    root->path = path;
+    root->attributes = attributes;
+    root->pending = 1;
+    root->keep = false;
+
+    std::vector<std::thread> threads;
+    bool cancelled = false;
+    try {
+        for (size_t i = 0; i < threadCount_; i++) {
+            threads.emplace_back([this]() { workerLoop(); });
+        }
+
+        // A link or junction is removed without looking inside; listing it would list its target.
+        if (!(attributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+            cancelled = !list(root, progress);
+        }
+    } catch (...) {
+        // The workers must not outlive the tree they are deleting.
+        stop(&threads);
+        throw;
+    }
+
+    if (!cancelled) {
+        release(root);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            lock.unlock();
+            bool keepGoing = !progress || progress(deleted_);
+            lock.lock();
+
+            if (finished_) {
+                break;
+            }
+            if (!keepGoing) {
+                cancelled = true;
+                break;
+            }
+            done_.wait_for(lock, kProgressInterval, [this]() { return finished_.load(); });
+        }
+    }
+    stop(&threads);
+
+    if (cancelled) {
+        return ERROR_REQUEST_ABORTED;
+    }
+    return failures_.empty() ? 0 : failures_.front().error;
+}
+
+void TreeDeleter::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        work_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            return;
+        }
+
+        Task task = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        deleteFile(task);
+
+        lock.lock();
+    }
+}
+
+void TreeDeleter::stop(std::vector<std::thread>* threads) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_.notify_all();
+    for (auto& thread : *threads) {
+        thread.join();
+    }
+    queue_.clear();
+    directories_.clear();
+}
+
+void TreeDeleter::push(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Once the queue is full, files are deleted by the thread listing the tree, which holds a huge directory's
+        // listing back to the pace of its deletion.
+        if (queue_.size() < queueCapacity_) {
+            queue_.push_back(std::move(task));
+            work_.notify_one();
+            return;
+        }
+    }
+    deleteFile(task);
+}
+
+bool TreeDeleter::list(Directory* root, const ProgressFunction& progress) {
+    TreeWalker walker;
+    std::vector<Directory*> stack{root};  // The directory being listed, and those it is in.
+    auto reported = std::chrono::steady_clock::time_point();  // So progress is asked first, before anything goes.
+
+    uint32_t error = walker.start(root->path);
+    if (error && error != ERROR_FILE_NOT_FOUND) {
+        fail(root->path, error);
+        root->keep = true;
+    }
+
+    for (TreeWalker::Visit visit = walker.next(); visit != TreeWalker::Visit::End; visit = walker.next()) {
+        auto now = std::chrono::steady_clock::now();
+        if (progress && now - reported >= kProgressInterval) {
+            reported = now;
+            if (!progress(deleted_)) {
+                return false;
+            }
+        }
+
+        Directory* directory = stack.back();
+        const WIN32_FIND_DATAW& data = walker.data();
+
+        if (visit == TreeWalker::Visit::Leave) {
+            // Its listing is over, so once what is in it is gone it can go too.
+            if (walker.error()) {
+                fail(directory->path, walker.error());
+                directory->keep = true;
+            }
+            stack.pop_back();
+            release(directory);
+        } else if (data.dwFileAttributes & keepAttributes_) {
+            directory->keep = true;
+            if (visit == TreeWalker::Visit::Enter) {
+                walker.skip();
+            }
+        } else if (visit == TreeWalker::Visit::Enter) {
+            // Links and junctions are entered too, but not walked into; on the way out they are removed themselves.
+            directory->pending++;
+
+            directories_.push_back(std::make_unique<Directory>());
+            Directory* child = directories_.back().get();
+            child->parent = directory;
+            child->path = walker.path();
+            child->attributes = data.dwFileAttributes;
+            child->pending = 1;
+            child->keep = false;
+            stack.push_back(child);
+        } else if (keep_ && keep_(walker.path())) {
+            directory->keep = true;
+        } else {
+            directory->pending++;
+            push(Task{directory, walker.path(), data.dwFileAttributes});
+        }
+    }
+    return true;
+}
+
+void TreeDeleter::deleteFile(const Task& task) {
+    uint32_t error = remove(task.path, task.attributes);
+    if (error) {
+        fail(task.path, error);
+        task.directory->keep = true;
+    }
+    release(task.directory);
+}
+
+void TreeDeleter::release(Directory* directory) {
+    // The last one out of each directory removes it, and goes on up.
+    while (directory && --directory->pending == 0) {
+        Directory* parent = directory->parent;
+
+        if (!directory->keep) {
+            uint32_t error = remove(directory->path, directory->attributes);
+            if (error) {
+                fail(directory->path, error);
+                directory->keep = true;
+            }
+        }
+        if (parent && directory->keep) {
+            parent->keep = true;
+        }
+
+        if (!parent) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                finished_ = true;
+            }
+            done_.notify_all();
+        }
+        directory = parent;
+    }
+}
+
+uint32_t TreeDeleter::remove(const std::wstring& path, uint32_t attributes) {
+    if (attributes & FILE_ATTRIBUTE_READONLY) {
+        SetFileAttributesW(path.c_str(), attributes & ~FILE_ATTRIBUTE_READONLY);
+    }
+
+    // Links and junctions to directories are directories themselves, as far as removing them goes.
+    BOOL removed = (attributes & FILE_ATTRIBUTE_DIRECTORY) ? RemoveDirectoryW(path.c_str()) : DeleteFileW(path.c_str());
+    if (removed) {
+        deleted_++;
+        return 0;
+    }
+
+    // Gone already, which is all that was wanted.
+    uint32_t error = GetLastError();
+    return error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND ? 0 : error;
+}
+
+void TreeDeleter::fail(const std::wstring& path, uint32_t error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failures_.push_back(Failure{path, error});
+}
+
+}  // namespace libwinfile
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace libwinfile {
+
+// Deletes a directory tree for good, on a bounded pool of worker threads. The tree is listed once, by a TreeWalker on
+// the calling thread; the files in it are deleted by whichever workers are free, and a directory is removed as soon as
+// the last thing in it is gone, so the tree comes down from the bottom up while the rest of it is still being listed.
+// Deleting a tree of many small files one at a time is dominated by per-file latency, like copying them, so many
+// deletes in flight at once finish much sooner.
+//
+// Nothing asks the user anything. What they would be asked about is decided before the deleter starts: entries with
+// any of the attributes it is told to keep, read-only or hidden ones say, and files the caller picks out by path are
+// left alone for the caller to deal with afterwards, and anything else read-only is deleted all the same. Links and
+// junctions are removed themselves, never followed. What is kept or can't be deleted is left, along with the
+// directories above it; what can't be deleted is reported with the error that stopped it.
+class TreeDeleter {
+   public:
+    // Called on the thread that called deleteTree(), every so often and once at the end, with how many files and
+    // directories are gone so far. Returns false to stop: nothing more is started, and what is running finishes.
+    using ProgressFunction = std::function<bool(uint64_t deleted)>;
+
+    // Called on the thread that called deleteTree() with the path of each file as it is listed. Returns true to keep
+    // the file, as if it had one of the attributes to keep.
+    using KeepFunction = std::function<bool(const std::wstring& path)>;
+
+    struct Failure {
+        std::wstring path;
+        uint32_t error;
+    };
+
+    static constexpr size_t kDefaultQueueCapacity = 4096;
+
+    explicit TreeDeleter(size_t threadCount, size_t queueCapacity = kDefaultQueueCapacity);
+
+    TreeDeleter(const TreeDeleter&) = delete;
+    TreeDeleter& operator=(const TreeDeleter&) = delete;
+
+    // Deletes directory and everything in it but the entries with any of keepAttributes and the files keep asks to
+    // keep. Returns zero once all the rest is gone, ERROR_REQUEST_ABORTED if progress stopped it, or else the error of
+    // the first failure; failures() has them all. A directory that is a link or junction is only removed itself.
+    uint32_t deleteTree(
+        const std::wstring& directory,
+        uint32_t keepAttributes,
+        ProgressFunction progress = nullptr,
+        KeepFunction keep = nullptr);
+
+    // What the last deleteTree() couldn't delete, in the order it found out.
+    const std::vector<Failure>& failures() const { return failures_; }
+
+   private:
+    struct Directory {
+        Directory* parent;
+        std::wstring path;
+        uint32_t attributes;
+        std::atomic<size_t> pending;  // Entries not yet deleted, plus one until the directory has been listed.
+        std::atomic<bool> keep;       // Something in it is kept or couldn't be deleted, so it stays too.
+    };
+
+    struct Task {
+        Directory* directory;  // The directory the file is in.
+        std::wstring path;
+        uint32_t attributes;
+    };
+
+    void workerLoop();
+    void stop(std::vector<std::thread>* threads);
+    void push(Task task);
+    bool list(Directory* root, const ProgressFunction& progress);
+    void deleteFile(const Task& task);
+    void release(Directory* directory);
+    uint32_t remove(const std::wstring& path, uint32_t attributes);
+    void fail(const std::wstring& path, uint32_t error);
+
+    size_t threadCount_;
+    size_t queueCapacity_;
+    uint32_t keepAttributes_ = 0;
+    KeepFunction keep_;
+
+    std::mutex mutex_;
+    std::condition_variable work_;  // Signalled when a task is queued or the work is over.
+    std::condition_variable done_;  // Signalled when the root has been removed, or kept.
+    std::deque<Task> queue_;
+    std::deque<std::unique_ptr<Directory>> directories_;
+    std::atomic<bool> finished_{false};  // Set under mutex_, but also read without it.
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> deleted_{0};
+    std::vector<Failure> failures_;
+};
+
+}  // namespace libwinfile
@@ -0,0 +1,160 @@
+#include "libwinfile/pch.h"
+#include "TreePathIndex.h"
+
+#include <algorithm>
+
+namespace libwinfile {
+
+void TreePathIndex::update(Item* item) {
+    item->count = 1 + count(item->left) + count(item->right);
+    if (item->left) {
+        item->left->parent = item;
+    }
+    if (item->right) {
+        item->right->parent = item;
+    }
+}
+
+// Splits the subtree at item into the first position items and the rest.
+void TreePathIndex::split(Item* item, size_t position, Item** left, Item** right) {
+    if (!item) {
+        *left = *right = nullptr;
+        return;
+    }
+
+    if (count(item->left) < position) {
+        split(item->right, position - count(item->left) - 1, &item->right, right);
+        *left = item;
+    } else {
+        split(item->left, position, left, &item->left);
+        *right = item;
+    }
+    update(item);
+    item->parent = nullptr;
+}
+
+// Joins two subtrees, with every item of left before every item of right.
+TreePathIndex::Item* TreePathIndex::merge(Item* left, Item* right) {
+    if (!left || !right) {
+        return left ? left : right;
+    }
+
+    Item* top;
+    if (left->priority > right->priority) {
+        left->right = merge(left->right, right);
+        top = left;
+    } else {
+        right->left = merge(left, right->left);
+        top = right;
+    }
+    update(top);
+    top->parent = nullptr;
+    return top;
+}
+
+size_t TreePathIndex::position(const Item* item) {
+    size_t result = count(item->left);
+    for (; item->parent; item = item->parent) {
+        if (item == item->parent->right) {
+            result += count(item->parent->left) + 1;
+        }
+    }
+    return result;
+}
+
+void TreePathIndex::insert(const std::wstring& path, Node node, size_t position) {
+    remove(node);
+
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 17;
+    random_ ^= random_ << 5;
+
+    Item* item = &items_[node];
+    *item = Item{node, pathKey(path), nullptr, nullptr, nullptr, 1, random_};
+    byKey_[item->key].push_back(node);
+
+    Item* left;
+    Item* right;
+    split(root_, position, &left, &right);
+    root_ = merge(merge(left, item), right);
+}
+
+void TreePathIndex::remove(Node node) {
+    auto it = items_.find(node);
+    if (it == items_.end()) {
+        return;
+    }
+
+    Item* item = &it->second;
+    Item* parent = item->parent;
+    Item* children = merge(item->left, item->right);
+    if (!parent) {
+        root_ = children;
+    } else if (parent->left == item) {
+        parent->left = children;
+    } else {
+        parent->right = children;
+    }
+    if (children) {
+        children->parent = parent;
+    }
+    for (; parent; parent = parent->parent) {
+        parent->count--;
+    }
+
+    // Other nodes at the same path stay findable.
+    auto byKey = byKey_.find(item->key);
+    if (byKey != byKey_.end()) {
+        auto& nodes = byKey->second;
+        nodes.erase(std::find(nodes.begin(), nodes.end(), node));
+        if (nodes.empty()) {
+            byKey_.erase(byKey);
+        }
+    }
+    items_.erase(it);
+}
+
+void TreePathIndex::clear() {
+    byKey_.clear();
+    items_.clear();
+    root_ = nullptr;
+}
+
+const TreePathIndex::Item* TreePathIndex::findKey(const std::wstring& key) const {
+    auto it = byKey_.find(key);
+    return it == byKey_.end() ? nullptr : &items_.at(it->second.back());
+}
+
+TreePathIndex::Node TreePathIndex::find(const std::wstring& path, size_t* position) const {
+    const Item* item = findKey(pathKey(path));
+    if (!item) {
+        return nullptr;
+    }
+    *position = TreePathIndex::position(item);
+    return item->node;
+}
+
+TreePathIndex::Node TreePathIndex::findDeepest(const std::wstring& path, size_t* position, bool* exact) const {
+    std::wstring key = pathKey(path);
+    *exact = true;
+
+    while (!key.empty()) {
+        const Item* item = findKey(key);
+        if (item) {
+            *position = TreePathIndex::position(item);
+            return item->node;
+        }
+
+        *exact = false;
+        auto slash = key.find_last_of(L'\\');
+        if (slash == std::wstring::npos) {
+            break;
+        }
+        key.resize(slash);
+    }
+
+    *exact = false;
+    return nullptr;
+}
+
+}  // namespace libwinfile
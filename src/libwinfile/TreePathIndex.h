@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PathCache.h"
+
+namespace libwinfile {
+
+// Finds the nodes of the directory tree by full path with a hash lookup instead of a walk over the tree's items.
+// Paths are compared as pathKey() keys, so case and trailing backslashes don't matter.
+//
+// A node is an opaque pointer (winfile uses the PDNODE). The index mirrors the order of the owner's item list, so it
+// knows where each node is: the owner tells it about every item it inserts or removes, and the positions of the items
+// after it shift to match. Positions are kept in a tree ordered by position, so inserting, removing and finding where
+// a node is all take O(log n).
+class TreePathIndex {
+   public:
+    using Node = const void*;
+
+    TreePathIndex() = default;
+    TreePathIndex(const TreePathIndex&) = delete;
+    TreePathIndex& operator=(const TreePathIndex&) = delete;
+
+    // Records that node, at path, was inserted into the item list at position; the items from there on move down one.
+    // If node was already in the index, it is removed first. Of several nodes at one path, the one added last is found.
+    void insert(const std::wstring& path, Node node, size_t position);
+
+    // Records that node was removed from the item list; the items after it move up one. Does nothing if it was never
+    // inserted.
+    void remove(Node node);
+
+    void clear();
+
+    // Returns the node at path and stores its position in *position, or returns nullptr.
+    Node find(const std::wstring& path, size_t* position) const;
+
+    // Returns the node at path or, failing that, at its deepest recorded ancestor; nullptr if there is neither.
+    // *exact says which it was.
+    Node findDeepest(const std::wstring& path, size_t* position, bool* exact) const;
+
+    // How many nodes are in the index.
+    size_t size() const { return items_.size(); }
+
+   private:
+    // One item of the owner's list: a node of a treap ordered by position, with heap order on priority.
+    struct Item {
+        Node node;
+        std::wstring key;
+        Item* parent;
+        Item* left;
+        Item* right;
+        size_t count;  // Items in the subtree rooted here, this one included.
+        uint32_t priority;
+    };
+
+    static size_t count(const Item* item) { return item ? item->count : 0; }
+    static void update(Item* item);
+    static void split(Item* item, size_t position, Item** left, Item** right);
+    static Item* merge(Item* left, Item* right);
+    static size_t position(const Item* item);
+
+    const Item* findKey(const std::wstring& key) const;
+
+    std::unordered_map<std::wstring, std::vector<Node>> byKey_;  // The nodes at each key, in the order they were added.
+    std::unordered_map<Node, Item> items_;  // Elements of an unordered_map don't move, so Items can point at each other.
+    Item* root_ = nullptr;
+    uint32_t random_ = 2463534242;  // State of the xorshift generator that picks priorities.
+};
+
+}  // namespace libwinfile
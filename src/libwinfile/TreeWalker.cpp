@@ -0,0 +1,235 @@
+#include "libwinfile/pch.h"
+#include "TreeWalker.h"
+
+namespace libwinfile {
+
+namespace {
+
+bool isDotDirectory(const wchar_t* name) {
+    return name[0] == L'.' && (name[1] == L'\0' || (name[1] == L'.' && name[2] == L'\0'));
+}
+
+bool isSeparator(wchar_t ch) {
+    return ch == L'\\' || ch == L'/';
+}
+
+}  // namespace
+
+TreeWalker::TreeWalker(size_t batchSize) : batchSize_(batchSize ? batchSize : 1) {}
+
+TreeWalker::~TreeWalker() {
+    stop();
+}
+
+uint32_t TreeWalker::start(
+    const std::wstring& directory,
+    const std::wstring& pattern,
+    uint32_t flags,
+    size_t maxPathLength) {
+    stop();
+
+    // Trailing separators are dropped, but for the one of a drive's root.
+    path_ = directory;
+    while (path_.size() > 1 && isSeparator(path_.back()) && !(path_.size() == 3 && path_[1] == L':')) {
+        path_.pop_back();
+    }
+    flags_ = flags;
+    maxPathLength_ = maxPathLength;
+    pattern_ = pattern;
+
+    if (levels_.empty()) {
+        levels_.emplace_back();
+    }
+    Level& root = levels_[0];
+    root.find = INVALID_HANDLE_VALUE;
+    root.listed = false;
+    root.pathLength = path_.size();
+    root.count = 0;
+    root.position = 0;
+    root.error = 0;
+
+    top_ = 0;
+    depth_ = 0;
+    error_ = 0;
+    current_ = nullptr;
+    walking_ = true;
+
+    if (!fill(&root, pattern_.c_str()) && root.error) {
+        uint32_t error = root.error;
+        stop();
+        return error;
+    }
+    return 0;
+}
+
+TreeWalker::Visit TreeWalker::next() {
+    current_ = nullptr;
+    error_ = 0;
+    if (!walking_) {
+        return Visit::End;
+    }
+
+    if (descend_) {
+        descend_ = false;
+
+        // Levels are kept once made, with their buffers, for the next directory as deep.
+        if (levels_.size() == top_ + 1) {
+            levels_.emplace_back();
+        }
+        Level& child = levels_[top_ + 1];
+        child.self = levels_[top_].batch[levels_[top_].position - 1];
+        child.find = INVALID_HANDLE_VALUE;
+        child.listed = !isWalkedInto(child.self);  // A link is left as soon as it is entered.
+        child.pathLength = path_.size();
+        child.count = 0;
+        child.position = 0;
+        child.error = 0;
+        top_++;
+    }
+
+    while (true) {
+        Level& level = levels_[top_];
+
+        if (level.position == level.count && (!level.listed || level.find != INVALID_HANDLE_VALUE)) {
+            fill(&level, top_ == 0 ? pattern_.c_str() : L"*");
+        }
+
+        if (level.position < level.count) {
+            WIN32_FIND_DATAW& data = level.batch[level.position++];
+            bool directory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            if (isDotDirectory(data.cFileName) || ((flags_ & kDirectoriesOnly) && !directory)) {
+                continue;
+            }
+
+            path_.resize(level.pathLength);
+            if (path_.empty() || !isSeparator(path_.back())) {
+                path_ += L'\\';
+            }
+            path_ += data.cFileName;
+            current_ = &data;
+            depth_ = top_ + 1;
+
+            // Too long to be opened, let alone what is inside, unless the short name fits instead; then the entry goes
+            // by it, cFileName included.
+            if (path_.size() >= maxPathLength_) {
+                size_t nameLength = wcslen(data.cFileName);
+                size_t shortLength = wcslen(data.cAlternateFileName);
+                if (!shortLength || path_.size() - nameLength + shortLength >= maxPathLength_) {
+                    error_ = ERROR_FILENAME_EXCED_RANGE;
+                    return directory ? Visit::Enter : Visit::File;
+                }
+                path_.resize(path_.size() - nameLength);
+                path_ += data.cAlternateFileName;
+                wmemcpy(data.cFileName, data.cAlternateFileName, shortLength + 1);
+            }
+
+            if (directory) {
+                descend_ = true;
+                return Visit::Enter;
+            }
+            return Visit::File;
+        }
+
+        path_.resize(level.pathLength);
+        if (top_ == 0) {
+            stop();
+            return Visit::End;
+        }
+
+        current_ = &level.self;
+        error_ = level.error == ERROR_FILE_NOT_FOUND ? 0 : level.error;
+        depth_ = top_;
+        top_--;
+        return Visit::Leave;
+    }
+}
+
+void TreeWalker::skip() {
+    descend_ = false;
+}
+
+void TreeWalker::stop() {
+    for (auto& level : levels_) {
+        close(&level);
+    }
+    walking_ = false;
+    descend_ = false;
+    top_ = 0;
+    depth_ = 0;
+}
+
+uint32_t TreeWalker::walk(
+    const std::wstring& directory,
+    const std::wstring& pattern,
+    uint32_t flags,
+    const VisitFunction& visit) {
+    uint32_t error = start(directory, pattern, flags);
+    if (error) {
+        return error;
+    }
+
+    for (Visit visited = next(); visited != Visit::End; visited = next()) {
+        Action action = visit(visited, *this);
+        if (action == Action::Stop) {
+            stop();
+        } else if (action == Action::Skip && visited == Visit::Enter) {
+            skip();
+        }
+    }
+    return 0;
+}
+
+bool TreeWalker::fill(Level* level, const wchar_t* pattern) {
+    level->count = 0;
+    level->position = 0;
+    if (level->batch.size() < batchSize_) {
+        level->batch.resize(batchSize_);
+    }
+
+    if (!level->listed) {
+        // path_ is the directory itself until its listing has begun.
+        level->listed = true;
+        std::wstring spec = path_;
+        if (spec.empty() || !isSeparator(spec.back())) {
+            spec += L'\\';
+        }
+        spec += pattern;
+
+        level->find = FindFirstFileExW(
+            spec.c_str(), (flags_ & kShortNames) ? FindExInfoStandard : FindExInfoBasic, &level->batch[0],
+            (flags_ & kDirectoriesOnly) ? FindExSearchLimitToDirectories : FindExSearchNameMatch, nullptr,
+            FIND_FIRST_EX_LARGE_FETCH);
+        if (level->find == INVALID_HANDLE_VALUE) {
+            level->error = GetLastError();
+            return false;
+        }
+        level->count = 1;
+    }
+
+    while (level->count < batchSize_ && level->find != INVALID_HANDLE_VALUE) {
+        if (FindNextFileW(level->find, &level->batch[level->count])) {
+            level->count++;
+        } else {
+            uint32_t error = GetLastError();
+            if (error != ERROR_NO_MORE_FILES) {
+                level->error = error;
+            }
+            close(level);
+        }
+    }
+    return level->count > 0;
+}
+
+bool TreeWalker::isWalkedInto(const WIN32_FIND_DATAW& data) const {
+    return (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+        (!(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) || (flags_ & kFollowLinks));
+}
+
+void TreeWalker::close(Level* level) {
+    if (level->find != INVALID_HANDLE_VALUE) {
+        FindClose(level->find);
+        level->find = INVALID_HANDLE_VALUE;
+    }
+}
+
+}  // namespace libwinfile
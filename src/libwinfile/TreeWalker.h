@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace libwinfile {
+
+// Walks a directory tree depth first, one entry per call to next(), without recursion. The directories being walked
+// are kept on a stack that grows with the depth of the tree, so there is no limit on depth but the length of the
+// paths, and each level keeps its listing buffer once it has one, so a walk allocates little after its first descent.
+// Each directory is listed in batches of entries, with the system fetching large runs of them at once.
+//
+// A directory is visited on the way in, before what is in it (pre-order), and again on the way out (post-order). Links
+// and junctions to directories are visited the same way but, unless kFollowLinks is given, not walked into; what they
+// point to is not part of the tree. Not thread-safe.
+class TreeWalker {
+   public:
+    enum class Visit {
+        End,    // The walk is over.
+        File,   // Anything but a directory.
+        Enter,  // A directory, before what is in it.
+        Leave,  // A directory, after what is in it.
+    };
+
+    enum Flags : uint32_t {
+        kShortNames = 1,       // Fill in cAlternateFileName, which costs a little more to list.
+        kDirectoriesOnly = 2,  // Visit directories only.
+        kFollowLinks = 4,      // Walk into links and junctions to directories too.
+    };
+
+    // What a visit function has the walk do next.
+    enum class Action {
+        Continue,
+        Skip,  // After Enter: leave the directory out, neither walking into it nor visiting it on the way out.
+        Stop,
+    };
+
+    using VisitFunction = std::function<Action(Visit visit, const TreeWalker& walker)>;
+
+    static constexpr size_t kDefaultBatchSize = 64;
+
+    explicit TreeWalker(size_t batchSize = kDefaultBatchSize);
+    ~TreeWalker();
+
+    TreeWalker(const TreeWalker&) = delete;
+    TreeWalker& operator=(const TreeWalker&) = delete;
+
+    // Starts walking what is in directory whose names match pattern, such as "*.txt"; the directories below are
+    // walked whole. A walk under way is ended first. Returns zero, or the error listing directory, in which case there
+    // is nothing to walk.
+    // An entry whose full path is maxPathLength characters or longer goes by its short name if that fits, which takes
+    // kShortNames. Otherwise it is still visited, but with error() set to ERROR_FILENAME_EXCED_RANGE; a directory among
+    // them is not walked into, nor visited on the way out.
+    uint32_t start(
+        const std::wstring& directory,
+        const std::wstring& pattern = L"*",
+        uint32_t flags = 0,
+        size_t maxPathLength = SIZE_MAX);
+
+    // Moves on to the next entry and says how it is visited.
+    Visit next();
+
+    // After Enter: leaves the directory out, neither walking into it nor visiting it on the way out.
+    void skip();
+
+    // Ends the walk, so that next() returns End.
+    void stop();
+
+    // The entry visited: for Leave the directory's own, as it was on Enter. Valid until the next call to next().
+    const WIN32_FIND_DATAW& data() const { return *current_; }
+
+    // The full path of the entry visited, or at End of the directory walked.
+    const std::wstring& path() const { return path_; }
+
+    // How deep the entry visited is, 1 for what is directly in the directory walked.
+    size_t depth() const { return depth_; }
+
+    // On Leave, the error that kept the directory from being listed in full; on File or Enter,
+    // ERROR_FILENAME_EXCED_RANGE if the path is too long, even by the short name. Otherwise zero.
+    uint32_t error() const { return error_; }
+
+    // Walks directory, calling visit for each entry on the thread that calls it. Returns what start() does.
+    uint32_t walk(
+        const std::wstring& directory,
+        const std::wstring& pattern,
+        uint32_t flags,
+        const VisitFunction& visit);
+
+   private:
+    struct Level {
+        HANDLE find = INVALID_HANDLE_VALUE;
+        bool listed = false;    // FindFirstFileExW has been called.
+        size_t pathLength = 0;  // The length of path_ for the directory itself.
+        std::vector<WIN32_FIND_DATAW> batch;
+        size_t count = 0;     // Entries in batch.
+        size_t position = 0;  // The next entry in batch to visit.
+        uint32_t error = 0;
+        WIN32_FIND_DATAW self{};  // The directory's own entry, from its parent's listing.
+    };
+
+    bool fill(Level* level, const wchar_t* pattern);
+    bool isWalkedInto(const WIN32_FIND_DATAW& data) const;
+    void close(Level* level);
+
+    size_t batchSize_;
+    uint32_t flags_ = 0;
+    size_t maxPathLength_ = SIZE_MAX;
+    std::wstring pattern_;
+    std::vector<Level> levels_;  // levels_[0] is the directory walked; levels_[top_] the one being listed.
+    size_t top_ = 0;
+    size_t depth_ = 0;
+    bool walking_ = false;
+    bool descend_ = false;  // The last visit was Enter, and next() walks into it.
+    std::wstring path_;
+    const WIN32_FIND_DATAW* current_ = nullptr;
+    uint32_t error_ = 0;
+};
+
+}  // namespace libwinfile
@@ -0,0 +1,326 @@
+#include "libwinfile/pch.h"
+#include "UnbufferedCopier.h"
+
+#include <algorithm>
+
+namespace libwinfile {
+
+namespace {
+
+constexpr DWORD kUnsupportedAttributes = FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_COMPRESSED |
+    FILE_ATTRIBUTE_ENCRYPTED | FILE_ATTRIBUTE_SPARSE_FILE | FILE_ATTRIBUTE_REPARSE_POINT;
+
+struct FileHandle {
+    HANDLE handle = INVALID_HANDLE_VALUE;
+
+    ~FileHandle() {
+        if (handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(handle);
+        }
+    }
+};
+
+// One of the buffers that take turns being read into and written from, with the I/O in flight on it if any.
+struct Buffer {
+    void* data = nullptr;
+    OVERLAPPED overlapped{};
+    HANDLE file = INVALID_HANDLE_VALUE;  // That the pending I/O is on; invalid when none is.
+    DWORD length = 0;                    // Bytes of file data in the buffer.
+
+    Buffer() = default;
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    ~Buffer() {
+        if (file != INVALID_HANDLE_VALUE) {
+            DWORD ignored;
+            CancelIoEx(file, &overlapped);
+            GetOverlappedResult(file, &overlapped, &ignored, TRUE);
+        }
+        if (overlapped.hEvent) {
+            CloseHandle(overlapped.hEvent);
+        }
+        if (data) {
+            VirtualFree(data, 0, MEM_RELEASE);
+        }
+    }
+};
+
+bool hasAlternateStreams(const std::wstring& path) {
+    WIN32_FIND_STREAM_DATA stream;
+    HANDLE find = FindFirstStreamW(path.c_str(), FindStreamInfoStandard, &stream, 0);
+    if (find == INVALID_HANDLE_VALUE) {
+        return false;  // No streams at all, or a file system without them.
+    }
+    bool more = FindNextStreamW(find, &stream) != FALSE;
+    FindClose(find);
+    return more;
+}
+
+// Starts reading or writing length bytes at offset. A read at or past the end of the file completes at once with
+// nothing read.
+uint32_t start(Buffer* buffer, HANDLE file, uint64_t offset, DWORD length, bool write) {
+    HANDLE event = buffer->overlapped.hEvent;
+    buffer->overlapped = OVERLAPPED{};
+    buffer->overlapped.Offset = static_cast<DWORD>(offset);
+    buffer->overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    buffer->overlapped.hEvent = event;
+
+    BOOL ok = write ? WriteFile(file, buffer->data, length, nullptr, &buffer->overlapped)
+                    : ReadFile(file, buffer->data, length, nullptr, &buffer->overlapped);
+    if (!ok) {
+        DWORD error = GetLastError();
+        if (!write && error == ERROR_HANDLE_EOF) {
+            return 0;
+        }
+        if (error != ERROR_IO_PENDING) {
+            return error;
+        }
+    }
+    buffer->file = file;
+    return 0;
+}
+
+// Waits for the buffer's I/O, if any, and stores how many bytes it moved.
+uint32_t finish(Buffer* buffer, DWORD* transferred) {
+    *transferred = 0;
+    if (buffer->file == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    BOOL ok = GetOverlappedResult(buffer->file, &buffer->overlapped, transferred, TRUE);
+    buffer->file = INVALID_HANDLE_VALUE;
+    if (!ok) {
+        DWORD error = GetLastError();
+        return error == ERROR_HANDLE_EOF ? 0 : error;
+    }
+    return 0;
+}
+
+bool allocate(std::vector<Buffer>* buffers, uint32_t bufferSize) {
+    for (auto& buffer : *buffers) {
+        buffer.data = VirtualAlloc(nullptr, bufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        buffer.overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (!buffer.data || !buffer.overlapped.hEvent) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+UnbufferedCopier::UnbufferedCopier(uint32_t bufferSize, uint32_t bufferCount)
+    : bufferSize_(bufferSize), bufferCount_(bufferCount) {
+    if (bufferSize_ > UINT32_MAX - kAlignment) {
+        throw std::invalid_argument("UnbufferedCopier buffer is too large.");
+    }
+    bufferSize_ = std::max(kAlignment, (bufferSize_ + kAlignment - 1) / kAlignment * kAlignment);
+    bufferCount_ = std::max(bufferCount_, 2u);
+}
+
+uint32_t UnbufferedCopier::copy(
+    const std::wstring& from,
+    const std::wstring& to,
+    const Progress& progress,
+    Crc32c* sourceChecksum,
+    bool resumable,
+    uint64_t offset) const {
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExW(from.c_str(), GetFileExInfoStandard, &attributes)) {
+        return GetLastError();
+    }
+    if ((attributes.dwFileAttributes & kUnsupportedAttributes) || hasAlternateStreams(from)) {
+        return ERROR_NOT_SUPPORTED;
+    }
+
+    // Declared ahead of the buffers, so that any I/O still pending when they go is cancelled while the handles are
+    // open.
+    FileHandle source;
+    FileHandle destination;
+    source.handle = CreateFileW(
+        from.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (source.handle == INVALID_HANDLE_VALUE) {
+        return ERROR_NOT_SUPPORTED;
+    }
+
+    LARGE_INTEGER sourceSize;
+    if (!GetFileSizeEx(source.handle, &sourceSize)) {
+        return GetLastError();
+    }
+    uint64_t size = static_cast<uint64_t>(sourceSize.QuadPart);
+
+    std::vector<Buffer> buffers(bufferCount_);
+    if (!allocate(&buffers, bufferSize_)) {
+        return ERROR_NOT_SUPPORTED;
+    }
+
+    // Any trouble opening the destination this way is left to CopyFileEx, which also reports the real errors, such as
+    // a read-only or hidden file in the way.
+    if (offset % kAlignment || offset > size) {
+        offset = 0;
+    }
+    destination.handle = CreateFileW(
+        to.c_str(), GENERIC_WRITE | DELETE, 0, nullptr, offset ? OPEN_ALWAYS : CREATE_ALWAYS,
+        FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED, nullptr);
+    if (destination.handle == INVALID_HANDLE_VALUE) {
+        return ERROR_NOT_SUPPORTED;
+    }
+    if (offset) {
+        LARGE_INTEGER destinationSize;
+        if (!GetFileSizeEx(destination.handle, &destinationSize) ||
+            static_cast<uint64_t>(destinationSize.QuadPart) < offset) {
+            offset = 0;
+        }
+    }
+
+    // Reserving the space up front keeps the new file in as few pieces as the volume can manage. It is only a hint.
+    FILE_ALLOCATION_INFO allocation;
+    allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+    SetFileInformationByHandle(destination.handle, FileAllocationInfo, &allocation, sizeof(allocation));
+
+    // Chunk k of what is left to copy, at offset + k * bufferSize_, goes through buffers[k % bufferCount_]. Every
+    // buffer starts with a read; from then on, each time a chunk's write is started, the previous chunk's write is
+    // waited for and its buffer reads the next chunk it is due. So there is always a read in flight alongside the
+    // write.
+    uint64_t chunks = (size - offset + bufferSize_ - 1) / bufferSize_;
+    uint64_t done = offset;
+    uint64_t end = offset;
+    uint32_t error = 0;
+
+    for (uint64_t k = 0; k < chunks && k < bufferCount_ && !error; k++) {
+        error = start(&buffers[k], source.handle, offset + k * bufferSize_, bufferSize_, false);
+    }
+
+    for (uint64_t k = 0; k <= chunks && !error; k++) {
+        if (k < chunks) {
+            Buffer* current = &buffers[k % bufferCount_];
+            DWORD read;
+            if ((error = finish(current, &read))) {
+                break;
+            }
+            current->length = read;
+            if (read) {
+                // The tail of the last chunk is written out to a whole sector and cut off below.
+                DWORD length = (read + kAlignment - 1) / kAlignment * kAlignment;
+                end = offset + k * bufferSize_ + read;
+                if ((error = start(current, destination.handle, offset + k * bufferSize_, length, true))) {
+                    break;
+                }
+                if (sourceChecksum) {
+                    sourceChecksum->update(current->data, read);
+                }
+            }
+        }
+
+        if (k > 0) {
+            Buffer* previous = &buffers[(k - 1) % bufferCount_];
+            DWORD written;
+            if ((error = finish(previous, &written))) {
+                break;
+            }
+            done += previous->length;
+            if (progress && !progress(done, size)) {
+                error = ERROR_REQUEST_ABORTED;
+                break;
+            }
+            if (k - 1 + bufferCount_ < chunks) {
+                error = start(
+                    previous, source.handle, offset + (k - 1 + bufferCount_) * bufferSize_, bufferSize_, false);
+            }
+        }
+    }
+
+    if (!error) {
+        FILE_END_OF_FILE_INFO endOfFile;
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(end);
+        if (!SetFileInformationByHandle(destination.handle, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile))) {
+            error = GetLastError();
+        }
+    }
+
+    if (!error) {
+        // As CopyFileEx does, the copy keeps the source's attributes and last write time and is created now.
+        FILE_BASIC_INFO basic{};
+        basic.LastWriteTime.LowPart = attributes.ftLastWriteTime.dwLowDateTime;
+        basic.LastWriteTime.HighPart = static_cast<LONG>(attributes.ftLastWriteTime.dwHighDateTime);
+        basic.FileAttributes = attributes.dwFileAttributes;
+        if (!SetFileInformationByHandle(destination.handle, FileBasicInfo, &basic, sizeof(basic))) {
+            error = GetLastError();
+        }
+    }
+
+    if (error) {
+        // Nothing may write into a buffer or the file once they are gone.
+        buffers.clear();
+
+        // What a resumable copy got onto the disk is kept, unless it was cancelled.
+        if (!resumable || error == ERROR_REQUEST_ABORTED || done == 0) {
+            FILE_DISPOSITION_INFO disposition;
+            disposition.DeleteFile = TRUE;
+            SetFileInformationByHandle(destination.handle, FileDispositionInfo, &disposition, sizeof(disposition));
+        }
+    }
+
+    return error;
+}
+
+uint32_t UnbufferedCopier::checksum(
+    const std::wstring& path,
+    bool bypassCache,
+    Crc32c* crc,
+    const Progress& progress) const {
+    FileHandle file;
+    DWORD flags = FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN;
+    file.handle = CreateFileW(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        flags | (bypassCache ? FILE_FLAG_NO_BUFFERING : 0), nullptr);
+    if (file.handle == INVALID_HANDLE_VALUE && bypassCache) {
+        file.handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    }
+    if (file.handle == INVALID_HANDLE_VALUE) {
+        return GetLastError();
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file.handle, &fileSize)) {
+        return GetLastError();
+    }
+    uint64_t size = static_cast<uint64_t>(fileSize.QuadPart);
+
+    std::vector<Buffer> buffers(bufferCount_);
+    if (!allocate(&buffers, bufferSize_)) {
+        return ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    // As in copy(), chunk k goes through buffers[k % bufferCount_]; each buffer reads its next chunk as soon as it has
+    // been summed.
+    uint64_t chunks = (size + bufferSize_ - 1) / bufferSize_;
+    uint64_t done = 0;
+    uint32_t error = 0;
+
+    for (uint64_t k = 0; k < chunks && k < bufferCount_ && !error; k++) {
+        error = start(&buffers[k], file.handle, k * bufferSize_, bufferSize_, false);
+    }
+
+    for (uint64_t k = 0; k < chunks && !error; k++) {
+        Buffer* current = &buffers[k % bufferCount_];
+        DWORD read;
+        if ((error = finish(current, &read))) {
+            break;
+        }
+        crc->update(current->data, read);
+        done += read;
+        if (progress && !progress(done, size)) {
+            error = ERROR_REQUEST_ABORTED;
+            break;
+        }
+        if (k + bufferCount_ < chunks) {
+            error = start(current, file.handle, (k + bufferCount_) * bufferSize_, bufferSize_, false);
+        }
+    }
+
+    return error;
+}
+
+}  // namespace libwinfile
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "Crc32c.h"
+
+namespace libwinfile {
+
+// Copies huge files, such as VM images and ISOs, with unbuffered I/O: the data goes straight between the disks and
+// large aligned buffers of our own, rather than through the system cache. A multi-GB copy through the cache pushes
+// everything else out of it for data that will not be read again soon, and on fast drives the extra memory copy costs
+// throughput. The buffers are used in turn, so one is written while the next is read.
+//
+// Only plain data files are copied this way. A file with alternate data streams, or one that is compressed, encrypted,
+// sparse or a reparse point, needs what CopyFileEx knows about them; so does a volume that refuses unbuffered handles.
+// copy() returns ERROR_NOT_SUPPORTED for those without touching the destination, and the caller copies them as usual.
+//
+// To verify a copy, copy() can checksum the source as each chunk passes through memory, while the chunk is being
+// written; checksum() then reads the copy back from the disk itself.
+class UnbufferedCopier {
+   public:
+    // Reports done of size bytes written. Returning false cancels the copy.
+    using Progress = std::function<bool(uint64_t done, uint64_t size)>;
+
+    static constexpr uint32_t kDefaultBufferSize = 4 * 1024 * 1024;
+    static constexpr uint32_t kDefaultBufferCount = 2;
+
+    // Unbuffered reads and writes must be whole sectors at sector offsets. Buffers are multiples of this, which any
+    // sector size divides.
+    static constexpr uint32_t kAlignment = 64 * 1024;
+
+    // bufferSize is rounded up to a multiple of kAlignment; bufferCount is at least 2.
+    explicit UnbufferedCopier(uint32_t bufferSize = kDefaultBufferSize, uint32_t bufferCount = kDefaultBufferCount);
+
+    uint32_t bufferSize() const { return bufferSize_; }
+    uint32_t bufferCount() const { return bufferCount_; }
+
+    // Copies from to to, replacing to, along with the source's attributes and times, adding the data copied to
+    // sourceChecksum if it isn't null. Returns zero or a Win32 error code: ERROR_REQUEST_ABORTED if progress cancelled
+    // it, and ERROR_NOT_SUPPORTED as described above. A failed or cancelled copy deletes the partial destination. Safe
+    // to call from several threads at once.
+    //
+    // A copy that may need resuming passes resumable: if it then fails, other than by being cancelled, whatever was
+    // written, up to the last done that progress reported, is left in place. To carry on from there, pass the offset
+    // up to which it was written; the copy keeps that much of to and goes on from it, or starts over if the offset is
+    // not a multiple of kAlignment or to is shorter. Only the data copied this time is added to sourceChecksum.
+    uint32_t copy(
+        const std::wstring& from,
+        const std::wstring& to,
+        const Progress& progress = nullptr,
+        Crc32c* sourceChecksum = nullptr,
+        bool resumable = false,
+        uint64_t offset = 0) const;
+
+    // Adds the contents of path to crc, reading the next chunk while the last is summed. With bypassCache the data
+    // comes from the disk rather than the system cache, where the volume allows it. Returns zero or a Win32 error code,
+    // ERROR_REQUEST_ABORTED if progress cancelled it.
+    uint32_t checksum(
+        const std::wstring& path,
+        bool bypassCache,
+        Crc32c* crc,
+        const Progress& progress = nullptr) const;
+
+   private:
+    uint32_t bufferSize_;
+    uint32_t bufferCount_;
+};
+
+}  // namespace libwinfile
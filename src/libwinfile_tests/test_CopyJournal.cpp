@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "libwinfile/CopyJournal.h"
+
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::CopyJournal;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (CopyJournalTests) {
+    std::filesystem::path tempDir_;
+
+    std::filesystem::path JournalPath(const std::wstring& name) {
+        return tempDir_ / (name + CopyJournal::kExtension);
+    }
+
+    static void Append(const std::filesystem::path& path, const std::string& text) {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file << text;
+    }
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        tempDir_ = std::filesystem::temp_directory_path() / "libwinfile_journal_test";
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+        std::filesystem::create_directories(tempDir_);
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+    }
+
+   public:
+    TEST_METHOD (ReadsBackWhatWasRecorded) {
+        auto path = JournalPath(L"job");
+        const std::wstring from = L"\"C:\\Virtual Machines\\*.*\" C:\\Stra\u00dfe\\\u65e5\u672c.iso";
+        {
+            CopyJournal journal(path, from, L"\\\\server\\backup\\");
+            journal.recordDone(L"\\\\server\\backup\\a.vhdx");
+            journal.recordPartial(L"\\\\server\\backup\\b.vhdx", {1000000, 132000000000000000ull}, 65536);
+            journal.recordPartial(L"\\\\server\\backup\\c.vhdx", {5, 6}, 65536);
+            journal.recordDone(L"\\\\server\\backup\\c.vhdx");
+        }
+
+        CopyJournal journal(path);
+        Assert::AreEqual(from, journal.from());
+        Assert::AreEqual(std::wstring(L"\\\\server\\backup\\"), journal.to());
+
+        // Paths compare as Windows compares them.
+        Assert::IsTrue(journal.isDone(L"\\\\SERVER\\Backup\\A.vhdx"));
+        Assert::IsFalse(journal.isDone(L"\\\\server\\backup\\b.vhdx"));
+        Assert::IsTrue(journal.isDone(L"\\\\server\\backup\\c.vhdx"));
+
+        CopyJournal::Source source;
+        uint64_t offset = 0;
+        Assert::IsTrue(journal.partial(L"\\\\server\\backup\\b.vhdx", &source, &offset));
+        Assert::AreEqual(uint64_t(1000000), source.size);
+        Assert::AreEqual(uint64_t(132000000000000000ull), source.lastWriteTime);
+        Assert::AreEqual(uint64_t(65536), offset);
+        Assert::IsFalse(journal.partial(L"\\\\server\\backup\\c.vhdx", &source, &offset));
+        Assert::IsFalse(journal.partial(L"\\\\server\\backup\\a.vhdx", &source, &offset));
+
+        auto partials = journal.partialDestinations();
+        Assert::AreEqual(size_t(1), partials.size());
+        Assert::AreEqual(std::wstring(L"\\\\server\\backup\\b.vhdx"), partials[0]);
+    }
+
+    TEST_METHOD (LaterPartialRecordsReplaceEarlierOnes) {
+        auto path = JournalPath(L"job");
+        {
+            CopyJournal journal(path, L"C:\\big.iso", L"D:\\");
+            journal.recordPartial(L"D:\\big.iso", {100, 1}, 65536);
+            journal.recordPartial(L"D:\\big.iso", {100, 1}, 131072);
+        }
+
+        CopyJournal journal(path);
+        CopyJournal::Source source;
+        uint64_t offset = 0;
+        Assert::IsTrue(journal.partial(L"D:\\big.iso", &source, &offset));
+        Assert::AreEqual(uint64_t(131072), offset);
+    }
+
+    TEST_METHOD (ClearedPartialRecordsStayCleared) {
+        auto path = JournalPath(L"job");
+        {
+            CopyJournal journal(path, L"C:\\big.iso", L"D:\\");
+            journal.recordPartial(L"D:\\big.iso", {100, 1}, 65536);
+            journal.clearPartial(L"D:\\big.iso");
+        }
+
+        CopyJournal journal(path);
+        CopyJournal::Source source;
+        uint64_t offset = 0;
+        Assert::IsFalse(journal.partial(L"D:\\big.iso", &source, &offset));
+        Assert::IsTrue(journal.partialDestinations().empty());
+    }
+
+    TEST_METHOD (IgnoresARecordTornByACrash) {
+        auto path = JournalPath(L"job");
+        {
+            CopyJournal journal(path, L"C:\\", L"D:\\");
+            journal.recordDone(L"D:\\one");
+        }
+        Append(path, "done\tD:\\tw");
+
+        {
+            CopyJournal journal(path);
+            Assert::IsTrue(journal.isDone(L"D:\\one"));
+            Assert::IsFalse(journal.isDone(L"D:\\tw"));
+            journal.recordDone(L"D:\\two");
+        }
+
+        // The torn record is gone, rather than run together with the next one.
+        CopyJournal journal(path);
+        Assert::IsTrue(journal.isDone(L"D:\\two"));
+        Assert::IsFalse(journal.isDone(L"D:\\tw"));
+    }
+
+    TEST_METHOD (RefusesFilesThatAreNotJournals) {
+        auto path = JournalPath(L"other");
+        Append(path, "something else\nfrom\tC:\\\nto\tD:\\\n");
+        Assert::ExpectException<std::runtime_error>([&] { CopyJournal journal(path); });
+
+        auto torn = JournalPath(L"torn");
+        Append(torn, "heirloom copy journal 1\nfrom\tC:\\\nto\tD:");
+        Assert::ExpectException<std::runtime_error>([&] { CopyJournal journal(torn); });
+
+        Assert::ExpectException<std::runtime_error>([&] { CopyJournal journal(JournalPath(L"missing")); });
+    }
+
+    TEST_METHOD (ListsJournalsOldestFirstAndRemovesThem) {
+        CopyJournal first(JournalPath(L"b"), L"C:\\1", L"D:\\");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CopyJournal second(JournalPath(L"a"), L"C:\\2", L"D:\\");
+        Append(tempDir_ / "notes.txt", "not a journal");
+
+        auto journals = CopyJournal::list(tempDir_);
+        Assert::AreEqual(size_t(2), journals.size());
+        Assert::IsTrue(journals[0] == first.path());
+        Assert::IsTrue(journals[1] == second.path());
+
+        first.remove();
+        Assert::IsFalse(std::filesystem::exists(first.path()));
+        Assert::AreEqual(size_t(1), CopyJournal::list(tempDir_).size());
+        Assert::AreEqual(size_t(0), CopyJournal::list(tempDir_ / "missing").size());
+    }
+};
+
+}  // namespace libwinfile_tests
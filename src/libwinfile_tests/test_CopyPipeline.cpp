@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "test_util.h"
+#include "libwinfile/CopyPipeline.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::CopyPipeline;
+using libwinfile::CopyResult;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (CopyPipelineTests) {
+    std::filesystem::path tempDir_;
+
+    // Stands in for the file system. Records which copies ran, and can hold them at a gate.
+    struct FakeVolume {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::set<std::wstring> copied;
+        std::set<std::wstring> failing;
+        bool gateClosed = false;
+        int waitingAtGate = 0;
+
+        CopyPipeline::CopyFunction copyFunction() {
+            return [this](const std::wstring& from, const std::wstring& to, uint64_t) -> uint32_t {
+                std::unique_lock<std::mutex> lock(mutex);
+                waitingAtGate++;
+                changed.notify_all();
+                changed.wait(lock, [this]() { return !gateClosed; });
+                waitingAtGate--;
+
+                if (failing.count(from)) {
+                    return ERROR_ACCESS_DENIED;
+                }
+                copied.insert(to);
+                return 0;
+            };
+        }
+
+        template <typename Predicate>
+        void waitFor(Predicate predicate) {
+            std::unique_lock<std::mutex> lock(mutex);
+            bool satisfied = changed.wait_for(lock, std::chrono::seconds(10), predicate);
+            Assert::IsTrue(satisfied, L"Timed out waiting for the pipeline.");
+        }
+
+        void setGate(bool closed) {
+            std::lock_guard<std::mutex> lock(mutex);
+            gateClosed = closed;
+            changed.notify_all();
+        }
+    };
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        tempDir_ = std::filesystem::temp_directory_path() / "libwinfile_copypipeline_test";
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+        std::filesystem::create_directories(tempDir_);
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+    }
+
+   public:
+    TEST_METHOD (EveryCopyIsReported) {
+        FakeVolume volume;
+        volume.failing.insert(L"C:\\Src\\7");
+        CopyPipeline pipeline(4, volume.copyFunction());
+
+        for (int i = 0; i < 100; i++) {
+            pipeline.enqueue(L"C:\\Src\\" + std::to_wstring(i), L"D:\\Dst\\" + std::to_wstring(i));
+        }
+        pipeline.drain();
+        Assert::IsFalse(pipeline.busy());
+
+        auto results = pipeline.takeFinished();
+        Assert::AreEqual(size_t(100), results.size());
+        Assert::AreEqual(size_t(99), volume.copied.size());
+        for (const auto& result : results) {
+            bool shouldFail = result.from == L"C:\\Src\\7";
+            Assert::AreEqual(shouldFail ? uint32_t(ERROR_ACCESS_DENIED) : uint32_t(0), result.error);
+        }
+        Assert::IsTrue(pipeline.takeFinished().empty());
+    }
+
+    TEST_METHOD (FullQueueHoldsBackTheWalk) {
+        FakeVolume volume;
+        volume.gateClosed = true;
+        CopyPipeline pipeline(1, volume.copyFunction(), 2);
+
+        pipeline.enqueue(L"C:\\1", L"D:\\1");
+        volume.waitFor([&volume]() { return volume.waitingAtGate == 1; });
+        pipeline.enqueue(L"C:\\2", L"D:\\2");
+        pipeline.enqueue(L"C:\\3", L"D:\\3");
+
+        std::atomic<bool> queued(false);
+        std::thread walker([&]() {
+            pipeline.enqueue(L"C:\\4", L"D:\\4");
+            queued = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        Assert::IsFalse(queued.load());
+
+        volume.setGate(false);
+        walker.join();
+        Assert::IsTrue(queued.load());
+        pipeline.drain();
+        Assert::AreEqual(size_t(4), volume.copied.size());
+    }
+
+    TEST_METHOD (WaitForWaitsOnlyForItsDestination) {
+        FakeVolume volume;
+        volume.gateClosed = true;
+        CopyPipeline pipeline(1, volume.copyFunction());
+
+        pipeline.enqueue(L"C:\\Busy", L"D:\\Busy");
+        volume.waitFor([&volume]() { return volume.waitingAtGate == 1; });
+
+        // Nothing writes to this one, so there is nothing to wait for.
+        pipeline.waitFor(L"D:\\Other");
+
+        std::atomic<bool> waited(false);
+        std::thread confirmer([&]() {
+            pipeline.waitFor(L"d:\\busy");
+            waited = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        Assert::IsFalse(waited.load());
+
+        volume.setGate(false);
+        confirmer.join();
+        Assert::AreEqual(size_t(1), volume.copied.count(L"D:\\Busy"));
+    }
+
+    TEST_METHOD (CancelDropsQueuedCopies) {
+        FakeVolume volume;
+        volume.gateClosed = true;
+        CopyPipeline pipeline(1, volume.copyFunction());
+
+        pipeline.enqueue(L"C:\\Running", L"D:\\Running");
+        volume.waitFor([&volume]() { return volume.waitingAtGate == 1; });
+        pipeline.enqueue(L"C:\\Queued", L"D:\\Queued");
+
+        pipeline.cancel();
+        pipeline.waitFor(L"D:\\Queued");
+        volume.setGate(false);
+        pipeline.drain();
+
+        auto results = pipeline.takeFinished();
+        Assert::AreEqual(size_t(1), results.size());
+        Assert::AreEqual(std::wstring(L"D:\\Running"), results[0].to);
+    }
+
+    TEST_METHOD (ThreeThousandSmallFilesAgainstSerialCopy) {
+        const int kFiles = 3000;
+        auto source = tempDir_ / "source";
+        auto serial = tempDir_ / "serial";
+        auto parallel = tempDir_ / "parallel";
+        std::filesystem::create_directories(source);
+        std::filesystem::create_directories(serial);
+        std::filesystem::create_directories(parallel);
+        for (int i = 0; i < kFiles; i++) {
+            WriteFile(source / (std::to_wstring(i) + L".txt"), std::string(4096, 'x'));
+        }
+
+        auto copyFile = [](const std::wstring& from, const std::wstring& to, uint64_t) -> uint32_t {
+            return CopyFileW(from.c_str(), to.c_str(), FALSE) ? 0 : GetLastError();
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kFiles; i++) {
+            std::wstring name = std::to_wstring(i) + L".txt";
+            Assert::AreEqual(uint32_t(0), copyFile((source / name).wstring(), (serial / name).wstring(), 4096));
+        }
+        auto serialElapsed = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        {
+            CopyPipeline pipeline(8, copyFile);
+            for (int i = 0; i < kFiles; i++) {
+                std::wstring name = std::to_wstring(i) + L".txt";
+                pipeline.enqueue((source / name).wstring(), (parallel / name).wstring(), 4096);
+            }
+            pipeline.drain();
+            for (const auto& result : pipeline.takeFinished()) {
+                Assert::AreEqual(uint32_t(0), result.error);
+            }
+        }
+        auto parallelElapsed = std::chrono::steady_clock::now() - start;
+
+        for (int i = 0; i < kFiles; i++) {
+            Assert::AreEqual(uintmax_t(4096), std::filesystem::file_size(parallel / (std::to_wstring(i) + L".txt")));
+        }
+
+        std::wstring message = L"Copied " + std::to_wstring(kFiles) + L" 4 KB files one at a time in " +
+            std::to_wstring(Milliseconds(serialElapsed)) + L" ms and on 8 workers in " +
+            std::to_wstring(Milliseconds(parallelElapsed)) + L" ms\n";
+        Logger::WriteMessage(message.c_str());
+    }
+};
+
+}  // namespace libwinfile_tests
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "libwinfile/CopyProgress.h"
+
+#include <cmath>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::CopyProgress;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (CopyProgressTests) {
+    static CopyProgress::Clock::time_point At(double seconds) {
+        return CopyProgress::Clock::time_point() +
+            std::chrono::duration_cast<CopyProgress::Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+   public:
+    TEST_METHOD (TotalsFollowTheScanAndTheCopies) {
+        CopyProgress progress;
+        progress.addScanned(3, 3000);
+
+        auto id = progress.beginFile(L"C:\\Src\\a");
+        progress.updateFile(id, 400, 1000);
+        auto snapshot = progress.sample(At(0));
+        Assert::AreEqual(uint64_t(0), snapshot.filesDone);
+        Assert::AreEqual(uint64_t(3), snapshot.filesTotal);
+        Assert::AreEqual(uint64_t(400), snapshot.bytesDone);
+        Assert::AreEqual(uint64_t(3000), snapshot.bytesTotal);
+        Assert::IsFalse(snapshot.scanned);
+
+        progress.updateFile(id, 1000, 1000);
+        progress.endFile(id, true);
+        snapshot = progress.sample(At(1));
+        Assert::AreEqual(uint64_t(1), snapshot.filesDone);
+        Assert::AreEqual(uint64_t(1000), snapshot.bytesDone);
+    }
+
+    TEST_METHOD (SkippedAndFailedFilesLeaveTheTotals) {
+        CopyProgress progress;
+        progress.addScanned(3, 3000);
+        progress.finishScan();
+
+        // The user chose not to replace one.
+        progress.skip(1, 1000);
+
+        // Another failed halfway.
+        auto id = progress.beginFile(L"C:\\Src\\b");
+        progress.updateFile(id, 500, 1000);
+        progress.endFile(id, false);
+
+        auto snapshot = progress.sample(At(0));
+        Assert::AreEqual(uint64_t(1), snapshot.filesTotal);
+        Assert::AreEqual(uint64_t(0), snapshot.bytesDone);
+        Assert::AreEqual(uint64_t(1000), snapshot.bytesTotal);
+    }
+
+    TEST_METHOD (TotalsNeverFallBelowWhatIsDone) {
+        CopyProgress progress;
+
+        // The copy got ahead of the scan.
+        auto id = progress.beginFile(L"C:\\Src\\a");
+        progress.updateFile(id, 1000, 1000);
+        progress.endFile(id, true);
+
+        auto snapshot = progress.sample(At(0));
+        Assert::AreEqual(uint64_t(1), snapshot.filesTotal);
+        Assert::AreEqual(uint64_t(1000), snapshot.bytesTotal);
+    }
+
+    TEST_METHOD (RateIsSmoothedOverTime) {
+        CopyProgress progress(5.0);
+        auto id = progress.beginFile(L"C:\\Src\\big");
+
+        progress.sample(At(0));
+        progress.updateFile(id, 100, 10000);
+        Assert::AreEqual(100.0, progress.sample(At(1)).bytesPerSecond, 0.001);
+
+        // A second with nothing copied pulls the rate down by 1 - e^(-1/5) of the way, not all the way to zero.
+        double rate = progress.sample(At(2)).bytesPerSecond;
+        Assert::AreEqual(100.0 * std::exp(-1.0 / 5.0), rate, 0.001);
+
+        // Sampling twice as often over the same time gives the same rate.
+        CopyProgress often(5.0);
+        auto oftenId = often.beginFile(L"C:\\Src\\big");
+        often.sample(At(0));
+        often.updateFile(oftenId, 100, 10000);
+        often.sample(At(1));
+        often.sample(At(1.5));
+        Assert::AreEqual(rate, often.sample(At(2)).bytesPerSecond, 0.001);
+    }
+
+    TEST_METHOD (EtaWaitsForTheScan) {
+        CopyProgress progress;
+        progress.addScanned(1, 1000);
+        auto id = progress.beginFile(L"C:\\Src\\a");
+
+        progress.sample(At(0));
+        progress.updateFile(id, 100, 1000);
+        Assert::IsTrue(progress.sample(At(1)).secondsLeft < 0);
+
+        progress.finishScan();
+        progress.updateFile(id, 200, 1000);
+        auto snapshot = progress.sample(At(2));
+        Assert::AreEqual(800.0 / snapshot.bytesPerSecond, snapshot.secondsLeft, 0.001);
+
+        progress.updateFile(id, 1000, 1000);
+        progress.endFile(id, true);
+        Assert::AreEqual(0.0, progress.sample(At(3)).secondsLeft);
+    }
+
+    TEST_METHOD (LargestFileInFlightIsReported) {
+        CopyProgress progress;
+        auto small = progress.beginFile(L"C:\\Src\\small");
+        auto huge = progress.beginFile(L"C:\\Src\\huge");
+        progress.updateFile(small, 10, 100);
+        progress.updateFile(huge, 1 << 20, 1ull << 40);
+
+        auto snapshot = progress.sample(At(0));
+        Assert::AreEqual(std::wstring(L"C:\\Src\\huge"), snapshot.largestFile);
+        Assert::AreEqual(uint64_t(1) << 20, snapshot.largestFileDone);
+        Assert::AreEqual(uint64_t(1) << 40, snapshot.largestFileSize);
+
+        progress.endFile(huge, true);
+        Assert::AreEqual(std::wstring(L"C:\\Src\\small"), progress.sample(At(1)).largestFile);
+    }
+};
+
+}  // namespace libwinfile_tests
@@ -0,0 +1,130 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "libwinfile/CopyQueue.h"
+
+#include <future>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::CopyQueue;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (CopyQueueTests) {
+    // Starts waitTurn() on another thread, as a job's own thread would call it.
+    static std::future<bool> StartWaiting(CopyQueue* queue, CopyQueue::JobId id) {
+        return std::async(std::launch::async, [queue, id]() { return queue->waitTurn(id); });
+    }
+
+    static bool IsWaiting(std::future<bool>& result) {
+        return result.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout;
+    }
+
+   public:
+    TEST_METHOD (JobsOnSeparateDisksRunAtOnce) {
+        CopyQueue queue;
+        auto a = queue.add({L"disk1"});
+        auto b = queue.add({L"disk2"});
+        auto c = queue.add({});
+
+        Assert::IsTrue(queue.waitTurn(a));
+        Assert::IsTrue(queue.waitTurn(b));
+        Assert::IsTrue(queue.waitTurn(c));
+        Assert::IsTrue(queue.state(b) == CopyQueue::State::Running);
+    }
+
+    TEST_METHOD (JobsSharingADiskRunOneAfterAnotherInOrder) {
+        CopyQueue queue;
+        auto a = queue.add({L"disk1"});
+        auto b = queue.add({L"disk1", L"disk2"});
+        auto c = queue.add({L"disk2"});
+        Assert::IsTrue(queue.waitTurn(a));
+
+        // c's disk is free, but b is ahead of it and needs that disk too.
+        auto bTurn = StartWaiting(&queue, b);
+        auto cTurn = StartWaiting(&queue, c);
+        Assert::IsTrue(IsWaiting(bTurn));
+        Assert::IsTrue(IsWaiting(cTurn));
+        Assert::IsTrue(queue.state(b) == CopyQueue::State::Queued);
+
+        queue.finish(a);
+        Assert::IsTrue(bTurn.get());
+        Assert::IsTrue(IsWaiting(cTurn));
+
+        queue.finish(b);
+        Assert::IsTrue(cTurn.get());
+    }
+
+    TEST_METHOD (AJobMovedToTheFrontRunsNext) {
+        CopyQueue queue;
+        auto a = queue.add({L"disk1"});
+        auto b = queue.add({L"disk1"});
+        auto c = queue.add({L"disk1"});
+        Assert::IsTrue(queue.waitTurn(a));
+
+        auto bTurn = StartWaiting(&queue, b);
+        auto cTurn = StartWaiting(&queue, c);
+        queue.moveToFront(c);
+        queue.moveToFront(a);  // Already running; stays where it is.
+        Assert::IsTrue(IsWaiting(cTurn));
+
+        queue.finish(a);
+        Assert::IsTrue(cTurn.get());
+        Assert::IsTrue(IsWaiting(bTurn));
+
+        queue.finish(c);
+        Assert::IsTrue(bTurn.get());
+    }
+
+    TEST_METHOD (APausedJobStopsAtItsCheckpointAndKeepsItsDisk) {
+        CopyQueue queue;
+        auto a = queue.add({L"disk1"});
+        auto b = queue.add({L"disk1"});
+        Assert::IsTrue(queue.waitTurn(a));
+        Assert::IsTrue(queue.checkpoint(a));
+
+        queue.pause(a);
+        Assert::IsTrue(queue.state(a) == CopyQueue::State::Paused);
+        auto aGoesOn = std::async(std::launch::async, [&queue, a]() { return queue.checkpoint(a); });
+        auto bTurn = StartWaiting(&queue, b);
+        Assert::IsTrue(IsWaiting(aGoesOn));
+        Assert::IsTrue(IsWaiting(bTurn));
+
+        queue.resume(a);
+        Assert::IsTrue(aGoesOn.get());
+        Assert::IsTrue(queue.state(a) == CopyQueue::State::Running);
+        Assert::IsTrue(IsWaiting(bTurn));
+
+        queue.finish(a);
+        Assert::IsTrue(bTurn.get());
+        Assert::IsTrue(queue.state(a) == CopyQueue::State::Finished);
+    }
+
+    TEST_METHOD (CancellingReleasesWaitingAndPausedJobs) {
+        CopyQueue queue;
+        auto a = queue.add({L"disk1"});
+        auto b = queue.add({L"disk1"});
+        Assert::IsTrue(queue.waitTurn(a));
+
+        auto bTurn = StartWaiting(&queue, b);
+        Assert::IsTrue(IsWaiting(bTurn));
+        queue.cancel(b);
+        Assert::IsFalse(bTurn.get());
+        queue.finish(b);
+
+        queue.pause(a);
+        auto aGoesOn = std::async(std::launch::async, [&queue, a]() { return queue.checkpoint(a); });
+        Assert::IsTrue(IsWaiting(aGoesOn));
+        queue.cancel(a);
+        Assert::IsFalse(aGoesOn.get());
+        queue.finish(a);
+    }
+
+    TEST_METHOD (PathsInOneDirectoryAreOnTheSameDisks) {
+        auto temp = std::filesystem::temp_directory_path();
+        auto devices = CopyQueue::devicesOf(temp.wstring());
+        Assert::IsFalse(devices.empty());
+        Assert::IsTrue(devices == CopyQueue::devicesOf((temp / L"not yet copied").wstring()));
+    }
+};
+
+}  // namespace libwinfile_tests
@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "libwinfile/Crc32c.h"
+
+#include <chrono>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::Crc32c;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (Crc32cTests) {
+    static std::vector<uint8_t> RandomBytes(size_t size) {
+        std::mt19937 random(12345);
+        std::vector<uint8_t> bytes(size);
+        for (auto& byte : bytes) {
+            byte = static_cast<uint8_t>(random());
+        }
+        return bytes;
+    }
+
+    static uint32_t Checksum(const void* data, size_t size) {
+        Crc32c crc;
+        crc.update(data, size);
+        return crc.value();
+    }
+
+   public:
+    TEST_METHOD (MatchesTheStandardCheckValue) {
+        Assert::AreEqual(uint32_t(0), Checksum("", 0));
+        Assert::AreEqual(uint32_t(0xE3069283), Checksum("123456789", 9));
+        Assert::AreEqual(uint32_t(0xE3069283), ~Crc32c::updateSoftware(Crc32c::kInitialState, "123456789", 9));
+    }
+
+    TEST_METHOD (InstructionsAgreeWithTheTables) {
+        std::vector<uint8_t> bytes = RandomBytes(4096);
+
+        // Every length and alignment around the 4- and 8-byte steps.
+        for (size_t offset = 0; offset < 8; offset++) {
+            for (size_t size = 0; size < 100; size++) {
+                uint32_t software = ~Crc32c::updateSoftware(Crc32c::kInitialState, bytes.data() + offset, size);
+                Assert::AreEqual(software, Checksum(bytes.data() + offset, size));
+            }
+        }
+        Assert::AreEqual(
+            ~Crc32c::updateSoftware(Crc32c::kInitialState, bytes.data(), bytes.size()),
+            Checksum(bytes.data(), bytes.size()));
+    }
+
+    TEST_METHOD (UpdatesInPiecesMatchOneUpdate) {
+        std::vector<uint8_t> bytes = RandomBytes(10000);
+
+        Crc32c crc;
+        for (size_t done = 0, piece = 1; done < bytes.size(); done += piece, piece = piece * 3 % 1000 + 1) {
+            crc.update(bytes.data() + done, std::min(piece, bytes.size() - done));
+        }
+        Assert::AreEqual(Checksum(bytes.data(), bytes.size()), crc.value());
+    }
+
+    TEST_METHOD (SixtyFourMegabytesWithInstructionsAndTables) {
+        std::vector<uint8_t> bytes = RandomBytes(64 * 1024 * 1024);
+
+        auto start = std::chrono::steady_clock::now();
+        uint32_t fast = Checksum(bytes.data(), bytes.size());
+        auto fastElapsed = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        uint32_t slow = ~Crc32c::updateSoftware(Crc32c::kInitialState, bytes.data(), bytes.size());
+        auto slowElapsed = std::chrono::steady_clock::now() - start;
+
+        Assert::AreEqual(slow, fast);
+
+        auto megabytesPerSecond = [](std::chrono::steady_clock::duration elapsed) {
+            double seconds = std::chrono::duration<double>(elapsed).count();
+            return std::to_wstring(static_cast<long long>(64 / std::max(seconds, 1e-6)));
+        };
+        std::wstring message = L"CRC-32C of 64 MB: " + megabytesPerSecond(fastElapsed) + L" MB/s " +
+            (Crc32c::hardware() ? L"with CRC32 instructions" : L"without CRC32 instructions") + L", " +
+            megabytesPerSecond(slowElapsed) + L" MB/s with tables\n";
+        Logger::WriteMessage(message.c_str());
+    }
+};
+
+}  // namespace libwinfile_tests
@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "libwinfile/DirectoryChangeSet.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::DirectoryChange;
+using libwinfile::DirectoryChangeKind;
+using libwinfile::DirectoryChangeSet;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (DirectoryChangeSetTests) {
+    // Lays out FILE_NOTIFY_INFORMATION records the way ReadDirectoryChangesW does, DWORD-aligned.
+    struct NotifyBuffer {
+        std::vector<DWORD> words;
+        size_t lastRecord = SIZE_MAX;
+
+        void add(DWORD action, const std::wstring& name) {
+            size_t record = words.size();
+            if (lastRecord != SIZE_MAX) {
+                words[lastRecord] = static_cast<DWORD>((record - lastRecord) * sizeof(DWORD));
+            }
+            lastRecord = record;
+
+            size_t nameBytes = name.size() * sizeof(WCHAR);
+            size_t recordBytes = offsetof(FILE_NOTIFY_INFORMATION, FileName) + nameBytes;
+            words.resize(record + (recordBytes + sizeof(DWORD) - 1) / sizeof(DWORD), 0);
+
+            auto* info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(&words[record]);
+            info->NextEntryOffset = 0;
+            info->Action = action;
+            info->FileNameLength = static_cast<DWORD>(nameBytes);
+            memcpy(info->FileName, name.data(), nameBytes);
+        }
+
+        size_t size() const { return words.size() * sizeof(DWORD); }
+    };
+
+    static void AssertChange(const DirectoryChange& change, DirectoryChangeKind kind, const wchar_t* name) {
+        Assert::IsTrue(change.kind == kind);
+        Assert::AreEqual(std::wstring(name), change.name);
+    }
+
+   public:
+    TEST_METHOD (ReportsEachKindOfChange) {
+        DirectoryChangeSet set;
+        set.added(L"new.txt");
+        set.removed(L"old.txt");
+        set.modified(L"log.txt");
+        set.renamed(L"draft.doc", L"final.doc");
+
+        auto changes = set.changes();
+        Assert::AreEqual(size_t(5), changes.size());
+        AssertChange(changes[0], DirectoryChangeKind::Added, L"new.txt");
+        AssertChange(changes[1], DirectoryChangeKind::Removed, L"old.txt");
+        AssertChange(changes[2], DirectoryChangeKind::Modified, L"log.txt");
+        AssertChange(changes[3], DirectoryChangeKind::Removed, L"draft.doc");
+        AssertChange(changes[4], DirectoryChangeKind::Added, L"final.doc");
+        Assert::IsFalse(set.overflowed());
+    }
+
+    TEST_METHOD (CoalescesRepeatedEventsForOneName) {
+        DirectoryChangeSet set;
+        for (int i = 0; i < 100; i++) {
+            set.modified(L"output.obj");
+        }
+        set.added(L"temp.tmp");
+        set.modified(L"TEMP.TMP");
+        set.removed(L"temp.tmp");
+        set.removed(L"replaced.dll");
+        set.added(L"replaced.dll");
+
+        auto changes = set.changes();
+        Assert::AreEqual(size_t(2), changes.size());
+        AssertChange(changes[0], DirectoryChangeKind::Modified, L"output.obj");
+        AssertChange(changes[1], DirectoryChangeKind::Modified, L"replaced.dll");
+    }
+
+    TEST_METHOD (CreatedThenDeletedLeavesNothing) {
+        DirectoryChangeSet set;
+        set.added(L"a.tmp");
+        set.modified(L"a.tmp");
+        set.removed(L"a.tmp");
+        Assert::IsTrue(set.empty());
+
+        set.added(L"a.tmp");
+        auto changes = set.changes();
+        Assert::AreEqual(size_t(1), changes.size());
+        AssertChange(changes[0], DirectoryChangeKind::Added, L"a.tmp");
+    }
+
+    TEST_METHOD (TooManyNamesOverflows) {
+        DirectoryChangeSet set(3);
+        set.added(L"1");
+        set.added(L"2");
+        set.added(L"3");
+        set.modified(L"2");
+        Assert::IsFalse(set.overflowed());
+
+        set.added(L"4");
+        Assert::IsTrue(set.overflowed());
+        Assert::IsFalse(set.empty());
+        Assert::IsTrue(set.changes().empty());
+
+        set.clear();
+        Assert::IsTrue(set.empty());
+    }
+
+    TEST_METHOD (ParsesNotificationBuffers) {
+        NotifyBuffer buffer;
+        buffer.add(FILE_ACTION_ADDED, L"a.txt");
+        buffer.add(FILE_ACTION_RENAMED_OLD_NAME, L"b.txt");
+        buffer.add(FILE_ACTION_RENAMED_NEW_NAME, L"c.txt");
+        buffer.add(FILE_ACTION_MODIFIED, L"d.txt");
+        buffer.add(FILE_ACTION_REMOVED, L"e.txt");
+        buffer.add(FILE_ACTION_RENAMED_NEW_NAME, L"moved in.txt");
+        buffer.add(FILE_ACTION_RENAMED_OLD_NAME, L"moved out.txt");
+
+        DirectoryChangeSet set;
+        set.addNotifications(buffer.words.data(), buffer.size());
+
+        auto changes = set.changes();
+        Assert::AreEqual(size_t(7), changes.size());
+        AssertChange(changes[0], DirectoryChangeKind::Added, L"a.txt");
+        AssertChange(changes[1], DirectoryChangeKind::Removed, L"b.txt");
+        AssertChange(changes[2], DirectoryChangeKind::Added, L"c.txt");
+        AssertChange(changes[3], DirectoryChangeKind::Modified, L"d.txt");
+        AssertChange(changes[4], DirectoryChangeKind::Removed, L"e.txt");
+        AssertChange(changes[5], DirectoryChangeKind::Added, L"moved in.txt");
+        AssertChange(changes[6], DirectoryChangeKind::Removed, L"moved out.txt");
+    }
+
+    TEST_METHOD (EmptyOrMalformedBufferOverflows) {
+        DirectoryChangeSet set;
+        set.addNotifications(nullptr, 0);
+        Assert::IsTrue(set.overflowed());
+
+        NotifyBuffer buffer;
+        buffer.add(FILE_ACTION_ADDED, L"a.txt");
+        auto* info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer.words.data());
+        info->FileNameLength = 4096;
+
+        DirectoryChangeSet malformed;
+        malformed.addNotifications(buffer.words.data(), buffer.size());
+        Assert::IsTrue(malformed.overflowed());
+    }
+};
+
+}  // namespace libwinfile_tests
@@ -0,0 +1,264 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "libwinfile/DirectoryLevelLoader.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::DirectoryLevel;
+using libwinfile::DirectoryLevelLoader;
+using libwinfile::DirectoryLevelResult;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (DirectoryLevelLoaderTests) {
+    // An in-memory directory tree standing in for the file system. Reads can be held at a gate so that tests can
+    // act while a read is in flight.
+    struct FakeTree {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::map<std::wstring, std::vector<std::wstring>> children;
+        int reads = 0;
+        bool gateClosed = false;
+        int waitingAtGate = 0;
+        int notifications = 0;
+
+        DirectoryLevelLoader::Enumerator enumerator() {
+            return [this](const std::wstring& path, DirectoryLevel* level) {
+                std::unique_lock<std::mutex> lock(mutex);
+                reads++;
+                waitingAtGate++;
+                changed.notify_all();
+                changed.wait(lock, [this]() { return !gateClosed; });
+                waitingAtGate--;
+
+                auto it = children.find(path);
+                if (it == children.end()) {
+                    return false;
+                }
+                for (const auto& name : it->second) {
+                    level->push_back({name, 0x10});
+                }
+                return true;
+            };
+        }
+
+        DirectoryLevelLoader::CompletionCallback callback() {
+            return [this](DirectoryLevelLoader::Owner) {
+                std::lock_guard<std::mutex> lock(mutex);
+                notifications++;
+                changed.notify_all();
+            };
+        }
+
+        template <typename Predicate>
+        void waitFor(Predicate predicate) {
+            std::unique_lock<std::mutex> lock(mutex);
+            bool satisfied = changed.wait_for(lock, std::chrono::seconds(10), predicate);
+            Assert::IsTrue(satisfied, L"Timed out waiting for the loader.");
+        }
+
+        void setGate(bool closed) {
+            std::lock_guard<std::mutex> lock(mutex);
+            gateClosed = closed;
+            changed.notify_all();
+        }
+    };
+
+    // Collects results for owner until count have arrived.
+    static std::vector<DirectoryLevelResult> WaitForResults(
+        FakeTree& tree, DirectoryLevelLoader& loader, DirectoryLevelLoader::Owner owner, size_t count) {
+        std::vector<DirectoryLevelResult> results;
+        while (results.size() < count) {
+            tree.waitFor([&tree]() { return tree.notifications > 0; });
+            {
+                std::lock_guard<std::mutex> lock(tree.mutex);
+                tree.notifications--;
+            }
+            for (auto& result : loader.takeCompleted(owner)) {
+                results.push_back(std::move(result));
+            }
+        }
+        return results;
+    }
+
+   public:
+    TEST_METHOD (RequestDeliversLevelAndCachesIt) {
+        FakeTree tree;
+        tree.children[L"C:\\Data"] = {L"Alpha", L"Beta"};
+        DirectoryLevelLoader loader(2, tree.enumerator(), tree.callback());
+
+        loader.request(1, L"C:\\Data");
+        auto results = WaitForResults(tree, loader, 1, 1);
+
+        Assert::AreEqual(std::wstring(L"C:\\Data"), results[0].path);
+        Assert::IsTrue(results[0].level != nullptr);
+        Assert::AreEqual(size_t(2), results[0].level->size());
+        Assert::AreEqual(std::wstring(L"Beta"), (*results[0].level)[1].name);
+
+        // Cache lookups ignore case and trailing backslashes, and never touch the enumerator.
+        auto cached = loader.cached(L"c:\\DATA\\");
+        Assert::IsTrue(cached == results[0].level);
+        Assert::AreEqual(1, tree.reads);
+    }
+
+    TEST_METHOD (ConcurrentRequestsShareOneRead) {
+        FakeTree tree;
+        tree.children[L"C:\\Data"] = {L"Alpha"};
+        tree.gateClosed = true;
+        DirectoryLevelLoader loader(2, tree.enumerator(), tree.callback());
+
+        loader.request(1, L"C:\\Data");
+        tree.waitFor([&tree]() { return tree.waitingAtGate == 1; });
+        loader.request(2, L"c:\\data");
+        loader.request(1, L"C:\\Data");
+        tree.setGate(false);
+
+        auto first = WaitForResults(tree, loader, 1, 1);
+        auto second = WaitForResults(tree, loader, 2, 1);
+        Assert::IsTrue(first[0].level == second[0].level);
+        Assert::AreEqual(1, tree.reads);
+        Assert::IsTrue(loader.takeCompleted(1).empty());
+    }
+
+    TEST_METHOD (CancelDropsQueuedReadsAndResults) {
+        FakeTree tree;
+        tree.children[L"C:\\A"] = {L"One"};
+        tree.children[L"C:\\B"] = {L"Two"};
+        tree.gateClosed = true;
+        DirectoryLevelLoader loader(1, tree.enumerator(), tree.callback());
+
+        loader.request(1, L"C:\\A");
+        tree.waitFor([&tree]() { return tree.waitingAtGate == 1; });
+        loader.request(1, L"C:\\B");
+        loader.cancel(1);
+        tree.setGate(false);
+
+        // The running read of A finishes and is cached; the queued read of B never starts. The marker read queues
+        // behind A on the single worker, so once it is delivered A is done.
+        loader.request(2, L"C:\\Marker");
+        WaitForResults(tree, loader, 2, 1);
+        Assert::AreEqual(2, tree.reads);
+        Assert::IsTrue(loader.cached(L"C:\\A") != nullptr);
+        Assert::IsTrue(loader.cached(L"C:\\B") == nullptr);
+        Assert::IsTrue(loader.takeCompleted(1).empty());
+    }
+
+    TEST_METHOD (StopWaitsForTheRunningReadAndDropsTheRest) {
+        FakeTree tree;
+        tree.children[L"C:\\A"] = {L"One"};
+        tree.children[L"C:\\B"] = {L"Two"};
+        tree.gateClosed = true;
+        DirectoryLevelLoader loader(1, tree.enumerator(), tree.callback());
+
+        loader.request(1, L"C:\\A");
+        tree.waitFor([&tree]() { return tree.waitingAtGate == 1; });
+        loader.request(1, L"C:\\B");
+
+        std::thread opener([&tree]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            tree.setGate(false);
+        });
+        loader.stop();
+        opener.join();
+
+        // A was running, so stop() waited for it; B was only queued.
+        Assert::AreEqual(1, tree.reads);
+        Assert::IsTrue(loader.cached(L"C:\\A") != nullptr);
+        Assert::IsTrue(loader.cached(L"C:\\B") == nullptr);
+
+        loader.request(1, L"C:\\B");
+        loader.stop();
+        Assert::AreEqual(1, tree.reads);
+    }
+
+    TEST_METHOD (FailedReadIsDeliveredButNotCached) {
+        FakeTree tree;
+        DirectoryLevelLoader loader(1, tree.enumerator(), tree.callback());
+
+        loader.request(7, L"Q:\\Missing");
+        auto results = WaitForResults(tree, loader, 7, 1);
+        Assert::IsTrue(results[0].level == nullptr);
+        Assert::IsTrue(loader.cached(L"Q:\\Missing") == nullptr);
+    }
+
+    TEST_METHOD (InvalidateSubtreeLeavesSiblings) {
+        FakeTree tree;
+        DirectoryLevelLoader loader(1, tree.enumerator(), tree.callback());
+        loader.store(L"C:\\", {{L"Apps", 0x10}, {L"AppsOld", 0x10}});
+        loader.store(L"C:\\Apps", {{L"Tool", 0x10}});
+        loader.store(L"C:\\Apps\\Tool", {});
+        loader.store(L"C:\\AppsOld", {});
+
+        loader.invalidate(L"c:\\apps", true);
+        Assert::IsTrue(loader.cached(L"C:\\Apps") == nullptr);
+        Assert::IsTrue(loader.cached(L"C:\\Apps\\Tool") == nullptr);
+        Assert::IsTrue(loader.cached(L"C:\\AppsOld") != nullptr);
+        Assert::IsTrue(loader.cached(L"C:\\") != nullptr);
+
+        loader.invalidate(L"C:\\", false);
+        Assert::IsTrue(loader.cached(L"C:\\") == nullptr);
+        Assert::IsTrue(loader.cached(L"C:\\AppsOld") != nullptr);
+        Assert::AreEqual(0, tree.reads);
+    }
+
+    TEST_METHOD (InvalidateDuringReadRereadsTheDirectory) {
+        FakeTree tree;
+        tree.children[L"C:\\Data"] = {L"Old"};
+        tree.gateClosed = true;
+        DirectoryLevelLoader loader(1, tree.enumerator(), tree.callback());
+
+        loader.request(1, L"C:\\Data");
+        tree.waitFor([&tree]() { return tree.waitingAtGate == 1; });
+        {
+            std::lock_guard<std::mutex> lock(tree.mutex);
+            tree.children[L"C:\\Data"] = {L"Old", L"New"};
+        }
+        loader.invalidate(L"C:\\Data", false);
+        tree.setGate(false);
+
+        auto results = WaitForResults(tree, loader, 1, 1);
+        Assert::AreEqual(2, tree.reads);
+        Assert::AreEqual(size_t(2), results[0].level->size());
+    }
+
+    TEST_METHOD (CacheEvictsLeastRecentlyUsed) {
+        FakeTree tree;
+        DirectoryLevelLoader loader(1, tree.enumerator(), tree.callback(), 2);
+        loader.store(L"C:\\A", {});
+        loader.store(L"C:\\B", {});
+        loader.cached(L"C:\\A");
+        loader.store(L"C:\\C", {});
+
+        Assert::IsTrue(loader.cached(L"C:\\A") != nullptr);
+        Assert::IsTrue(loader.cached(L"C:\\B") == nullptr);
+        Assert::IsTrue(loader.cached(L"C:\\C") != nullptr);
+    }
+
+    TEST_METHOD (ManyLevelsAcrossThreads) {
+        FakeTree tree;
+        for (int i = 0; i < 2000; i++) {
+            tree.children[L"C:\\Tree\\" + std::to_wstring(i)] = {L"x", L"y", L"z"};
+        }
+        DirectoryLevelLoader loader(4, tree.enumerator(), tree.callback());
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < 2000; i++) {
+            loader.request(1, L"C:\\Tree\\" + std::to_wstring(i));
+        }
+        auto results = WaitForResults(tree, loader, 1, 2000);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - start);
+
+        Assert::AreEqual(size_t(2000), results.size());
+        for (const auto& result : results) {
+            Assert::AreEqual(size_t(3), result.level->size());
+        }
+        Logger::WriteMessage(("2000 levels on 4 threads: " + std::to_string(elapsed.count()) + " ms\n").c_str());
+    }
+};
+
+}  // namespace libwinfile_tests
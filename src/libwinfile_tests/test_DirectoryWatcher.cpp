@@ -0,0 +1,166 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "libwinfile/DirectoryWatcher.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::DirectoryChangeKind;
+using libwinfile::DirectoryChangeSet;
+using libwinfile::DirectoryWatcher;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (DirectoryWatcherTests) {
+    static constexpr uint32_t kFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME;
+
+    std::filesystem::path tempDir_;
+
+    // Records which owners the watcher has woken up.
+    struct Recorder {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::set<DirectoryWatcher::Owner> notified;
+
+        DirectoryWatcher::CompletionCallback callback() {
+            return [this](DirectoryWatcher::Owner owner) {
+                std::lock_guard<std::mutex> lock(mutex);
+                notified.insert(owner);
+                changed.notify_all();
+            };
+        }
+
+        void waitFor(size_t count) {
+            std::unique_lock<std::mutex> lock(mutex);
+            bool satisfied =
+                changed.wait_for(lock, std::chrono::seconds(30), [this, count]() { return notified.size() >= count; });
+            Assert::IsTrue(satisfied, L"Timed out waiting for the watcher.");
+        }
+    };
+
+    static void CreateFileIn(const std::filesystem::path& directory, const wchar_t* name) {
+        std::ofstream file(directory / name);
+        Assert::IsTrue(file.is_open(), L"Failed to create test file");
+    }
+
+    static bool HasAdded(const DirectoryChangeSet& changes, const std::wstring& name) {
+        for (const auto& change : changes.changes()) {
+            if (change.kind == DirectoryChangeKind::Added && change.name == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        tempDir_ = std::filesystem::temp_directory_path() / "libwinfile_watcher_test";
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+        std::filesystem::create_directories(tempDir_);
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+    }
+
+   public:
+    TEST_METHOD (OwnersOfOnePathShareOneWatch) {
+        Recorder recorder;
+        DirectoryWatcher watcher(recorder.callback());
+
+        Assert::IsTrue(watcher.watch(1, tempDir_.wstring(), kFilter));
+        Assert::IsTrue(watcher.watch(2, tempDir_.wstring() + L"\\", kFilter));
+        Assert::AreEqual(size_t(1), watcher.pathCount());
+
+        CreateFileIn(tempDir_, L"new.txt");
+        recorder.waitFor(2);
+
+        Assert::IsTrue(HasAdded(watcher.takeChanges(1), L"new.txt"));
+        Assert::IsTrue(HasAdded(watcher.takeChanges(2), L"new.txt"));
+    }
+
+    TEST_METHOD (LastUnwatchClosesTheDirectory) {
+        Recorder recorder;
+        DirectoryWatcher watcher(recorder.callback());
+        auto other = tempDir_ / "other";
+        std::filesystem::create_directories(other);
+
+        watcher.watch(1, tempDir_.wstring(), kFilter);
+        watcher.watch(2, tempDir_.wstring(), kFilter);
+        watcher.unwatch(1);
+        Assert::AreEqual(size_t(1), watcher.pathCount());
+
+        // Moving the last owner elsewhere closes the old directory too.
+        watcher.watch(2, other.wstring(), kFilter);
+        Assert::AreEqual(size_t(1), watcher.pathCount());
+
+        watcher.unwatch(2);
+        Assert::AreEqual(size_t(0), watcher.pathCount());
+    }
+
+    TEST_METHOD (WatchingAgainDropsPendingChanges) {
+        Recorder recorder;
+        DirectoryWatcher watcher(recorder.callback());
+
+        watcher.watch(1, tempDir_.wstring(), kFilter);
+        CreateFileIn(tempDir_, L"seen.txt");
+        recorder.waitFor(1);
+
+        watcher.watch(1, tempDir_.wstring(), kFilter);
+        Assert::IsTrue(watcher.takeChanges(1).empty());
+    }
+
+    TEST_METHOD (DeletedDirectoryOverflows) {
+        Recorder recorder;
+        DirectoryWatcher watcher(recorder.callback());
+        auto doomed = tempDir_ / "doomed";
+        std::filesystem::create_directories(doomed);
+
+        watcher.watch(1, doomed.wstring(), kFilter);
+        std::filesystem::remove(doomed);
+        recorder.waitFor(1);
+
+        // The read that reports the deletion may still succeed; the one after it fails.
+        for (int i = 0; i < 100 && watcher.pathCount() != 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        Assert::AreEqual(size_t(0), watcher.pathCount());
+        Assert::IsTrue(watcher.takeChanges(1).overflowed());
+    }
+
+    TEST_METHOD (FiveHundredDirectoriesAreAllWatched) {
+        const size_t kDirectories = 500;
+        Recorder recorder;
+        DirectoryWatcher watcher(recorder.callback());
+
+        for (size_t i = 0; i < kDirectories; i++) {
+            auto directory = tempDir_ / std::to_wstring(i);
+            std::filesystem::create_directories(directory);
+            Assert::IsTrue(watcher.watch(i, directory.wstring(), kFilter));
+        }
+        Assert::AreEqual(kDirectories, watcher.pathCount());
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < kDirectories; i++) {
+            CreateFileIn(tempDir_ / std::to_wstring(i), L"file.txt");
+        }
+        recorder.waitFor(kDirectories);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        for (size_t i = 0; i < kDirectories; i++) {
+            Assert::IsTrue(HasAdded(watcher.takeChanges(i), L"file.txt"));
+        }
+
+        std::wstring message = L"Created a file in each of " + std::to_wstring(kDirectories) +
+            L" watched directories and heard about all of them in " +
+            std::to_wstring(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()) + L" ms\n";
+        Logger::WriteMessage(message.c_str());
+    }
+};
+
+}  // namespace libwinfile_tests
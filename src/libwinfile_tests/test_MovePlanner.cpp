@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "test_util.h"
+#include "libwinfile/MovePlanner.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::MovePlanner;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (MovePlannerTests) {
+    std::filesystem::path tempDir_;
+
+    // The step moving source, which must be in steps exactly once.
+    static const MovePlanner::Step& StepFor(
+        const std::vector<MovePlanner::Step>& steps, const std::filesystem::path& source) {
+        const MovePlanner::Step* found = nullptr;
+        for (const auto& step : steps) {
+            if (step.source == source.wstring()) {
+                Assert::IsNull(found, source.wstring().c_str());
+                found = &step;
+            }
+        }
+        Assert::IsNotNull(found, source.wstring().c_str());
+        return *found;
+    }
+
+    static bool IsAction(const MovePlanner::Step& step, MovePlanner::Action action) { return step.action == action; }
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        tempDir_ = std::filesystem::temp_directory_path() / "libwinfile_moveplanner_test";
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+        std::filesystem::create_directories(tempDir_ / "from");
+        std::filesystem::create_directories(tempDir_ / "to");
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+    }
+
+   public:
+    TEST_METHOD (RenamesATreeWholeWhenNothingIsInTheWay) {
+        auto source = tempDir_ / "from" / "tree";
+        std::filesystem::create_directories(source / "a" / "b");
+        WriteFile(source / "a" / "b" / "file.txt");
+
+        MovePlanner planner;
+        auto steps = planner.plan(source.wstring(), (tempDir_ / "to" / "tree").wstring());
+
+        Assert::AreEqual(size_t(1), steps.size());
+        Assert::IsTrue(IsAction(steps[0], MovePlanner::Action::Rename));
+        Assert::AreEqual((tempDir_ / "to" / "tree").wstring(), steps[0].destination);
+    }
+
+    TEST_METHOD (MergesOnlyWhereTheDestinationHasTheDirectory) {
+        auto source = tempDir_ / "from" / "tree";
+        auto destination = tempDir_ / "to" / "tree";
+        std::filesystem::create_directories(source / "shared" / "deeper");
+        std::filesystem::create_directories(source / "new" / "deeper");
+        WriteFile(source / "top.txt");
+        WriteFile(source / "shared" / "inside.txt");
+        WriteFile(source / "shared" / "deeper" / "file.txt");
+        WriteFile(source / "new" / "deeper" / "file.txt");
+        std::filesystem::create_directories(destination / "shared");
+        WriteFile(destination / "top.txt");
+
+        MovePlanner planner;
+        auto steps = planner.plan(source.wstring(), destination.wstring());
+
+        // The tree and "shared" are merged; everything directly in them is renamed, and "new" with all it holds.
+        Assert::AreEqual(size_t(6), steps.size());
+        Assert::IsTrue(IsAction(steps[0], MovePlanner::Action::Merge));
+        Assert::IsTrue(IsAction(StepFor(steps, source / "shared"), MovePlanner::Action::Merge));
+        Assert::IsTrue(IsAction(StepFor(steps, source / "top.txt"), MovePlanner::Action::Rename));
+        Assert::IsTrue(IsAction(StepFor(steps, source / "new"), MovePlanner::Action::Rename));
+        Assert::IsTrue(IsAction(StepFor(steps, source / "shared" / "inside.txt"), MovePlanner::Action::Rename));
+        Assert::IsTrue(IsAction(StepFor(steps, source / "shared" / "deeper"), MovePlanner::Action::Rename));
+        Assert::AreEqual(
+            (destination / "shared" / "deeper").wstring(), StepFor(steps, source / "shared" / "deeper").destination);
+    }
+
+    TEST_METHOD (CopiesOnlyAcrossVolumes) {
+        auto source = tempDir_ / "from" / "tree";
+        auto destination = tempDir_ / "to" / "tree";
+        std::filesystem::create_directories(source / "sub");
+        std::filesystem::create_directories(destination / "sub");
+        auto from = (tempDir_ / "from").wstring();
+
+        // "from" and everything below it is one volume, and the rest another.
+        MovePlanner planner([&from](const std::wstring& path) {
+            return path.compare(0, from.size(), from) == 0 ? L"A" : L"B";
+        });
+
+        auto steps = planner.plan(source.wstring(), destination.wstring());
+        Assert::AreEqual(size_t(1), steps.size());
+        Assert::IsTrue(IsAction(steps[0], MovePlanner::Action::CopyDelete));
+
+        // Within the source's volume the same tree is still renamed.
+        Assert::IsTrue(
+            planner.decide(source.wstring(), (tempDir_ / "from" / "renamed").wstring()) ==
+            MovePlanner::Action::Rename);
+    }
+
+    TEST_METHOD (CopiesWhenTheVolumeCantBeTold) {
+        auto source = tempDir_ / "from" / "file.txt";
+        WriteFile(source);
+
+        MovePlanner planner([](const std::wstring&) { return std::wstring(); });
+
+        Assert::IsTrue(
+            planner.decide(source.wstring(), (tempDir_ / "to" / "file.txt").wstring()) ==
+            MovePlanner::Action::CopyDelete);
+    }
+
+    TEST_METHOD (LooksUpEachDirectorysVolumeOnce) {
+        auto source = tempDir_ / "from" / "tree";
+        auto destination = tempDir_ / "to" / "tree";
+        std::filesystem::create_directories(destination);
+        for (int i = 0; i < 50; i++) {
+            std::filesystem::create_directories(source / (L"dir" + std::to_wstring(i)));
+            std::filesystem::create_directories(destination / (L"dir" + std::to_wstring(i)));
+            WriteFile(source / (L"dir" + std::to_wstring(i)) / L"file.txt");
+        }
+
+        int lookups = 0;
+        MovePlanner planner([&lookups](const std::wstring&) {
+            lookups++;
+            return std::wstring(L"C");
+        });
+        auto steps = planner.plan(source.wstring(), destination.wstring());
+
+        // One step for the tree, 50 merged directories, 50 files; the parents of each side of them looked up once.
+        Assert::AreEqual(size_t(101), steps.size());
+        Assert::AreEqual(2 + 2 * 51, lookups);
+    }
+};
+
+}  // namespace libwinfile_tests
@@ -0,0 +1,134 @@
+#include "pch.h"
+#include <windows.h>
+#include "CppUnitTest.h"
+#include "libwinfile/SearchFilter.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::SearchCandidate;
+using libwinfile::SearchFilter;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (SearchFilterTests) {
+    // FILETIME ticks for noon UTC on the given day. Noon keeps the value on the same calendar day in every time
+    // zone, so the local-time date terms in these tests are deterministic.
+    static uint64_t TicksAtNoonUtc(int year, int month, int day) {
+        SYSTEMTIME st{};
+        st.wYear = static_cast<WORD>(year);
+        st.wMonth = static_cast<WORD>(month);
+        st.wDay = static_cast<WORD>(day);
+        st.wHour = 12;
+        FILETIME ft;
+        SystemTimeToFileTime(&st, &ft);
+        return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    }
+
+    static SearchCandidate File(const wchar_t* name, uint64_t size) {
+        SearchCandidate candidate;
+        candidate.name = name;
+        candidate.attributes = FILE_ATTRIBUTE_ARCHIVE;
+        candidate.size = size;
+        candidate.lastWriteTime = TicksAtNoonUtc(2024, 3, 15);
+        candidate.depth = 0;
+        return candidate;
+    }
+
+   public:
+    TEST_METHOD (EmptyExpressionMatchesEverything) {
+        auto filter = SearchFilter::parse(L"   ");
+        Assert::IsTrue(filter.empty());
+        Assert::IsTrue(filter.matches(File(L"a.txt", 0)));
+        Assert::AreEqual(INT_MAX, filter.maxDepth());
+    }
+
+    TEST_METHOD (SizeRangesWithSuffixes) {
+        auto filter = SearchFilter::parse(L"size>=1K size<2MB");
+        Assert::IsFalse(filter.matches(File(L"small", 1023)));
+        Assert::IsTrue(filter.matches(File(L"edge", 1024)));
+        Assert::IsTrue(filter.matches(File(L"mid", 1024 * 1024)));
+        Assert::IsFalse(filter.matches(File(L"big", 2 * 1024 * 1024)));
+
+        auto exact = SearchFilter::parse(L"size=0");
+        Assert::IsTrue(exact.matches(File(L"empty", 0)));
+        Assert::IsFalse(exact.matches(File(L"one", 1)));
+
+        auto impossible = SearchFilter::parse(L"size<0");
+        Assert::IsFalse(impossible.matches(File(L"empty", 0)));
+    }
+
+    TEST_METHOD (ModifiedBeforeAndAfter) {
+        auto filter = SearchFilter::parse(L"modified>=2024-01-01 modified<2024-06-01");
+        auto candidate = File(L"a", 0);
+
+        candidate.lastWriteTime = TicksAtNoonUtc(2023, 12, 15);
+        Assert::IsFalse(filter.matches(candidate));
+        candidate.lastWriteTime = TicksAtNoonUtc(2024, 3, 15);
+        Assert::IsTrue(filter.matches(candidate));
+        candidate.lastWriteTime = TicksAtNoonUtc(2024, 6, 15);
+        Assert::IsFalse(filter.matches(candidate));
+    }
+
+    TEST_METHOD (ModifiedEqualsCoversTheWholeDay) {
+        auto filter = SearchFilter::parse(L"modified=2024-03-15");
+        auto candidate = File(L"a", 0);
+        Assert::IsTrue(filter.matches(candidate));
+        candidate.lastWriteTime = TicksAtNoonUtc(2024, 3, 16);
+        Assert::IsFalse(filter.matches(candidate));
+    }
+
+    TEST_METHOD (AttributesRequiredAndExcluded) {
+        auto filter = SearchFilter::parse(L"attr:+h-r");
+        auto candidate = File(L"a", 0);
+        Assert::IsFalse(filter.matches(candidate));
+
+        candidate.attributes |= FILE_ATTRIBUTE_HIDDEN;
+        Assert::IsTrue(filter.matches(candidate));
+
+        candidate.attributes |= FILE_ATTRIBUTE_READONLY;
+        Assert::IsFalse(filter.matches(candidate));
+    }
+
+    TEST_METHOD (DepthLimitsMatchesAndRecursion) {
+        auto filter = SearchFilter::parse(L"depth<=1");
+        auto candidate = File(L"a", 0);
+        Assert::IsTrue(filter.matches(candidate));
+        candidate.depth = 2;
+        Assert::IsFalse(filter.matches(candidate));
+        Assert::AreEqual(1, filter.maxDepth());
+    }
+
+    TEST_METHOD (RegexIsCaseInsensitiveAndQuoted) {
+        auto filter = SearchFilter::parse(L"regex:\"^q[1-4] report\\.xlsx?$\"");
+        Assert::IsTrue(filter.matches(File(L"Q3 Report.XLSX", 0)));
+        Assert::IsTrue(filter.matches(File(L"q1 report.xls", 0)));
+        Assert::IsFalse(filter.matches(File(L"q5 report.xls", 0)));
+    }
+
+    TEST_METHOD (AllTermsMustMatch) {
+        auto filter = SearchFilter::parse(L"size>100 regex:\\.log$");
+        Assert::IsTrue(filter.matches(File(L"build.log", 200)));
+        Assert::IsFalse(filter.matches(File(L"build.log", 50)));
+        Assert::IsFalse(filter.matches(File(L"build.txt", 200)));
+    }
+
+    TEST_METHOD (MalformedTermsThrow) {
+        Assert::ExpectException<std::invalid_argument>([]() { SearchFilter::parse(L"size>lots"); });
+        Assert::ExpectException<std::invalid_argument>([]() { SearchFilter::parse(L"size>10Q"); });
+        Assert::ExpectException<std::invalid_argument>([]() { SearchFilter::parse(L"modified>yesterday"); });
+        Assert::ExpectException<std::invalid_argument>([]() { SearchFilter::parse(L"attr:+z"); });
+        Assert::ExpectException<std::invalid_argument>([]() { SearchFilter::parse(L"regex:[unclosed"); });
+        Assert::ExpectException<std::invalid_argument>([]() { SearchFilter::parse(L"color=blue"); });
+        Assert::ExpectException<std::invalid_argument>([]() { SearchFilter::parse(L"regex:\"open"); });
+    }
+
+    TEST_METHOD (ErrorsQuoteTheTermInUtf8) {
+        try {
+            SearchFilter::parse(L"couleur=\u00e9t\u00e9");
+            Assert::Fail(L"Expected std::invalid_argument");
+        } catch (const std::invalid_argument& e) {
+            Assert::IsTrue(std::string(e.what()).find("couleur=\xC3\xA9t\xC3\xA9") != std::string::npos);
+        }
+    }
+};
+
+}  // namespace libwinfile_tests
@@ -0,0 +1,248 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "libwinfile/SubdirectoryProber.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::SubdirectoryProbeResult;
+using libwinfile::SubdirectoryProber;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (SubdirectoryProberTests) {
+    // Stands in for the file system. Records the order of probes, and can hold them at a gate.
+    struct FakeVolume {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::map<std::wstring, bool> hasSubdirectories;
+        std::vector<std::wstring> probed;
+        bool gateClosed = false;
+        int waitingAtGate = 0;
+        int notifications = 0;
+
+        SubdirectoryProber::Probe probe() {
+            return [this](const std::wstring& path, bool* result) {
+                std::unique_lock<std::mutex> lock(mutex);
+                probed.push_back(path);
+                waitingAtGate++;
+                changed.notify_all();
+                changed.wait(lock, [this]() { return !gateClosed; });
+                waitingAtGate--;
+
+                auto it = hasSubdirectories.find(path);
+                if (it == hasSubdirectories.end()) {
+                    return false;
+                }
+                *result = it->second;
+                return true;
+            };
+        }
+
+        SubdirectoryProber::CompletionCallback callback() {
+            return [this](SubdirectoryProber::Owner) {
+                std::lock_guard<std::mutex> lock(mutex);
+                notifications++;
+                changed.notify_all();
+            };
+        }
+
+        template <typename Predicate>
+        void waitFor(Predicate predicate) {
+            std::unique_lock<std::mutex> lock(mutex);
+            bool satisfied = changed.wait_for(lock, std::chrono::seconds(10), predicate);
+            Assert::IsTrue(satisfied, L"Timed out waiting for the prober.");
+        }
+
+        void setGate(bool closed) {
+            std::lock_guard<std::mutex> lock(mutex);
+            gateClosed = closed;
+            changed.notify_all();
+        }
+    };
+
+    static std::map<std::wstring, bool> WaitForResults(
+        FakeVolume& volume, SubdirectoryProber& prober, SubdirectoryProber::Owner owner, size_t count) {
+        std::map<std::wstring, bool> results;
+        while (results.size() < count) {
+            volume.waitFor([&volume]() { return volume.notifications > 0; });
+            {
+                std::lock_guard<std::mutex> lock(volume.mutex);
+                volume.notifications--;
+            }
+            for (const auto& result : prober.takeCompleted(owner)) {
+                results[result.path] = result.hasSubdirectories;
+            }
+        }
+        return results;
+    }
+
+    // Holds the single worker on a probe for owner 99 so that requests can be queued behind it.
+    static void Occupy(FakeVolume& volume, SubdirectoryProber& prober) {
+        volume.hasSubdirectories[L"C:\\Busy"] = false;
+        volume.gateClosed = true;
+        prober.probe(99, {L"C:\\Busy"});
+        volume.waitFor([&volume]() { return volume.waitingAtGate == 1; });
+    }
+
+   public:
+    TEST_METHOD (AnswersAreDeliveredAndCached) {
+        FakeVolume volume;
+        volume.hasSubdirectories[L"N:\\Share\\Full"] = true;
+        volume.hasSubdirectories[L"N:\\Share\\Empty"] = false;
+        SubdirectoryProber prober(2, volume.probe(), volume.callback());
+
+        prober.probe(1, {L"N:\\Share\\Full", L"N:\\Share\\Empty"});
+        auto results = WaitForResults(volume, prober, 1, 2);
+        Assert::IsTrue(results[L"N:\\Share\\Full"]);
+        Assert::IsFalse(results[L"N:\\Share\\Empty"]);
+
+        bool hasSubdirectories = false;
+        Assert::IsTrue(prober.cached(L"n:\\share\\full\\", &hasSubdirectories));
+        Assert::IsTrue(hasSubdirectories);
+
+        // Asking again is answered from the cache.
+        prober.probe(1, {L"N:\\Share\\Full"});
+        WaitForResults(volume, prober, 1, 1);
+        Assert::AreEqual(size_t(2), volume.probed.size());
+    }
+
+    TEST_METHOD (NewestViewportReplacesTheOldOne) {
+        FakeVolume volume;
+        for (auto name : {L"A", L"B", L"C", L"D"}) {
+            volume.hasSubdirectories[std::wstring(L"C:\\") + name] = true;
+        }
+        SubdirectoryProber prober(1, volume.probe(), volume.callback());
+        Occupy(volume, prober);
+
+        prober.probe(1, {L"C:\\A", L"C:\\B", L"C:\\C"});
+        prober.probe(1, {L"C:\\D", L"C:\\C"});  // scrolled: A and B are no longer visible
+        volume.setGate(false);
+
+        auto results = WaitForResults(volume, prober, 1, 2);
+        Assert::AreEqual(size_t(2), results.size());
+        Assert::AreEqual(size_t(3), volume.probed.size());
+        Assert::AreEqual(std::wstring(L"C:\\D"), volume.probed[1]);
+        Assert::AreEqual(std::wstring(L"C:\\C"), volume.probed[2]);
+    }
+
+    TEST_METHOD (NewerRequestsJumpTheQueue) {
+        FakeVolume volume;
+        volume.hasSubdirectories[L"C:\\Old"] = true;
+        volume.hasSubdirectories[L"C:\\New"] = true;
+        SubdirectoryProber prober(1, volume.probe(), volume.callback());
+        Occupy(volume, prober);
+
+        prober.probe(1, {L"C:\\Old"});
+        prober.probe(2, {L"C:\\New"});
+        volume.setGate(false);
+
+        WaitForResults(volume, prober, 1, 1);
+        Assert::AreEqual(std::wstring(L"C:\\New"), volume.probed[1]);
+        Assert::AreEqual(std::wstring(L"C:\\Old"), volume.probed[2]);
+    }
+
+    TEST_METHOD (SamePathIsProbedOnceForSeveralOwners) {
+        FakeVolume volume;
+        volume.hasSubdirectories[L"C:\\Shared"] = true;
+        volume.gateClosed = true;
+        SubdirectoryProber prober(2, volume.probe(), volume.callback());
+
+        prober.probe(1, {L"C:\\Shared"});
+        volume.waitFor([&volume]() { return volume.waitingAtGate == 1; });
+        prober.probe(2, {L"c:\\shared"});
+        volume.setGate(false);
+
+        Assert::IsTrue(WaitForResults(volume, prober, 1, 1)[L"C:\\Shared"]);
+        Assert::IsTrue(WaitForResults(volume, prober, 2, 1)[L"c:\\shared"]);
+        Assert::AreEqual(size_t(1), volume.probed.size());
+    }
+
+    TEST_METHOD (UnreadableDirectoriesAreNotCached) {
+        FakeVolume volume;
+        SubdirectoryProber prober(1, volume.probe(), volume.callback());
+
+        prober.probe(1, {L"N:\\Offline"});
+        auto results = WaitForResults(volume, prober, 1, 1);
+        Assert::IsFalse(results[L"N:\\Offline"]);
+
+        bool hasSubdirectories;
+        Assert::IsFalse(prober.cached(L"N:\\Offline", &hasSubdirectories));
+    }
+
+    TEST_METHOD (InvalidateForgetsAnswers) {
+        FakeVolume volume;
+        SubdirectoryProber prober(1, volume.probe(), volume.callback());
+        prober.store(L"C:\\Root", true);
+        prober.store(L"C:\\Root\\Child", false);
+        prober.store(L"C:\\Rooted", true);
+
+        prober.invalidate(L"C:\\Root", true);
+
+        bool hasSubdirectories;
+        Assert::IsFalse(prober.cached(L"C:\\Root", &hasSubdirectories));
+        Assert::IsFalse(prober.cached(L"C:\\Root\\Child", &hasSubdirectories));
+        Assert::IsTrue(prober.cached(L"C:\\Rooted", &hasSubdirectories));
+    }
+
+    TEST_METHOD (InvalidatedRunningProbeIsDeliveredButNotCached) {
+        FakeVolume volume;
+        volume.hasSubdirectories[L"C:\\Changing"] = false;
+        volume.gateClosed = true;
+        SubdirectoryProber prober(1, volume.probe(), volume.callback());
+
+        prober.probe(1, {L"C:\\Changing"});
+        volume.waitFor([&volume]() { return volume.waitingAtGate == 1; });
+        prober.invalidate(L"C:\\Changing", false);
+        volume.setGate(false);
+
+        WaitForResults(volume, prober, 1, 1);
+        bool hasSubdirectories;
+        Assert::IsFalse(prober.cached(L"C:\\Changing", &hasSubdirectories));
+    }
+
+    TEST_METHOD (StopWaitsForTheRunningProbeAndDropsTheRest) {
+        FakeVolume volume;
+        volume.hasSubdirectories[L"C:\\Queued"] = true;
+        SubdirectoryProber prober(1, volume.probe(), volume.callback());
+        Occupy(volume, prober);
+        prober.probe(1, {L"C:\\Queued"});
+
+        std::thread opener([&volume]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            volume.setGate(false);
+        });
+        prober.stop();
+        opener.join();
+
+        // The busy probe was running, so stop() waited for it; the queued one never ran.
+        bool hasSubdirectories;
+        Assert::AreEqual(size_t(1), volume.probed.size());
+        Assert::IsTrue(prober.cached(L"C:\\Busy", &hasSubdirectories));
+        Assert::IsFalse(prober.cached(L"C:\\Queued", &hasSubdirectories));
+
+        prober.probe(1, {L"C:\\Queued"});
+        prober.stop();
+        Assert::AreEqual(size_t(1), volume.probed.size());
+    }
+
+    TEST_METHOD (CancelDropsQueuedProbes) {
+        FakeVolume volume;
+        volume.hasSubdirectories[L"C:\\Queued"] = true;
+        SubdirectoryProber prober(1, volume.probe(), volume.callback());
+        Occupy(volume, prober);
+
+        prober.probe(1, {L"C:\\Queued"});
+        prober.cancel(1);
+        volume.setGate(false);
+
+        WaitForResults(volume, prober, 99, 1);
+        Assert::AreEqual(size_t(1), volume.probed.size());
+        Assert::IsTrue(prober.takeCompleted(1).empty());
+    }
+};
+
+}  // namespace libwinfile_tests
@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "test_util.h"
+#include "libwinfile/TreeDeleter.h"
+
+#include <chrono>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::TreeDeleter;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (TreeDeleterTests) {
+    std::filesystem::path tempDir_;
+
+    // Makes a tree of directories, the first few nested one in another, each holding files files. Returns how many
+    // files and directories that is, root included.
+    static uint64_t MakeTree(const std::filesystem::path& root, int directories, int files) {
+        uint64_t count = 1;
+        std::filesystem::create_directories(root);
+        std::filesystem::path parent = root;
+        for (int i = 0; i < directories; i++) {
+            auto directory = parent / (L"dir" + std::to_wstring(i));
+            std::filesystem::create_directory(directory);
+            count++;
+            for (int j = 0; j < files; j++) {
+                WriteFile(directory / (L"file" + std::to_wstring(j) + L".txt"));
+                count++;
+            }
+            parent = i < 5 ? directory : root;
+        }
+        return count;
+    }
+
+    static void SetReadOnly(const std::filesystem::path& path, bool readOnly) {
+        DWORD attributes = GetFileAttributesW(path.wstring().c_str());
+        attributes = readOnly ? attributes | FILE_ATTRIBUTE_READONLY : attributes & ~FILE_ATTRIBUTE_READONLY;
+        Assert::IsTrue(SetFileAttributesW(path.wstring().c_str(), attributes) != FALSE);
+    }
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        tempDir_ = std::filesystem::temp_directory_path() / "libwinfile_treedeleter_test";
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+        std::filesystem::create_directories(tempDir_);
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        for (auto it = std::filesystem::recursive_directory_iterator(tempDir_, ec);
+             !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            SetFileAttributesW(it->path().wstring().c_str(), FILE_ATTRIBUTE_NORMAL);
+        }
+        std::filesystem::remove_all(tempDir_, ec);
+    }
+
+   public:
+    TEST_METHOD (DeletesANestedTreeBottomUp) {
+        auto root = tempDir_ / "root";
+        uint64_t count = MakeTree(root, 12, 30);
+
+        uint64_t lastReport = 0;
+        TreeDeleter deleter(4, 8);
+        uint32_t error = deleter.deleteTree(root.wstring() + L"\\", 0, [&lastReport](uint64_t deleted) {
+            Assert::IsTrue(deleted >= lastReport);
+            lastReport = deleted;
+            return true;
+        });
+
+        Assert::AreEqual(uint32_t(0), error);
+        Assert::IsTrue(deleter.failures().empty());
+        Assert::IsFalse(std::filesystem::exists(root));
+        Assert::AreEqual(count, lastReport);
+    }
+
+    TEST_METHOD (ReadOnlyFilesAreKeptOnlyWhenAsked) {
+        auto root = tempDir_ / "root";
+        MakeTree(root, 3, 5);
+        auto readOnly = root / "dir0" / "dir1" / "file2.txt";
+        SetReadOnly(readOnly, true);
+
+        TreeDeleter deleter(2);
+        Assert::AreEqual(uint32_t(0), deleter.deleteTree(root.wstring(), FILE_ATTRIBUTE_READONLY));
+
+        // The file stays, and so do the directories it is in; everything else is gone.
+        Assert::IsTrue(deleter.failures().empty());
+        Assert::IsTrue(std::filesystem::exists(readOnly));
+        Assert::IsFalse(std::filesystem::exists(root / "dir0" / "file0.txt"));
+        Assert::IsFalse(std::filesystem::exists(root / "dir0" / "dir1" / "dir2"));
+        Assert::AreEqual(
+            size_t(1), size_t(std::distance(
+                           std::filesystem::directory_iterator(root / "dir0" / "dir1"),
+                           std::filesystem::directory_iterator())));
+
+        Assert::AreEqual(uint32_t(0), deleter.deleteTree(root.wstring(), 0));
+        Assert::IsTrue(deleter.failures().empty());
+        Assert::IsFalse(std::filesystem::exists(root));
+    }
+
+    TEST_METHOD (FilesTheCallerKeepsStayWithTheirDirectories) {
+        auto root = tempDir_ / "root";
+        MakeTree(root, 3, 5);
+        auto kept = root / "dir0" / "dir1" / "file2.txt";
+
+        TreeDeleter deleter(2);
+        uint32_t error = deleter.deleteTree(
+            root.wstring(), 0, nullptr, [&kept](const std::wstring& path) { return path == kept.wstring(); });
+
+        Assert::AreEqual(uint32_t(0), error);
+        Assert::IsTrue(deleter.failures().empty());
+        Assert::IsTrue(std::filesystem::exists(kept));
+        Assert::IsFalse(std::filesystem::exists(root / "dir0" / "dir1" / "file1.txt"));
+        Assert::IsFalse(std::filesystem::exists(root / "dir0" / "dir1" / "dir2"));
+    }
+
+    TEST_METHOD (AFileInUseIsReportedAndKeptWithItsDirectories) {
+        auto root = tempDir_ / "root";
+        MakeTree(root, 3, 5);
+        auto inUse = root / "dir0" / "dir1" / "file2.txt";
+
+        TreeDeleter deleter(2);
+        {
+            std::ofstream open(inUse, std::ios::binary | std::ios::app);
+            Assert::AreEqual(uint32_t(ERROR_SHARING_VIOLATION), deleter.deleteTree(root.wstring(), 0));
+        }
+
+        Assert::AreEqual(size_t(1), deleter.failures().size());
+        Assert::AreEqual(inUse.wstring(), deleter.failures()[0].path);
+        Assert::IsTrue(std::filesystem::exists(inUse));
+        Assert::IsFalse(std::filesystem::exists(root / "dir0" / "file0.txt"));
+        Assert::IsFalse(std::filesystem::exists(root / "dir0" / "dir1" / "dir2"));
+    }
+
+    TEST_METHOD (StopsWhenProgressSaysSo) {
+        auto root = tempDir_ / "root";
+        MakeTree(root, 20, 100);
+
+        TreeDeleter deleter(1, 1);
+        uint32_t error = deleter.deleteTree(root.wstring(), 0, [](uint64_t) { return false; });
+
+        Assert::AreEqual(uint32_t(ERROR_REQUEST_ABORTED), error);
+        Assert::IsTrue(std::filesystem::exists(root));
+    }
+
+    TEST_METHOD (ReportsAMissingRoot) {
+        TreeDeleter deleter(2);
+        uint32_t error = deleter.deleteTree((tempDir_ / "missing").wstring(), 0);
+
+        Assert::AreEqual(uint32_t(ERROR_FILE_NOT_FOUND), error);
+        Assert::AreEqual(size_t(1), deleter.failures().size());
+    }
+
+    TEST_METHOD (TwentyThousandSmallFilesAgainstSerialDelete) {
+        auto serial = tempDir_ / "serial";
+        auto parallel = tempDir_ / "parallel";
+        uint64_t count = MakeTree(serial, 200, 100);
+        MakeTree(parallel, 200, 100);
+
+        auto start = std::chrono::steady_clock::now();
+        Assert::AreEqual(uintmax_t(count), std::filesystem::remove_all(serial));
+        auto serialElapsed = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        Assert::AreEqual(uint32_t(0), TreeDeleter(8).deleteTree(parallel.wstring(), 0));
+        auto parallelElapsed = std::chrono::steady_clock::now() - start;
+
+        Assert::IsFalse(std::filesystem::exists(parallel));
+
+        std::wstring message = L"Deleted " + std::to_wstring(count) + L" files and directories one at a time in " +
+            std::to_wstring(Milliseconds(serialElapsed)) + L" ms and on 8 workers in " +
+            std::to_wstring(Milliseconds(parallelElapsed)) + L" ms\n";
+        Logger::WriteMessage(message.c_str());
+    }
+};
+
+}  // namespace libwinfile_tests
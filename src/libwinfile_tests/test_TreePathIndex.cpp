@@ -0,0 +1,250 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "libwinfile/TreePathIndex.h"
+
+#include <chrono>
+#include <cwctype>
+#include <memory>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::TreePathIndex;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (TreePathIndexTests) {
+    // A tree node as the tree control's listbox holds them: a name and a parent, in display order.
+    struct FakeNode {
+        const FakeNode* parent;
+        std::wstring name;
+    };
+
+    static bool EqualsIgnoringCase(const std::wstring& a, const std::wstring& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++) {
+            if (towupper(a[i]) != towupper(b[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The lookup FindItemFromPath did before the index: for each path element, scan forward through the items for
+    // a child of the previous match with that name.
+    static const FakeNode* LinearFind(const std::vector<FakeNode*>& items, const std::wstring& path) {
+        const FakeNode* previous = nullptr;
+        size_t i = 0;
+        size_t start = 0;
+        while (start <= path.size()) {
+            size_t end = path.find(L'\\', start);
+            if (end == std::wstring::npos) {
+                end = path.size();
+            }
+            std::wstring element = path.substr(start, end - start);
+            if (previous == nullptr) {
+                element += L'\\';
+            }
+            start = end + 1;
+
+            while (true) {
+                if (i == items.size()) {
+                    return nullptr;
+                }
+                if (items[i]->parent == previous && EqualsIgnoringCase(items[i]->name, element)) {
+                    previous = items[i];
+                    break;
+                }
+                i++;
+            }
+        }
+        return previous;
+    }
+
+   public:
+    TEST_METHOD (FindsNodesByPathIgnoringCase) {
+        int root, windows, system32;
+        TreePathIndex index;
+        index.insert(L"C:\\", &root, 0);
+        index.insert(L"C:\\Windows", &windows, 1);
+        index.insert(L"C:\\Windows\\System32", &system32, 2);
+
+        size_t position = 99;
+        Assert::IsTrue(index.find(L"c:\\windows\\system32\\", &position) == &system32);
+        Assert::AreEqual(size_t(2), position);
+        Assert::IsTrue(index.find(L"C:\\", &position) == &root);
+        Assert::IsTrue(index.find(L"C:\\Program Files", &position) == nullptr);
+    }
+
+    TEST_METHOD (FindDeepestFallsBackToAncestor) {
+        int root, windows;
+        TreePathIndex index;
+        index.insert(L"C:\\", &root, 0);
+        index.insert(L"C:\\Windows", &windows, 1);
+
+        size_t position = 0;
+        bool exact = true;
+        Assert::IsTrue(index.findDeepest(L"C:\\Windows\\Temp\\Deeper", &position, &exact) == &windows);
+        Assert::IsFalse(exact);
+        Assert::AreEqual(size_t(1), position);
+
+        Assert::IsTrue(index.findDeepest(L"C:\\WINDOWS", &position, &exact) == &windows);
+        Assert::IsTrue(exact);
+
+        Assert::IsTrue(index.findDeepest(L"D:\\Windows", &position, &exact) == nullptr);
+        Assert::IsFalse(exact);
+    }
+
+    TEST_METHOD (InsertingAndRemovingShiftTheItemsAfter) {
+        int root, a, b, c;
+        TreePathIndex index;
+        index.insert(L"C:\\", &root, 0);
+        index.insert(L"C:\\C", &c, 1);
+        index.insert(L"C:\\A", &a, 1);
+        index.insert(L"C:\\B", &b, 2);
+
+        size_t position = 0;
+        Assert::IsTrue(index.find(L"C:\\A", &position) == &a);
+        Assert::AreEqual(size_t(1), position);
+        Assert::IsTrue(index.find(L"C:\\C", &position) == &c);
+        Assert::AreEqual(size_t(3), position);
+
+        index.remove(&a);
+        Assert::IsTrue(index.find(L"C:\\A", &position) == nullptr);
+        Assert::IsTrue(index.find(L"C:\\B", &position) == &b);
+        Assert::AreEqual(size_t(1), position);
+        Assert::AreEqual(size_t(3), index.size());
+
+        index.remove(&a);
+        index.clear();
+        Assert::AreEqual(size_t(0), index.size());
+        Assert::IsTrue(index.find(L"C:\\", &position) == nullptr);
+    }
+
+    TEST_METHOD (PositionsFollowRandomInsertsAndRemoves) {
+        std::vector<std::unique_ptr<int>> storage;
+        std::vector<const int*> items;  // What the owner's item list holds.
+        TreePathIndex index;
+        std::mt19937 random(29);
+
+        for (int step = 0; step < 20000; step++) {
+            if (items.empty() || random() % 3 != 0) {
+                size_t position = random() % (items.size() + 1);
+                storage.push_back(std::make_unique<int>(step));
+                items.insert(items.begin() + position, storage.back().get());
+                index.insert(L"C:\\Dir" + std::to_wstring(step), storage.back().get(), position);
+            } else {
+                size_t position = random() % items.size();
+                index.remove(items[position]);
+                items.erase(items.begin() + position);
+            }
+        }
+
+        Assert::AreEqual(items.size(), index.size());
+        for (size_t i = 0; i < items.size(); i++) {
+            size_t position = 0;
+            Assert::IsTrue(index.find(L"C:\\Dir" + std::to_wstring(*items[i]), &position) == items[i]);
+            Assert::AreEqual(i, position);
+        }
+    }
+
+    TEST_METHOD (ALaterNodeForThePathIsFound) {
+        int oldNode, newNode;
+        TreePathIndex index;
+        index.insert(L"C:\\A", &oldNode, 0);
+        index.insert(L"C:\\A", &newNode, 1);
+        Assert::AreEqual(size_t(2), index.size());
+
+        // Removing the old node leaves the new one alone.
+        index.remove(&oldNode);
+        size_t position = 99;
+        Assert::IsTrue(index.find(L"C:\\A", &position) == &newNode);
+        Assert::AreEqual(size_t(0), position);
+
+        // Inserting a node again moves it.
+        index.insert(L"C:\\Renamed", &newNode, 0);
+        Assert::IsTrue(index.find(L"C:\\A", &position) == nullptr);
+        Assert::IsTrue(index.find(L"C:\\Renamed", &position) == &newNode);
+        Assert::AreEqual(size_t(1), index.size());
+    }
+
+    TEST_METHOD (RemovingTheLaterNodeForThePathFindsTheEarlierOne) {
+        int oldNode, newNode;
+        TreePathIndex index;
+        index.insert(L"C:\\A", &oldNode, 0);
+        index.insert(L"C:\\A", &newNode, 1);
+
+        index.remove(&newNode);
+        size_t position = 99;
+        Assert::IsTrue(index.find(L"C:\\A", &position) == &oldNode);
+        Assert::AreEqual(size_t(0), position);
+
+        index.remove(&oldNode);
+        Assert::IsTrue(index.find(L"C:\\A", &position) == nullptr);
+    }
+
+    TEST_METHOD (BenchmarkOneHundredThousandNodes) {
+        // C:\ with 10 x 100 x 100 directories below it, in display order.
+        std::vector<std::unique_ptr<FakeNode>> storage;
+        std::vector<FakeNode*> items;
+        std::vector<std::wstring> paths;
+        auto addNode = [&](const FakeNode* parent, const std::wstring& name, const std::wstring& path) {
+            storage.push_back(std::make_unique<FakeNode>(FakeNode{parent, name}));
+            items.push_back(storage.back().get());
+            paths.push_back(path);
+            return storage.back().get();
+        };
+
+        const FakeNode* root = addNode(nullptr, L"C:\\", L"C:\\");
+        for (int i = 0; i < 10; i++) {
+            std::wstring pathI = L"C:\\Dir" + std::to_wstring(i);
+            const FakeNode* nodeI = addNode(root, L"Dir" + std::to_wstring(i), pathI);
+            for (int j = 0; j < 100; j++) {
+                std::wstring pathJ = pathI + L"\\Sub" + std::to_wstring(j);
+                const FakeNode* nodeJ = addNode(nodeI, L"Sub" + std::to_wstring(j), pathJ);
+                for (int k = 0; k < 100; k++) {
+                    addNode(nodeJ, L"Leaf" + std::to_wstring(k), pathJ + L"\\Leaf" + std::to_wstring(k));
+                }
+            }
+        }
+        Assert::IsTrue(items.size() > 100000);
+
+        TreePathIndex index;
+        for (size_t i = 0; i < items.size(); i++) {
+            index.insert(paths[i], items[i], i);
+        }
+
+        std::mt19937 random(29);
+        std::vector<size_t> lookups(1000);
+        for (auto& lookup : lookups) {
+            lookup = random() % items.size();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t lookup : lookups) {
+            Assert::IsTrue(LinearFind(items, paths[lookup]) == items[lookup]);
+        }
+        auto linear = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t lookup : lookups) {
+            size_t position = 0;
+            Assert::IsTrue(index.find(paths[lookup], &position) == items[lookup]);
+            Assert::AreEqual(lookup, position);
+        }
+        auto hashed = std::chrono::steady_clock::now() - start;
+
+        auto micros = [](std::chrono::steady_clock::duration d) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        };
+        std::wstring message = std::to_wstring(lookups.size()) + L" lookups in " + std::to_wstring(items.size()) +
+            L" nodes: linear walk " + std::to_wstring(micros(linear)) + L" us, index " +
+            std::to_wstring(micros(hashed)) + L" us";
+        Logger::WriteMessage(message.c_str());
+
+        Assert::IsTrue(hashed < linear);
+    }
+};
+
+}  // namespace libwinfile_tests
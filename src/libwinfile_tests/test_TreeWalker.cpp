@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "test_util.h"
+#include "libwinfile/TreeWalker.h"
+
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::TreeWalker;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (TreeWalkerTests) {
+    std::filesystem::path tempDir_;
+
+    // Walks on from start() and writes down each visit as "+dir", "file" or "-dir", with paths relative to the
+    // directory walked and '/' between names, in the order they came.
+    static std::vector<std::wstring> Visits(TreeWalker& walker) {
+        std::vector<std::wstring> visits;
+        size_t rootLength = walker.path().size() + 1;
+
+        for (auto visit = walker.next(); visit != TreeWalker::Visit::End; visit = walker.next()) {
+            std::wstring name = walker.path().substr(rootLength);
+            std::replace(name.begin(), name.end(), L'\\', L'/');
+            if (visit == TreeWalker::Visit::Enter) {
+                name = L"+" + name;
+            } else if (visit == TreeWalker::Visit::Leave) {
+                name = L"-" + name;
+            }
+            visits.push_back(name);
+        }
+        return visits;
+    }
+
+    static size_t IndexOf(const std::vector<std::wstring>& visits, const std::wstring& visit) {
+        auto it = std::find(visits.begin(), visits.end(), visit);
+        Assert::IsTrue(it != visits.end(), visit.c_str());
+        return it - visits.begin();
+    }
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        tempDir_ = std::filesystem::temp_directory_path() / "libwinfile_treewalker_test";
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+        std::filesystem::create_directories(tempDir_ / "root" / "a" / "b");
+        std::filesystem::create_directories(tempDir_ / "root" / "c");
+        WriteFile(tempDir_ / "root" / "a" / "b" / "deep.txt");
+        WriteFile(tempDir_ / "root" / "a" / "in_a.txt");
+        WriteFile(tempDir_ / "root" / "top.log");
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+    }
+
+   public:
+    TEST_METHOD (VisitsDirectoriesBeforeAndAfterWhatIsInThem) {
+        TreeWalker walker(2);
+        Assert::AreEqual(uint32_t(0), walker.start((tempDir_ / "root").wstring() + L"\\"));
+
+        auto visits = Visits(walker);
+
+        Assert::AreEqual(size_t(9), visits.size());
+        Assert::IsTrue(IndexOf(visits, L"+a") < IndexOf(visits, L"+a/b"));
+        Assert::IsTrue(IndexOf(visits, L"+a/b") < IndexOf(visits, L"a/b/deep.txt"));
+        Assert::IsTrue(IndexOf(visits, L"a/b/deep.txt") < IndexOf(visits, L"-a/b"));
+        Assert::IsTrue(IndexOf(visits, L"+a") < IndexOf(visits, L"a/in_a.txt"));
+        Assert::IsTrue(IndexOf(visits, L"a/in_a.txt") < IndexOf(visits, L"-a"));
+        Assert::IsTrue(IndexOf(visits, L"-a/b") < IndexOf(visits, L"-a"));
+        Assert::AreEqual(IndexOf(visits, L"+c") + 1, IndexOf(visits, L"-c"));
+        IndexOf(visits, L"top.log");
+        Assert::AreEqual((tempDir_ / "root").wstring(), walker.path());
+    }
+
+    TEST_METHOD (ReportsDepthAndTheDirectoryOnTheWayOut) {
+        TreeWalker walker;
+        Assert::AreEqual(uint32_t(0), walker.start((tempDir_ / "root").wstring()));
+
+        size_t deepest = 0;
+        for (auto visit = walker.next(); visit != TreeWalker::Visit::End; visit = walker.next()) {
+            deepest = std::max(deepest, walker.depth());
+            if (visit == TreeWalker::Visit::Leave) {
+                std::wstring name = walker.data().cFileName;
+                Assert::IsTrue(walker.path().size() >= name.size());
+                Assert::AreEqual(name, walker.path().substr(walker.path().size() - name.size()));
+                Assert::AreEqual(uint32_t(0), walker.error());
+            }
+            if (std::wstring(walker.data().cFileName) == L"deep.txt") {
+                Assert::AreEqual(size_t(3), walker.depth());
+            }
+        }
+        Assert::AreEqual(size_t(3), deepest);
+    }
+
+    TEST_METHOD (SkippedDirectoriesAreLeftOut) {
+        std::vector<std::wstring> seen;
+        TreeWalker walker;
+        uint32_t error = walker.walk(
+            (tempDir_ / "root").wstring(), L"*", 0, [&seen](TreeWalker::Visit visit, const TreeWalker& walker) {
+                std::wstring name = walker.data().cFileName;
+                seen.push_back(name);
+                return visit == TreeWalker::Visit::Enter && name == L"a" ? TreeWalker::Action::Skip
+                                                                         : TreeWalker::Action::Continue;
+            });
+
+        Assert::AreEqual(uint32_t(0), error);
+        std::sort(seen.begin(), seen.end());
+        Assert::IsTrue((std::vector<std::wstring>{L"a", L"c", L"c", L"top.log"}) == seen);
+    }
+
+    TEST_METHOD (TooLongPathsAreReportedAndNotWalkedInto) {
+        // Room for root\a and root\c, but not for root\a\b or any of the files.
+        auto root = (tempDir_ / "root").wstring();
+        TreeWalker walker;
+        Assert::AreEqual(uint32_t(0), walker.start(root, L"*", 0, root.size() + 4));
+
+        std::vector<std::wstring> visits;
+        for (auto visit = walker.next(); visit != TreeWalker::Visit::End; visit = walker.next()) {
+            std::wstring name = walker.data().cFileName;
+            if (visit == TreeWalker::Visit::Enter) {
+                name = L"+" + name;
+            } else if (visit == TreeWalker::Visit::Leave) {
+                name = L"-" + name;
+            }
+            if (walker.error() == ERROR_FILENAME_EXCED_RANGE) {
+                name = L"!" + name;
+            }
+            visits.push_back(name);
+        }
+
+        std::sort(visits.begin(), visits.end());
+        Assert::IsTrue(
+            (std::vector<std::wstring>{L"!+b", L"!in_a.txt", L"!top.log", L"+a", L"+c", L"-a", L"-c"}) == visits);
+    }
+
+    TEST_METHOD (TooLongNamesFallBackToTheirShortNames) {
+        auto root = (tempDir_ / "short").wstring();
+        std::filesystem::create_directories(root);
+        WriteFile(tempDir_ / "short" / "a long file name.txt");
+
+        // Room for an 8.3 name, but not the long one.
+        TreeWalker walker;
+        Assert::AreEqual(uint32_t(0), walker.start(root, L"*", TreeWalker::kShortNames, root.size() + 14));
+        Assert::IsTrue(walker.next() == TreeWalker::Visit::File);
+
+        // Short names may be turned off on the volume, and then the file can only be reported.
+        std::wstring shortName = walker.data().cAlternateFileName;
+        if (shortName.empty()) {
+            Assert::AreEqual(uint32_t(ERROR_FILENAME_EXCED_RANGE), walker.error());
+        } else {
+            Assert::AreEqual(uint32_t(0), walker.error());
+            Assert::AreEqual(shortName, std::wstring(walker.data().cFileName));
+            Assert::AreEqual(root + L"\\" + shortName, walker.path());
+        }
+        Assert::IsTrue(walker.next() == TreeWalker::Visit::End);
+    }
+
+    TEST_METHOD (MatchesThePatternOnlyInTheDirectoryWalked) {
+        std::filesystem::create_directories(tempDir_ / "root" / "logs.log");
+        WriteFile(tempDir_ / "root" / "logs.log" / "inner.txt");
+
+        TreeWalker walker;
+        Assert::AreEqual(uint32_t(0), walker.start((tempDir_ / "root").wstring(), L"*.log"));
+
+        auto visits = Visits(walker);
+        Assert::IsTrue(
+            (std::vector<std::wstring>{L"+logs.log", L"logs.log/inner.txt", L"-logs.log", L"top.log"}) == visits ||
+            (std::vector<std::wstring>{L"top.log", L"+logs.log", L"logs.log/inner.txt", L"-logs.log"}) == visits);
+
+        Assert::AreEqual(uint32_t(ERROR_FILE_NOT_FOUND), walker.start((tempDir_ / "root").wstring(), L"*.none"));
+        Assert::IsTrue(walker.next() == TreeWalker::Visit::End);
+    }
+
+    TEST_METHOD (VisitsOnlyDirectoriesWhenAsked) {
+        TreeWalker walker;
+        Assert::AreEqual(
+            uint32_t(0), walker.start((tempDir_ / "root").wstring(), L"*", TreeWalker::kDirectoriesOnly));
+
+        auto visits = Visits(walker);
+        Assert::AreEqual(size_t(6), visits.size());
+        Assert::IsTrue(IndexOf(visits, L"+a/b") + 1 == IndexOf(visits, L"-a/b"));
+        IndexOf(visits, L"+c");
+        IndexOf(visits, L"-a");
+    }
+
+    TEST_METHOD (StopEndsTheWalk) {
+        int visits = 0;
+        TreeWalker walker;
+        walker.walk((tempDir_ / "root").wstring(), L"*", 0, [&visits](TreeWalker::Visit, const TreeWalker&) {
+            visits++;
+            return TreeWalker::Action::Stop;
+        });
+
+        Assert::AreEqual(1, visits);
+        Assert::IsTrue(walker.next() == TreeWalker::Visit::End);
+    }
+
+    TEST_METHOD (ReportsAMissingDirectory) {
+        TreeWalker walker;
+        Assert::AreNotEqual(uint32_t(0), walker.start((tempDir_ / "missing").wstring()));
+        Assert::IsTrue(walker.next() == TreeWalker::Visit::End);
+    }
+
+    TEST_METHOD (WalksAndRemovesAChainDeeperThanTheOldLimit) {
+        // COPYROOT had room for 130 levels. Paths this long need the "\\?\" prefix.
+        const int kLevels = 200;
+        std::wstring path = L"\\\\?\\" + (tempDir_ / "chain").wstring();
+        Assert::IsTrue(CreateDirectoryW(path.c_str(), nullptr) != FALSE);
+        std::wstring root = path;
+        for (int i = 0; i < kLevels; i++) {
+            path += L"\\d";
+            Assert::IsTrue(CreateDirectoryW(path.c_str(), nullptr) != FALSE);
+        }
+
+        // Directories are removed on the way out, once what is in them is gone.
+        size_t entered = 0;
+        size_t deepest = 0;
+        TreeWalker walker;
+        uint32_t error = walker.walk(
+            root, L"*", 0, [&entered, &deepest](TreeWalker::Visit visit, const TreeWalker& walker) {
+                if (visit == TreeWalker::Visit::Enter) {
+                    entered++;
+                    deepest = std::max(deepest, walker.depth());
+                } else if (visit == TreeWalker::Visit::Leave) {
+                    Assert::IsTrue(RemoveDirectoryW(walker.path().c_str()) != FALSE);
+                }
+                return TreeWalker::Action::Continue;
+            });
+
+        Assert::AreEqual(uint32_t(0), error);
+        Assert::AreEqual(size_t(kLevels), entered);
+        Assert::AreEqual(size_t(kLevels), deepest);
+        Assert::IsTrue(RemoveDirectoryW(root.c_str()) != FALSE);
+    }
+};
+
+}  // namespace libwinfile_tests
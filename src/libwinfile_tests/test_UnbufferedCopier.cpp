@@ -0,0 +1,225 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "test_util.h"
+#include "libwinfile/UnbufferedCopier.h"
+
+#include <chrono>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using libwinfile::Crc32c;
+using libwinfile::UnbufferedCopier;
+
+namespace libwinfile_tests {
+
+TEST_CLASS (UnbufferedCopierTests) {
+    static constexpr uint32_t kSmallBuffer = UnbufferedCopier::kAlignment;
+
+    std::filesystem::path tempDir_;
+
+    // Contents that differ from file to file and from chunk to chunk, so a chunk written to the wrong place shows.
+    static std::string Contents(size_t size) {
+        std::string contents(size, '\0');
+        for (size_t i = 0; i < size; i++) {
+            contents[i] = static_cast<char>((i * 131 + i / kSmallBuffer + size) % 251);
+        }
+        return contents;
+    }
+
+    static std::string ReadFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        Assert::IsTrue(file.is_open(), L"Failed to open copied file");
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    TEST_METHOD_INITIALIZE(SetUp) {
+        tempDir_ = std::filesystem::temp_directory_path() / "libwinfile_unbuffered_test";
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+        std::filesystem::create_directories(tempDir_);
+    }
+
+    TEST_METHOD_CLEANUP(TearDown) {
+        std::error_code ec;
+        std::filesystem::remove_all(tempDir_, ec);
+    }
+
+   public:
+    TEST_METHOD (BufferSizeIsRoundedToTheAlignment) {
+        Assert::AreEqual(UnbufferedCopier::kAlignment, UnbufferedCopier(1).bufferSize());
+        Assert::AreEqual(kSmallBuffer * 2, UnbufferedCopier(kSmallBuffer + 1).bufferSize());
+        Assert::AreEqual(UnbufferedCopier::kDefaultBufferSize, UnbufferedCopier().bufferSize());
+        Assert::AreEqual(uint32_t(2), UnbufferedCopier(kSmallBuffer, 1).bufferCount());
+    }
+
+    TEST_METHOD (CopiesFilesOfAwkwardSizes) {
+        const size_t sizes[] = {
+            0, 1, 4095, kSmallBuffer - 1, kSmallBuffer, kSmallBuffer + 1, 3 * kSmallBuffer + 123, 10 * kSmallBuffer};
+
+        for (uint32_t bufferCount : {2u, 3u}) {
+            UnbufferedCopier copier(kSmallBuffer, bufferCount);
+            for (size_t size : sizes) {
+                auto source = tempDir_ / (L"source" + std::to_wstring(size));
+                auto destination = tempDir_ / (L"destination" + std::to_wstring(size));
+                std::string contents = Contents(size);
+                WriteFile(source, contents);
+
+                Assert::AreEqual(uint32_t(0), copier.copy(source.wstring(), destination.wstring()));
+                Assert::IsTrue(ReadFile(destination) == contents, L"Copied contents differ");
+            }
+        }
+    }
+
+    TEST_METHOD (ReplacesALongerFile) {
+        auto source = tempDir_ / "source";
+        auto destination = tempDir_ / "destination";
+        WriteFile(source, Contents(kSmallBuffer + 10));
+        WriteFile(destination, Contents(5 * kSmallBuffer));
+
+        Assert::AreEqual(uint32_t(0), UnbufferedCopier(kSmallBuffer).copy(source.wstring(), destination.wstring()));
+        Assert::IsTrue(ReadFile(destination) == Contents(kSmallBuffer + 10), L"Copied contents differ");
+    }
+
+    TEST_METHOD (ReportsProgressInOrderToTheEnd) {
+        auto source = tempDir_ / "source";
+        auto destination = tempDir_ / "destination";
+        const uint64_t size = 5 * kSmallBuffer + 7;
+        WriteFile(source, Contents(size));
+
+        std::vector<uint64_t> reports;
+        uint32_t error = UnbufferedCopier(kSmallBuffer).copy(
+            source.wstring(), destination.wstring(), [&](uint64_t done, uint64_t total) {
+                Assert::AreEqual(size, total);
+                reports.push_back(done);
+                return true;
+            });
+
+        Assert::AreEqual(uint32_t(0), error);
+        Assert::AreEqual(size_t(6), reports.size());
+        for (size_t i = 1; i < reports.size(); i++) {
+            Assert::IsTrue(reports[i - 1] < reports[i]);
+        }
+        Assert::AreEqual(size, reports.back());
+    }
+
+    TEST_METHOD (CancellingDeletesThePartialCopy) {
+        auto source = tempDir_ / "source";
+        auto destination = tempDir_ / "destination";
+        WriteFile(source, Contents(8 * kSmallBuffer));
+
+        uint32_t error = UnbufferedCopier(kSmallBuffer).copy(
+            source.wstring(), destination.wstring(), [](uint64_t, uint64_t) { return false; });
+
+        Assert::AreEqual(uint32_t(ERROR_REQUEST_ABORTED), error);
+        Assert::IsFalse(std::filesystem::exists(destination));
+    }
+
+    TEST_METHOD (ResumesFromAnAlignedOffset) {
+        auto source = tempDir_ / "source";
+        auto destination = tempDir_ / "destination";
+        std::string contents = Contents(5 * kSmallBuffer + 77);
+        WriteFile(source, contents);
+        UnbufferedCopier copier(kSmallBuffer);
+
+        // What is already there is kept as it is, so a copy that started over would show.
+        uint64_t offset = 2 * kSmallBuffer;
+        std::string kept(offset, 'x');
+        WriteFile(destination, kept + "partly written");
+        uint64_t first = 0;
+        auto progress = [&first](uint64_t done, uint64_t) {
+            first = first ? first : done;
+            return true;
+        };
+        Assert::AreEqual(
+            uint32_t(0), copier.copy(source.wstring(), destination.wstring(), progress, nullptr, true, offset));
+        Assert::IsTrue(ReadFile(destination) == kept + contents.substr(offset), L"Resumed contents differ");
+        Assert::AreEqual(offset + kSmallBuffer, first);
+
+        // An unaligned offset, or one past the end of the destination, starts the copy over.
+        for (uint64_t badOffset : {offset + 1, uint64_t(4) * kSmallBuffer}) {
+            WriteFile(destination, kept);
+            Assert::AreEqual(
+                uint32_t(0), copier.copy(source.wstring(), destination.wstring(), nullptr, nullptr, true, badOffset));
+            Assert::IsTrue(ReadFile(destination) == contents, L"Restarted contents differ");
+        }
+    }
+
+    TEST_METHOD (LeavesFilesWithAlternateStreamsToCopyFileEx) {
+        auto source = tempDir_ / "source";
+        auto destination = tempDir_ / "destination";
+        WriteFile(source, Contents(kSmallBuffer));
+        WriteFile(source.wstring() + L":Zone.Identifier", "[ZoneTransfer]\r\nZoneId=3\r\n");
+
+        uint32_t error = UnbufferedCopier(kSmallBuffer).copy(source.wstring(), destination.wstring());
+        Assert::AreEqual(uint32_t(ERROR_NOT_SUPPORTED), error);
+        Assert::IsFalse(std::filesystem::exists(destination));
+    }
+
+    TEST_METHOD (ChecksumsTheSourceOnTheWayAndTheCopyFromDisk) {
+        auto source = tempDir_ / "source";
+        auto destination = tempDir_ / "destination";
+        std::string contents = Contents(7 * kSmallBuffer + 99);
+        WriteFile(source, contents);
+        Crc32c expected;
+        expected.update(contents.data(), contents.size());
+
+        UnbufferedCopier copier(kSmallBuffer, 3);
+        Crc32c sourceCrc;
+        Assert::AreEqual(uint32_t(0), copier.copy(source.wstring(), destination.wstring(), nullptr, &sourceCrc));
+        Crc32c destinationCrc;
+        Assert::AreEqual(uint32_t(0), copier.checksum(destination.wstring(), true, &destinationCrc));
+        Crc32c cachedCrc;
+        Assert::AreEqual(uint32_t(0), copier.checksum(source.wstring(), false, &cachedCrc));
+
+        Assert::AreEqual(expected.value(), sourceCrc.value());
+        Assert::AreEqual(expected.value(), destinationCrc.value());
+        Assert::AreEqual(expected.value(), cachedCrc.value());
+
+        WriteFile(destination, contents.substr(0, contents.size() - 1) + "!");
+        Crc32c damagedCrc;
+        Assert::AreEqual(uint32_t(0), copier.checksum(destination.wstring(), true, &damagedCrc));
+        Assert::AreNotEqual(expected.value(), damagedCrc.value());
+    }
+
+    TEST_METHOD (QuarterGigabyteFileAgainstCopyFile) {
+        const size_t kSize = 256 * 1024 * 1024;
+        auto source = tempDir_ / "source.vhdx";
+        auto buffered = tempDir_ / "buffered.vhdx";
+        auto unbuffered = tempDir_ / "unbuffered.vhdx";
+        auto verified = tempDir_ / "verified.vhdx";
+        {
+            std::ofstream file(source, std::ios::binary);
+            Assert::IsTrue(file.is_open(), L"Failed to create test file");
+            std::string block = Contents(kSmallBuffer);
+            for (size_t written = 0; written < kSize; written += block.size()) {
+                file.write(block.data(), block.size());
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Assert::IsTrue(CopyFileW(source.wstring().c_str(), buffered.wstring().c_str(), FALSE) != FALSE);
+        auto bufferedElapsed = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        Assert::AreEqual(uint32_t(0), UnbufferedCopier().copy(source.wstring(), unbuffered.wstring()));
+        auto unbufferedElapsed = std::chrono::steady_clock::now() - start;
+
+        // Verifying sums the source as it goes by and then reads the copy back from the disk.
+        start = std::chrono::steady_clock::now();
+        UnbufferedCopier copier;
+        Crc32c sourceCrc;
+        Crc32c destinationCrc;
+        Assert::AreEqual(uint32_t(0), copier.copy(source.wstring(), verified.wstring(), nullptr, &sourceCrc));
+        Assert::AreEqual(uint32_t(0), copier.checksum(verified.wstring(), true, &destinationCrc));
+        Assert::AreEqual(sourceCrc.value(), destinationCrc.value());
+        auto verifiedElapsed = std::chrono::steady_clock::now() - start;
+
+        Assert::AreEqual(uintmax_t(kSize), std::filesystem::file_size(unbuffered));
+
+        std::wstring message = L"Copied 256 MB with CopyFile in " + std::to_wstring(Milliseconds(bufferedElapsed)) +
+            L" ms, unbuffered with two 4 MB buffers in " + std::to_wstring(Milliseconds(unbufferedElapsed)) +
+            L" ms, and unbuffered and verified in " + std::to_wstring(Milliseconds(verifiedElapsed)) + L" ms\n";
+        Logger::WriteMessage(message.c_str());
+    }
+};
+
+}  // namespace libwinfile_tests
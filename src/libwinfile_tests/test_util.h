@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CppUnitTest.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace libwinfile_tests {
+
+// Creates the file at path, or replaces it, holding contents.
+inline void WriteFile(const std::filesystem::path& path, const std::string& contents = "contents") {
+    std::ofstream file(path, std::ios::binary);
+    Microsoft::VisualStudio::CppUnitTestFramework::Assert::IsTrue(file.is_open(), L"Failed to create test file");
+    file.write(contents.data(), contents.size());
+}
+
+inline long long Milliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+}  // namespace libwinfile_tests
@@ -127,8 +127,9 @@ FolderWindow::FolderWindow(
     HINSTANCE instance,
     HWND mdiClient,
     std::shared_ptr<libprogman::ShortcutFolder> folder,
-    libprogman::ShortcutManager* shortcutManager)
-    : instance_(instance), folder_(folder), shortcutManager_(shortcutManager) {
+    libprogman::ShortcutManager* shortcutManager,
+    libprogman::IconLoader* iconLoader)
+    : instance_(instance), folder_(folder), shortcutManager_(shortcutManager), iconLoader_(iconLoader) {
     // Register window class if needed
     WNDCLASSEXW wcex = {};
     if (!GetClassInfoExW(instance_, kFolderWindowClass, &wcex)) {
@@ -239,6 +240,13 @@ void FolderWindow::createListView() {
             ImageList_Create(GetSystemMetrics(SM_CXICON), GetSystemMetrics(SM_CYICON), ILC_COLOR32 | ILC_MASK, 30, 10);
         ListView_SetImageList(listView_, hSystemImageList, LVSIL_NORMAL);
     }
+
+    // The generic application icon stands in for shortcuts whose icons are still loading
+    HIMAGELIST imageList = ListView_GetImageList(listView_, LVSIL_NORMAL);
+    placeholderIconIndex_ = ImageList_AddIcon(imageList, LoadIconW(nullptr, IDI_APPLICATION));
+
+    // Shortcuts that share an icon share its slot, and refreshes reuse the slots of icons no longer shown
+    iconSlots_ = std::make_unique<ImageListSlots>(imageList);
 }
 
 void FolderWindow::refreshListView() {
@@ -246,30 +254,189 @@ void FolderWindow::refreshListView() {
         return;
     }
 
-    // Clear existing items
-    ListView_DeleteAllItems(listView_);
+    // Apply only what changed since the list view was last filled, so the scroll position, selection and focus of
+    // items that didn't change are left alone.
+    bool wasEmpty = ListView_GetItemCount(listView_) == 0;
+    auto diff = libprogman::ShortcutFolder::diff(shownShortcuts_, folder_->shortcuts());
+    shownShortcuts_ = folder_->shortcuts();
+
+    std::vector<std::shared_ptr<libprogman::Shortcut>> unloaded;
+
+    for (const auto& shortcut : diff.removed) {
+        int index = findItem(shortcut.get());
+        if (index != -1) {
+            iconSlots_->release(itemIconIndex(index));
+            ListView_DeleteItem(listView_, index);
+        }
+    }
+
+    // A changed .lnk file keeps its item, and gets the new Shortcut object and icon
+    for (const auto& [oldShortcut, newShortcut] : diff.changed) {
+        int index = findItem(oldShortcut.get());
+        if (index == -1) {
+            diff.added.push_back(newShortcut);
+            continue;
+        }
 
-    // Populate with shortcuts
-    int itemIndex = 0;
-    for (const auto& [name, shortcut] : folder_->shortcuts()) {
-        // Add icon to the image list
-        HIMAGELIST hImageList = ListView_GetImageList(listView_, LVSIL_NORMAL);
-        int iconIndex = ImageList_AddIcon(hImageList, shortcut->icon().get());
+        int oldIconIndex = itemIconIndex(index);
 
-        // Add item to ListView
+        LVITEMW lvItem = {};
+        lvItem.mask = LVIF_IMAGE | LVIF_PARAM;
+        lvItem.iItem = index;
+        lvItem.iImage = acquireIconIndex(newShortcut, &unloaded);
+        lvItem.lParam = reinterpret_cast<LPARAM>(newShortcut.get());
+        ListView_SetItem(listView_, &lvItem);
+
+        iconSlots_->release(oldIconIndex);
+    }
+
+    for (const auto& shortcut : diff.added) {
+        // Filling an empty list view, append everything and sort once at the end. Otherwise put each new item
+        // where it sorts, so the items around it don't move any more than they have to.
         LVITEMW lvItem = {};
         lvItem.mask = LVIF_TEXT | LVIF_IMAGE | LVIF_PARAM;
-        lvItem.iItem = itemIndex++;
+        lvItem.iItem = wasEmpty ? ListView_GetItemCount(listView_) : sortedInsertIndex(shortcut->name());
         lvItem.iSubItem = 0;
-        lvItem.pszText = const_cast<LPWSTR>(name.c_str());
-        lvItem.iImage = iconIndex;
+        lvItem.pszText = const_cast<LPWSTR>(shortcut->name().c_str());
+        lvItem.iImage = acquireIconIndex(shortcut, &unloaded);
         lvItem.lParam = reinterpret_cast<LPARAM>(shortcut.get());
 
         ListView_InsertItem(listView_, &lvItem);
     }
 
-    // Sort items by name
-    ListView_SortItems(listView_, CompareListViewItems, 0);
+    if (wasEmpty) {
+        // Sort items by name
+        ListView_SortItems(listView_, CompareListViewItems, 0);
+    }
+
+    if (!unloaded.empty()) {
+        // Post at most one message at a time; swapInLoadedIcons() picks up every icon loaded by then.
+        HWND window = window_;
+        auto posted = iconsLoadedPosted_;
+        iconLoader_->load(unloaded, [window, posted]() {
+            if (!posted->exchange(true)) {
+                PostMessageW(window, libprogman::WM_SHORTCUT_ICONS_LOADED, 0, 0);
+            }
+        });
+        prioritizeVisibleIcons();
+    }
+}
+
+int FolderWindow::acquireIconIndex(
+    const std::shared_ptr<libprogman::Shortcut>& shortcut,
+    std::vector<std::shared_ptr<libprogman::Shortcut>>* unloaded) {
+    // Shortcuts that IconLoader hasn't gotten to yet show the placeholder until swapInLoadedIcons() replaces it.
+    // Check isLoaded() first so one that finishes in between is still queued.
+    if (!shortcut->isLoaded()) {
+        unloaded->push_back(shortcut);
+        return placeholderIconIndex_;
+    }
+
+    int slot = iconSlots_->acquire(shortcut->icon());
+    return slot == -1 ? placeholderIconIndex_ : slot;
+}
+
+int FolderWindow::findItem(const libprogman::Shortcut* shortcut) const {
+    LVFINDINFOW findInfo = {};
+    findInfo.flags = LVFI_PARAM;
+    findInfo.lParam = reinterpret_cast<LPARAM>(shortcut);
+    return ListView_FindItem(listView_, -1, &findInfo);
+}
+
+int FolderWindow::itemIconIndex(int index) const {
+    LVITEMW lvItem = {};
+    lvItem.mask = LVIF_IMAGE;
+    lvItem.iItem = index;
+    if (!ListView_GetItem(listView_, &lvItem)) {
+        return -1;
+    }
+    return lvItem.iImage;
+}
+
+int FolderWindow::sortedInsertIndex(const std::wstring& name) const {
+    // The items are sorted by name, so binary search for the first one that sorts after it.
+    int low = 0;
+    int high = ListView_GetItemCount(listView_);
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+
+        LVITEMW lvItem = {};
+        lvItem.mask = LVIF_PARAM;
+        lvItem.iItem = middle;
+        ListView_GetItem(listView_, &lvItem);
+        auto* shortcut = reinterpret_cast<libprogman::Shortcut*>(lvItem.lParam);
+
+        if (shortcut != nullptr && _wcsicmp(shortcut->name().c_str(), name.c_str()) <= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void FolderWindow::swapInLoadedIcons() {
+    iconsLoadedPosted_->store(false);
+
+    if (!listView_) {
+        return;
+    }
+
+    int count = ListView_GetItemCount(listView_);
+    for (int i = 0; i < count; i++) {
+        LVITEMW lvItem = {};
+        lvItem.mask = LVIF_IMAGE | LVIF_PARAM;
+        lvItem.iItem = i;
+        if (!ListView_GetItem(listView_, &lvItem) || lvItem.iImage != placeholderIconIndex_) {
+            continue;
+        }
+
+        // Shortcuts that failed to load have no icon and keep the placeholder
+        auto* shortcut = reinterpret_cast<libprogman::Shortcut*>(lvItem.lParam);
+        if (!shortcut || !shortcut->isLoaded()) {
+            continue;
+        }
+        int slot = iconSlots_->acquire(shortcut->icon());
+        if (slot == -1) {
+            continue;
+        }
+
+        lvItem.mask = LVIF_IMAGE;
+        lvItem.iImage = slot;
+        ListView_SetItem(listView_, &lvItem);
+    }
+}
+
+void FolderWindow::prioritizeVisibleIcons() {
+    if (!listView_) {
+        return;
+    }
+
+    RECT clientRect;
+    GetClientRect(listView_, &clientRect);
+
+    // Items still showing the placeholder that are at least partly scrolled into view, top to bottom
+    std::vector<const libprogman::Shortcut*> visible;
+    int count = ListView_GetItemCount(listView_);
+    for (int i = 0; i < count; i++) {
+        LVITEMW lvItem = {};
+        lvItem.mask = LVIF_IMAGE | LVIF_PARAM;
+        lvItem.iItem = i;
+        if (!ListView_GetItem(listView_, &lvItem) || lvItem.iImage != placeholderIconIndex_) {
+            continue;
+        }
+
+        RECT itemRect;
+        RECT intersection;
+        if (ListView_GetItemRect(listView_, i, &itemRect, LVIR_BOUNDS) &&
+            IntersectRect(&intersection, &itemRect, &clientRect)) {
+            visible.push_back(reinterpret_cast<const libprogman::Shortcut*>(lvItem.lParam));
+        }
+    }
+
+    if (!visible.empty()) {
+        iconLoader_->prioritize(visible);
+    }
 }
 
 void FolderWindow::setOnMinimizeCallback(std::function<void(const std::wstring&)> callback) {
@@ -380,6 +547,9 @@ LRESULT FolderWindow::handleMessage(HWND hwnd, UINT message, WPARAM wParam, LPAR
             GetClientRect(hwnd, &clientRect);
             if (listView_) {
                 MoveWindow(listView_, 0, 0, clientRect.right, clientRect.bottom, TRUE);
+
+                // Growing the window can bring items into view
+                prioritizeVisibleIcons();
             }
             // Continue with default handling for MDI child window
             break;
@@ -428,6 +598,10 @@ LRESULT FolderWindow::handleMessage(HWND hwnd, UINT message, WPARAM wParam, LPAR
             renameSelectedItem();
             return 0;
 
+        case libprogman::WM_SHORTCUT_ICONS_LOADED:
+            swapInLoadedIcons();
+            return 0;
+
         case WM_NOTIFY: {
             NMHDR* nmhdr = reinterpret_cast<NMHDR*>(lParam);
             if (nmhdr->hwndFrom == listView_) {
@@ -576,6 +750,11 @@ LRESULT FolderWindow::handleMessage(HWND hwnd, UINT message, WPARAM wParam, LPAR
                         break;
                     }
 
+                    case LVN_ENDSCROLL:
+                        // Load the icons scrolled into view first
+                        prioritizeVisibleIcons();
+                        break;
+
                     case LVN_ITEMCHANGED: {
                         // Handle selection changes in the ListView
                         NMLISTVIEW* pnmlv = reinterpret_cast<NMLISTVIEW*>(lParam);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "progman/pch.h"
+#include "progman/ImageListSlots.h"
+#include "libprogman/IconLoader.h"
 #include "libprogman/ShortcutFolder.h"
 #include "libprogman/ShortcutManager.h"
 
@@ -23,7 +25,8 @@ class FolderWindow {
         HINSTANCE instance,
         HWND mdiClient,
         std::shared_ptr<libprogman::ShortcutFolder> folder,
-        libprogman::ShortcutManager* shortcutManager);
+        libprogman::ShortcutManager* shortcutManager,
+        libprogman::IconLoader* iconLoader);
     FolderWindow(const FolderWindow&) = delete;
     FolderWindow& operator=(const FolderWindow&) = delete;
     FolderWindow(FolderWindow&&) = delete;
@@ -62,7 +65,12 @@ class FolderWindow {
     HWND window_ = nullptr;
     HWND listView_ = nullptr;
     std::shared_ptr<libprogman::ShortcutFolder> folder_;
+    immer::map<std::wstring, std::shared_ptr<libprogman::Shortcut>> shownShortcuts_;  // What the list view shows.
     libprogman::ShortcutManager* shortcutManager_ = nullptr;
+    libprogman::IconLoader* iconLoader_ = nullptr;
+    int placeholderIconIndex_ = -1;  // Shown for shortcuts until IconLoader has their icons.
+    std::unique_ptr<ImageListSlots> iconSlots_;
+    std::shared_ptr<std::atomic<bool>> iconsLoadedPosted_ = std::make_shared<std::atomic<bool>>(false);
     std::function<void(const std::wstring&)> onMinimizeCallback_;
     std::function<void()> onFocusChangeCallback_;
     bool isMinimized_ = false;
@@ -77,6 +85,14 @@ class FolderWindow {
 
     void createListView();
     void refreshListView();
+    int acquireIconIndex(
+        const std::shared_ptr<libprogman::Shortcut>& shortcut,
+        std::vector<std::shared_ptr<libprogman::Shortcut>>* unloaded);
+    int findItem(const libprogman::Shortcut* shortcut) const;
+    int itemIconIndex(int index) const;
+    int sortedInsertIndex(const std::wstring& name) const;
+    void swapInLoadedIcons();
+    void prioritizeVisibleIcons();
     void setupDragAndDrop();
     void cleanupDragAndDrop();
 
@@ -0,0 +1,58 @@
+#include "progman/pch.h"
+#include "progman/ImageListSlots.h"
+
+namespace progman {
+
+ImageListSlots::ImageListSlots(HIMAGELIST imageList)
+    : imageList_(imageList), firstSlot_(ImageList_GetImageCount(imageList)) {}
+
+int ImageListSlots::acquire(const wil::shared_hicon& icon) {
+    if (!icon) {
+        return -1;
+    }
+
+    auto it = slotsByIcon_.find(icon.get());
+    if (it != slotsByIcon_.end()) {
+        slots_[it->second - firstSlot_].users++;
+        return it->second;
+    }
+
+    // Overwrite a slot no item uses anymore before growing the image list.
+    int index = -1;
+    if (!freeSlots_.empty()) {
+        index = ImageList_ReplaceIcon(imageList_, freeSlots_.back(), icon.get());
+        if (index != -1) {
+            freeSlots_.pop_back();
+        }
+    } else {
+        index = ImageList_AddIcon(imageList_, icon.get());
+        if (index != -1) {
+            slots_.resize(index - firstSlot_ + 1);
+        }
+    }
+    if (index == -1) {
+        return -1;
+    }
+
+    slots_[index - firstSlot_] = { icon, 1 };
+    slotsByIcon_[icon.get()] = index;
+    return index;
+}
+
+void ImageListSlots::release(int slot) noexcept {
+    if (slot < firstSlot_ || slot - firstSlot_ >= static_cast<int>(slots_.size())) {
+        return;
+    }
+
+    auto& entry = slots_[slot - firstSlot_];
+    if (entry.users == 0 || --entry.users > 0) {
+        return;
+    }
+
+    // Keep the pixels in the image list until the slot is reused, but let the icon go.
+    slotsByIcon_.erase(entry.icon.get());
+    entry.icon = wil::shared_hicon{};
+    freeSlots_.push_back(slot);
+}
+
+}  // namespace progman
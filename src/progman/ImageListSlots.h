@@ -0,0 +1,37 @@
+#pragma once
+
+#include "progman/pch.h"
+
+namespace progman {
+
+// Tracks which icon is in each slot of a list view's image list and how many items show it, so items showing the
+// same icon share a slot and slots nobody uses anymore are overwritten rather than appended to. The image list stays
+// as big as the most distinct icons shown at once, however often the list view is repopulated.
+// Slots already in the image list when this is constructed, such as a placeholder icon, are left alone.
+class ImageListSlots {
+   public:
+    explicit ImageListSlots(HIMAGELIST imageList);
+    ImageListSlots(const ImageListSlots&) = delete;
+    ImageListSlots& operator=(const ImageListSlots&) = delete;
+
+    // Returns the slot showing icon, putting it in a free slot if no item shows it yet, and counts one more item
+    // using it. The slot holds a reference to icon until it's released. Returns -1 if the icon can't be added.
+    int acquire(const wil::shared_hicon& icon);
+
+    // Counts one less item using the slot. Ignores -1 and the slots that were there before this was constructed.
+    void release(int slot) noexcept;
+
+   private:
+    struct Slot {
+        wil::shared_hicon icon;  // Null while the slot is free.
+        int users;
+    };
+
+    HIMAGELIST imageList_;
+    int firstSlot_;                               // Image list index of slots_[0].
+    std::vector<Slot> slots_;
+    std::unordered_map<HICON, int> slotsByIcon_;  // Image list index by the icon in it.
+    std::vector<int> freeSlots_;
+};
+
+}  // namespace progman
@@ -1,6 +1,7 @@
 #include "progman/pch.h"
 #include "progman/NewShortcutDialog.h"
 #include "progman/resource.h"
+#include "libprogman/constants.h"
 #include "libprogman/window_data.h"
 
 using namespace progman;
@@ -41,6 +42,14 @@ INT_PTR CALLBACK NewShortcutDialog::dialogProc(HWND hwnd, UINT message, WPARAM w
                         dialog->selectPathRadio(hwnd);
                     }
                     return TRUE;
+
+                case IDC_SEARCH_EDIT:
+                    if (HIWORD(wParam) == EN_SETFOCUS) {
+                        dialog->selectApplicationRadio(hwnd);
+                    } else if (HIWORD(wParam) == EN_CHANGE) {
+                        dialog->filterApplicationsList(hwnd);
+                    }
+                    return TRUE;
             }
             break;
 
@@ -55,10 +64,20 @@ INT_PTR CALLBACK NewShortcutDialog::dialogProc(HWND hwnd, UINT message, WPARAM w
                         dialog->selectApplicationRadio(hwnd);
                         dialog->handleOkButton(hwnd);
                         return TRUE;
+                    case LVN_ENDSCROLL:
+                        dialog->prioritizeVisibleIcons(hwnd);
+                        return TRUE;
+                    case LVN_GETDISPINFO:
+                        dialog->getItemDisplayInfo(hwnd, reinterpret_cast<NMLVDISPINFO*>(lParam));
+                        return TRUE;
                 }
             }
             break;
 
+        case libprogman::WM_SHORTCUT_ICONS_LOADED:
+            dialog->swapInLoadedIcons(hwnd);
+            return TRUE;
+
         case WM_CLOSE:
             EndDialog(hwnd, IDCANCEL);
             return TRUE;
@@ -72,12 +91,15 @@ NewShortcutDialog::NewShortcutDialog(
     HINSTANCE hInstance,
     std::filesystem::path folder,
     immer::vector<std::shared_ptr<libprogman::Shortcut>> installedApps,
-    libprogman::ShortcutFactory* shortcutFactory)
+    libprogman::ShortcutFactory* shortcutFactory,
+    libprogman::IconLoader* iconLoader)
     : parentWindow_(parentWindow),
       hInstance_(hInstance),
       folder_(folder),
       installedApps_(installedApps),
-      shortcutFactory_(shortcutFactory) {}
+      shortcutFactory_(shortcutFactory),
+      iconLoader_(iconLoader),
+      searchIndex_(installedApps) {}
 
 void NewShortcutDialog::showDialog() {
     dialogHandle_ = nullptr;
@@ -123,61 +145,152 @@ void NewShortcutDialog::initializeDialog(HWND hwnd) {
 
     ListView_SetImageList(listView, imageList, LVSIL_SMALL);
 
+    // The generic application icon stands in for apps whose icons are still loading
+    placeholderIconIndex_ = ImageList_AddIcon(imageList, LoadIconW(nullptr, IDI_APPLICATION));
+    iconSlots_ = std::make_unique<ImageListSlots>(imageList);
+
+    // Set full row select style and disable grid lines for a cleaner look
+    DWORD exStyle = ListView_GetExtendedListViewStyle(listView);
+    exStyle |= LVS_EX_FULLROWSELECT;
+    ListView_SetExtendedListViewStyle(listView, exStyle);
+
+    SendDlgItemMessage(hwnd, IDC_SEARCH_EDIT, EM_SETCUEBANNER, FALSE, reinterpret_cast<LPARAM>(L"Search"));
+
     // Select Application radio by default
     CheckDlgButton(hwnd, IDC_INSTALLED_APPLICATION_RADIO, BST_CHECKED);
 
-    // Populate applications list
-    populateApplicationsList(hwnd);
+    // Show every app until something is typed in the search box
+    filterApplicationsList(hwnd);
+    startLoadingIcons(hwnd);
+}
+
+void NewShortcutDialog::startLoadingIcons(HWND hwnd) {
+    // Apps that IconLoader hasn't gotten to yet show the placeholder until their rows are redrawn by
+    // swapInLoadedIcons().
+    std::vector<std::shared_ptr<Shortcut>> unloaded;
+    for (const auto& app : installedApps_) {
+        if (!app->isLoaded()) {
+            unloaded.push_back(app);
+        }
+    }
+
+    if (!unloaded.empty()) {
+        // Post at most one message at a time; swapInLoadedIcons() picks up every icon loaded by then.
+        auto posted = iconsLoadedPosted_;
+        iconLoader_->load(unloaded, [hwnd, posted]() {
+            if (!posted->exchange(true)) {
+                PostMessageW(hwnd, libprogman::WM_SHORTCUT_ICONS_LOADED, 0, 0);
+            }
+        });
+        prioritizeVisibleIcons(hwnd);
+    }
 }
 
-void NewShortcutDialog::populateApplicationsList(HWND hwnd) {
+void NewShortcutDialog::filterApplicationsList(HWND hwnd) {
+    wchar_t query[MAX_PATH] = { 0 };
+    GetDlgItemText(hwnd, IDC_SEARCH_EDIT, query, MAX_PATH);
+    shownApps_ = searchIndex_.search(query);
+
+    // The list view is virtual; it asks getItemDisplayInfo() for the rows it draws, so only the count changes here
     HWND listView = GetDlgItem(hwnd, IDC_APPLICATIONS_LIST);
+    ListView_SetItemState(listView, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+    ListView_SetItemCountEx(listView, static_cast<int>(shownApps_.size()), 0);
+
+    // Select the best match, so Enter picks it
+    if (query[0] != L'\0' && !shownApps_.empty()) {
+        ListView_SetItemState(listView, 0, LVIS_SELECTED | LVIS_FOCUSED, LVIS_SELECTED | LVIS_FOCUSED);
+        ListView_EnsureVisible(listView, 0, FALSE);
+    }
+
+    prioritizeVisibleIcons(hwnd);
+}
+
+void NewShortcutDialog::getItemDisplayInfo(HWND hwnd, NMLVDISPINFO* info) {
+    if (info->item.iItem < 0 || info->item.iItem >= static_cast<int>(shownApps_.size())) {
+        return;
+    }
+    const auto& app = installedApps_[shownApps_[info->item.iItem]];
+
+    if (info->item.mask & LVIF_TEXT) {
+        wcsncpy_s(info->item.pszText, info->item.cchTextMax, app->name().c_str(), _TRUNCATE);
+    }
+    if (info->item.mask & LVIF_IMAGE) {
+        info->item.iImage = appIconIndex(hwnd, *app);
+    }
+}
+
+int NewShortcutDialog::appIconIndex(HWND hwnd, const Shortcut& app) {
+    if (!app.isLoaded()) {
+        return placeholderIconIndex_;
+    }
+
+    // Apps that failed to load have no icon and keep the placeholder
+    auto it = iconIndices_.find(&app);
+    if (it == iconIndices_.end()) {
+        it = iconIndices_.emplace(&app, addAppIcon(hwnd, app)).first;
+    }
+    return it->second;
+}
+
+int NewShortcutDialog::addAppIcon(HWND hwnd, const Shortcut& app) {
+    // Add icon to image list - using DPI-aware icon if possible
+    wil::shared_hicon icon = app.icon();
+    if (!icon) {
+        return placeholderIconIndex_;
+    }
 
     // Get DPI for the current window
     int dpi = GetDpiForWindow(hwnd);
     float dpiScale = static_cast<float>(dpi) / 96.0f;
 
-    // Add each app to the list
-    int itemIndex = 0;
-    for (const auto& app : installedApps_) {
-        // Add icon to image list - using DPI-aware icon if possible
-        wil::shared_hicon icon = app->icon();
-
-        // For high DPI, we'll extract the icon directly using a better size
-        if (dpiScale > 1.0f) {
-            // Try to extract a larger icon from the executable file
-            std::filesystem::path exePath = app->path();
-            if (std::filesystem::exists(exePath)) {
-                int scaledSize = static_cast<int>(32 * dpiScale);
-                HICON hIcon = nullptr;
-
-                // Use ExtractIconEx to get a better size icon
-                if (ExtractIconEx(exePath.c_str(), 0, &hIcon, nullptr, 1) > 0 && hIcon) {
-                    // Replace the icon with this higher resolution one
-                    icon.reset(hIcon);
-                }
+    // For high DPI, we'll extract the icon directly using a better size
+    if (dpiScale > 1.0f) {
+        // Try to extract a larger icon from the executable file
+        std::filesystem::path exePath = app.path();
+        if (std::filesystem::exists(exePath)) {
+            HICON hIcon = nullptr;
+
+            // Use ExtractIconEx to get a better size icon
+            if (ExtractIconEx(exePath.c_str(), 0, &hIcon, nullptr, 1) > 0 && hIcon) {
+                // Replace the icon with this higher resolution one
+                icon.reset(hIcon);
             }
         }
+    }
+
+    int slot = iconSlots_->acquire(icon);
+    return slot == -1 ? placeholderIconIndex_ : slot;
+}
 
-        int imageIndex = ImageList_AddIcon(ListView_GetImageList(listView, LVSIL_SMALL), icon.get());
+void NewShortcutDialog::swapInLoadedIcons(HWND hwnd) {
+    iconsLoadedPosted_->store(false);
 
-        // Add item to list view
-        LVITEM item = { 0 };
-        item.mask = LVIF_TEXT | LVIF_IMAGE;
-        item.iItem = itemIndex++;
-        item.iSubItem = 0;
-        item.iImage = imageIndex;
+    // Rows ask for their icons again when they're redrawn, and scrolled-off rows will when they're scrolled back
+    HWND listView = GetDlgItem(hwnd, IDC_APPLICATIONS_LIST);
+    int top = ListView_GetTopIndex(listView);
+    int bottom = std::min(top + ListView_GetCountPerPage(listView), static_cast<int>(shownApps_.size()) - 1);
+    if (bottom >= top) {
+        ListView_RedrawItems(listView, top, bottom);
+    }
+}
 
-        std::wstring name = app->name();
-        item.pszText = const_cast<LPWSTR>(name.c_str());
+void NewShortcutDialog::prioritizeVisibleIcons(HWND hwnd) {
+    HWND listView = GetDlgItem(hwnd, IDC_APPLICATIONS_LIST);
 
-        ListView_InsertItem(listView, &item);
+    // The rows scrolled into view, top to bottom
+    std::vector<const Shortcut*> visible;
+    int top = ListView_GetTopIndex(listView);
+    int bottom = std::min(top + ListView_GetCountPerPage(listView) + 1, static_cast<int>(shownApps_.size()));
+    for (int i = top; i < bottom; i++) {
+        const auto& app = installedApps_[shownApps_[i]];
+        if (!app->isLoaded()) {
+            visible.push_back(app.get());
+        }
     }
 
-    // Set full row select style and disable grid lines for a cleaner look
-    DWORD exStyle = ListView_GetExtendedListViewStyle(listView);
-    exStyle |= LVS_EX_FULLROWSELECT;
-    ListView_SetExtendedListViewStyle(listView, exStyle);
+    if (!visible.empty()) {
+        iconLoader_->prioritize(visible);
+    }
 }
 
 void NewShortcutDialog::handleOkButton(HWND hwnd) {
@@ -224,8 +337,8 @@ void NewShortcutDialog::createShortcut(HWND hwnd) {
             HWND listView = GetDlgItem(hwnd, IDC_APPLICATIONS_LIST);
             int selectedIndex = ListView_GetNextItem(listView, -1, LVNI_SELECTED);
 
-            if (selectedIndex >= 0 && selectedIndex < static_cast<int>(installedApps_.size())) {
-                auto selectedApp = installedApps_[selectedIndex];
+            if (selectedIndex >= 0 && selectedIndex < static_cast<int>(shownApps_.size())) {
+                auto selectedApp = installedApps_[shownApps_[selectedIndex]];
                 std::filesystem::path targetPath = selectedApp->path();
                 std::filesystem::path lnkPath = folder_ / (selectedApp->name() + L".lnk");
                 shortcutFactory_->create(lnkPath, targetPath);
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "progman/pch.h"
+#include "progman/ImageListSlots.h"
+#include "libprogman/AppSearchIndex.h"
+#include "libprogman/IconLoader.h"
 #include "libprogman/ShortcutFactory.h"
 #include "libprogman/Shortcut.h"
 
@@ -13,7 +16,8 @@ class NewShortcutDialog {
         HINSTANCE hInstance,
         std::filesystem::path folder,
         immer::vector<std::shared_ptr<libprogman::Shortcut>> installedApps,
-        libprogman::ShortcutFactory* shortcutFactory);
+        libprogman::ShortcutFactory* shortcutFactory,
+        libprogman::IconLoader* iconLoader);
 
     void showDialog();
 
@@ -21,7 +25,13 @@ class NewShortcutDialog {
     static INT_PTR CALLBACK dialogProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
 
     void initializeDialog(HWND hwnd);
-    void populateApplicationsList(HWND hwnd);
+    void startLoadingIcons(HWND hwnd);
+    void filterApplicationsList(HWND hwnd);
+    void getItemDisplayInfo(HWND hwnd, NMLVDISPINFO* info);
+    int appIconIndex(HWND hwnd, const libprogman::Shortcut& app);
+    int addAppIcon(HWND hwnd, const libprogman::Shortcut& app);
+    void swapInLoadedIcons(HWND hwnd);
+    void prioritizeVisibleIcons(HWND hwnd);
     void handleOkButton(HWND hwnd);
     void handleBrowseButton(HWND hwnd);
     void selectApplicationRadio(HWND hwnd);
@@ -34,7 +44,16 @@ class NewShortcutDialog {
     std::filesystem::path folder_;
     immer::vector<std::shared_ptr<libprogman::Shortcut>> installedApps_;
     libprogman::ShortcutFactory* shortcutFactory_;
+    libprogman::IconLoader* iconLoader_;
+    libprogman::AppSearchIndex searchIndex_;
+    std::vector<int> shownApps_;  // The installedApps_ index of each row in the list view, which is virtual.
     HWND dialogHandle_ = nullptr;
+    int placeholderIconIndex_ = -1;              // Shown for apps until IconLoader has their icons.
+    std::unique_ptr<ImageListSlots> iconSlots_;  // Apps with the same icon share one image list slot.
+    std::shared_ptr<std::atomic<bool>> iconsLoadedPosted_ = std::make_shared<std::atomic<bool>>(false);
+
+    // The image list index of each loaded app's icon, from the first time its row was drawn.
+    std::unordered_map<const libprogman::Shortcut*, int> iconIndices_;
 };
 
 }  // namespace progman
@@ -48,11 +48,15 @@ ProgramManagerWindow::ProgramManagerWindow(
     HINSTANCE hInstance,
     libprogman::ShortcutManager* shortcutManager,
     libprogman::ShortcutFactory* shortcutFactory,
-    libprogman::InstalledAppList* installedAppList)
+    libprogman::InstalledAppList* installedAppList,
+    libprogman::InstalledAppMonitor* installedAppMonitor,
+    libprogman::IconLoader* iconLoader)
     : hInstance_(hInstance),
       shortcutManager_(shortcutManager),
       shortcutFactory_(shortcutFactory),
-      installedAppList_(installedAppList) {
+      installedAppList_(installedAppList),
+      installedAppMonitor_(installedAppMonitor),
+      iconLoader_(iconLoader) {
     registerWindowClass();
 
     // Create the main frame window with explicit MDI frame styles
@@ -417,16 +421,23 @@ LRESULT ProgramManagerWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam,
                         return 0;
                     }
 
-                    // 2. Show FindingAppsDialog to load installed apps
-                    FindingAppsDialog findingAppsDialog(hInstance_, installedAppList_);
-                    int result = findingAppsDialog.showDialog(hwnd);
-                    if (result != IDOK) {
-                        return 0;
+                    // 2. Get the list of installed apps. InstalledAppMonitor keeps it up to date in the background;
+                    // only if its first scan isn't done yet, show FindingAppsDialog while we wait for one.
+                    immer::vector<std::shared_ptr<libprogman::Shortcut>> installedApps;
+                    if (auto monitoredApps = installedAppMonitor_->apps()) {
+                        installedApps = std::move(*monitoredApps);
+                    } else {
+                        installedAppMonitor_->hurry();
+
+                        // 3. Show FindingAppsDialog to load installed apps
+                        FindingAppsDialog findingAppsDialog(hInstance_, installedAppList_);
+                        int result = findingAppsDialog.showDialog(hwnd);
+                        if (result != IDOK) {
+                            return 0;
+                        }
+                        installedApps = findingAppsDialog.apps();
                     }
 
-                    // 3. Get the list of installed apps
-                    auto installedApps = findingAppsDialog.apps();
-
                     // Get the folder path from the folder name
                     std::wstring folderName = activeFolder->getName();
                     try {
@@ -437,7 +448,7 @@ LRESULT ProgramManagerWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam,
 
                         // 4. Show NewShortcutDialog
                         NewShortcutDialog newShortcutDialog(
-                            hwnd, hInstance_, folderPtr->path(), installedApps, shortcutFactory_);
+                            hwnd, hInstance_, folderPtr->path(), installedApps, shortcutFactory_, iconLoader_);
                         newShortcutDialog.showDialog();
                     } catch (const std::exception& e) {
                         // Show error message if the folder couldn't be found
@@ -544,9 +555,9 @@ LRESULT ProgramManagerWindow::handleMessage(HWND hwnd, UINT uMsg, WPARAM wParam,
     return DefFrameProcW(hwnd, mdiClient_, uMsg, wParam, lParam);
 }
 
-void ProgramManagerWindow::refresh() {
-    // Refresh the shortcuts from disk.
-    shortcutManager_->refresh();
+void ProgramManagerWindow::refresh(const std::vector<libprogman::FolderChange>& changes) {
+    // Reload what changed from disk.
+    shortcutManager_->applyChanges(changes);
 
     // Post a message to sync the folder windows on the UI thread
     PostMessageW(hwnd_, libprogman::WM_SYNC_FOLDER_WINDOWS, 0, 0);
@@ -583,7 +594,8 @@ void ProgramManagerWindow::syncFolderWindows() {
     for (const auto& [folderName, folder] : currentFolders) {
         if (folderWindows_.find(folderName) == folderWindows_.end()) {
             // New folder, create a window for it
-            auto folderWindow = std::make_unique<FolderWindow>(hInstance_, mdiClient_, folder, shortcutManager_);
+            auto folderWindow =
+                std::make_unique<FolderWindow>(hInstance_, mdiClient_, folder, shortcutManager_, iconLoader_);
             // Set the minimize callback
             folderWindow->setOnMinimizeCallback([this](const std::wstring& name) {
                 // Add to minimized list
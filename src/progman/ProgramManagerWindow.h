@@ -4,6 +4,8 @@
 #include "libprogman/ShortcutManager.h"
 #include "libprogman/ShortcutFactory.h"
 #include "libprogman/InstalledAppList.h"
+#include "libprogman/InstalledAppMonitor.h"
+#include "libprogman/IconLoader.h"
 #include "progman/FolderWindow.h"
 #include "progman/MinimizedFolderListControl.h"
 
@@ -15,14 +17,16 @@ class ProgramManagerWindow {
         HINSTANCE hInstance,
         libprogman::ShortcutManager* shortcutManager,
         libprogman::ShortcutFactory* shortcutFactory,
-        libprogman::InstalledAppList* installedAppList);
+        libprogman::InstalledAppList* installedAppList,
+        libprogman::InstalledAppMonitor* installedAppMonitor,
+        libprogman::IconLoader* iconLoader);
     ProgramManagerWindow(const ProgramManagerWindow&) = delete;
     ProgramManagerWindow& operator=(const ProgramManagerWindow&) = delete;
     ProgramManagerWindow(ProgramManagerWindow&&) = delete;
     ProgramManagerWindow& operator=(ProgramManagerWindow&&) = delete;
 
     void show(int cmdShow);
-    void refresh();
+    void refresh(const std::vector<libprogman::FolderChange>& changes);
     HWND hwnd() const { return hwnd_; }
     HWND getMdiClient() const { return mdiClient_; }
 
@@ -57,6 +61,8 @@ class ProgramManagerWindow {
     libprogman::ShortcutManager* shortcutManager_ = nullptr;
     libprogman::ShortcutFactory* shortcutFactory_ = nullptr;
     libprogman::InstalledAppList* installedAppList_ = nullptr;
+    libprogman::InstalledAppMonitor* installedAppMonitor_ = nullptr;
+    libprogman::IconLoader* iconLoader_ = nullptr;
     std::unordered_map<std::wstring, std::unique_ptr<FolderWindow>> folderWindows_;
     std::unique_ptr<MinimizedFolderListControl> minimizedFolderList_;
 };
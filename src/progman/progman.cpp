@@ -1,8 +1,12 @@
 #include "progman/pch.h"
 #include "libprogman/com_util.h"
 #include "libprogman/InstalledAppList.h"
+#include "libprogman/InstalledAppMonitor.h"
 #include "libprogman/FolderWatcher.h"
+#include "libprogman/ShortcutCache.h"
 #include "libprogman/ShortcutFactory.h"
+#include "libprogman/IconLoader.h"
+#include "libprogman/IconStore.h"
 #include "libprogman/ShortcutManager.h"
 #include "libprogman/string_util.h"
 #include "progman/ProgramManagerWindow.h"
@@ -58,18 +62,37 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPWSTR,
 
         auto installedAppsFolders = getInstalledAppsFolders();
 
-        auto shortcutFactory = std::make_unique<libprogman::ShortcutFactory>();
+        // Shortcuts whose icons come from the same file and index share one icon, whether read or cached.
+        auto iconStore = std::make_unique<libprogman::IconStore>();
+
+        // It's "%APPDATA%\Heirloom Program Manager\shortcut_cache.bin", next to the Shortcuts folder.
+        auto shortcutCache = std::make_unique<libprogman::ShortcutCache>(
+            shortcutsPath.parent_path() / L"shortcut_cache.bin", iconStore.get());
+
+        auto shortcutFactory = std::make_unique<libprogman::ShortcutFactory>(shortcutCache.get(), iconStore.get());
+
+        // Shortcuts are shown with a placeholder icon first; this fills in the real icons in the background.
+        auto iconLoader = std::make_unique<libprogman::IconLoader>(shortcutFactory.get());
 
         auto installedAppList =
             std::make_unique<libprogman::InstalledAppList>(shortcutFactory.get(), installedAppsFolders);
 
+        // Scans for installed apps at idle priority now and whenever the Start Menu changes, so the New Shortcut
+        // dialog doesn't have to.
+        auto installedAppMonitor =
+            std::make_unique<libprogman::InstalledAppMonitor>(installedAppList.get(), installedAppsFolders);
+
         auto shortcutManager = std::make_unique<libprogman::ShortcutManager>(shortcutsPath, shortcutFactory.get());
 
         auto programManagerWindow = std::make_unique<progman::ProgramManagerWindow>(
-            hInstance, shortcutManager.get(), shortcutFactory.get(), installedAppList.get());
+            hInstance, shortcutManager.get(), shortcutFactory.get(), installedAppList.get(), installedAppMonitor.get(),
+            iconLoader.get());
 
         auto folderWatcher = std::make_unique<libprogman::FolderWatcher>(
-            shortcutsPath, [&programManagerWindow]() { programManagerWindow->refresh(); },
+            shortcutsPath,
+            [&programManagerWindow](const std::vector<libprogman::FolderChange>& changes) {
+                programManagerWindow->refresh(changes);
+            },
             [](std::wstring errorMsg) {
                 MessageBox(nullptr, errorMsg.c_str(), L"Program Manager", MB_OK | MB_ICONERROR);
             });
@@ -92,6 +115,16 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPWSTR,
             }
         }
 
+        // Save what was read from .lnk files this session so the next start can skip reading them. Stop the icon
+        // loader and the installed app scans first so nothing is still using the cache.
+        iconLoader.reset();
+        installedAppMonitor.reset();
+        try {
+            shortcutCache->save();
+        } catch (const std::exception&) {
+            // Ignore. The cache is only an optimization; the next start reads the shortcuts itself.
+        }
+
         return 0;
     } catch (const std::exception& e) {
         std::wstring wstr = libprogman::utf8ToWide(e.what());
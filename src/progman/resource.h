@@ -19,6 +19,7 @@
 #define IDC_BROWSE 1006
 #define IDC_FINDING_LABEL 1007
 #define IDC_VERSION_LABEL 1008
+#define IDC_SEARCH_EDIT 1009
 #define ID_FILE_EXIT 32771
 #define ID_FILE_NEWFOLDER 32772
 #define ID_FILE_NEWSHORTCUT 32773
@@ -41,7 +42,7 @@
 #define _APS_NO_MFC 1
 #define _APS_NEXT_RESOURCE_VALUE 111
 #define _APS_NEXT_COMMAND_VALUE 32783
-#define _APS_NEXT_CONTROL_VALUE 1009
+#define _APS_NEXT_CONTROL_VALUE 1010
 #define _APS_NEXT_SYMED_VALUE 110
 #endif
 #endif
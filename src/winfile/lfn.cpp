@@ -192,6 +192,74 @@ BOOL WFFindClose(LPLFNDTA lpFind) {
     return (bRet);
 }
 
+/* WFWalkStart -
+ *
+ *  Starts lpWalker walking what in lpDir matches lpPattern, with file
+ *  system redirection off as for WFFindFirst.  Entries whose full path is
+ *  MAXPATHLEN or longer go by their short names, as in WFFindNext, if
+ *  dwFlags asks for them and they fit; the rest are flagged rather than
+ *  walked.  See WFWalkNext.
+ *
+ *  returns:
+ *      0, or the error listing lpDir
+ */
+DWORD WFWalkStart(libwinfile::TreeWalker* lpWalker, LPCWSTR lpDir, LPCWSTR lpPattern, DWORD dwFlags) {
+    DWORD dwError;
+
+    PVOID oldValue = NULL;
+    if (Wow64DisableWow64FsRedirection != NULL) {
+        Wow64DisableWow64FsRedirection(&oldValue);
+    }
+
+    dwError = lpWalker->start(lpDir, lpPattern, dwFlags, MAXPATHLEN);
+
+    if (Wow64RevertWow64FsRedirection != NULL) {
+        Wow64RevertWow64FsRedirection(oldValue);
+    }
+    return dwError;
+}
+
+/* WFWalkNext -
+ *
+ *  Moves lpWalker on to its next entry and fills lpFind->fd with it, the
+ *  way WFFindNext does.  lpFind->err is the walker's error(): for an entry
+ *  whose full path is MAXPATHLEN or longer even by its short name,
+ *  ERROR_FILENAME_EXCED_RANGE.
+ *  Such a directory is not walked into, so the caller must report it
+ *  rather than use its path.
+ */
+libwinfile::TreeWalker::Visit WFWalkNext(libwinfile::TreeWalker* lpWalker, LPLFNDTA lpFind) {
+    libwinfile::TreeWalker::Visit visit;
+
+    PVOID oldValue = NULL;
+    if (Wow64DisableWow64FsRedirection != NULL) {
+        Wow64DisableWow64FsRedirection(&oldValue);
+    }
+
+    visit = lpWalker->next();
+
+    if (Wow64RevertWow64FsRedirection != NULL) {
+        Wow64RevertWow64FsRedirection(oldValue);
+    }
+
+    lpFind->hFindFile = INVALID_HANDLE_VALUE;
+    lpFind->err = lpWalker->error();
+    if (visit == libwinfile::TreeWalker::Visit::End) {
+        return visit;
+    }
+
+    lpFind->fd = lpWalker->data();
+    lpFind->fd.dwFileAttributes &= ATTR_USED;
+    if (lpFind->fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+        if (lpFind->fd.dwReserved0 == IO_REPARSE_TAG_MOUNT_POINT) {
+            lpFind->fd.dwFileAttributes |= ATTR_JUNCTION;
+        } else if (lpFind->fd.dwReserved0 == IO_REPARSE_TAG_SYMLINK) {
+            lpFind->fd.dwFileAttributes |= ATTR_SYMBOLIC;
+        }
+    }
+    return visit;
+}
+
 /* WFIsDir
  *
  *  Determines if the specified path is a directory
@@ -447,6 +515,21 @@ WFCopy(LPWSTR pszFrom, LPWSTR pszTo) {
     return dwRet;
 }
 
+/* WFCopyFile
+ *
+ *  Copies one file without touching the UI or the change notification
+ *  code, so it can run on a copy pipeline worker.  Leaves the print share
+ *  and unprivileged symlink fallbacks to WFCopy; the caller reports the new
+ *  file.  lpProgressRoutine and lpData are passed on to CopyFileEx.
+ */
+DWORD
+WFCopyFile(LPCWSTR pszFrom, LPCWSTR pszTo, LPPROGRESS_ROUTINE lpProgressRoutine, LPVOID lpData, LPBOOL pbCancel) {
+    if (CopyFileEx(pszFrom, pszTo, lpProgressRoutine, lpData, pbCancel, COPY_FILE_COPY_SYMLINK))
+        return 0;
+
+    return GetLastError();
+}
+
 /* WFHardlink
  *
  *  Creates a Hardlink
@@ -42,6 +42,8 @@ BOOL IsLFN(LPWSTR pName);
 BOOL WFFindFirst(LPLFNDTA lpFind, LPWSTR lpName, DWORD dwAttrFilter);
 BOOL WFFindNext(LPLFNDTA);
 BOOL WFFindClose(LPLFNDTA);
+DWORD WFWalkStart(libwinfile::TreeWalker* lpWalker, LPCWSTR lpDir, LPCWSTR lpPattern, DWORD dwFlags);
+libwinfile::TreeWalker::Visit WFWalkNext(libwinfile::TreeWalker* lpWalker, LPLFNDTA lpFind);
 
 DWORD I_LFNCanon(USHORT CanonType, LPWSTR InFile, LPWSTR OutFile);
 DWORD LFNParse(LPWSTR, LPWSTR, LPWSTR);
@@ -53,6 +55,7 @@ BOOL LFNMergePath(LPWSTR, LPWSTR);
 BOOL IsLFNSelected();
 
 DWORD WFCopy(LPWSTR, LPWSTR);
+DWORD WFCopyFile(LPCWSTR pszFrom, LPCWSTR pszTo, LPPROGRESS_ROUTINE lpProgressRoutine, LPVOID lpData, LPBOOL pbCancel);
 DWORD WFRemove(LPWSTR pszFile);
 DWORD WFMove(LPWSTR pszFrom, LPWSTR pszTo, PBOOL pbErrorOnDest, BOOL bSilent);
 DWORD WFCopyIfSymlink(LPWSTR pszFrom, LPWSTR pszTo, DWORD dwFlags, DWORD dwNotification);
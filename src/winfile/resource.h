@@ -260,6 +260,15 @@
 #define IDS_CONFIRMDELETERO 168
 #define IDS_COPYINGTITLE 169
 #define IDS_REMOVINGDIRMSG 170
+#define IDS_COPYSCANNING 171
+#define IDS_COPYPROGRESS 172
+#define IDS_COPYPROGRESSETA 173
+#define IDS_RESUMECOPYTITLE 174
+#define IDS_RESUMECOPY 175
+#define IDS_COPYWAITING 176
+#define IDS_COPYPAUSED 177
+#define IDS_COPYPAUSE 178
+#define IDS_COPYRESUME 179
 #define IDS_STATUSMSG 180
 #define IDS_DIRSREAD 181
 #define IDS_DRIVEFREE 182
@@ -272,11 +281,15 @@
 #define IDS_UNFORMATTED 189
 
 // #define IDS_PRINTFNF        191
+#define IDS_DELETEPERMANENTTITLE 192
+#define IDS_CANCELJOBS 193
+#define IDS_CANCELJOBSTITLE 194
 
 #define IDS_TREEABORT 195
 #define IDS_TREEABORTTITLE 196
 #define IDS_DESTFULL 197
 #define IDS_WRITEPROTECTFILE 198
+#define IDS_DELETEPERMANENTTEXT 199
 
 // #define IDS_OS2APPMSG       200
 // #define IDS_NEWWINDOWSMSG   201
@@ -15,6 +15,7 @@ constexpr WCHAR kNewWinOnNetConnect[] = L"NewWinOnNetConnect";
 constexpr WCHAR kEditorPath[] = L"EditorPath";
 constexpr WCHAR kMirrorContent[] = L"MirrorContent";
 constexpr WCHAR kMinOnRun[] = L"MinOnRun";
+constexpr WCHAR kVerifyCopies[] = L"VerifyCopies";
 constexpr WCHAR kStatusBar[] = L"StatusBar";
 constexpr WCHAR kScrollOnExpand[] = L"ScrollOnExpand";
 
@@ -28,6 +29,8 @@ constexpr WCHAR kConfirmReadOnly[] = L"ConfirmSystemHiddenReadOnly";
 constexpr WCHAR kDriveListFace[] = L"DriveListFace";
 
 constexpr WCHAR kChangeNotifyTime[] = L"ChangeNotifyTime";
+constexpr WCHAR kUnbufferedCopyMB[] = L"UnbufferedCopyMB";
+constexpr WCHAR kCopyBufferKB[] = L"CopyBufferKB";
 
 constexpr WCHAR kDirKeyFormat[] = L"dir%d";
 constexpr WCHAR kWindow[] = L"Window";
@@ -45,6 +48,7 @@ constexpr WCHAR kAddons[] = L"AddOns";
 constexpr WCHAR kDefPrograms[] = L"EXE COM BAT PIF";
 constexpr WCHAR kRoamINIPath[] = L"\\Heirloom File Manager";
 constexpr WCHAR kBaseINIFile[] = L"heirloom.ini";
+constexpr WCHAR kCopyJobsPath[] = L"\\Copy Jobs";
 constexpr WCHAR kPrevious[] = L"Previous";
 constexpr WCHAR kSettings[] = L"Settings";
 constexpr WCHAR kInternational[] = L"Intl";
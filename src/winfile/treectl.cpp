@@ -22,8 +22,12 @@
 #include "wftree.h"
 #include "wfcomman.h"
 #include "stringconstants.h"
+#include "libwinfile/DirectoryLevelLoader.h"
+#include "libwinfile/SubdirectoryProber.h"
+#include "libwinfile/TreePathIndex.h"
 #include <commctrl.h>
 #include <winnls.h>
+#include <unordered_map>
 
 #define WS_TREESTYLE                                                                                            \
     (WS_CHILD | WS_VISIBLE | LBS_NOTIFY | WS_VSCROLL | WS_HSCROLL | LBS_OWNERDRAWFIXED | LBS_NOINTEGRALHEIGHT | \
@@ -32,12 +36,40 @@
 #define READDIRLEVEL_UPDATE 7
 #define READDIRLEVEL_YIELDBIT 2
 
+#define TREELOADER_THREADS 4
+#define TREEPROBER_THREADS 2
+
 #define IS_PARTIALSORT(drive) (aDriveInfo[drive].dwFileSystemFlags & FS_CASE_IS_PRESERVED)
 
 #define CALC_EXTENT(pNode) (pNode->dwExtent + (2 * pNode->nLevels) * dxText + dxFolder + 3 * dyBorderx2)
 
 DWORD cNodes;
 
+//
+// Per tree control state for background level reads, stored in GWL_TREEASYNC.
+// pending maps the loader key of each directory whose level has been requested
+// to TRUE if that directory is being fully expanded, in which case its children
+// are requested in turn as the level arrives.  bProbePosted is TRUE while a
+// TC_PROBEVISIBLE is on its way.
+//
+typedef struct tagTREEASYNC {
+    std::unordered_map<std::wstring, BOOL> pending;
+    BOOL bProbePosted;
+} TREEASYNC;
+
+//
+// The index of a tree control's nodes by path, stored in GWL_TREEINDEX.
+// Nodes are inserted and removed along with their listbox items, so it also
+// knows where each one is; FindItemFromPath looks them up here.
+//
+#define TREEINDEX(hwndTC) ((libwinfile::TreePathIndex*)GetWindowLongPtr((hwndTC), GWL_TREEINDEX))
+
+//
+// A node whose subdirectories haven't been read or probed yet; it is drawn
+// without an expand marker until the prober finds out.
+//
+#define IS_PROBE_UNKNOWN(pNode) (!((pNode)->wFlags & (TF_PROBED | TF_HASCHILDREN | TF_EXPANDED)))
+
 void GetTreePathIndirect(PDNODE pNode, LPWSTR szDest);
 
 int InsertDirectory(
@@ -211,6 +243,27 @@ int CompareNodes(PDNODE p1, PDNODE p2) {
     return ret;
 }
 
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     IndexTreeNode
+//
+// Synopsis: Records pNode, just inserted at listbox index iNode, in the
+//           tree's path index.  The nodes below it move down one there,
+//           as they do in the listbox.
+//
+/////////////////////////////////////////////////////////////////////
+
+static void IndexTreeNode(HWND hwndTC, PDNODE pNode, int iNode) {
+    libwinfile::TreePathIndex* pIndex = TREEINDEX(hwndTC);
+    WCHAR szPath[MAXPATHLEN * 2];
+
+    if (!pIndex)
+        return;
+
+    GetTreePath(pNode, szPath);
+    pIndex->insert(szPath, pNode, iNode);
+}
+
 //
 // InsertDirectory()
 //
@@ -365,6 +418,7 @@ int InsertDirectory(
     }
 
     SendMessage(hwndLB, LB_INSERTSTRING, iMax, (LPARAM)pNode);
+    IndexTreeNode(hwndTreeCtl, pNode, iMax);
 
     if (ppNode) {
         *ppNode = pNode;
@@ -390,6 +444,342 @@ void wfYield() {
     }
 }
 
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     TreeLoaderEnumerate
+//
+// Synopsis: Lists the subdirectories of path for the tree loader.
+//           Runs on a loader thread, so it only uses WFFindFirst/Next
+//           and touches no window or tree data.
+//
+/////////////////////////////////////////////////////////////////////
+
+static bool TreeLoaderEnumerate(const std::wstring& path, libwinfile::DirectoryLevel* level) {
+    LFNDTA lfndta{};
+    WCHAR szSpec[MAXPATHLEN + 1];
+
+    if (path.size() + 4 >= COUNTOF(szSpec))
+        return false;
+
+    lstrcpy(szSpec, path.c_str());
+    AddBackslash(szSpec);
+    lstrcat(szSpec, kStarDotStar);
+
+    lfndta.hFindFile = INVALID_HANDLE_VALUE;
+
+    if (!WFFindFirst(&lfndta, szSpec, ATTR_DIR | ATTR_ALL)) {
+        // a directory without entries (such as an empty root) is not an error
+        return lfndta.err == ERROR_SUCCESS || lfndta.err == ERROR_FILE_NOT_FOUND || lfndta.err == ERROR_NO_MORE_FILES;
+    }
+
+    do {
+        if (!ISDOTDIR(lfndta.fd.cFileName) && (lfndta.fd.dwFileAttributes & ATTR_DIR)) {
+            level->push_back({lfndta.fd.cFileName, lfndta.fd.dwFileAttributes});
+        }
+    } while (WFFindNext(&lfndta));
+
+    WFFindClose(&lfndta);
+    return true;
+}
+
+//
+// The loader shared by all tree windows.  Levels it reads (and levels
+// ReadDirLevel reads on the UI thread) are cached by path, so collapsing and
+// re-expanding a node, or opening a second tree on the same drive, does not
+// touch the disk.  Finished reads are posted back to the requesting tree
+// control as TC_LEVELREAD.
+//
+static libwinfile::DirectoryLevelLoader& TreeLoader() {
+    static libwinfile::DirectoryLevelLoader loader(
+        TREELOADER_THREADS, TreeLoaderEnumerate,
+        [](libwinfile::DirectoryLevelLoader::Owner owner) { PostMessage((HWND)owner, TC_LEVELREAD, 0, 0L); });
+    return loader;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     TreeProbeEnumerate
+//
+// Synopsis: Finds out whether path has any subdirectories for the
+//           prober, stopping at the first one.  Runs on a prober thread.
+//
+/////////////////////////////////////////////////////////////////////
+
+static bool TreeProbeEnumerate(const std::wstring& path, bool* hasSubdirectories) {
+    LFNDTA lfndta{};
+    WCHAR szSpec[MAXPATHLEN + 1];
+
+    *hasSubdirectories = false;
+
+    if (path.size() + 4 >= COUNTOF(szSpec))
+        return false;
+
+    lstrcpy(szSpec, path.c_str());
+    AddBackslash(szSpec);
+    lstrcat(szSpec, kStarDotStar);
+
+    lfndta.hFindFile = INVALID_HANDLE_VALUE;
+
+    if (!WFFindFirst(&lfndta, szSpec, ATTR_DIR | ATTR_ALL)) {
+        return lfndta.err == ERROR_SUCCESS || lfndta.err == ERROR_FILE_NOT_FOUND || lfndta.err == ERROR_NO_MORE_FILES;
+    }
+
+    do {
+        if (!ISDOTDIR(lfndta.fd.cFileName) && (lfndta.fd.dwFileAttributes & ATTR_DIR)) {
+            *hasSubdirectories = true;
+            break;
+        }
+    } while (WFFindNext(&lfndta));
+
+    WFFindClose(&lfndta);
+    return true;
+}
+
+//
+// The prober shared by all tree windows.  Nodes are drawn right away and
+// TC_PROBEVISIBLE asks it about the ones on screen; answers come back to
+// the tree control as TC_PROBED and turn into expand markers.  On network
+// drives this keeps the per-directory round trips off the UI thread.
+//
+static libwinfile::SubdirectoryProber& TreeProber() {
+    static libwinfile::SubdirectoryProber prober(
+        TREEPROBER_THREADS, TreeProbeEnumerate,
+        [](libwinfile::SubdirectoryProber::Owner owner) { PostMessage((HWND)owner, TC_PROBED, 0, 0L); });
+    return prober;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     StopTreeThreads
+//
+// Synopsis: Stops the loader's and the prober's threads and waits for
+//           them, for the frame to call as it goes away.  Otherwise they
+//           would be joined only as statics are destroyed, while a read
+//           or probe could still be running and posting to tree controls
+//           that are long gone.
+//
+/////////////////////////////////////////////////////////////////////
+
+void StopTreeThreads() {
+    TreeLoader().stop();
+    TreeProber().stop();
+}
+
+static void RequestLevel(HWND hwndTC, PDNODE pNode, int nIndex, BOOL bFullyExpand);
+
+//
+// InsertLevel()
+//
+// Inserts the subdirectories in level under pNode, which is at listbox index
+// nIndex and must not be expanded yet.  With bFullyExpand each new child is
+// expanded in turn, from the cache if possible and otherwise in the background.
+//
+// Returns the number of listbox entries added.
+//
+
+static int InsertLevel(
+    HWND hwndTC,
+    PDNODE pNode,
+    int nIndex,
+    LPWSTR szPath,
+    const libwinfile::DirectoryLevel& level,
+    BOOL bFullyExpand) {
+    HWND hwndLB;
+    DRIVE drive;
+    BOOL bCasePreserved;
+    BOOL bPartialSort;
+    PDNODE pChild;
+    int iCount;
+    int cChildren;
+    int i;
+    RECT rc;
+
+    hwndLB = GetDlgItem(hwndTC, IDCW_TREELISTBOX);
+
+    drive = DRIVEID(szPath);
+    bCasePreserved = IsCasePreservedDrive(drive);
+    bPartialSort = IS_PARTIALSORT(drive);
+
+    iCount = (int)SendMessage(hwndLB, LB_GETCOUNT, 0, 0L);
+
+    for (const auto& entry : level) {
+        InsertDirectory(
+            hwndTC, pNode, nIndex, (LPWSTR)entry.name.c_str(), &pChild, bCasePreserved, bPartialSort,
+            entry.attributes);
+        cNodes++;
+    }
+
+    pNode->wFlags |= TF_PROBED;
+
+    cChildren = (int)SendMessage(hwndLB, LB_GETCOUNT, 0, 0L) - iCount;
+
+    // pNode's expand marker changed
+    if (SendMessage(hwndLB, LB_GETITEMRECT, nIndex, (LPARAM)&rc) != LB_ERR)
+        InvalidateRect(hwndLB, &rc, FALSE);
+
+    if (bFullyExpand) {
+        //
+        // The new children sit right below pNode.  Go from the last one up
+        // so that expanding a child from the cache doesn't move the ones
+        // still to be visited.
+        //
+        for (i = cChildren; i > 0; i--) {
+            if (SendMessage(hwndLB, LB_GETTEXT, nIndex + i, (LPARAM)&pChild) != LB_ERR) {
+                RequestLevel(hwndTC, pChild, nIndex + i, TRUE);
+            }
+        }
+    }
+
+    return (int)SendMessage(hwndLB, LB_GETCOUNT, 0, 0L) - iCount;
+}
+
+//
+// RequestLevel()
+//
+// Expands pNode (at listbox index nIndex) from the level cache if it can;
+// otherwise queues a background read, and TC_LEVELREAD inserts the level
+// when it arrives.
+//
+
+static void RequestLevel(HWND hwndTC, PDNODE pNode, int nIndex, BOOL bFullyExpand) {
+    WCHAR szPath[MAXPATHLEN * 2];
+    TREEASYNC* pAsync;
+
+    GetTreePath(pNode, szPath);
+
+    auto level = TreeLoader().cached(szPath);
+    if (level) {
+        InsertLevel(hwndTC, pNode, nIndex, szPath, *level, bFullyExpand);
+        return;
+    }
+
+    pAsync = (TREEASYNC*)GetWindowLongPtr(hwndTC, GWL_TREEASYNC);
+    if (!pAsync)
+        return;
+
+    auto it = pAsync->pending.emplace(libwinfile::DirectoryLevelLoader::key(szPath), bFullyExpand).first;
+    it->second |= bFullyExpand;
+
+    TreeLoader().request((libwinfile::DirectoryLevelLoader::Owner)hwndTC, szPath);
+}
+
+//
+// DropPendingLevels()
+//
+// Forgets background reads requested for pNode and everything below it, so
+// that their results are ignored when they arrive.  Pass NULL for the whole
+// tree.
+//
+
+static void DropPendingLevels(HWND hwndTC, PDNODE pNode) {
+    WCHAR szPath[MAXPATHLEN * 2];
+    TREEASYNC* pAsync;
+
+    pAsync = (TREEASYNC*)GetWindowLongPtr(hwndTC, GWL_TREEASYNC);
+    if (!pAsync || pAsync->pending.empty())
+        return;
+
+    if (!pNode) {
+        pAsync->pending.clear();
+        TreeLoader().cancel((libwinfile::DirectoryLevelLoader::Owner)hwndTC);
+        return;
+    }
+
+    GetTreePath(pNode, szPath);
+    std::wstring key = libwinfile::DirectoryLevelLoader::key(szPath);
+
+    for (auto it = pAsync->pending.begin(); it != pAsync->pending.end();) {
+        const std::wstring& pendingKey = it->first;
+
+        if (pendingKey.compare(0, key.size(), key) == 0 &&
+            (pendingKey.size() == key.size() || pendingKey[key.size()] == CHAR_BACKSLASH)) {
+            it = pAsync->pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+//
+// IsLevelPending()
+//
+// TRUE if a background read of szPath has been requested for this tree and
+// has not arrived yet.
+//
+
+static BOOL IsLevelPending(HWND hwndTC, LPWSTR szPath) {
+    TREEASYNC* pAsync;
+
+    pAsync = (TREEASYNC*)GetWindowLongPtr(hwndTC, GWL_TREEASYNC);
+
+    return pAsync && pAsync->pending.count(libwinfile::DirectoryLevelLoader::key(szPath)) != 0;
+}
+
+//
+// InvalidateTreeLevel()
+//
+// Forgets the cached level for szPath, for example because a change
+// notification says its contents changed.
+//
+
+void InvalidateTreeLevel(LPCWSTR szPath) {
+    TreeLoader().invalidate(szPath, false);
+    TreeProber().invalidate(szPath, false);
+}
+
+//
+// ProbeVisibleNodes()
+//
+// Resolves whether the nodes on screen have subdirectories: from the level
+// and probe caches when possible, otherwise by asking the prober, top of
+// the view first.  This replaces whatever was asked for the previous view.
+//
+
+static void ProbeVisibleNodes(HWND hwndTC) {
+    HWND hwndLB;
+    PDNODE pNode;
+    RECT rc;
+    int iTopIndex;
+    int iBottomIndex;
+    int i;
+    bool bHasSubdirectories;
+    BOOL bRedraw = FALSE;
+    WCHAR szPath[MAXPATHLEN * 2];
+    std::vector<std::wstring> paths;
+
+    hwndLB = GetDlgItem(hwndTC, IDCW_TREELISTBOX);
+
+    iTopIndex = (int)SendMessage(hwndLB, LB_GETTOPINDEX, 0, 0L);
+    GetClientRect(hwndLB, &rc);
+    iBottomIndex = iTopIndex + (rc.bottom + 1) / dyFileName;
+
+    for (i = iTopIndex; i <= iBottomIndex; i++) {
+        if (SendMessage(hwndLB, LB_GETTEXT, i, (LPARAM)&pNode) == LB_ERR)
+            break;
+
+        if (!IS_PROBE_UNKNOWN(pNode))
+            continue;
+
+        GetTreePath(pNode, szPath);
+
+        auto level = TreeLoader().cached(szPath);
+        if (level) {
+            bHasSubdirectories = !level->empty();
+        } else if (!TreeProber().cached(szPath, &bHasSubdirectories)) {
+            paths.push_back(szPath);
+            continue;
+        }
+
+        pNode->wFlags |= TF_PROBED | (bHasSubdirectories ? TF_HASCHILDREN : 0);
+        bRedraw = TRUE;
+    }
+
+    if (bRedraw)
+        InvalidateRect(hwndLB, NULL, FALSE);
+
+    TreeProber().probe((libwinfile::SubdirectoryProber::Owner)hwndTC, paths);
+}
+
 /////////////////////////////////////////////////////////////////////
 //
 // Name:     ReadDirLevel
@@ -445,6 +835,8 @@ BOOL ReadDirLevel(
     BOOL bResult = TRUE;
     LPXDTALINK lpStart = NULL;  // assume none to steal from
     HWND hwndDir;
+    BOOL bListed;
+    libwinfile::DirectoryLevel level;  // what we read, for the level cache
 
     LFNDTA lfndta{};
     lfndta.hFindFile = INVALID_HANDLE_VALUE;
@@ -545,6 +937,8 @@ BOOL ReadDirLevel(
         bFound = WFFindFirst(&lfndta, szMessage, dwAttribs);
     }
 
+    bListed = bFound;
+
     // for net drive case where we can't actually see what is in these
     // directories we will build the tree automatically
 
@@ -614,6 +1008,8 @@ BOOL ReadDirLevel(
                 hwndTreeCtl, pParentNode, iParentNode, lfndta.fd.cFileName, &pNode,
                 IsCasePreservedDrive(DRIVEID(szPath)), bPartialSort, lfndta.fd.dwFileAttributes);
 
+            level.push_back({lfndta.fd.cFileName, lfndta.fd.dwFileAttributes});
+
             if (hwndStatus && ((cNodes % READDIRLEVEL_UPDATE) == 0)) {
                 // make sure we are the active window before we
                 // update the status bar
@@ -689,6 +1085,15 @@ BOOL ReadDirLevel(
 
     WFFindClose(&lfndta);
 
+    //
+    // The whole level was read, so remember it; expanding this node again
+    // later won't have to go to the disk.
+    //
+    if (bListed) {
+        *szEndPath = CHAR_NULL;
+        TreeLoader().store(szPath, std::move(level));
+    }
+
 DONE:
 
     //
@@ -697,7 +1102,7 @@ DONE:
     if (lpStart)
         MemLinkToHead(lpStart)->fdwStatus &= ~LPXDTA_STATUS_READING;
 
-    pParentNode->wFlags |= TF_HASCHILDREN;
+    pParentNode->wFlags |= TF_PROBED;
 
     SetWindowLongPtr(hwndTreeCtl, GWL_READLEVEL, GetWindowLongPtr(hwndTreeCtl, GWL_READLEVEL) - 1);
 
@@ -798,6 +1203,7 @@ BOOL StealTreeData(HWND hwndTC, HWND hwndLB, LPWSTR szDir) {
                 }
 
                 SendMessage(hwndLB, LB_INSERTSTRING, i, (LPARAM)pNewNode);
+                IndexTreeNode(hwndTC, pNewNode, i);
             }
         }
 
@@ -816,7 +1222,13 @@ void FreeAllTreeData(HWND hwndLB) {
     int nIndex;
     PDNODE pNode;
 
-    // Free up the old tree (if any)
+    // Forget reads still on their way for the old tree, then free it (if any)
+
+    DropPendingLevels(GetParent(hwndLB), NULL);
+    TreeProber().cancel((libwinfile::SubdirectoryProber::Owner)GetParent(hwndLB));
+
+    if (TREEINDEX(GetParent(hwndLB)))
+        TREEINDEX(GetParent(hwndLB))->clear();
 
     nIndex = (int)SendMessage(hwndLB, LB_GETCOUNT, 0, 0L) - 1;
     while (nIndex >= 0) {
@@ -837,6 +1249,7 @@ void FreeAllTreeData(HWND hwndLB) {
 
 void FillTreeListbox(HWND hwndTC, LPWSTR szDefaultDir, BOOL bFullyExpand, BOOL bDontSteal) {
     PDNODE pNode;
+    PDNODE pNodeT;
     int iNode;
     DWORD dwAttribs;
     WCHAR szTemp[MAXPATHLEN + 1] = SZ_ACOLONSLASH;
@@ -866,6 +1279,15 @@ void FillTreeListbox(HWND hwndTC, LPWSTR szDefaultDir, BOOL bFullyExpand, BOOL b
 
         bPartialSort = IS_PARTIALSORT(drive);
 
+        //
+        // Not stealing means the caller wants what is on the disk now
+        // (a refresh), so don't trust cached levels for this drive either.
+        //
+        if (bDontSteal) {
+            TreeLoader().invalidate(szTemp, true);
+            TreeProber().invalidate(szTemp, true);
+        }
+
         iNode = InsertDirectory(
             hwndTC, NULL, 0, szTemp, &pNode, IsCasePreservedDrive(DRIVEID(szDefaultDir)), bPartialSort,
             INVALID_FILE_ATTRIBUTES);
@@ -892,8 +1314,20 @@ void FillTreeListbox(HWND hwndTC, LPWSTR szDefaultDir, BOOL bFullyExpand, BOOL b
             } else
                 *szExpand = CHAR_NULL;
 
-            if (!ReadDirLevel(hwndTC, pNode, szTemp, 1, 0, dwAttribs, bFullyExpand, szExpand, bPartialSort)) {
+            //
+            // Read the path to the default directory now so it can be
+            // selected; when expanding fully, the rest of the drive is
+            // read in the background and fills in as it arrives.
+            //
+            if (!ReadDirLevel(hwndTC, pNode, szTemp, 1, 0, dwAttribs, FALSE, szExpand, bPartialSort)) {
                 SPC_SET_NOTREE(qFreeSpace);
+            } else if (bFullyExpand) {
+                for (iNode = (int)SendMessage(hwndLB, LB_GETCOUNT, 0, 0L) - 1; iNode >= 0; iNode--) {
+                    SendMessage(hwndLB, LB_GETTEXT, iNode, (LPARAM)&pNodeT);
+
+                    if (!(pNodeT->wFlags & TF_EXPANDED))
+                        RequestLevel(hwndTC, pNodeT, iNode, TRUE);
+                }
             }
         }
     }
@@ -992,14 +1426,18 @@ void FillOutTreeList(HWND hwndTC, LPWSTR szDir, DWORD nIndex, PDNODE pNode) {
 //      *pIndex is listbox index pNode returned; (DWORD)-1 if no match found
 //      *ppNode is filled with pNode of node, or pNode of parent if bReturnParent is TRUE; NULL if not found
 //
+// The node and its listbox index are looked up in the tree's path index
+// (GWL_TREEINDEX) rather than by walking the listbox, so this doesn't slow
+// down as the tree grows.
+//
 
 BOOL FindItemFromPath(HWND hwndLB, LPWSTR lpszPath, BOOL bReturnParent, DWORD* pIndex, PDNODE* ppNode) {
-    DWORD i;
-    LPWSTR p;
+    libwinfile::TreePathIndex* pTreeIndex;
     PDNODE pNode;
-    DWORD iPreviousNode;
-    PDNODE pPreviousNode;
-    WCHAR szElement[1 + MAXFILENAMELEN + 1];
+    size_t iNode;
+    bool bExact;
+    WCHAR szTarget[MAXPATHLEN * 2];
+    LPWSTR p;
 
     if (pIndex) {
         *pIndex = (DWORD)-1;
@@ -1008,83 +1446,44 @@ BOOL FindItemFromPath(HWND hwndLB, LPWSTR lpszPath, BOOL bReturnParent, DWORD* p
         *ppNode = NULL;
     }
 
-    if (!lpszPath || lstrlen(lpszPath) < 3 || lpszPath[1] != CHAR_COLON) {
+    if (!lpszPath || lstrlen(lpszPath) < 3 || lpszPath[1] != CHAR_COLON || lstrlen(lpszPath) >= COUNTOF(szTarget)) {
         return FALSE;
     }
 
-    i = 0;
-    iPreviousNode = (DWORD)-1;
-    pPreviousNode = NULL;
-
-    while (*lpszPath) {
-        /* NULL out szElement[1] so the backslash hack isn't repeated with
-         * a first level directory of length 1.
-         */
-        szElement[1] = CHAR_NULL;
-
-        /* Copy the next section of the path into 'szElement' */
-        p = szElement;
-
-        while (*lpszPath && *lpszPath != CHAR_BACKSLASH)
-            *p++ = *lpszPath++;
-
-        /* Add a backslash for the Root directory. */
+    pTreeIndex = TREEINDEX(GetParent(hwndLB));
+    if (!pTreeIndex) {
+        return FALSE;
+    }
 
-        if (szElement[1] == CHAR_COLON)
-            *p++ = CHAR_BACKSLASH;
+    lstrcpy(szTarget, lpszPath);
 
-        /* NULL terminate 'szElement' */
+    //
+    // Drop the filename; the root keeps its "X:".  The root has no parent,
+    // so it is returned itself.
+    //
+    if (bReturnParent && szTarget[3]) {
+        p = szTarget + lstrlen(szTarget);
+        while (p > szTarget + 2 && *--p != CHAR_BACKSLASH)
+            ;
         *p = CHAR_NULL;
+    }
 
-        /* Skip over the path's next Backslash. */
-
-        if (*lpszPath)
-            lpszPath++;
-
-        else if (bReturnParent) {
-            /* We're at the end of a path which includes a filename.  Return
-             * the previously found parent.
-             */
-            if (pIndex) {
-                *pIndex = iPreviousNode;
-            }
-            if (ppNode) {
-                *ppNode = pPreviousNode;
-            }
-            return TRUE;
-        }
-
-        while (TRUE) {
-            /* Out of LB items?  Not found. */
-            if (SendMessage(hwndLB, LB_GETTEXT, i, (LPARAM)&pNode) == LB_ERR) {
-                if (pIndex) {
-                    *pIndex = iPreviousNode;
-                }
-                if (ppNode) {
-                    *ppNode = pPreviousNode;
-                }
-                return FALSE;
-            }
-
-            if (pNode->pParent == pPreviousNode) {
-                if (!lstrcmpi(szElement, pNode->szName)) {
-                    /* We've found the element... */
-                    iPreviousNode = i;
-                    pPreviousNode = pNode;
-                    break;
-                }
-            }
-            i++;
-        }
+    //
+    // On a miss this is the deepest ancestor that is in the tree.
+    //
+    pNode = (PDNODE)pTreeIndex->findDeepest(szTarget, &iNode, &bExact);
+    if (!pNode) {
+        return FALSE;
     }
+
     if (pIndex) {
-        *pIndex = iPreviousNode;
+        *pIndex = (DWORD)iNode;
     }
     if (ppNode) {
-        *ppNode = pPreviousNode;
+        *ppNode = pNode;
     }
 
-    return TRUE;
+    return bExact;
 }
 
 /*--------------------------------------------------------------------------*/
@@ -1234,6 +1633,34 @@ BOOL IsNetPath(PDNODE pNode) {
     return pNode->dwNetType;
 }
 
+//
+// DrawExpandMarker()
+//
+// Draws the boxed plus (bPlus) or minus centered on the branch junction at
+// x, y.  The caller has selected the line brush into hdc.
+//
+
+static void DrawExpandMarker(HDC hdc, int x, int y, BOOL bPlus) {
+    RECT rcBox;
+    HBRUSH hbr;
+    int d = max(dyText / 4, 3);
+
+    rcBox.left = x - d;
+    rcBox.top = y - d;
+    rcBox.right = x + d + dyBorder;
+    rcBox.bottom = y + d + dyBorder;
+
+    FillRect(hdc, &rcBox, GetSysColorBrush(COLOR_WINDOW));
+    if (hbr = CreateSolidBrush(GetSysColor(COLOR_GRAYTEXT))) {
+        FrameRect(hdc, &rcBox, hbr);
+        DeleteObject(hbr);
+    }
+
+    PatBlt(hdc, x - d + 2, y, 2 * d - 3 + dyBorder, dyBorder, PATCOPY);
+    if (bPlus)
+        PatBlt(hdc, x, y - d + 2, dyBorder, 2 * d - 3 + dyBorder, PATCOPY);
+}
+
 void TCWP_DrawItem(LPDRAWITEMSTRUCT lpLBItem, HWND hwndLB, HWND hWnd) {
     int x, y, dy;
     int nLevel;
@@ -1272,6 +1699,18 @@ void TCWP_DrawItem(LPDRAWITEMSTRUCT lpLBItem, HWND hwndLB, HWND hWnd) {
     rc.right = rc.left + dxFolder + size.cx + 4 * dyBorderx2;
 
     if (lpLBItem->itemAction & (ODA_DRAWENTIRE | ODA_SELECT)) {
+        // nodes in view whose subdirectories are unknown get probed once
+        // painting settles; see ProbeVisibleNodes
+
+        if (IS_PROBE_UNKNOWN(pNode)) {
+            TREEASYNC* pAsync = (TREEASYNC*)GetWindowLongPtr(hWnd, GWL_TREEASYNC);
+
+            if (pAsync && !pAsync->bProbePosted) {
+                pAsync->bProbePosted = TRUE;
+                PostMessage(hWnd, TC_PROBEVISIBLE, 0, 0L);
+            }
+        }
+
         // draw the branches of the tree first
 
         nLevel = pNode->nLevels;
@@ -1305,6 +1744,10 @@ void TCWP_DrawItem(LPDRAWITEMSTRUCT lpLBItem, HWND hwndLB, HWND hWnd) {
 
                     pNTemp = pNTemp->pParent;
                 }
+
+                /* Mark nodes known to have subdirectories. */
+                if (pNode->wFlags & TF_HASCHILDREN)
+                    DrawExpandMarker(hdc, x, y, !(pNode->wFlags & TF_EXPANDED));
             }
 
             if (hOld)
@@ -1447,6 +1890,9 @@ void CollapseLevel(HWND hwndLB, PDNODE pNode, int nIndex) {
     if (GetWindowLongPtr(GetParent(hwndLB), GWL_READLEVEL))
         return;
 
+    /* Anything below still being read in the background is no longer wanted. */
+    DropPendingLevels(GetParent(hwndLB), pParentNode);
+
     /* Disable redrawing early. */
     SendMessage(hwndLB, WM_SETREDRAW, FALSE, 0L);
 
@@ -1468,6 +1914,7 @@ void CollapseLevel(HWND hwndLB, PDNODE pNode, int nIndex) {
             xTreeMax = 0;
         }
 
+        TREEINDEX(GetParent(hwndLB))->remove(pNode);
         LocalFree((HANDLE)pNode);
 
         SendMessage(hwndLB, LB_DELETESTRING, nIndexT, 0L);
@@ -1483,17 +1930,43 @@ void CollapseLevel(HWND hwndLB, PDNODE pNode, int nIndex) {
     InvalidateRect(hwndLB, NULL, TRUE);
 }
 
-void ExpandLevel(HWND hWnd, WPARAM wParam, int nIndex, LPWSTR szPath) {
-    HWND hwndLB;
-    PDNODE pNode;
-    int iNumExpanded;
-    int iBottomIndex;
+//
+// ScrollExpansionIntoView()
+//
+// After iNumExpanded entries were added below the current selection, scroll
+// so as many of them as fit are visible.  Controlled by
+// winfile.ini[Settings]ScrollOnExpand.  Default == TRUE
+//
+
+static void ScrollExpansionIntoView(HWND hwndLB, int iNumExpanded) {
     int iTopIndex;
+    int iBottomIndex;
     int iNewTopIndex;
     int iExpandInView;
     int iCurrentIndex;
     RECT rc;
-    DWORD dwAttribs;
+
+    iCurrentIndex = (int)SendMessage(hwndLB, LB_GETCURSEL, 0, 0L);
+    iTopIndex = (int)SendMessage(hwndLB, LB_GETTOPINDEX, 0, 0L);
+    GetClientRect(hwndLB, &rc);
+    iBottomIndex = iTopIndex + (rc.bottom + 1) / dyFileName;
+
+    // this is how many will be in view
+
+    iExpandInView = (iBottomIndex - (int)iCurrentIndex);
+
+    if (iNumExpanded >= iExpandInView) {
+        iNewTopIndex = min((int)iCurrentIndex, iTopIndex + iNumExpanded - iExpandInView + 1);
+
+        if (TRUE == bScrollOnExpand)
+            SendMessage(hwndLB, LB_SETTOPINDEX, (WPARAM)iNewTopIndex, 0L);
+    }
+}
+
+void ExpandLevel(HWND hWnd, WPARAM wParam, int nIndex, LPWSTR szPath) {
+    HWND hwndLB;
+    PDNODE pNode;
+    int iNumExpanded;
 
     //
     // Don't do anything while the tree is being built.
@@ -1520,39 +1993,32 @@ void ExpandLevel(HWND hWnd, WPARAM wParam, int nIndex, LPWSTR szPath) {
 
     GetTreePath(pNode, szPath);
 
+    //
+    // Already on its way; TC_LEVELREAD will expand it.
+    //
+    if (IsLevelPending(hWnd, szPath))
+        return;
+
     cNodes = 0;
     bCancelTree = FALSE;
 
     SendMessage(hwndLB, WM_SETREDRAW, FALSE, 0L);  // Disable redrawing.
 
-    iCurrentIndex = (int)SendMessage(hwndLB, LB_GETCURSEL, 0, 0L);
     iNumExpanded = (int)SendMessage(hwndLB, LB_GETCOUNT, 0, 0L);
-    iTopIndex = (int)SendMessage(hwndLB, LB_GETTOPINDEX, 0, 0L);
-    GetClientRect(hwndLB, &rc);
-    iBottomIndex = iTopIndex + (rc.bottom + 1) / dyFileName;
 
     U_VolInfo(DRIVEID(szPath));
 
+    //
+    // Expand from the level cache when we can, else read in the
+    // background so the window stays responsive on slow or huge drives.
+    //
     if (IsTheDiskReallyThere(hWnd, szPath, FUNC_EXPAND, FALSE)) {
-        dwAttribs = ATTR_DIR | ATTR_ALL;
-        ReadDirLevel(
-            hWnd, pNode, szPath, pNode->nLevels + 1, nIndex, dwAttribs, (BOOL)wParam, NULL,
-            IS_PARTIALSORT(DRIVEID(szPath)));
+        RequestLevel(hWnd, pNode, nIndex, (BOOL)wParam);
     }
 
-    // this is how many will be in view
-
-    iExpandInView = (iBottomIndex - (int)iCurrentIndex);
-
     iNumExpanded = (int)SendMessage(hwndLB, LB_GETCOUNT, 0, 0L) - iNumExpanded;
 
-    if (iNumExpanded >= iExpandInView) {
-        iNewTopIndex = min((int)iCurrentIndex, iTopIndex + iNumExpanded - iExpandInView + 1);
-
-        // Control tree view scroll behavior on expand via winfile.ini[Settings]ScrollOnExpand. Default == TRUE
-        if (TRUE == bScrollOnExpand)
-            SendMessage(hwndLB, LB_SETTOPINDEX, (WPARAM)iNewTopIndex, 0L);
-    }
+    ScrollExpansionIntoView(hwndLB, iNumExpanded);
 
     SendMessage(hwndLB, WM_SETREDRAW, TRUE, 0L);
 
@@ -1670,6 +2136,104 @@ TreeControlWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
             break;
         }
 
+        case TC_LEVELREAD: {
+            //
+            // Background level reads have finished (see RequestLevel).
+            // Insert the ones we still want.
+            //
+            TREEASYNC* pAsync;
+            DWORD dwIndex;
+            int iAdded;
+
+            auto results = TreeLoader().takeCompleted((libwinfile::DirectoryLevelLoader::Owner)hwnd);
+
+            pAsync = (TREEASYNC*)GetWindowLongPtr(hwnd, GWL_TREEASYNC);
+            if (!pAsync || results.empty())
+                break;
+
+            if (bCancelTree) {
+                DropPendingLevels(hwnd, NULL);
+                UpdateStatus(hwndParent);
+                break;
+            }
+
+            SendMessage(hwndLB, WM_SETREDRAW, FALSE, 0L);
+
+            for (const auto& result : results) {
+                auto it = pAsync->pending.find(libwinfile::DirectoryLevelLoader::key(result.path));
+
+                //
+                // Collapsed, refreshed or closed since it was requested.
+                //
+                if (it == pAsync->pending.end())
+                    continue;
+
+                BOOL bFullyExpand = it->second;
+                pAsync->pending.erase(it);
+
+                lstrcpy(szPath, result.path.c_str());
+
+                if (!FindItemFromPath(hwndLB, szPath, FALSE, &dwIndex, &pNode) || (pNode->wFlags & TF_EXPANDED))
+                    continue;
+
+                if (!result.level) {
+                    pNode->wFlags |= TF_PROBED;
+                    continue;
+                }
+
+                iAdded = InsertLevel(hwnd, pNode, (int)dwIndex, szPath, *result.level, bFullyExpand);
+
+                if ((int)dwIndex == (int)SendMessage(hwndLB, LB_GETCURSEL, 0, 0L))
+                    ScrollExpansionIntoView(hwndLB, iAdded);
+            }
+
+            SendMessage(hwndLB, WM_SETREDRAW, TRUE, 0L);
+            InvalidateRect(hwndLB, NULL, TRUE);
+
+            if (!pAsync->pending.empty()) {
+                if (hwndStatus && hwndParent == (HWND)SendMessage(hwndMDIClient, WM_MDIGETACTIVE, 0, 0L)) {
+                    SetStatusText(0, SST_FORMAT, szDirsRead, cNodes);
+                }
+            } else {
+                UpdateStatus(hwndParent);
+            }
+            break;
+        }
+
+        case TC_PROBEVISIBLE: {
+            TREEASYNC* pAsync;
+
+            pAsync = (TREEASYNC*)GetWindowLongPtr(hwnd, GWL_TREEASYNC);
+            if (!pAsync)
+                break;
+
+            pAsync->bProbePosted = FALSE;
+            ProbeVisibleNodes(hwnd);
+            break;
+        }
+
+        case TC_PROBED: {
+            //
+            // The prober has answered (see ProbeVisibleNodes); redraw the
+            // nodes that now know whether to show an expand marker.
+            //
+            DWORD dwIndex;
+            RECT rc;
+
+            for (const auto& result : TreeProber().takeCompleted((libwinfile::SubdirectoryProber::Owner)hwnd)) {
+                lstrcpy(szPath, result.path.c_str());
+
+                if (!FindItemFromPath(hwndLB, szPath, FALSE, &dwIndex, &pNode) || !IS_PROBE_UNKNOWN(pNode))
+                    continue;
+
+                pNode->wFlags |= TF_PROBED | (result.hasSubdirectories ? TF_HASCHILDREN : 0);
+
+                if (SendMessage(hwndLB, LB_GETITEMRECT, dwIndex, (LPARAM)&rc) != LB_ERR)
+                    InvalidateRect(hwndLB, &rc, FALSE);
+            }
+            break;
+        }
+
         case TC_GETDIR:
 
             //
@@ -1852,6 +2416,18 @@ TreeControlWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
                     UnregisterDropWindow(hwnd, pDropTarget);
             }
             FreeAllTreeData(hwndLB);
+            {
+                TREEASYNC* pAsync;
+
+                pAsync = (TREEASYNC*)GetWindowLongPtr(hwnd, GWL_TREEASYNC);
+                TreeLoader().cancel((libwinfile::DirectoryLevelLoader::Owner)hwnd);
+                TreeProber().cancel((libwinfile::SubdirectoryProber::Owner)hwnd);
+                SetWindowLongPtr(hwnd, GWL_TREEASYNC, 0L);
+                delete pAsync;
+
+                delete TREEINDEX(hwnd);
+                SetWindowLongPtr(hwnd, GWL_TREEINDEX, 0L);
+            }
             break;
 
         case WM_XBUTTONDOWN:
@@ -1879,6 +2455,8 @@ TreeControlWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 
             SendMessage(hwndLB, WM_SETFONT, (WPARAM)hFont, MAKELPARAM(TRUE, 0));
             SetWindowLongPtr(hwnd, GWL_READLEVEL, 0);
+            SetWindowLongPtr(hwnd, GWL_TREEASYNC, (LONG_PTR) new TREEASYNC());
+            SetWindowLongPtr(hwnd, GWL_TREEINDEX, (LONG_PTR) new libwinfile::TreePathIndex());
 
             {
                 WF_IDropTarget* pDropTarget;
@@ -1909,6 +2487,24 @@ TreeControlWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
                 bCreationOperation = TRUE;
             }
 
+            //
+            // The parent's level has changed (and a removed directory's whole
+            // subtree is gone), so the level cache must not hand out the old
+            // listings.
+            //
+            if (bCreationOperation || dwFSCOperation == FSC_RMDIR) {
+                lstrcpy(szPath, (LPWSTR)lParam);
+
+                if (dwFSCOperation == FSC_RMDIR) {
+                    TreeLoader().invalidate(szPath, true);
+                    TreeProber().invalidate(szPath, true);
+                }
+
+                StripFilespec(szPath);
+                TreeLoader().invalidate(szPath, false);
+                TreeProber().invalidate(szPath, false);
+            }
+
             //
             // search for a tree node corresponding to the item (if it is being
             // removed), or to the item's parent (if it is being added.)  If an
@@ -1935,6 +2531,18 @@ TreeControlWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
                         SendMessage(hwnd, TC_EXPANDLEVEL, FALSE, 0L);
                     }
 
+                    //
+                    // if the parent is being read in the background, the
+                    // new directory arrives with the rest of its level
+                    //
+                    {
+                        WCHAR szParent[MAXPATHLEN * 2];
+
+                        GetTreePath(pNode, szParent);
+                        if (IsLevelPending(hwnd, szParent))
+                            break;
+                    }
+
                     //
                     // make sure this node isn't already here
                     //
@@ -2004,6 +2612,7 @@ TreeControlWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
                     i = (int)SendMessage(hwndLB, LB_GETCURSEL, 0, 0L);
 
                     SendMessage(hwnd, TC_COLLAPSELEVEL, nIndex, 0L);
+                    TREEINDEX(hwnd)->remove(pNode);
                     SendMessage(hwndLB, LB_DELETESTRING, nIndex, 0L);
 
                     if (i >= nIndex) {
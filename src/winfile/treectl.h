@@ -16,6 +16,7 @@
 #define TF_HASCHILDREN 0x02
 #define TF_EXPANDED 0x04
 #define TF_DISABLED 0x08
+#define TF_PROBED 0x10  // whether there are subdirectories is known; TF_HASCHILDREN says which
 
 #define TF_LOWERCASE 0x20
 
@@ -37,4 +38,6 @@ void wfYield();
 void InvalidateAllNetTypes();
 void GetTreeUNCName(HWND hwndTree, LPWSTR szBuf, int nBuf);
 BOOL RectTreeItem(HWND hwndLB, int iItem, BOOL bFocusOn);
+void InvalidateTreeLevel(LPCWSTR szPath);
 LRESULT CALLBACK TreeControlWndProc(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam);
+void StopTreeThreads();
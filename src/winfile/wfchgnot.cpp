@@ -11,64 +11,23 @@
 
 #include "winfile.h"
 #include "wfchgnot.h"
+#include "wfdir.h"
+#include "wftree.h"
+#include "wfutil.h"
+#include "treectl.h"
+#include "libwinfile/DirectoryWatcher.h"
+#include <unordered_map>
 
 //
-// Forward Declarations
+// One DirectoryWatcher serves every window, however many there are;
+// watchedWindows remembers which drive each window watches so that
+// NotifyPause can find them.
 //
-void NotifyReset();
-void NotifyDeleteHandle(int i);
-void NotifyAddHandle(int i, HWND hwnd, LPWSTR lpPath, DWORD dwFilter);
-
-//
-// Maximum number of windows that are viewable
-// at once.
-//
-HWND ahwndWindows[MAX_WINDOWS];
-DRIVE adrive[MAX_WINDOWS];
-HANDLE ahEvents[MAX_WINDOWS];
-int nHandles;
+static libwinfile::DirectoryWatcher* pWatcher;
+static std::unordered_map<HWND, DRIVE> watchedWindows;
 
 #define bNOTIFYACTIVE uChangeNotifyTime
 
-void vWaitMessage() {
-    DWORD dwEvent;
-
-    dwEvent = MsgWaitForMultipleObjects(nHandles, ahEvents, FALSE, INFINITE, QS_ALLINPUT);
-
-    if (dwEvent != (DWORD)(WAIT_OBJECT_0 + nHandles)) {
-        if (dwEvent == (DWORD)-1) {
-            NotifyReset();
-
-        } else {
-            dwEvent -= WAIT_OBJECT_0;
-
-            //
-            // Check to see if this handle has been removed already, if so
-            // return before we try to refresh a non-existent window.
-            //
-            if ((dwEvent >= MAX_WINDOWS) || ahEvents[dwEvent] == NULL)
-                return;
-
-            //
-            // Modify GWL_FSCFLAG directly.
-            //
-            // We do the ModifyWatchList right before we read (close then
-            // open on the same path).  This clears out any extra notifications
-            // caused by fileman's move/copy etc.
-            //
-            SetWindowLongPtr(ahwndWindows[dwEvent], GWL_FSCFLAG, TRUE);
-            PostMessage(hwndFrame, FS_FSCREQUEST, 0, 0L);
-
-            if (FindNextChangeNotification(ahEvents[dwEvent]) == FALSE) {
-                //
-                // If we can't find the next change notification, remove it.
-                //
-                NotifyDeleteHandle(dwEvent);
-            }
-        }
-    }
-}
-
 /////////////////////////////////////////////////////////////////////
 //
 // Name:     InitializeWatchList
@@ -82,16 +41,14 @@ void vWaitMessage() {
 //
 // Assumes:  GetSettings has initialized uChangeNotifyTime
 //
-// Effects:  nHandles, ahwndWindows, ahEvents
+// Effects:  pWatcher
 //
 //
-// Notes:    If not successful, bNOTIFYACTIVE = FALSE
+// Notes:    If not successful, pWatcher is NULL and nothing is watched
 //
 /////////////////////////////////////////////////////////////////////
 
 void InitializeWatchList() {
-    int i;
-
     //
     // Change notify system is off if uChangeNotifyTime == 0
     // No, this doesn't mean zero time.
@@ -99,12 +56,16 @@ void InitializeWatchList() {
     if (!bNOTIFYACTIVE)
         return;
 
-    for (i = 0; i < MAX_WINDOWS; i++) {
-        ahwndWindows[i] = NULL;
-        ahEvents[i] = NULL;
+    //
+    // The watcher wakes us from its own thread; the changes are applied
+    // when the change notify timer fires (NotifyApplyChanges).
+    //
+    try {
+        pWatcher = new libwinfile::DirectoryWatcher(
+            [](libwinfile::DirectoryWatcher::Owner) { PostMessage(hwndFrame, FS_FSCREQUEST, 0, 0L); });
+    } catch (const std::exception&) {
+        pWatcher = NULL;
     }
-
-    nHandles = 0;
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -127,24 +88,15 @@ void InitializeWatchList() {
 /////////////////////////////////////////////////////////////////////
 
 void DestroyWatchList() {
-    PHANDLE phChange;
-
     //
     // Only destroy if successfully started
     //
-    if (bNOTIFYACTIVE) {
-        //
-        // Clean up handles in hChange!
-        //
-        for (phChange = ahEvents; nHandles; nHandles--, phChange++) {
-            FindCloseChangeNotification(*phChange);
-        }
+    if (pWatcher) {
+        delete pWatcher;
+        pWatcher = NULL;
     }
-}
 
-void NotifyReset() {
-    NotifyPause(-1, (UINT)-2);
-    nHandles = 0;
+    watchedWindows.clear();
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -174,29 +126,24 @@ void NotifyReset() {
 /////////////////////////////////////////////////////////////////////
 
 void NotifyPause(DRIVE drive, UINT uType) {
-    int i;
     DRIVE driveCurrent;
 
-    if (!bNOTIFYACTIVE)
+    if (!pWatcher)
         return;
 
-    for (i = 0; i < nHandles; i++) {
-        driveCurrent = adrive[i];
+    for (auto it = watchedWindows.begin(); it != watchedWindows.end();) {
+        driveCurrent = it->second;
 
         if (-2 == drive ||
             ((-1 == drive || drive == driveCurrent) &&
              ((UINT)-1 == uType || aDriveInfo[driveCurrent].uType == uType))) {
             if (-2 != drive)
-                SetWindowLongPtr(ahwndWindows[i], GWL_NOTIFYPAUSE, 1L);
-
-            NotifyDeleteHandle(i);
+                SetWindowLongPtr(it->first, GWL_NOTIFYPAUSE, 1L);
 
-            //
-            // This is the traverse while compact problem.
-            // We get around this by decrementing i so the i++ is
-            // negated.
-            //
-            i--;
+            pWatcher->unwatch((libwinfile::DirectoryWatcher::Owner)it->first);
+            it = watchedWindows.erase(it);
+        } else {
+            ++it;
         }
     }
 }
@@ -276,168 +223,120 @@ void NotifyResume(DRIVE drive, UINT uType) {
 // Return:   void
 //
 //
-// Assumes:  Single threaded implementation.  All calls in this file
-//           are non reentrant.  (Multithreaded approach removed around
-//           9/15/93 to eliminate a thread.)
+// Assumes:  Called by main thread.  The watcher's own thread only
+//           reads directory changes and posts FS_FSCREQUEST.
 //
-// Effects:  ahwndWindows
-//           ahChange
-//           adrives
+// Effects:  watchedWindows
 //
 // Notes:
 //
 /////////////////////////////////////////////////////////////////////
 
 void ModifyWatchList(HWND hwnd, LPWSTR lpPath, DWORD fdwFilter) {
-    int i;
-
-    if (!bNOTIFYACTIVE)
+    if (!pWatcher)
         return;
 
     //
-    // First we must see if this window already has a watch handle
-    // assigned to it.  If so, then we must close that watch, and
-    // restart a new one for it.  UNLESS lpPath is NULL, in which
-    // case the window will be removed from our list.
+    // Watching a path replaces the window's old watch, and drops the
+    // changes it collected: they were caused by whatever made the window
+    // read again.  A NULL lpPath removes the window from the list.
     //
-
-    for (i = 0; i < nHandles && ahwndWindows[i] != NULL && ahwndWindows[i] != hwnd; i++)
-
-        ;
-
-    if (i < nHandles && ahwndWindows[i] != NULL) {
-        //
-        // Now check to see if we are just changing the handle or removing
-        // the window all together.
-        //
-
-        if (lpPath == NULL) {
-            NotifyDeleteHandle(i);
-            //
-            // Now we need to clean up and exit.
-            //
-            return;
-
-        } else {
-            if (FindCloseChangeNotification(ahEvents[i]) == FALSE) {
-                //
-                // BUGBUG:   In the event that this fails we will need to do
-                //           something about it....I am not sure what at this
-                //           point.
-                //
-            }
-
-            //
-            // We now need to issue a new FindFirstChangeNotification for
-            // the new path and modify the structures appropriately.
-            //
-
-            NotifyAddHandle(i, hwnd, lpPath, fdwFilter);
-
-            //
-            // Now we need to clean up and exit.
-            //
-            return;
-        }
+    if (lpPath && pWatcher->watch((libwinfile::DirectoryWatcher::Owner)hwnd, lpPath, fdwFilter)) {
+        watchedWindows[hwnd] = DRIVEID(lpPath);
     } else {
-        if (lpPath == NULL) {
-            //
-            // BUGBUG: We didn't find the window handle but we are being
-            //         asked to remove it from the list....Something went
-            //         wrong.
-            //
-            return;
-        }
+        pWatcher->unwatch((libwinfile::DirectoryWatcher::Owner)hwnd);
+        watchedWindows.erase(hwnd);
     }
-
-    //
-    // We now need to issue a new FindFirstChangeNotification for
-    // the new path and modify the structures appropriately.
-    //
-
-    NotifyAddHandle(i, hwnd, lpPath, fdwFilter);
 }
 
 /////////////////////////////////////////////////////////////////////
 //
-// Name:     NotifyDeleteHandle
-//
-// Synopsis: Deletes open associated handle handle.
+// Name:     NotifyApplyChanges
 //
-// INC       i  index in ahwndWindows[] to delete
+// Synopsis: Applies the changes collected for a window to its
+//           directory listing and tree in place
 //
+// IN        hwnd      MDI child window
 //
 // Return:   void
 //
+// Assumes:  Called by main thread when the change notify timer fires,
+//           before GWL_FSCFLAG is checked
 //
-// Assumes:  Exclusive, safe access to globals.
-//
-// Effects:  ahwndWindows, nHandles, adrives
-//
-//
-// Notes:
+// Effects:  GWL_FSCFLAG is set if the window must be read again
+//           instead: changes were lost, or the listing can't be
+//           patched right now
 //
 /////////////////////////////////////////////////////////////////////
 
-void NotifyDeleteHandle(int i) {
-    if (INVALID_HANDLE_VALUE != ahEvents[i] && FindCloseChangeNotification(ahEvents[i]) == FALSE) {
-    }
+void NotifyApplyChanges(HWND hwnd) {
+    PDIRPATCH pPatch;
+    HWND hwndTree = NULL;
+    HWND hwndDir;
+    WCHAR szDir[MAXPATHLEN];
+    WCHAR szPath[MAXPATHLEN];
+    DWORD dwAttrs;
+    BOOL bRemoved;
+    BOOL bApplied;
+
+    if (!pWatcher)
+        return;
 
-    //
-    // We now need to delete the window all together...So compact
-    // the list of change handles and window handles to reflect this.
-    // Since order isn't important, just copy the last
-    // item to the empty spot, and write NULL in the
-    // last position.
-    //
-    nHandles--;
+    libwinfile::DirectoryChangeSet changes = pWatcher->takeChanges((libwinfile::DirectoryWatcher::Owner)hwnd);
 
-    ahwndWindows[i] = ahwndWindows[nHandles];
-    ahEvents[i] = ahEvents[nHandles];
-    adrive[i] = adrive[nHandles];
+    if (changes.empty())
+        return;
 
-    ahwndWindows[nHandles] = NULL;
-    ahEvents[nHandles] = NULL;
+    SendMessage(hwnd, FS_GETDIRECTORY, COUNTOF(szDir), (LPARAM)szDir);
 
-    return;
-}
+    bApplied = FALSE;
+    pPatch = NULL;
 
-/////////////////////////////////////////////////////////////////////
-//
-// Name:     NotifyAddHandle
-//
-// Synopsis: Adds handle and associated data
-//
-// INC       i         int     Index to modify
-// INC       hwnd      --      hwnd of window to watch (hwndTree, not hwndDir)
-// INC       lpPath    --      path to watch, -1 == same as old
-// INC       fdwFilter --      filters for notification
-//
-// Return:   void
-//
-// Assumes:  i is a valid index; no boundary checking done.
-//
-// Effects:  nHandles is incremented if necessary.
-//
-//
-// Notes:
-//
-/////////////////////////////////////////////////////////////////////
+    if (!changes.overflowed() && !GetWindowLongPtr(hwnd, GWL_FSCFLAG)) {
+        GetTreeWindows(hwnd, &hwndTree, &hwndDir);
+
+        if (hwndDir)
+            pPatch = DirPatchBegin(hwndDir);
+    }
+
+    if (pPatch) {
+        bApplied = TRUE;
+
+        for (const auto& change : changes.changes()) {
+            bRemoved = change.kind == libwinfile::DirectoryChangeKind::Removed;
+
+            if (!DirPatchApply(pPatch, change.name.c_str(), bRemoved, &dwAttrs)) {
+                bApplied = FALSE;
+                break;
+            }
+
+            //
+            // The tree ignores paths it doesn't show, so whatever is gone
+            // can be passed on without knowing whether it was a directory.
+            //
+            if (!hwndTree || lstrlen(szDir) + (int)change.name.size() >= (int)COUNTOF(szPath))
+                continue;
 
-void NotifyAddHandle(int i, HWND hwnd, LPWSTR lpPath, DWORD fdwFilter) {
-    adrive[i] = DRIVEID(lpPath);
+            lstrcpy(szPath, szDir);
+            AddBackslash(szPath);
+            lstrcat(szPath, change.name.c_str());
 
-    ahwndWindows[i] = hwnd;
+            if (dwAttrs == INVALID_FILE_ATTRIBUTES)
+                SendMessage(hwndTree, WM_FSC, FSC_RMDIR, (LPARAM)szPath);
+            else if (dwAttrs & ATTR_DIR)
+                SendMessage(hwndTree, WM_FSC, FSC_MKDIR | FSC_QUIET, (LPARAM)szPath);
+        }
 
-    ahEvents[i] = FindFirstChangeNotification(lpPath, FALSE, fdwFilter);
+        DirPatchEnd(pPatch);
+    }
 
-    if (nHandles == i)
-        nHandles++;
+    if (!bApplied) {
+        SetWindowLongPtr(hwnd, GWL_FSCFLAG, TRUE);
 
-    if (ahEvents[i] == INVALID_HANDLE_VALUE) {
         //
-        // Since this handle is invalid, delete it.
+        // The directory's subdirectories may have changed too, so the
+        // tree's cached listing of it is no longer trustworthy.
         //
-        NotifyDeleteHandle(i);
+        InvalidateTreeLevel(szDir);
     }
 }
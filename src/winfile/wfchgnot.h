@@ -9,4 +9,4 @@ void ModifyWatchList(HWND hwndWatch, LPWSTR lpPath, DWORD fdwFilter);
 void DestroyWatchList();
 void NotifyPause(DRIVE drive, UINT uType);
 void NotifyResume(DRIVE drive, UINT uType);
-void vWaitMessage();
+void NotifyApplyChanges(HWND hwnd);
@@ -1575,6 +1575,7 @@ BOOL AppCommandProc(DWORD id) {
 
         case IDM_DELETE:
             dwSuperDlgMode = id;
+            bDeletePermanent = GetKeyState(VK_SHIFT) < 0;
 
             DialogBox(hAppInstance, (LPWSTR)MAKEINTRESOURCE(DELETEDLG), hwndFrame, SuperDlgProc);
             break;
@@ -1849,6 +1850,12 @@ BOOL AppCommandProc(DWORD id) {
                 break;
             }
 
+            // Running jobs are cancelled, and their threads waited for,
+            // before anything else goes away under them.
+
+            if (!CancelProgressDlgs(hwndFrame, TRUE))
+                break;
+
             if (iReadLevel) {
                 // don't exit now.  setting this variable will force the
                 // tree read to terminate and then post a close message
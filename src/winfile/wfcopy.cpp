@@ -21,11 +21,30 @@
 #include "wftree.h"
 #include "wfdrives.h"
 #include "stringconstants.h"
+#include "libwinfile/CopyPipeline.h"
+#include "libwinfile/UnbufferedCopier.h"
 
-BOOL* pbConfirmAll;
-BOOL* pbConfirmReadOnlyAll;
+#include <shlobj.h>
+#include <algorithm>
 
-int ManySource;
+// Per copy thread, like hdlgProgress.
+thread_local BOOL* pbConfirmAll;
+thread_local BOOL* pbConfirmReadOnlyAll;
+
+thread_local int ManySource;
+
+// Files copied at once by WFMoveCopyDriverThread.
+#define COPY_THREADS 8
+
+// How often, in bytes copied, a huge file's progress is saved to the copy
+// journal.  A resumed copy redoes at most this much of it.
+#define JOURNAL_INTERVAL (64 * 1024 * 1024)
+
+typedef enum {
+    JOURNAL_NEW,      // Not yet copied, as far as the journal knows
+    JOURNAL_DONE,     // Copied, and the copy still matches its source
+    JOURNAL_PARTIAL,  // Copied part way, from the source as it still is
+} JOURNALSTATE;
 
 void wfYield();
 
@@ -923,11 +942,7 @@ IsInvalidPath(LPWSTR pPath) {
 
 PLFNDTA
 CurPDTA(PCOPYROOT pcr) {
-    if (pcr->cDepth) {
-        return (pcr->rgDTA + pcr->cDepth - 1);
-    } else {
-        return pcr->rgDTA;
-    }
+    return &pcr->dta;
 }
 
 /*--------------------------------------------------------------------------*/
@@ -937,10 +952,9 @@ CurPDTA(PCOPYROOT pcr) {
 /*--------------------------------------------------------------------------*/
 
 void GetNextCleanup(PCOPYROOT pcr) {
-    while (pcr->cDepth) {
-        WFFindClose(CurPDTA(pcr));
-        pcr->cDepth--;
-    }
+    pcr->walker.stop();
+    pcr->bWalking = FALSE;
+    pcr->bDescend = FALSE;
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -1005,151 +1019,122 @@ GetNextPair(
     pDTA = NULL;
 
     //
-    // Keep recursing directory structure until we get to the bottom
+    // Keep walking the directory structure until we get to the bottom
     //
     while (TRUE) {
-        if (pcr->cDepth) {
+        if (pcr->bDescend) {
             //
-            // The directory we returned last call needs to be recursed.
+            // The directory we returned last call needs to be walked into.
             //
-            pDTA = pcr->rgDTA + pcr->cDepth - 1;  // use this DTA below
-
-            if (pcr->fRecurse && pcr->cDepth == 1 && !pcr->rgDTA[0].fd.cFileName[0])
+            pcr->bDescend = FALSE;
+            pDTA = &pcr->dta;
 
+            if (pcr->bFastMove || !pcr->fRecurse) {
                 //
-                // The last one was the recursion root.
+                // It was moved whole, or is not to be recursed: pretend
+                // it was empty.
                 //
-                goto BeginDirSearch;
+                if (pcr->bWalking)
+                    pcr->walker.skip();
+                RemoveLast(pcr->szDest);
+                pcr->bFastMove = FALSE;
+                continue;
+            }
 
-            if (pcr->cDepth >= (MAXDIRDEPTH - 1)) {  // reached the limit?
-                dwOp = OPER_ERROR;
-                *pdwError = ERROR_FILENAME_EXCED_RANGE;
+            // Check if we should skip an entry because it was e.g. an reparse point
+            if (pcr->bWalking && (pDTA->fd.dwFileAttributes & (ATTR_SYMBOLIC | ATTR_JUNCTION))) {
+                pcr->walker.skip();
+                RemoveLast(pcr->szDest);
+                dwOp = OPER_RMDIR;
                 goto ReturnPair;
             }
 
-            if (pcr->fRecurse && (pDTA->fd.dwFileAttributes & ATTR_DIR) &&
-                !(pDTA->fd.dwFileAttributes & ATTR_RETURNED)) {
-                //
-                // Was returned on last call, begin search.
-                //
-                pDTA->fd.dwFileAttributes |= ATTR_RETURNED;
-
-                if (pcr->bFastMove)
-                    goto FastMoveSkipDir;
-
-                // Check if we should skip an entry because it was e.g. an reparse point
-                if (pDTA->fd.dwFileAttributes & (ATTR_SYMBOLIC | ATTR_JUNCTION)) {
-                    RemoveLast(pcr->szDest);
-                    dwOp = OPER_RMDIR;
-                    goto ReturnPair;
-                }
-
-                pcr->cDepth++;
-                pDTA++;
-
-            BeginDirSearch:
-
+            if (!pcr->bWalking) {
                 //
-                // Search for all subfiles in directory.
+                // The last one was the recursion root.  A root that can't
+                // be listed is walked as if it were empty.
                 //
-                AppendToPath(pcr->sz, kStarDotStar);
-                goto BeginSearch;
+                pcr->dtaRoot = pcr->dta;
+                WFWalkStart(&pcr->walker, pcr->sz, L"*", libwinfile::TreeWalker::kShortNames);
+                pcr->bWalking = TRUE;
             }
+        }
 
-        SkipThisFile:
+        if (pcr->bWalking) {
+            pDTA = &pcr->dta;
 
-            //
-            // Search for the next matching file.
-            //
-            if (!WFFindNext(pDTA)) {
-                WFFindClose(pDTA);
+            switch (WFWalkNext(&pcr->walker, pDTA)) {
+                case libwinfile::TreeWalker::Visit::Enter:
+                    //
+                    // Ignore directories if we're not recursing.
+                    //
+                    if (!pcr->fRecurse) {
+                        pcr->walker.skip();
+                        continue;
+                    }
 
-            LeaveDirectory:
+                    if (pDTA->err)
+                        goto PathTooLong;
 
-                //
-                // This spec has been exhausted...
-                //
-                pcr->cDepth--;
+                    // We need to create this directory, and then begin walking
+                    // what is in it.
 
-                //
-                // Remove the child file spec.
-                //
-                RemoveLast(pcr->sz);
+                    lstrcpy(pcr->sz, pcr->walker.path().c_str());
+                    AppendToPath(pcr->szDest, pDTA->fd.cFileName);
+                    pcr->bDescend = TRUE;
+                    dwOp = OPER_MKDIR;
+                    goto ReturnPair;
 
-            FastMoveSkipDir:
+                case libwinfile::TreeWalker::Visit::File:
+                    if (pDTA->err)
+                        goto PathTooLong;
 
-                RemoveLast(pcr->szDest);
+                    lstrcpy(pcr->sz, pcr->walker.path().c_str());
+                    dwOp = OPER_DOFILE;
+                    goto ReturnPair;
 
-                if (pcr->fRecurse && !pcr->bFastMove) {
+                PathTooLong:
                     //
-                    // Tell the move/copy driver it can now delete
-                    // the source directory if necessary.
+                    // Its path doesn't fit in pcr->sz even by its short
+                    // name, let alone the destination's, so there is no
+                    // pair to make.  Report it instead of leaving it
+                    // behind unnoticed; a move then stops before it
+                    // removes the source directory.
                     //
-                    // (Don't do on a fast move since the directory was
-                    // removed on the move.)
+                    StrCpyN(pFrom, pcr->walker.path().c_str(), MAXPATHLEN);
+                    *pdwError = pDTA->err;
+                    return OPER_ERROR;
 
+                case libwinfile::TreeWalker::Visit::Leave:
+                    //
+                    // Tell the move/copy driver it can now delete the
+                    // source directory if necessary.
+                    //
+                    lstrcpy(pcr->sz, pcr->walker.path().c_str());
+                    RemoveLast(pcr->szDest);
                     dwOp = OPER_RMDIR;
                     goto ReturnPair;
-                }
-
-                pcr->bFastMove = FALSE;
-
-                //
-                // Not recursing, get more stuff.
-                //
-                continue;
-            }
-
-        ProcessSearchResult:
-
-            //
-            // Got a file or dir in the DTA which matches the wild card
-            // originally passed in...
-            //
-            if (pDTA->fd.dwFileAttributes & ATTR_DIR) {
-                //
-                // Ignore directories if we're not recursing.
-                //
-                if (!pcr->fRecurse)
-                    goto SkipThisFile;
-
-                //
-                // Skip the current and parent directories.
-                //
-                if (ISDOTDIR(pDTA->fd.cFileName)) {
-                    goto SkipThisFile;
-                }
-
-                // We need to create this directory, and then begin searching
-                // for subfiles.
-
-                dwOp = OPER_MKDIR;
-                RemoveLast(pcr->sz);
-                AppendToPath(pcr->sz, pDTA->fd.cFileName);
-                AppendToPath(pcr->szDest, pDTA->fd.cFileName);
-                goto ReturnPair;
-            }
-
-            if (pcr->fRecurse || !(pDTA->fd.dwFileAttributes & ATTR_DIR)) {
-                /* Remove the original spec. */
-
-                RemoveLast(pcr->sz);
 
-                /* Replace it. */
-
-                AppendToPath(pcr->sz, pDTA->fd.cFileName);
-
-                /* Convert to ANSI. */
-
-                pT = FindFileName(pcr->sz);
+                case libwinfile::TreeWalker::Visit::End:
+                    pcr->bWalking = FALSE;
 
-                // If its a dir, tell the driver to create it
-                // otherwise, tell the driver to "operate" on the file.
+                    if (pcr->fRecurse) {
+                        //
+                        // The root is done with too.
+                        //
+                        lstrcpy(pcr->sz, pcr->walker.path().c_str());
+                        pcr->dta = pcr->dtaRoot;
+                        RemoveLast(pcr->szDest);
+                        dwOp = OPER_RMDIR;
+                        goto ReturnPair;
+                    }
 
-                dwOp = (pDTA->fd.dwFileAttributes & ATTR_DIR) ? OPER_RMDIR : OPER_DOFILE;
-                goto ReturnPair;
+                    //
+                    // Not recursing, get more stuff.
+                    //
+                    pcr->bFastMove = FALSE;
+                    continue;
             }
-            continue;
         } else {
             //
             // Read the next source spec out of the raw source string.
@@ -1185,69 +1170,51 @@ GetNextPair(
                 //
                 // Wild card... operate on all matches but not recursively.
                 //
-                pcr->cDepth = 1;
-                pDTA = pcr->rgDTA;
                 pcr->pRoot = NULL;
+                pT = FindFileName(pcr->sz);
+                std::wstring dir(pcr->sz, pT - pcr->sz);
 
-            BeginSearch:
-                //
-                // Quit if pcr->sz gets too big.
-                //
-                if (lstrlen(pcr->sz) - lstrlen(FindFileName(pcr->sz)) >= MAXPATHLEN)
-                    goto SearchStartFail;
-
-                //
-                // Search for the wildcard spec in pcr->sz.
-                //
-                if (!WFFindFirst(pDTA, pcr->sz, ATTR_ALL)) {
-                SearchStartFail:
-
-                    if (pcr->fRecurse) {
-                        // We are inside a recursive directory delete, so
-                        // instead of erroring out, go back a level
-
-                        goto LeaveDirectory;
-                    }
+                if (WFWalkStart(&pcr->walker, dir.c_str(), pT, libwinfile::TreeWalker::kShortNames)) {
                     lstrcpy(pFrom, pcr->sz);
 
                     //
                     // Back up as if we completed a search.
                     //
                     RemoveLast(pcr->sz);
-                    pcr->cDepth--;
 
                     //
-                    // Find First returned an error.  Return FileNotFound.
+                    // The search couldn't begin.  Return FileNotFound.
                     //
                     dwOp = OPER_ERROR;
                     *pdwError = ERROR_FILE_NOT_FOUND;
 
                     goto ReturnPair;
                 }
-                goto ProcessSearchResult;
+                pcr->bWalking = TRUE;
+                continue;
             } else {
                 // This could be a file or a directory.  Fill in the DTA
                 // structure for attrib check
 
                 if (!IsRootDirectory(pcr->sz)) {
-                    if (!WFFindFirst(pcr->rgDTA, pcr->sz, ATTR_ALL)) {
+                    if (!WFFindFirst(&pcr->dta, pcr->sz, ATTR_ALL)) {
                         dwOp = OPER_ERROR;
                         *pdwError = GetLastError();
 
                         goto ReturnPair;
                     }
-                    WFFindClose(pcr->rgDTA);
+                    WFFindClose(&pcr->dta);
 
                     // Mega hack fix by adding else clause
 
                 } else {
-                    pcr->rgDTA->hFindFile = INVALID_HANDLE_VALUE;
+                    pcr->dta.hFindFile = INVALID_HANDLE_VALUE;
                 }
 
                 //
                 // Now determine if its a file or a directory
                 //
-                pDTA = pcr->rgDTA;
+                pDTA = &pcr->dta;
                 if (IsRootDirectory(pcr->sz) || (pDTA->fd.dwFileAttributes & ATTR_DIR)) {
                     //
                     // Process directory
@@ -1276,8 +1243,7 @@ GetNextPair(
                     else
                         pcr->fRecurse = TRUE;
 
-                    pcr->cDepth = 1;
-                    pDTA->fd.cFileName[0] = CHAR_NULL;
+                    pcr->bDescend = TRUE;
                     pcr->pRoot = FindFileName(pcr->sz);
 
                     lstrcpy(pcr->szDest, pcr->pRoot);
@@ -1556,6 +1522,28 @@ SafeFileRemove(LPWSTR szFileOEM) {
         return WFRemove(szFileOEM);
 }
 
+//
+// Like SafeFileRemove, but deletes the file for good rather than sending it
+// to the recycle bin.  A read-only file is deleted all the same; the user
+// has been asked about it by now.
+//
+static DWORD SafeFileDelete(LPWSTR szFile) {
+    DWORD dwAttr;
+
+    if (IsWindowsFile(szFile))
+        return DE_WINDOWSFILE;
+
+    dwAttr = GetFileAttributes(szFile);
+    if (dwAttr != INVALID_FILE_ATTRIBUTES && (dwAttr & ATTR_READONLY))
+        SetFileAttributes(szFile, dwAttr & ~ATTR_READONLY);
+
+    if (!DeleteFile(szFile))
+        return GetLastError();
+
+    ChangeFileSystem(FSC_DELETE, szFile, NULL);
+    return 0;
+}
+
 DWORD
 WF_CreateDirectory(HWND hwndParent, LPWSTR szDest, LPWSTR szSrc) {
     DWORD ret = 0;
@@ -1632,6 +1620,302 @@ WF_CreateDirectory(HWND hwndParent, LPWSTR szDest, LPWSTR szSrc) {
     return ret;  // return the last error code
 }
 
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     GetCopyJournalDir
+//
+// Synopsis: Where copy journals are kept: a folder of their own beside
+//           the other roaming settings.  Empty if it can't be found.
+//
+/////////////////////////////////////////////////////////////////////
+
+static std::wstring GetCopyJournalDir() {
+    WCHAR szAppData[MAX_PATH];
+
+    if (FAILED(SHGetFolderPathW(NULL, CSIDL_APPDATA, NULL, 0, szAppData)))
+        return std::wstring();
+
+    return std::wstring(szAppData) + kRoamINIPath + kCopyJobsPath;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyJournalSource
+//
+// Synopsis: The version of a source file that a copy journal records.
+//
+/////////////////////////////////////////////////////////////////////
+
+static libwinfile::CopyJournal::Source CopyJournalSource(
+    DWORD nFileSizeHigh,
+    DWORD nFileSizeLow,
+    const FILETIME& ftLastWriteTime) {
+    libwinfile::CopyJournal::Source source;
+
+    source.size = ((uint64_t)nFileSizeHigh << 32) | nFileSizeLow;
+    source.lastWriteTime = ((uint64_t)ftLastWriteTime.dwHighDateTime << 32) | ftLastWriteTime.dwLowDateTime;
+
+    return source;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyJournalCreate
+//
+// Synopsis: Starts a journal for a new copy from pFrom to pTo.
+//
+// Return:   The journal, or NULL if it couldn't be made.  The copy goes
+//           ahead regardless; it just can't be resumed.
+//
+/////////////////////////////////////////////////////////////////////
+
+static libwinfile::CopyJournal* CopyJournalCreate(LPCWSTR pFrom, LPCWSTR pTo) {
+    std::wstring dir = GetCopyJournalDir();
+    FILETIME ftNow;
+
+    if (dir.empty())
+        return NULL;
+
+    SHCreateDirectoryExW(NULL, dir.c_str(), NULL);
+
+    GetSystemTimeAsFileTime(&ftNow);
+    std::wstring path = dir + L"\\" +
+        std::to_wstring(((uint64_t)ftNow.dwHighDateTime << 32) | ftNow.dwLowDateTime) + L"-" +
+        std::to_wstring(GetCurrentProcessId()) + libwinfile::CopyJournal::kExtension;
+
+    try {
+        return new libwinfile::CopyJournal(path, pFrom, pTo);
+    } catch (const std::exception&) {
+        return NULL;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyJournalCheck
+//
+// Synopsis: Looks up a file that is in the way of a resumed copy.  A file
+//           the copy finished is taken as done if it still has its
+//           source's size and last write time, which the copy gave it.
+//           A partial file can be carried on with if its source hasn't
+//           changed since; otherwise its record is cleared, and it is
+//           copied again from the start.
+//
+// pJournal - The copy's journal
+// pDest    - The file in the way
+// pfdSource, pfdDest - What was found for the source and the destination
+//
+/////////////////////////////////////////////////////////////////////
+
+static JOURNALSTATE CopyJournalCheck(
+    libwinfile::CopyJournal* pJournal,
+    LPCWSTR pDest,
+    const WIN32_FIND_DATA* pfdSource,
+    const WIN32_FIND_DATA* pfdDest) {
+    libwinfile::CopyJournal::Source source =
+        CopyJournalSource(pfdSource->nFileSizeHigh, pfdSource->nFileSizeLow, pfdSource->ftLastWriteTime);
+    libwinfile::CopyJournal::Source dest =
+        CopyJournalSource(pfdDest->nFileSizeHigh, pfdDest->nFileSizeLow, pfdDest->ftLastWriteTime);
+    libwinfile::CopyJournal::Source partial;
+    uint64_t qwOffset;
+
+    if (pfdDest->dwFileAttributes & ATTR_DIR)
+        return JOURNAL_NEW;
+
+    if (pJournal->isDone(pDest)) {
+        return source.size == dest.size && source.lastWriteTime == dest.lastWriteTime ? JOURNAL_DONE : JOURNAL_NEW;
+    }
+
+    if (pJournal->partial(pDest, &partial, &qwOffset)) {
+        if (partial.size == source.size && partial.lastWriteTime == source.lastWriteTime)
+            return JOURNAL_PARTIAL;
+
+        pJournal->clearPartial(pDest);
+    }
+
+    return JOURNAL_NEW;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyJobQueue
+//
+// Synopsis: The queue every operation waits in for its disks, so that
+//           copies on one disk take turns while copies between separate
+//           disks run at once.
+//
+/////////////////////////////////////////////////////////////////////
+
+libwinfile::CopyQueue& CopyJobQueue() {
+    static libwinfile::CopyQueue queue;
+    return queue;
+}
+
+//
+// The threads WFMoveCopyDriver has started that may still be running,
+// for CopyJobsWait.  Only used on the UI thread.
+//
+static std::vector<HANDLE> rgCopyThreads;
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyJobsWait
+//
+// Synopsis: Waits for every operation's thread to end, handling messages
+//           meanwhile since the threads send them to us.  The frame is
+//           disabled until then so the user can't start anything new.
+//           If the wait itself fails, the threads are left to finish
+//           on their own rather than spinning with the frame disabled.
+//
+/////////////////////////////////////////////////////////////////////
+
+void CopyJobsWait() {
+    MSG msg;
+    DWORD dwCount;
+    DWORD dwResult;
+
+    if (rgCopyThreads.empty())
+        return;
+
+    EnableWindow(hwndFrame, FALSE);
+
+    while (!rgCopyThreads.empty()) {
+        dwCount = min((DWORD)rgCopyThreads.size(), MAXIMUM_WAIT_OBJECTS - 1);
+        dwResult = MsgWaitForMultipleObjects(dwCount, rgCopyThreads.data(), FALSE, INFINITE, QS_ALLINPUT);
+
+        if (dwResult == WAIT_FAILED)
+            break;
+
+        if (dwResult < WAIT_OBJECT_0 + dwCount) {
+            CloseHandle(rgCopyThreads[dwResult - WAIT_OBJECT_0]);
+            rgCopyThreads.erase(rgCopyThreads.begin() + (dwResult - WAIT_OBJECT_0));
+            continue;
+        }
+
+        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+    }
+
+    EnableWindow(hwndFrame, TRUE);
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyJobDevices
+//
+// Synopsis: The disks an operation reads and writes in bulk: for a copy,
+//           or a move between volumes, those holding its first source
+//           and its destination.  Renames, deletes, links and moves
+//           within a volume only touch directory entries, so they need
+//           none and never wait.
+//
+/////////////////////////////////////////////////////////////////////
+
+static std::vector<std::wstring> CopyJobDevices(PCOPYINFO pCopyInfo) {
+    WCHAR szFrom[MAXPATHLEN];
+    WCHAR szTo[MAXPATHLEN];
+    WCHAR szFromRoot[MAXPATHLEN];
+    WCHAR szToRoot[MAXPATHLEN];
+    std::vector<std::wstring> devices;
+
+    if (pCopyInfo->dwFunc != FUNC_COPY && pCopyInfo->dwFunc != FUNC_MOVE)
+        return devices;
+
+    if (!GetNextFile(pCopyInfo->pFrom, szFrom, COUNTOF(szFrom)) ||
+        !GetNextFile(pCopyInfo->pTo, szTo, COUNTOF(szTo)))
+        return devices;
+
+    if (pCopyInfo->dwFunc == FUNC_MOVE) {
+        if (!GetVolumePathName(szFrom, szFromRoot, COUNTOF(szFromRoot)) ||
+            !GetVolumePathName(szTo, szToRoot, COUNTOF(szToRoot)) || !lstrcmpi(szFromRoot, szToRoot))
+            return devices;
+    }
+
+    devices = libwinfile::CopyQueue::devicesOf(szFrom);
+    for (auto& device : libwinfile::CopyQueue::devicesOf(szTo)) {
+        if (std::find(devices.begin(), devices.end(), device) == devices.end())
+            devices.push_back(std::move(device));
+    }
+
+    return devices;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyJobCheckpoint
+//
+// Synopsis: Waits while the user has the operation paused.
+//
+// Return:   FALSE once the operation has been cancelled
+//
+/////////////////////////////////////////////////////////////////////
+
+static BOOL CopyJobCheckpoint(PCOPYINFO pCopyInfo) {
+    return CopyJobQueue().checkpoint(pCopyInfo->jobId) && !pCopyInfo->bUserAbort;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     DeleteTreeWhole
+//
+// Synopsis: Deletes a directory and everything in it in one go, rather
+//           than a file at a time.  A recycled tree goes to the recycle
+//           bin in one piece; a permanently deleted one is taken down
+//           on a pool of worker threads.  Entries with any of
+//           dwKeepAttributes are left behind for the caller to ask the
+//           user about, along with the directories above them.  So are
+//           files Windows has loaded, which the caller then reports as
+//           SafeFileDelete does.
+//
+//           *pbGone is set if szDir is gone afterwards.
+//
+// Return:   DE_OPCANCELLED if the user cancelled, the error that
+//           stopped the recycle bin or the first one the deleter ran
+//           into, otherwise 0.  If the deleter can't start for want of
+//           memory or threads, 0 and the walk deletes the tree instead.
+//
+/////////////////////////////////////////////////////////////////////
+
+static DWORD DeleteTreeWhole(PCOPYINFO pCopyInfo, LPWSTR szDir, DWORD dwKeepAttributes, PBOOL pbGone) {
+    DWORD ret = 0;
+
+    Notify(hdlgProgress, IDS_REMOVINGDIRMSG, szDir, kEmptyString);
+
+    if (!pCopyInfo->bPermanent) {
+        ret = MoveFileToRecycleBin(szDir);
+    } else {
+        try {
+            libwinfile::TreeDeleter deleter(COPY_THREADS);
+            ret = deleter.deleteTree(
+                szDir, dwKeepAttributes, [pCopyInfo](uint64_t) { return CopyJobCheckpoint(pCopyInfo) != FALSE; },
+                [](const std::wstring& path) {
+                    WCHAR szFile[MAXPATHLEN];
+
+                    if (path.size() >= COUNTOF(szFile))
+                        return false;
+                    lstrcpy(szFile, path.c_str());
+                    return IsWindowsFile(szFile) != FALSE;
+                });
+            if (ret == ERROR_REQUEST_ABORTED)
+                return DE_OPCANCELLED;
+        } catch (const std::bad_alloc&) {
+            // Couldn't start, or couldn't list the tree; the walk deletes it.
+            ret = 0;
+        } catch (const std::system_error&) {
+            // Couldn't start its threads.
+            ret = 0;
+        }
+    }
+
+    *pbGone = GetFileAttributes(szDir) == INVALID_FILE_ATTRIBUTES;
+    if (*pbGone)
+        ChangeFileSystem(FSC_RMDIR, szDir, NULL);
+
+    return ret;
+}
+
 /////////////////////////////////////////////////////////////////////
 //
 // Name:     WFMoveCopyDriver
@@ -1660,6 +1944,36 @@ WFMoveCopyDriver(PCOPYINFO pCopyInfo) {
     HANDLE hThreadCopy;
     DWORD dwIgnore;
 
+    //
+    // Copies count their bytes for the status dialog.  It is made here,
+    // before the thread starts, so the dialog can sample it right away.
+    //
+    if (pCopyInfo->dwFunc == FUNC_COPY) {
+        try {
+            pCopyInfo->pProgress = new libwinfile::CopyProgress();
+        } catch (const std::bad_alloc&) {
+            pCopyInfo->pProgress = NULL;
+        }
+    }
+
+    //
+    // A new copy keeps a journal, with the source and destination as the
+    // user gave them, so that it can be resumed if it is cut short.  A
+    // resumed copy already has its journal.
+    //
+    if (pCopyInfo->dwFunc == FUNC_COPY && !pCopyInfo->pJournal) {
+        pCopyInfo->pJournal = CopyJournalCreate(pCopyInfo->pFrom, pCopyInfo->pTo);
+    }
+
+    //
+    // The thread reports to the progress window that is starting it, and
+    // takes its turn on its disks behind the operations already queued.
+    // It is queued from here so that the window can pause or reorder it
+    // from the start.
+    //
+    pCopyInfo->hDlg = hdlgProgress;
+    pCopyInfo->jobId = CopyJobQueue().add(CopyJobDevices(pCopyInfo));
+
     //
     // Move/Copy things.
     //
@@ -1669,18 +1983,364 @@ WFMoveCopyDriver(PCOPYINFO pCopyInfo) {
         //
         // Must free everything
         //
+        DWORD dwError = GetLastError();
+
+        CopyJobQueue().finish(pCopyInfo->jobId);
+        delete pCopyInfo->pProgress;
+        if (pCopyInfo->pJournal) {
+            pCopyInfo->pJournal->remove();
+            delete pCopyInfo->pJournal;
+        }
         LocalFree(pCopyInfo->pFrom);
         LocalFree(pCopyInfo->pTo);
         LocalFree(pCopyInfo);
 
-        return GetLastError();
+        SetLastError(dwError);
+        return dwError;
     }
 
-    CloseHandle(hThreadCopy);
+    //
+    // Keep the handle so that exiting can wait for the thread.  Handles
+    // of threads that have ended are let go on the way.
+    //
+    for (auto it = rgCopyThreads.begin(); it != rgCopyThreads.end();) {
+        if (WaitForSingleObject(*it, 0) == WAIT_OBJECT_0) {
+            CloseHandle(*it);
+            it = rgCopyThreads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    try {
+        rgCopyThreads.push_back(hThreadCopy);
+    } catch (const std::bad_alloc&) {
+        CloseHandle(hThreadCopy);
+    }
 
     return 0;
 }
 
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyScanFind
+//
+// Synopsis: Counts the files matching pszSpec into the copy's progress.
+//           If pDirectories is given, subdirectories other than symbolic
+//           links and junctions are added to it to be counted in turn.
+//
+/////////////////////////////////////////////////////////////////////
+
+static void CopyScanFind(PCOPYINFO pCopyInfo, LPWSTR pszSpec, std::vector<std::wstring>* pDirectories) {
+    LFNDTA lfndta;
+    WCHAR szPath[MAXPATHLEN];
+    uint64_t cFiles = 0;
+    uint64_t cbFiles = 0;
+
+    if (!WFFindFirst(&lfndta, pszSpec, ATTR_ALL))
+        return;
+
+    do {
+        if (lfndta.fd.dwFileAttributes & ATTR_DIR) {
+            if (pDirectories && !ISDOTDIR(lfndta.fd.cFileName) &&
+                !(lfndta.fd.dwFileAttributes & (ATTR_SYMBOLIC | ATTR_JUNCTION)) &&
+                lstrlen(pszSpec) + lstrlen(lfndta.fd.cFileName) < COUNTOF(szPath)) {
+                lstrcpy(szPath, pszSpec);
+                RemoveLast(szPath);
+                AppendToPath(szPath, lfndta.fd.cFileName);
+                pDirectories->push_back(szPath);
+            }
+        } else {
+            cFiles++;
+            cbFiles += ((uint64_t)lfndta.fd.nFileSizeHigh << 32) | lfndta.fd.nFileSizeLow;
+        }
+    } while (!pCopyInfo->bUserAbort && WFFindNext(&lfndta));
+
+    WFFindClose(&lfndta);
+
+    pCopyInfo->pProgress->addScanned(cFiles, cbFiles);
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyScanThread
+//
+// Synopsis: Counts the files and bytes a copy will go through, for the
+//           totals in the status dialog.  Runs alongside the copy rather
+//           than before it, and walks the sources the way GetNextPair
+//           does: a wildcard matches files in one directory, a directory
+//           is copied with everything below it, and symbolic links and
+//           junctions are not followed.
+//
+// lpParameter - The operation's PCOPYINFO, which must have a pProgress
+//
+// Return:   0
+//
+/////////////////////////////////////////////////////////////////////
+
+static DWORD WINAPI CopyScanThread(LPVOID lpParameter) {
+    PCOPYINFO pCopyInfo = (PCOPYINFO)lpParameter;
+    LPWSTR pSource = pCopyInfo->pFrom;
+    WCHAR szSource[MAXPATHLEN];
+    WCHAR szSpec[MAXPATHLEN];
+    LFNDTA lfndta;
+    std::vector<std::wstring> directories;
+
+    while (!pCopyInfo->bUserAbort && (pSource = GetNextFile(pSource, szSource, COUNTOF(szSource))) != NULL) {
+        QualifyPath(szSource);
+
+        if (IsWild(szSource)) {
+            CopyScanFind(pCopyInfo, szSource, NULL);
+        } else if (IsRootDirectory(szSource)) {
+            directories.push_back(szSource);
+        } else if (WFFindFirst(&lfndta, szSource, ATTR_ALL)) {
+            WFFindClose(&lfndta);
+
+            if (!(lfndta.fd.dwFileAttributes & ATTR_DIR)) {
+                pCopyInfo->pProgress->addScanned(1, ((uint64_t)lfndta.fd.nFileSizeHigh << 32) | lfndta.fd.nFileSizeLow);
+            } else if (!(lfndta.fd.dwFileAttributes & (ATTR_SYMBOLIC | ATTR_JUNCTION))) {
+                directories.push_back(szSource);
+            }
+        }
+
+        while (!pCopyInfo->bUserAbort && !directories.empty()) {
+            StrCpyN(szSpec, directories.back().c_str(), COUNTOF(szSpec) - 4);
+            directories.pop_back();
+
+            AppendToPath(szSpec, kStarDotStar);
+            CopyScanFind(pCopyInfo, szSpec, &directories);
+        }
+    }
+
+    pCopyInfo->pProgress->finishScan();
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyPipelineCopyFile
+//
+// Synopsis: Copies one file on a pipeline worker, reporting its bytes to
+//           the copy's progress as it goes.  Files of uUnbufferedCopyMB
+//           or more go around the system cache through pCopier, unless
+//           they need something only CopyFileEx does.
+//
+//           With bVerify, the copy is then read back from the disk and
+//           its checksum compared with the source's.  The source is summed
+//           as it passes through pCopier's buffers, or else read again
+//           from the cache, where CopyFileEx has just left it.
+//
+//           With a journal, a huge file's progress is saved as it goes,
+//           and what a failed copy wrote is kept; a copy of the same
+//           source to the same place carries on from there.
+//
+// Return:   0, a Win32 error code, or DE_VERIFYFAILED
+//
+/////////////////////////////////////////////////////////////////////
+
+typedef struct _COPYFILEPROGRESS {
+    PCOPYINFO pCopyInfo;
+    libwinfile::CopyProgress* pProgress;
+    libwinfile::CopyProgress::FileId id;
+} COPYFILEPROGRESS, *PCOPYFILEPROGRESS;
+
+static DWORD CALLBACK CopyFileProgressRoutine(
+    LARGE_INTEGER TotalFileSize,
+    LARGE_INTEGER TotalBytesTransferred,
+    LARGE_INTEGER StreamSize,
+    LARGE_INTEGER StreamBytesTransferred,
+    DWORD dwStreamNumber,
+    DWORD dwCallbackReason,
+    HANDLE hSourceFile,
+    HANDLE hDestinationFile,
+    LPVOID lpData) {
+    PCOPYFILEPROGRESS pFileProgress = (PCOPYFILEPROGRESS)lpData;
+
+    if (pFileProgress->pProgress) {
+        pFileProgress->pProgress->updateFile(
+            pFileProgress->id, TotalBytesTransferred.QuadPart, TotalFileSize.QuadPart);
+    }
+
+    return CopyJobCheckpoint(pFileProgress->pCopyInfo) ? PROGRESS_CONTINUE : PROGRESS_CANCEL;
+}
+
+static DWORD CopyPipelineCopyFile(
+    PCOPYINFO pCopyInfo,
+    const libwinfile::UnbufferedCopier* pCopier,
+    const std::wstring& from,
+    const std::wstring& to,
+    uint64_t qwSize,
+    BOOL bVerify) {
+    COPYFILEPROGRESS fileProgress;
+    DWORD dwError = ERROR_NOT_SUPPORTED;
+    BOOL bSummed = FALSE;
+    libwinfile::Crc32c sourceCrc;
+    libwinfile::Crc32c destCrc;
+    auto keepGoing = [pCopyInfo](uint64_t, uint64_t) { return CopyJobCheckpoint(pCopyInfo) != FALSE; };
+    libwinfile::CopyJournal* pJournal = pCopyInfo->pJournal;
+    libwinfile::CopyJournal::Source source;
+    libwinfile::CopyJournal::Source partial;
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    uint64_t qwOffset = 0;
+    uint64_t qwDone = 0;
+    uint64_t qwRecorded = 0;
+
+    //
+    // A paused copy holds its workers here, and inside the file they are
+    // copying, until it is resumed.
+    //
+    if (!CopyJobCheckpoint(pCopyInfo))
+        return ERROR_REQUEST_ABORTED;
+
+    fileProgress.pCopyInfo = pCopyInfo;
+    fileProgress.pProgress = pCopyInfo->pProgress;
+    fileProgress.id = pCopyInfo->pProgress ? pCopyInfo->pProgress->beginFile(from) : 0;
+
+    if (uUnbufferedCopyMB && qwSize >= (uint64_t)uUnbufferedCopyMB * 1024 * 1024) {
+        if (pJournal && GetFileAttributesEx(from.c_str(), GetFileExInfoStandard, &attributes)) {
+            source = CopyJournalSource(attributes.nFileSizeHigh, attributes.nFileSizeLow, attributes.ftLastWriteTime);
+            if (pJournal->partial(to, &partial, &qwOffset) &&
+                (partial.size != source.size || partial.lastWriteTime != source.lastWriteTime)) {
+                pJournal->clearPartial(to);
+                qwOffset = 0;
+            }
+        } else {
+            pJournal = NULL;
+        }
+
+        dwError = pCopier->copy(
+            from, to,
+            [&](uint64_t qwNow, uint64_t qwTotal) {
+                qwDone = qwNow;
+                if (fileProgress.pProgress)
+                    fileProgress.pProgress->updateFile(fileProgress.id, qwNow, qwTotal);
+                if (pJournal && qwNow < qwTotal && qwNow - qwRecorded >= JOURNAL_INTERVAL) {
+                    pJournal->recordPartial(to, source, qwNow);
+                    qwRecorded = qwNow;
+                }
+                return CopyJobCheckpoint(pCopyInfo) != FALSE;
+            },
+            bVerify && !qwOffset ? &sourceCrc : NULL, pJournal != NULL, qwOffset);
+        bSummed = dwError != ERROR_NOT_SUPPORTED && !qwOffset;
+
+        //
+        // Whatever a failed copy kept is noted, so it isn't written again.
+        //
+        if (pJournal && dwError && dwError != ERROR_NOT_SUPPORTED && dwError != ERROR_REQUEST_ABORTED &&
+            qwDone > qwRecorded) {
+            pJournal->recordPartial(to, source, qwDone);
+        }
+    }
+
+    if (dwError == ERROR_NOT_SUPPORTED) {
+        dwError = WFCopyFile(
+            from.c_str(), to.c_str(), CopyFileProgressRoutine, &fileProgress, &pCopyInfo->bUserAbort);
+    }
+
+    if (!dwError && bVerify) {
+        if (!bSummed)
+            dwError = pCopier->checksum(from, FALSE, &sourceCrc, keepGoing);
+        if (!dwError)
+            dwError = pCopier->checksum(to, TRUE, &destCrc, keepGoing);
+        if (!dwError && sourceCrc.value() != destCrc.value())
+            dwError = DE_VERIFYFAILED;
+    }
+
+    if (pCopyInfo->pProgress)
+        pCopyInfo->pProgress->endFile(fileProgress.id, dwError == 0);
+
+    return dwError;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyPipelineCollect
+//
+// Synopsis: Handles the copies the pipeline's workers have finished.
+//           New files are announced with ChangeFileSystem.  Failures get
+//           the same retry and error boxes as a file copied in line, and
+//           files to try again are queued again.  Runs on the copy thread.
+//
+// pPipeline      - Pipeline to collect from
+// pCopyInfo      - The operation; once it is aborted failures are dropped
+// pbErrorOccured - Set if the user skipped a failed file
+//
+// Return:   0 to carry on, else the code to end the whole operation with.
+//           The operation is then marked aborted and the pipeline's
+//           queued copies are dropped.
+//
+/////////////////////////////////////////////////////////////////////
+
+static DWORD CopyPipelineCollect(libwinfile::CopyPipeline* pPipeline, PCOPYINFO pCopyInfo, PBOOL pbErrorOccured) {
+    WCHAR szSource[MAXPATHLEN];
+    WCHAR szDest[MAXPATHLEN];
+    BOOL bErrorOnDest;
+    DWORD dwError;
+    DWORD dwResult = 0;
+    libwinfile::CopyJournal::Source partial;
+    uint64_t qwOffset;
+
+    for (const auto& result : pPipeline->takeFinished()) {
+        StrCpyN(szSource, result.from.c_str(), COUNTOF(szSource));
+        StrCpyN(szDest, result.to.c_str(), COUNTOF(szDest));
+        dwError = result.error;
+
+        //
+        // WFCopy knows how to copy to a print share, and how to copy a
+        // symlink the user isn't privileged to create.
+        //
+        if ((dwError == ERROR_INVALID_NAME || dwError == ERROR_PRIVILEGE_NOT_HELD) && !pCopyInfo->bUserAbort) {
+            dwError = WFCopy(szSource, szDest);
+        } else if (!dwError) {
+            ChangeFileSystem(FSC_CREATE, szDest, NULL);
+        }
+
+        if (!dwError && pCopyInfo->pJournal)
+            pCopyInfo->pJournal->recordDone(result.to);
+
+        if (!dwError || pCopyInfo->bUserAbort)
+            continue;
+
+        bErrorOnDest = FALSE;
+
+        if (((dwError == ERROR_DISK_FULL) && IsRemovableDrive(DRIVEID(szDest))) || (dwError == ERROR_PATH_NOT_FOUND)) {
+            SetFileAttributes(szDest, FILE_ATTRIBUTE_NORMAL);
+            DeleteFile(szDest);
+
+            dwError = CopyMoveRetry(szDest, dwError, &bErrorOnDest);
+            if (!dwError) {
+                pPipeline->enqueue(result.from, result.to, result.size);
+                continue;
+            }
+        }
+
+        if (dwError != DE_OPCANCELLED) {
+            dwError = CopyError(szSource, szDest, dwError, FUNC_COPY, OPER_DOFILE, bErrorOnDest, FALSE);
+
+            if (dwError == DE_RETRY) {
+                pPipeline->enqueue(result.from, result.to, result.size);
+                continue;
+            }
+            if (dwError == DE_OPCANCELLED) {
+                // Ignore: skip this file, and whatever part of it a
+                // journaled copy kept.
+                if (pCopyInfo->pJournal && pCopyInfo->pJournal->partial(result.to, &partial, &qwOffset)) {
+                    SetFileAttributes(szDest, FILE_ATTRIBUTE_NORMAL);
+                    DeleteFile(szDest);
+                }
+                *pbErrorOccured = TRUE;
+                continue;
+            }
+        }
+
+        pCopyInfo->bUserAbort = TRUE;
+        pPipeline->cancel();
+        dwResult = dwError;
+    }
+
+    return dwResult;
+}
+
 /////////////////////////////////////////////////////////////////////
 //
 // Name:     WFMoveCopyDriverThread
@@ -1729,6 +2389,7 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
     WCHAR szTemp[MAXPATHLEN];
 
     WCHAR szSource[MAXPATHLEN];   // Source file (ANSI string)
+    WCHAR szKept[MAXPATHLEN];     // Tree DeleteTreeWhole left things in
     LFNDTA DTADest;               // DTA block for reporting dest errors
     PLFNDTA pDTA = NULL;          // DTA pointer for source errors
     PCOPYROOT pcr;                // Structure for searching source tree
@@ -1754,14 +2415,21 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
 
     BOOL bConfirmed;
     BOOL bFatalError = FALSE;
+    BOOL bGone;
     BOOL bErrorOccured = FALSE;
 
+    libwinfile::CopyPipeline* pPipeline = NULL;  // Copies files for FUNC_COPY
+    libwinfile::MovePlanner movePlanner;          // Renames what it can for FUNC_MOVE
+    HANDLE hThreadScan = NULL;                    // Counts them for pProgress
+
+    hdlgProgress = pCopyInfo->hDlg;
+
     // Initialization stuff.  Disable all file system change processing until
     // we're all done
 
     SwitchToSafeDrive();
 
-    szDest[0] = szSource[0] = CHAR_NULL;
+    szDest[0] = szSource[0] = szKept[0] = CHAR_NULL;
     SendMessage(hwndFrame, FS_DISABLEFSC, 0, 0L);
 
     //
@@ -1777,7 +2445,7 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
     //
     // Allocate buffer for searching the source tree
     //
-    pcr = (PCOPYROOT)LocalAlloc(LPTR, sizeof(COPYROOT));
+    pcr = new (std::nothrow) COPYROOT();
     if (!pcr) {
         ret = DE_INSMEM;
         goto ShowMessageBox;
@@ -1852,14 +2520,51 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
     }
     pcr->pSource = pCopyInfo->pFrom;
 
+    //
+    // Wait for the operations ahead of this one on the same disks.
+    //
+    if (CopyJobQueue().state(pCopyInfo->jobId) == libwinfile::CopyQueue::State::Queued) {
+        LoadString(hAppInstance, IDS_COPYWAITING, szTemp, COUNTOF(szTemp));
+        SetDlgItemText(hdlgProgress, IDD_MYTEXT, szTemp);
+    }
+    if (!CopyJobQueue().waitTurn(pCopyInfo->jobId))
+        goto CancelWholeOperation;
+
+    //
+    // Copy files on a pool of workers while this thread walks the source
+    // tree, creates the directories and asks about conflicts.  If the pool
+    // can't be started, copy them one at a time.
+    //
+    if (pCopyInfo->dwFunc == FUNC_COPY) {
+        try {
+            pPipeline = new libwinfile::CopyPipeline(
+                COPY_THREADS,
+                [pCopyInfo, copier = libwinfile::UnbufferedCopier(uCopyBufferKB * 1024), bVerify = bVerifyCopies](
+                    const std::wstring& from, const std::wstring& to, uint64_t size) {
+                    return (uint32_t)CopyPipelineCopyFile(pCopyInfo, &copier, from, to, size, bVerify);
+                });
+        } catch (...) {
+            pPipeline = NULL;
+        }
+    }
+
+    if (pCopyInfo->pProgress) {
+        DWORD dwIgnore;
+
+        hThreadScan = CreateThread(NULL, 0L, CopyScanThread, pCopyInfo, 0L, &dwIgnore);
+    }
+
     //
     // Set up arguments for queued copy commands
     //
 
     while (pcr) {
-        // Allow the user to abort the operation
+        // Allow the user to pause or abort the operation
 
-        if (pCopyInfo->bUserAbort)
+        if (!CopyJobCheckpoint(pCopyInfo))
+            goto CancelWholeOperation;
+
+        if (pPipeline && (ret = CopyPipelineCollect(pPipeline, pCopyInfo, &bErrorOccured)))
             goto CancelWholeOperation;
 
         // Clean off the last filespec for multiple file copies
@@ -1875,7 +2580,7 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
         // Check for no operation or error
 
         if (!oper) {
-            LocalFree((HANDLE)pcr);
+            delete pcr;
             pcr = NULL;
             break;
         }
@@ -1977,6 +2682,13 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
                 goto ShowMessageBox;
             }
 
+            //
+            // A queued copy to the same name (from a search window selection,
+            // say) must land before we look at what is there.
+            //
+            if (pPipeline)
+                pPipeline->waitFor(szDest);
+
             //
             // Check to see if we are overwriting an existing file.  If so,
             // better confirm.
@@ -2009,6 +2721,29 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
                         goto ShowMessageBox;
                     }
 
+                    //
+                    // A resumed copy leaves alone the files it already
+                    // copied, and carries on with one it was part way
+                    // through without asking.
+                    //
+                    if (pCopyInfo->pJournal && pCopyInfo->dwFunc == FUNC_COPY) {
+                        switch (CopyJournalCheck(pCopyInfo->pJournal, szDest, &pDTA->fd, &DTADest.fd)) {
+                            case JOURNAL_DONE:
+                                if (pCopyInfo->pProgress) {
+                                    pCopyInfo->pProgress->skip(
+                                        1, ((uint64_t)pDTA->fd.nFileSizeHigh << 32) | pDTA->fd.nFileSizeLow);
+                                }
+                                continue;
+
+                            case JOURNAL_PARTIAL:
+                                bConfirmed = TRUE;
+                                break;
+
+                            default:
+                                break;
+                        }
+                    }
+
                     if (pCopyInfo->dwFunc == FUNC_RENAME) {
                         ret = DE_RENAMREPLACE;
                         goto ShowMessageBox;
@@ -2100,6 +2835,10 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
 
                             // Don't perform operation on current file
 
+                            if (pCopyInfo->pProgress) {
+                                pCopyInfo->pProgress->skip(
+                                    1, ((uint64_t)pDTA->fd.nFileSizeHigh << 32) | pDTA->fd.nFileSizeLow);
+                            }
                             continue;
 
                         case IDCANCEL:
@@ -2123,23 +2862,21 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
                 Notify(hdlgProgress, IDS_CREATINGMSG, szDest, kEmptyString);
 
                 if (pCopyInfo->dwFunc == FUNC_MOVE) {
-                    if ((CHAR_COLON == pcr->sz[1]) && (CHAR_COLON == szDest[1]) &&
-                        (DRIVEID(pcr->sz) == DRIVEID(szDest))) {
-                        //
-                        // Warning: This will not work on winball drives!
-                        // There is a problem here: if this is winball,
-                        // then we get an ERROR_ACCESS_DENIED when we try to do
-                        // the fastmove.  We could continue normally with the
-                        // slowmove.  However, in the case of moving NTFS directories,
-                        // we may get ERROR_ACCESS_DENIED because we don't have
-                        // write permission on the directory.  In this case, we
-                        // want to ignore the entire directory.
-                        //
-                        // For now, this works because DTAFast.err is neither
-                        // ERROR_PATH_NOT_FOUND ERROR_FILE_NOT_FOUND, do we're
-                        // ok by accident.
-                        //
-
+                    //
+                    // On one volume, with nothing in the way, one rename moves
+                    // the whole subtree.  Where the destination already has
+                    // the directory it is merged: created (it is there) and
+                    // walked, each entry in it decided the same way.  Only
+                    // across volumes is it walked to be copied and deleted.
+                    //
+                    // Volumes are told by their GUIDs, so this also works
+                    // for shares and for volumes mounted in folders.
+                    //
+                    // If the rename fails anyway, ERROR_ACCESS_DENIED without
+                    // write permission on an NTFS directory say, DoMove goes
+                    // back to DoMkDir and the directory is walked.
+                    //
+                    if (movePlanner.decide(szSource, szDest) == libwinfile::MovePlanner::Action::Rename) {
                         pcr->bFastMove = TRUE;
                         goto DoMove;
                     }
@@ -2214,7 +2951,7 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
                 }
 
                 // Don't follow a reparse point in the source. Stop recursion of GetNextPair for this entry
-                pcr->cDepth = 0;
+                GetNextCleanup(pcr);
 
                 if (ret != ERROR_SUCCESS)
                     bErrorOnDest = TRUE;
@@ -2231,25 +2968,81 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
                 if (IsRootDirectory(szSource))
                     break;
 
-                if (bConfirmed)
-                    break;
+                if (!bConfirmed) {
+                    dwResponse = ConfirmDialog(
+                        hdlgProgress, CONFIRMRMDIR, NULL, pDTA, szSource, NULL, bConfirmSubDel, &bSubtreeDelAll,
+                        bConfirmReadOnly, &bSubtreeDelReadOnlyAll);
+
+                    switch (dwResponse) {
+                        case IDYES:
+                            break;
 
-                dwResponse = ConfirmDialog(
-                    hdlgProgress, CONFIRMRMDIR, NULL, pDTA, szSource, NULL, bConfirmSubDel, &bSubtreeDelAll,
-                    bConfirmReadOnly, &bSubtreeDelReadOnlyAll);
+                        case IDNO:
+                        case IDCANCEL:
+                            goto CancelWholeOperation;
 
-                switch (dwResponse) {
-                    case IDYES:
+                        default:
+                            ret = dwResponse;
+                            goto ShowMessageBox;
+                    }
+                }
+
+                //
+                // Once nothing in the tree would be asked about, delete it
+                // whole instead of walking it.  Read-only, hidden and system
+                // entries that would still be asked about are left for the
+                // walk; the recycle bin can't leave them, so it waits until
+                // they are settled too.  The walk then finds only what was
+                // left, and doesn't hand it back here.
+                //
+                if ((bConfirmSubDel && !bSubtreeDelAll) || (bConfirmDelete && !bDeleteAll))
+                    break;
+
+                dwAttr = 0;
+                if (!(((!bConfirmReadOnly && !bConfirmSubDel) || bSubtreeDelReadOnlyAll) &&
+                      ((!bConfirmReadOnly && !bConfirmDelete) || bDeleteReadOnlyAll))) {
+                    if (!pCopyInfo->bPermanent)
                         break;
+                    dwAttr = ATTR_READONLY | ATTR_HIDDEN | ATTR_SYSTEM;
+                }
 
-                    case IDNO:
-                    case IDCANCEL:
-                        goto CancelWholeOperation;
+                if (szKept[0] && !StrCmpNI(szSource, szKept, lstrlen(szKept)) &&
+                    szSource[lstrlen(szKept)] == CHAR_BACKSLASH)
+                    break;
 
-                    default:
-                        ret = dwResponse;
-                        goto ShowMessageBox;
+                if (IsCurrentDirectory(szSource))
+                    CdDotDot(szSource);
+
+                ret = DeleteTreeWhole(pCopyInfo, szSource, dwAttr, &bGone);
+                if (ret == DE_OPCANCELLED)
+                    goto CancelWholeOperation;
+
+                if (bGone)
+                    pcr->bFastMove = TRUE;
+                else
+                    lstrcpy(szKept, szSource);
+
+                //
+                // An error is reported as failing to remove the directory.
+                // If the user goes on, the walk deletes what was left a
+                // file at a time.
+                //
+                if (ret) {
+                    switch (CopyError(szSource, szDest, ret, pCopyInfo->dwFunc, OPER_RMDIR, FALSE, FALSE)) {
+                        case DE_RETRY:
+                            bConfirmed = TRUE;
+                            goto TRY_COPY_AGAIN;
+
+                        case DE_OPCANCELLED:
+                            bErrorOccured = TRUE;
+                            ret = 0;
+                            break;
+
+                        default:
+                            goto CancelWholeOperation;
+                    }
                 }
+
                 break;
 
             case OPER_RMDIR | FUNC_MOVE:
@@ -2267,14 +3060,14 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
                 // to delete the directory
                 //
 
-                if (pCopyInfo->dwFunc == FUNC_DELETE) {
+                if (pCopyInfo->dwFunc == FUNC_DELETE && !pCopyInfo->bPermanent) {
                     // For delete operations, send the entire directory to recycle bin
                     // instead of permanently deleting it
                     ret = MoveFileToRecycleBin(szSource);
                     if (ret == 0)
                         ChangeFileSystem(FSC_RMDIR, szSource, NULL);
                 } else {
-                    // For move operations, use the original logic
+                    // For move operations and permanent deletes, use the original logic
                     //
                     // Tuck away the attribs in case we fail.
                     //
@@ -2319,6 +3112,18 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
                     break;
                 }
 
+                //
+                // The directory is there and any conflict has been settled,
+                // so the copy itself can wait for a worker.  Failures come
+                // back through CopyPipelineCollect.
+                //
+                if (pPipeline && pCopyInfo->dwFunc == FUNC_COPY) {
+                    Notify(hdlgProgress, IDS_COPYINGMSG, szSource, szDest);
+                    pPipeline->enqueue(
+                        szSource, szDest, ((uint64_t)pDTA->fd.nFileSizeHigh << 32) | pDTA->fd.nFileSizeLow);
+                    break;
+                }
+
                 //
                 // Now try to process the file.  Do extra error processing only
                 //      in 2 cases:
@@ -2336,6 +3141,8 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
                 switch (pCopyInfo->dwFunc) {
                     case FUNC_COPY:
                         ret = WFCopy(szSource, szDest);
+                        if (!ret && pCopyInfo->pJournal)
+                            pCopyInfo->pJournal->recordDone(szDest);
                         break;
 
                     case FUNC_LINK:
@@ -2558,7 +3365,10 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
                 // make sure we don't delete any open windows
                 // apps or dlls (lets hope this isn't too slow)
 
-                ret = SafeFileRemove(szSource);
+                if (pCopyInfo->bPermanent)
+                    ret = SafeFileDelete(szSource);
+                else
+                    ret = SafeFileRemove(szSource);
 
                 //
                 //  Reset the file attributes, since ConfirmDialog may have
@@ -2632,6 +3442,32 @@ WFMoveCopyDriverThread(LPVOID lpParameter) {
 
 ExitLoop:
 
+    //
+    // Wait for the copies still queued, reporting failures and queuing
+    // retries until none are left.  After an abort only the copies already
+    // running are waited for.
+    //
+    if (pPipeline) {
+        DWORD dwError;
+
+        do {
+            if (pCopyInfo->bUserAbort)
+                pPipeline->cancel();
+
+            pPipeline->drain();
+
+            if (dwError = CopyPipelineCollect(pPipeline, pCopyInfo, &bErrorOccured))
+                ret = dwError;
+        } while (pPipeline->busy());
+
+        delete pPipeline;
+    }
+
+    if (hThreadScan) {
+        WaitForSingleObject(hThreadScan, INFINITE);
+        CloseHandle(hThreadScan);
+    }
+
     // Copy any outstanding files in the copy queue
 
     // this happens in error cases where we broke out of the pcr loop
@@ -2639,7 +3475,7 @@ ExitLoop:
 
     if (pcr) {
         GetNextCleanup(pcr);
-        LocalFree((HANDLE)pcr);
+        delete pcr;
     }
 
     //
@@ -2666,8 +3502,21 @@ ExitLoop:
 
     NotifyResume(-1, (UINT)-1);
 
+    CopyJobQueue().finish(pCopyInfo->jobId);
+
+    //
+    // The journal is kept after a copy that failed, so it can be resumed,
+    // but not after one that finished or that the user cancelled.
+    //
+    if (pCopyInfo->pJournal) {
+        if (!ret || ret == DE_OPCANCELLED)
+            pCopyInfo->pJournal->remove();
+        delete pCopyInfo->pJournal;
+    }
+
     SendMessage(hdlgProgress, FS_COPYDONE, ret, (LPARAM)pCopyInfo);
 
+    delete pCopyInfo->pProgress;
     LocalFree(pCopyInfo->pFrom);
     LocalFree(pCopyInfo->pTo);
     LocalFree(pCopyInfo);
@@ -2675,6 +3524,29 @@ ExitLoop:
     return 0;
 }
 
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CopyJobStart
+//
+// Synopsis: Opens a modeless progress window for pCopyInfo, which starts
+//           the job and owns pCopyInfo from then on.  The job runs while
+//           the user goes on working, and alongside any others.
+//
+// Return:   0, or the error that kept the window from opening.
+//
+/////////////////////////////////////////////////////////////////////
+
+static DWORD CopyJobStart(PCOPYINFO pCopyInfo) {
+    HWND hDlg = CreateDialogParam(
+        hAppInstance, (LPWSTR)MAKEINTRESOURCE(DMSTATUSDLG), hwndFrame, ProgressDlgProc, (LPARAM)pCopyInfo);
+
+    if (!hDlg)
+        return GetLastError();
+
+    ShowWindow(hDlg, SW_SHOW);
+    return 0;
+}
+
 //--------------------------------------------------------------------------*/
 //
 //  DMMoveCopyHelper() -
@@ -2685,7 +3557,6 @@ ExitLoop:
 
 DWORD
 DMMoveCopyHelper(LPWSTR pFrom, LPWSTR pTo, int iOperation) {
-    DWORD dwStatus;
     LPWSTR pTemp;
     PCOPYINFO pCopyInfo;
 
@@ -2797,10 +3668,109 @@ DMMoveCopyHelper(LPWSTR pFrom, LPWSTR pTo, int iOperation) {
     lstrcpy(pCopyInfo->pFrom, pFrom);
     lstrcpy(pCopyInfo->pTo, pTo);
 
-    dwStatus = (DWORD)DialogBoxParam(
-        hAppInstance, (LPWSTR)MAKEINTRESOURCE(DMSTATUSDLG), hwndFrame, ProgressDlgProc, (LPARAM)pCopyInfo);
+    return CopyJobStart(pCopyInfo);
+}
 
-    return dwStatus;
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     ResumeCopyJobs
+//
+// Synopsis: Offers to resume each copy whose journal was left behind by
+//           a session that ended, or a network that dropped, part way
+//           through.  A resumed copy runs again from the same sources to
+//           the same destination with its journal, so the files it
+//           finished are skipped and a huge file it was part way
+//           through is carried on with.  Declining gives the copy up,
+//           deleting the partial files it left.
+//
+//           Journals still open in another window of ours are left to it.
+//
+/////////////////////////////////////////////////////////////////////
+
+VOID ResumeCopyJobs() {
+    std::wstring dir = GetCopyJournalDir();
+    WCHAR szFrom[MAX_PATH];
+    WCHAR szTo[MAX_PATH];
+    WCHAR szFormat[MAXMESSAGELEN];
+    libwinfile::CopyJournal* pJournal;
+    PCOPYINFO pCopyInfo;
+    HANDLE hFile;
+
+    if (dir.empty())
+        return;
+
+    for (const auto& path : libwinfile::CopyJournal::list(dir)) {
+        hFile = CreateFile(path.c_str(), GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            continue;
+        CloseHandle(hFile);
+
+        try {
+            pJournal = new libwinfile::CopyJournal(path);
+        } catch (const std::bad_alloc&) {
+            return;
+        } catch (const std::exception&) {
+            DeleteFile(path.c_str());
+            continue;
+        }
+
+        //
+        // The sources can be a long list; the start of it is enough to
+        // tell which copy this was.
+        //
+        StrCpyN(szFrom, pJournal->from().c_str(), COUNTOF(szFrom) - COUNTOF(kEllipses));
+        if (pJournal->from().size() >= COUNTOF(szFrom) - COUNTOF(kEllipses))
+            lstrcat(szFrom, kEllipses);
+        StrCpyN(szTo, pJournal->to().c_str(), COUNTOF(szTo) - COUNTOF(kEllipses));
+        if (pJournal->to().size() >= COUNTOF(szTo) - COUNTOF(kEllipses))
+            lstrcat(szTo, kEllipses);
+
+        LoadString(hAppInstance, IDS_RESUMECOPYTITLE, szTitle, COUNTOF(szTitle));
+        LoadString(hAppInstance, IDS_RESUMECOPY, szFormat, COUNTOF(szFormat));
+        wsprintf(szMessage, szFormat, szFrom, szTo);
+
+        switch (MessageBox(hwndFrame, szMessage, szTitle, MB_YESNOCANCEL | MB_ICONQUESTION)) {
+            case IDYES:
+                pCopyInfo = (PCOPYINFO)LocalAlloc(LPTR, sizeof(COPYINFO));
+                if (pCopyInfo) {
+                    pCopyInfo->pFrom = (LPWSTR)LocalAlloc(LMEM_FIXED, ByteCountOf(pJournal->from().size() + 1));
+                    pCopyInfo->pTo = (LPWSTR)LocalAlloc(LMEM_FIXED, ByteCountOf(pJournal->to().size() + 1));
+                }
+                if (!pCopyInfo || !pCopyInfo->pFrom || !pCopyInfo->pTo) {
+                    if (pCopyInfo) {
+                        if (pCopyInfo->pFrom)
+                            LocalFree(pCopyInfo->pFrom);
+                        if (pCopyInfo->pTo)
+                            LocalFree(pCopyInfo->pTo);
+                        LocalFree(pCopyInfo);
+                    }
+                    delete pJournal;
+                    return;
+                }
+
+                lstrcpy(pCopyInfo->pFrom, pJournal->from().c_str());
+                lstrcpy(pCopyInfo->pTo, pJournal->to().c_str());
+                pCopyInfo->dwFunc = FUNC_COPY;
+                pCopyInfo->bUserAbort = FALSE;
+                pCopyInfo->pJournal = pJournal;
+
+                CopyJobStart(pCopyInfo);
+                break;
+
+            case IDNO:
+                for (const auto& dest : pJournal->partialDestinations()) {
+                    SetFileAttributes(dest.c_str(), FILE_ATTRIBUTE_NORMAL);
+                    DeleteFile(dest.c_str());
+                }
+                pJournal->remove();
+                delete pJournal;
+                break;
+
+            default:
+                delete pJournal;
+                break;
+        }
+    }
 }
 
 DWORD
@@ -29,9 +29,6 @@
 #define OPER_DOFILE 0x0300
 #define OPER_ERROR 0x0400
 
-#define CCHPATHMAX 260
-#define MAXDIRDEPTH CCHPATHMAX / 2
-
 #define ATTR_ATTRIBS 0x200 /* Flag indicating we have file attributes */
 #define ATTR_COPIED 0x400  /* we have copied this file */
 #define ATTR_DELSRC 0x800  /* delete the source when done */
@@ -39,13 +36,16 @@
 typedef struct _copyroot {
     BOOL fRecurse : 1;
     BOOL bFastMove : 1;
-    WORD cDepth;
+    BOOL bWalking : 1;  // walker is walking the current source
+    BOOL bDescend : 1;  // the directory returned last is to be walked into
     LPWSTR pSource;
     LPWSTR pRoot;
     WCHAR cIsDiskThereCheck[26];
     WCHAR sz[MAXPATHLEN];
     WCHAR szDest[MAXPATHLEN];
-    LFNDTA rgDTA[MAXDIRDEPTH];
+    libwinfile::TreeWalker walker;
+    LFNDTA dta;      // the entry returned last
+    LFNDTA dtaRoot;  // the directory walked, returned again once it is done
 } COPYROOT, *PCOPYROOT;
 
 DWORD FileMove(LPWSTR, LPWSTR, PBOOL, BOOL);
@@ -63,6 +63,9 @@ LPWSTR FindFileName(LPWSTR pPath);
 DWORD DMMoveCopyHelper(LPWSTR pFrom, LPWSTR pTo, int iOperation);
 DWORD WFMoveCopyDriver(PCOPYINFO pCopyInfo);
 DWORD WINAPI WFMoveCopyDriverThread(LPVOID lpParameter);
+VOID ResumeCopyJobs();
+libwinfile::CopyQueue& CopyJobQueue();
+void CopyJobsWait();
 
 BOOL IsDirectory(LPWSTR pPath);
 BOOL IsTheDiskReallyThere(HWND hwnd, LPWSTR pPath, DWORD wFunc, BOOL bModal);
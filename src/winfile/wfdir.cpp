@@ -25,6 +25,7 @@
 #include "wfdirsrc.h"
 #include "wftree.h"
 #include "stringconstants.h"
+#include "libwinfile/PathCache.h"
 #include <commctrl.h>
 
 // Constants for selection types passed to DirGetSelection
@@ -3067,3 +3068,405 @@ BOOL SetDirFocus(HWND hwndDir) {
     } else
         return TRUE;
 }
+
+//
+// State for applying a batch of change notifications to a directory
+// listing in place.  Entries are found by name through byName, whose
+// values follow the entries when a removal compacts their link.
+//
+typedef struct tagDIRPATCH {
+    HWND hwndDir;
+    HWND hwndLB;
+    HWND hwndListParms;
+    LPXDTALINK lpStart;
+    DWORD dwSort;
+    BOOL bCasePreserved;
+    BOOL bAdded;
+    WCHAR szPath[MAXPATHLEN];  // directory and filespec, as read
+    LPWSTR pSpec;              // filespec part of szPath
+    std::unordered_map<std::wstring, LPXDTA> byName;
+} DIRPATCH;
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     DirPatchBegin
+//
+// Synopsis: Starts applying changes to a directory window's listing
+//
+// IN        hwndDir  directory window
+//
+// Return:   PDIRPATCH for DirPatchApply and DirPatchEnd, NULL if the
+//           listing can't be patched now (still reading, empty,
+//           showing an error) and must be read again instead
+//
+// Notes:    Main thread only.
+//
+/////////////////////////////////////////////////////////////////////
+
+PDIRPATCH
+DirPatchBegin(HWND hwndDir) {
+    LPXDTALINK lpStart;
+    LPXDTAHEAD lpHead;
+    PDIRPATCH pPatch;
+    LPXDTA lpxdta;
+    DWORD i;
+
+    lpStart = (LPXDTALINK)GetWindowLongPtr(hwndDir, GWL_HDTA);
+
+    if (!lpStart || GetWindowLongPtr(hwndDir, GWL_IERROR))
+        return NULL;
+
+    lpHead = MemLinkToHead(lpStart);
+
+    if ((lpHead->fdwStatus & LPXDTA_STATUS_READING) || !lpHead->alpxdtaSorted || !lpHead->dwEntries)
+        return NULL;
+
+    pPatch = new DIRPATCH();
+
+    pPatch->hwndDir = hwndDir;
+    pPatch->hwndLB = GetDlgItem(hwndDir, IDCW_LISTBOX);
+    pPatch->hwndListParms = (HWND)GetWindowLongPtr(hwndDir, GWL_LISTPARMS);
+    pPatch->lpStart = lpStart;
+    pPatch->dwSort = (DWORD)GetWindowLongPtr(pPatch->hwndListParms, GWL_SORT);
+    pPatch->bAdded = FALSE;
+
+    //
+    // The listbox must show exactly the sorted entries, one for one.
+    //
+    if ((DWORD)SendMessage(pPatch->hwndLB, LB_GETCOUNT, 0, 0L) != lpHead->dwEntries)
+        goto Fail;
+
+    GetMDIWindowText(pPatch->hwndListParms, pPatch->szPath, COUNTOF(pPatch->szPath));
+
+    pPatch->pSpec = StrRChr(pPatch->szPath, NULL, CHAR_BACKSLASH);
+    if (!pPatch->pSpec)
+        goto Fail;
+
+    pPatch->pSpec++;
+    pPatch->bCasePreserved = IsCasePreservedDrive(DRIVEID(pPatch->szPath));
+
+    pPatch->byName.reserve(lpHead->dwEntries);
+
+    for (i = 0; i < lpHead->dwEntries; i++) {
+        lpxdta = lpHead->alpxdtaSorted[i];
+        if (!(lpxdta->dwAttrs & ATTR_PARENT))
+            pPatch->byName[libwinfile::pathKey(MemGetFileName(lpxdta))] = lpxdta;
+    }
+
+    return pPatch;
+
+Fail:
+    delete pPatch;
+    return NULL;
+}
+
+//
+// Index of lpxdta in the sorted array, which is also its listbox index.
+//
+static DWORD DirPatchIndexOf(PDIRPATCH pPatch, LPXDTA lpxdta) {
+    LPXDTAHEAD lpHead = MemLinkToHead(pPatch->lpStart);
+    DWORD i;
+
+    for (i = 0; i < lpHead->dwEntries && lpHead->alpxdtaSorted[i] != lpxdta; i++)
+        ;
+
+    return i;
+}
+
+//
+// Where lpxdta belongs among the first dwCount sorted entries.
+//
+static DWORD DirPatchFindPosition(PDIRPATCH pPatch, LPXDTA lpxdta, DWORD dwCount) {
+    LPXDTA* alpxdta = MemLinkToHead(pPatch->lpStart)->alpxdtaSorted;
+    DWORD dwMin = 0;
+    DWORD dwMax = dwCount;
+    DWORD dwMid;
+
+    while (dwMin < dwMax) {
+        dwMid = (dwMin + dwMax) / 2;
+        if (CompareDTA(lpxdta, alpxdta[dwMid], pPatch->dwSort) > 0)
+            dwMin = dwMid + 1;
+        else
+            dwMax = dwMid;
+    }
+
+    return dwMin;
+}
+
+//
+// Inserts lpxdta, which is counted in dwEntries but not yet in the
+// sorted array, at its sorted place and in the listbox to match.
+//
+static void DirPatchInsertSorted(PDIRPATCH pPatch, LPXDTA lpxdta) {
+    LPXDTAHEAD lpHead = MemLinkToHead(pPatch->lpStart);
+    DWORD dwCount = lpHead->dwEntries - 1;
+    DWORD dwPos = DirPatchFindPosition(pPatch, lpxdta, dwCount);
+
+    memmove(&lpHead->alpxdtaSorted[dwPos + 1], &lpHead->alpxdtaSorted[dwPos], (dwCount - dwPos) * sizeof(LPXDTA));
+    lpHead->alpxdtaSorted[dwPos] = lpxdta;
+
+    SendMessage(pPatch->hwndLB, LB_INSERTSTRING, dwPos, (LPARAM)lpxdta);
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     DirPatchRemove
+//
+// Synopsis: Removes one entry from the listing and from its DTA block
+//
+// Return:   FALSE if the entry can't be removed in place; nothing has
+//           been changed in that case
+//
+// Notes:    The entry's link is compacted, so entries after it in the
+//           same link move; their sorted array, listbox and byName
+//           pointers are updated.  A later link that becomes empty is
+//           freed so that MemNext never walks into it.
+//
+/////////////////////////////////////////////////////////////////////
+
+static BOOL DirPatchRemove(PDIRPATCH pPatch, LPXDTA lpxdta) {
+    LPXDTAHEAD lpHead = MemLinkToHead(pPatch->lpStart);
+    LPXDTALINK lpLink, lpPrev;
+    PBYTE pFirst, pEnd;
+    DWORD cb, dwIndex, i;
+    BOOL bEmpties;
+    LPXDTA lpMoved;
+
+    //
+    // Leave the last entry to a full read, which shows "no files".
+    //
+    if (lpHead->dwEntries <= 1)
+        return FALSE;
+
+    lpPrev = NULL;
+    for (lpLink = pPatch->lpStart; lpLink; lpPrev = lpLink, lpLink = lpLink->next) {
+        if ((PBYTE)lpxdta >= (PBYTE)lpLink && (PBYTE)lpxdta < (PBYTE)lpLink + lpLink->dwNextFree)
+            break;
+    }
+
+    if (!lpLink)
+        return FALSE;
+
+    cb = lpxdta->dwSize;
+    pFirst = lpPrev ? (PBYTE)lpLink + sizeof(XDTALINK) : (PBYTE)MemFirst(lpLink);
+    pEnd = (PBYTE)lpLink + lpLink->dwNextFree;
+    bEmpties = (PBYTE)lpxdta == pFirst && (PBYTE)lpxdta + cb == pEnd;
+
+    //
+    // The first link holds the head; it can't be unlinked.
+    //
+    if (bEmpties && !lpPrev && lpLink->next)
+        return FALSE;
+
+    dwIndex = DirPatchIndexOf(pPatch, lpxdta);
+    if (dwIndex == lpHead->dwEntries)
+        return FALSE;
+
+    SendMessage(pPatch->hwndLB, LB_DELETESTRING, dwIndex, 0L);
+
+    memmove(
+        &lpHead->alpxdtaSorted[dwIndex], &lpHead->alpxdtaSorted[dwIndex + 1],
+        (lpHead->dwEntries - dwIndex - 1) * sizeof(LPXDTA));
+
+    pPatch->byName.erase(libwinfile::pathKey(MemGetFileName(lpxdta)));
+
+    lpHead->dwEntries--;
+    lpHead->dwTotalCount--;
+    lpHead->qTotalSize.QuadPart -= lpxdta->qFileSize.QuadPart;
+
+    if (bEmpties && lpPrev) {
+        lpPrev->next = lpLink->next;
+        LocalFree((HLOCAL)lpLink);
+        return TRUE;
+    }
+
+    memmove(lpxdta, (PBYTE)lpxdta + cb, pEnd - ((PBYTE)lpxdta + cb));
+    lpLink->dwNextFree -= cb;
+
+    for (i = 0; i < lpHead->dwEntries; i++) {
+        lpMoved = lpHead->alpxdtaSorted[i];
+
+        if ((PBYTE)lpMoved > (PBYTE)lpxdta && (PBYTE)lpMoved < pEnd) {
+            lpMoved = (LPXDTA)((PBYTE)lpMoved - cb);
+            lpHead->alpxdtaSorted[i] = lpMoved;
+
+            SendMessage(pPatch->hwndLB, LB_SETITEMDATA, i, (LPARAM)lpMoved);
+
+            if (!(lpMoved->dwAttrs & ATTR_PARENT))
+                pPatch->byName[libwinfile::pathKey(MemGetFileName(lpMoved))] = lpMoved;
+        }
+    }
+
+    return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     DirPatchApply
+//
+// Synopsis: Brings one name in the listing up to date
+//
+// IN        pPatch    from DirPatchBegin
+// IN        szName    file name within the directory
+// IN        bRemoved  the notification said the name is gone
+// OUT       pdwAttrs  attributes of the file now on disk,
+//                     INVALID_FILE_ATTRIBUTES if there is none
+//
+// Return:   FALSE if the listing must be read again instead
+//
+// Notes:    Anything not removed is looked up on disk, since by the
+//           time the notification is handled it may be gone again.
+//           A changed entry keeps its place and selection unless its
+//           sort position or its attributes changed.
+//
+/////////////////////////////////////////////////////////////////////
+
+BOOL DirPatchApply(PDIRPATCH pPatch, LPCWSTR szName, BOOL bRemoved, LPDWORD pdwAttrs) {
+    LPXDTAHEAD lpHead = MemLinkToHead(pPatch->lpStart);
+    WCHAR szFile[MAXPATHLEN];
+    LFNDTA lfndta;
+    LPXDTALINK lpLinkLast;
+    LPXDTA lpxdta;
+    LPXDTA* alpxdtaSorted;
+    DWORD dwIndex;
+    BOOL bFound;
+    BOOL bSelected;
+
+    *pdwAttrs = INVALID_FILE_ATTRIBUTES;
+
+    auto it = pPatch->byName.find(libwinfile::pathKey(szName));
+    lpxdta = it == pPatch->byName.end() ? NULL : it->second;
+
+    bFound = FALSE;
+
+    if (!bRemoved) {
+        if ((int)(pPatch->pSpec - pPatch->szPath) + lstrlen(szName) >= (int)COUNTOF(szFile))
+            return FALSE;
+
+        lstrcpyn(szFile, pPatch->szPath, (int)(pPatch->pSpec - pPatch->szPath) + 1);
+        lstrcat(szFile, szName);
+
+        if (WFFindFirst(&lfndta, szFile, ATTR_ALL)) {
+            WFFindClose(&lfndta);
+
+            lfndta.fd.dwFileAttributes &= (ATTR_USED | ATTR_JUNCTION | ATTR_SYMBOLIC);
+            *pdwAttrs = lfndta.fd.dwFileAttributes;
+
+            if ((lfndta.fd.dwFileAttributes & ATTR_DIR) && ISDOTDIR(lfndta.fd.cFileName))
+                return TRUE;
+
+            bFound = PathMatchSpec(lfndta.fd.cFileName, pPatch->pSpec) ||
+                (lfndta.fd.cAlternateFileName[0] && PathMatchSpec(lfndta.fd.cAlternateFileName, pPatch->pSpec));
+
+        } else if (
+            lfndta.err != ERROR_FILE_NOT_FOUND && lfndta.err != ERROR_PATH_NOT_FOUND &&
+            lfndta.err != ERROR_NO_MORE_FILES) {
+            return FALSE;
+        }
+    }
+
+    if (!bFound)
+        return lpxdta ? DirPatchRemove(pPatch, lpxdta) : TRUE;
+
+    if (lpxdta) {
+        if (!lstrcmp(MemGetFileName(lpxdta), lfndta.fd.cFileName) &&
+            !lstrcmp(MemGetAlternateFileName(lpxdta), lfndta.fd.cAlternateFileName) &&
+            (lpxdta->dwAttrs & (ATTR_USED | ATTR_JUNCTION | ATTR_SYMBOLIC)) == lfndta.fd.dwFileAttributes) {
+            //
+            // Same name and attributes: update the entry where it is.
+            //
+            lpHead->qTotalSize.QuadPart -= lpxdta->qFileSize.QuadPart;
+
+            lpxdta->ftLastWriteTime = lfndta.fd.ftLastWriteTime;
+            lpxdta->qFileSize.LowPart = lfndta.fd.nFileSizeLow;
+            lpxdta->qFileSize.HighPart = lfndta.fd.nFileSizeHigh;
+
+            lpHead->qTotalSize.QuadPart += lpxdta->qFileSize.QuadPart;
+
+            dwIndex = DirPatchIndexOf(pPatch, lpxdta);
+            if (dwIndex == lpHead->dwEntries)
+                return FALSE;
+
+            alpxdtaSorted = lpHead->alpxdtaSorted;
+
+            if ((dwIndex > 0 && CompareDTA(alpxdtaSorted[dwIndex - 1], lpxdta, pPatch->dwSort) > 0) ||
+                (dwIndex + 1 < lpHead->dwEntries &&
+                 CompareDTA(lpxdta, alpxdtaSorted[dwIndex + 1], pPatch->dwSort) > 0)) {
+                bSelected = SendMessage(pPatch->hwndLB, LB_GETSEL, dwIndex, 0L) > 0;
+
+                SendMessage(pPatch->hwndLB, LB_DELETESTRING, dwIndex, 0L);
+                memmove(
+                    &alpxdtaSorted[dwIndex], &alpxdtaSorted[dwIndex + 1],
+                    (lpHead->dwEntries - dwIndex - 1) * sizeof(LPXDTA));
+
+                DirPatchInsertSorted(pPatch, lpxdta);
+
+                if (bSelected)
+                    SendMessage(pPatch->hwndLB, LB_SETSEL, TRUE, DirPatchIndexOf(pPatch, lpxdta));
+            } else {
+                RECT rc;
+
+                if (SendMessage(pPatch->hwndLB, LB_GETITEMRECT, dwIndex, (LPARAM)&rc) != LB_ERR)
+                    InvalidateRect(pPatch->hwndLB, &rc, FALSE);
+            }
+
+            return TRUE;
+        }
+
+        if (!DirPatchRemove(pPatch, lpxdta))
+            return FALSE;
+    }
+
+    //
+    // Make room in the sorted array first, so that running out of
+    // memory leaves the block as it was.
+    //
+    alpxdtaSorted = (LPXDTA*)LocalReAlloc(
+        (HLOCAL)lpHead->alpxdtaSorted, sizeof(LPXDTA) * (lpHead->dwEntries + 1), LMEM_MOVEABLE);
+
+    if (!alpxdtaSorted)
+        return FALSE;
+
+    lpHead->alpxdtaSorted = alpxdtaSorted;
+
+    for (lpLinkLast = pPatch->lpStart; lpLinkLast->next; lpLinkLast = lpLinkLast->next)
+        ;
+
+    lpxdta = DirReadAddEntry(&lpLinkLast, lpHead, pPatch->szPath, &lfndta.fd, pPatch->bCasePreserved);
+    if (!lpxdta)
+        return FALSE;
+
+    DirPatchInsertSorted(pPatch, lpxdta);
+
+    pPatch->byName[libwinfile::pathKey(MemGetFileName(lpxdta))] = lpxdta;
+    pPatch->bAdded = TRUE;
+
+    return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     DirPatchEnd
+//
+// Synopsis: Finishes a batch started by DirPatchBegin
+//
+// IN        pPatch    from DirPatchBegin; freed
+//
+// Effects:  Column widths are measured again if names were added, the
+//           status bar is updated
+//
+/////////////////////////////////////////////////////////////////////
+
+void DirPatchEnd(PDIRPATCH pPatch) {
+    ExtSelItemsInvalidate();
+
+    if (pPatch->bAdded) {
+        SetLBFont(
+            pPatch->hwndDir, pPatch->hwndLB, hFont,
+            GetEffectiveView((DWORD)GetWindowLongPtr(pPatch->hwndListParms, GWL_VIEW)), pPatch->lpStart);
+    }
+
+    UpdateStatus(pPatch->hwndListParms);
+
+    delete pPatch;
+}
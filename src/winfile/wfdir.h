@@ -18,3 +18,9 @@ HWND GetMDIChildFromDescendant(HWND hwnd);
 void SetLBFont(HWND hwnd, HWND hwndLB, HANDLE hNewFont, DWORD dwViewFlags, LPXDTALINK lpStart);
 LRESULT CALLBACK DirWndProc(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam);
 LRESULT CALLBACK DirListBoxWndProc(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam);
+
+typedef struct tagDIRPATCH* PDIRPATCH;
+
+PDIRPATCH DirPatchBegin(HWND hwndDir);
+BOOL DirPatchApply(PDIRPATCH pPatch, LPCWSTR szName, BOOL bRemoved, LPDWORD pdwAttrs);
+void DirPatchEnd(PDIRPATCH pPatch);
@@ -542,10 +542,107 @@ DirReadServer(LPVOID lpvParm) {
     return 0;
 }
 
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     DirReadAddEntry
+//
+// Synopsis: Appends one found file or directory to a DTA block
+//
+// INOUT     plpLinkLast     last link of the block; moves on if a link
+//                           had to be added
+// INOUT     lpHead          head of the block; counts and size updated
+// IN        pPath           directory read, with filespec
+// IN        lpfd            what was found, attributes already masked
+// IN        bCasePreserved  is the drive case preserving?
+//
+// Return:   the new LPXDTA, NULL if out of memory
+//
+// Notes:    Used by the worker's full read and by the UI thread when it
+//           applies a change notification to a listing in place.
+//
+/////////////////////////////////////////////////////////////////////
+
+LPXDTA
+DirReadAddEntry(LPXDTALINK* plpLinkLast, LPXDTAHEAD lpHead, LPWSTR pPath, LPWIN32_FIND_DATA lpfd, BOOL bCasePreserved) {
+    LPWSTR pName = lpfd->cFileName;
+    PDOCBUCKET pDoc, pProgram;
+    LPXDTA lpxdta;
+    int iBitmap;
+
+    pDoc = NULL;
+    pProgram = NULL;
+    if (!(lpfd->dwFileAttributes & ATTR_DIR)) {
+        pProgram = IsProgramFile(pName);
+        pDoc = IsDocument(pName);
+    }
+
+    //
+    // figure out the bitmap type here
+    //
+    if (lpfd->dwFileAttributes & ATTR_DIR) {
+        // NOTE: Reparse points are directories
+
+        if (IsNetDir(pPath, pName))
+            iBitmap = BM_IND_CLOSEDFS;
+        else {
+            if (lpfd->dwFileAttributes & (ATTR_SYMBOLIC | ATTR_JUNCTION))
+                iBitmap = BM_IND_CLOSEREPARSE;
+            else
+                iBitmap = BM_IND_CLOSE;
+        }
+    } else if (lpfd->dwFileAttributes & (ATTR_HIDDEN | ATTR_SYSTEM)) {
+        iBitmap = BM_IND_RO;
+    } else if (pProgram) {
+        iBitmap = BM_IND_APP;
+    } else if (pDoc) {
+        iBitmap = BM_IND_DOC;
+    } else {
+        if (lpfd->dwFileAttributes & (ATTR_SYMBOLIC | ATTR_JUNCTION))
+            iBitmap = BM_IND_FILREPARSE;
+        else
+            iBitmap = BM_IND_FIL;
+    }
+
+    lpxdta = MemAdd(plpLinkLast, lstrlen(pName), lstrlen(lpfd->cAlternateFileName));
+
+    if (!lpxdta)
+        return NULL;
+
+    lpHead->dwEntries++;
+
+    lpxdta->dwAttrs = lpfd->dwFileAttributes;
+    lpxdta->ftLastWriteTime = lpfd->ftLastWriteTime;
+
+    //
+    // files > 2^63 will come out negative, so tough.
+    // (WIN32_FIND_DATA.nFileSizeHigh is not signed, but
+    // LARGE_INTEGER is)
+    //
+    lpxdta->qFileSize.LowPart = lpfd->nFileSizeLow;
+    lpxdta->qFileSize.HighPart = lpfd->nFileSizeHigh;
+
+    lpxdta->byBitmap = iBitmap;
+    lpxdta->pDocB = pDoc;  // even if program, use extension list for icon to display
+
+    if (IsLFN(pName)) {
+        lpxdta->dwAttrs |= ATTR_LFN;
+    }
+
+    if (!bCasePreserved)
+        lpxdta->dwAttrs |= ATTR_LOWERCASE;
+
+    lstrcpy(MemGetFileName(lpxdta), pName);
+    lstrcpy(MemGetAlternateFileName(lpxdta), lpfd->cAlternateFileName);
+
+    lpHead->dwTotalCount++;
+    (lpHead->qTotalSize).QuadPart = (lpxdta->qFileSize).QuadPart + (lpHead->qTotalSize).QuadPart;
+
+    return lpxdta;
+}
+
 LPXDTALINK
 CreateDTABlockWorker(HWND hwnd, HWND hwndDir) {
     LPWSTR pName;
-    PDOCBUCKET pDoc, pProgram;
 
     LFNDTA lfndta;
 
@@ -554,7 +651,6 @@ CreateDTABlockWorker(HWND hwnd, HWND hwndDir) {
 
     LPXDTA lpxdta;
 
-    int iBitmap;
     DRIVE drive;
 
     LPWSTR lpTemp;
@@ -751,81 +847,16 @@ RestartOverFindFirst:
         //
         lfndta.fd.dwFileAttributes &= (ATTR_USED | ATTR_JUNCTION | ATTR_SYMBOLIC);
 
-        pDoc = NULL;
-        pProgram = NULL;
-        if (!(lfndta.fd.dwFileAttributes & ATTR_DIR)) {
-            pProgram = IsProgramFile(pName);
-            pDoc = IsDocument(pName);
-        }
-
         //
-        // figure out the bitmap type here
+        // ignore "."  and ".." directories
         //
-        if (lfndta.fd.dwFileAttributes & ATTR_DIR) {
-            //
-            // ignore "."  and ".." directories
-            //
-            if (ISDOTDIR(pName)) {
-                goto CDBCont;
-            }
-
-            // NOTE: Reparse points are directories
-
-            if (IsNetDir(szPath, pName))
-                iBitmap = BM_IND_CLOSEDFS;
-            else {
-                if (lfndta.fd.dwFileAttributes & (ATTR_SYMBOLIC | ATTR_JUNCTION))
-                    iBitmap = BM_IND_CLOSEREPARSE;
-                else
-                    iBitmap = BM_IND_CLOSE;
-            }
-        } else if (lfndta.fd.dwFileAttributes & (ATTR_HIDDEN | ATTR_SYSTEM)) {
-            iBitmap = BM_IND_RO;
-        } else if (pProgram) {
-            iBitmap = BM_IND_APP;
-        } else if (pDoc) {
-            iBitmap = BM_IND_DOC;
-        } else {
-            if (lfndta.fd.dwFileAttributes & (ATTR_SYMBOLIC | ATTR_JUNCTION))
-                iBitmap = BM_IND_FILREPARSE;
-            else
-                iBitmap = BM_IND_FIL;
+        if ((lfndta.fd.dwFileAttributes & ATTR_DIR) && ISDOTDIR(pName)) {
+            goto CDBCont;
         }
 
-        lpxdta = MemAdd(&lpLinkLast, lstrlen(pName), lstrlen(lfndta.fd.cAlternateFileName));
-
-        if (!lpxdta)
+        if (!DirReadAddEntry(&lpLinkLast, lpHead, szPath, &lfndta.fd, bCasePreserved))
             goto CDBMemoryErr;
 
-        lpHead->dwEntries++;
-
-        lpxdta->dwAttrs = lfndta.fd.dwFileAttributes;
-        lpxdta->ftLastWriteTime = lfndta.fd.ftLastWriteTime;
-
-        //
-        // files > 2^63 will come out negative, so tough.
-        // (WIN32_FIND_DATA.nFileSizeHigh is not signed, but
-        // LARGE_INTEGER is)
-        //
-        lpxdta->qFileSize.LowPart = lfndta.fd.nFileSizeLow;
-        lpxdta->qFileSize.HighPart = lfndta.fd.nFileSizeHigh;
-
-        lpxdta->byBitmap = iBitmap;
-        lpxdta->pDocB = pDoc;  // even if program, use extension list for icon to display
-
-        if (IsLFN(pName)) {
-            lpxdta->dwAttrs |= ATTR_LFN;
-        }
-
-        if (!bCasePreserved)
-            lpxdta->dwAttrs |= ATTR_LOWERCASE;
-
-        lstrcpy(MemGetFileName(lpxdta), pName);
-        lstrcpy(MemGetAlternateFileName(lpxdta), lfndta.fd.cAlternateFileName);
-
-        lpHead->dwTotalCount++;
-        (lpHead->qTotalSize).QuadPart = (lpxdta->qFileSize).QuadPart + (lpHead->qTotalSize).QuadPart;
-
     CDBCont:
 
         if (bDirReadRebuildDocString) {
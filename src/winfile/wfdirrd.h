@@ -6,6 +6,12 @@
 BOOL InitDirRead();
 void DestroyDirRead();
 LPXDTALINK CreateDTABlock(HWND hwnd, LPWSTR pPath, BOOL bDontSteal);
+LPXDTA DirReadAddEntry(
+    LPXDTALINK* plpLinkLast,
+    LPXDTAHEAD lpHead,
+    LPWSTR pPath,
+    LPWIN32_FIND_DATA lpfd,
+    BOOL bCasePreserved);
 void FreeDTA(HWND hwnd);
 void DirReadDestroyWindow(HWND hwndDir);
 LPXDTALINK DirReadDone(HWND hwndDir, LPXDTALINK lpStart, int iError);
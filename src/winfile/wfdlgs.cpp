@@ -536,6 +536,9 @@ INT_PTR CALLBACK OptionsDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lPar
             // Minimize on use
             CheckDlgButton(hDlg, IDC_MINONRUN, bMinOnRun);
 
+            // Verify copies
+            CheckDlgButton(hDlg, IDC_VERIFYCOPY, bVerifyCopies);
+
             SetFocus(GetDlgItem(hDlg, IDOK));
             return FALSE;
 
@@ -594,6 +597,10 @@ INT_PTR CALLBACK OptionsDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lPar
                     bMinOnRun = IsDlgButtonChecked(hDlg, IDC_MINONRUN);
                     WritePrivateProfileBool(kMinOnRun, bMinOnRun);
 
+                    // Save verify copies
+                    bVerifyCopies = IsDlgButtonChecked(hDlg, IDC_VERIFYCOPY);
+                    WritePrivateProfileBool(kVerifyCopies, bVerifyCopies);
+
                     // Save all window settings
                     SaveWindows(hwndFrame);
 
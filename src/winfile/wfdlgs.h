@@ -90,6 +90,7 @@
 #define IDD_SAVESETTINGS 231
 #define IDD_SEARCHALL 232
 #define IDD_INCLUDEDIRS 233
+#define IDD_FILTER 234
 #define IDD_HIGHCAP 241
 #define IDD_MAKESYS 242
 #define IDD_PROGRESS 243
@@ -141,6 +142,7 @@
 #define IDC_FONT_LABEL 280
 #define IDC_FONT_CHANGE 281
 #define IDC_MINONRUN 282
+#define IDC_VERIFYCOPY 283
 
 #define IDD_NEW 300
 #define IDD_DESC 301
@@ -183,6 +185,9 @@
 // dialog item IDs
 #define IDD_MYTEXT 4000
 #define IDD_GASGAUGE 4001
+#define IDD_FILEGAUGE 4002
+#define IDD_PAUSE 4003
+#define IDD_RUNFIRST 4004
 
 #define IDD_KK_TEXTTO 2001
 #define IDD_KK_TEXTFROM 2002
@@ -204,5 +209,7 @@ INT_PTR CALLBACK SuperDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam
 INT_PTR CALLBACK MakeDirDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam);
 INT_PTR CALLBACK OtherDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam);
 INT_PTR CALLBACK ProgressDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam);
+BOOL IsProgressDlgMessage(LPMSG lpMsg);
+BOOL CancelProgressDlgs(HWND hwnd, BOOL bAsk);
 INT_PTR CALLBACK OptionsDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam);
 INT_PTR CALLBACK AboutDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam);
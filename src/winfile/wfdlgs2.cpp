@@ -93,6 +93,10 @@ SearchDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 
             SendDlgItemMessage(hDlg, IDD_DIR, EM_LIMITTEXT, COUNTOF(SearchInfo.szSearch) - 1, 0L);
             SendDlgItemMessage(hDlg, IDD_NAME, EM_LIMITTEXT, COUNTOF(szStart) - 1, 0L);
+            SendDlgItemMessage(hDlg, IDD_FILTER, EM_LIMITTEXT, COUNTOF(SearchInfo.szFilter) - 1, 0L);
+            SendDlgItemMessage(
+                hDlg, IDD_FILTER, EM_SETCUEBANNER, FALSE, (LPARAM)L"e.g. size>10M modified>=2024-01-31 attr:-h");
+            SetDlgItemText(hDlg, IDD_FILTER, SearchInfo.szFilter);
 
             GetSelectedDirectory(0, SearchInfo.szSearch);
             SetDlgItemText(hDlg, IDD_DIR, SearchInfo.szSearch);
@@ -130,6 +134,26 @@ SearchDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam) {
                     break;
 
                 case IDOK: {
+                    //
+                    // Validate the filter expression first so a typo keeps the dialog open
+                    //
+                    WCHAR szFilter[COUNTOF(SearchInfo.szFilter)];
+                    GetDlgItemText(hDlg, IDD_FILTER, szFilter, COUNTOF(szFilter));
+                    try {
+                        SearchInfo.filter = libwinfile::SearchFilter::parse(szFilter);
+                    } catch (const std::invalid_argument& e) {
+                        //
+                        // The message is UTF-8, and may quote the term
+                        //
+                        int cchErrorMsg = MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, NULL, 0);
+                        std::wstring wideErrorMsg(cchErrorMsg, CHAR_NULL);
+                        MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, &wideErrorMsg[0], cchErrorMsg);
+                        MessageBox(hDlg, wideErrorMsg.c_str(), L"Invalid Filter", MB_OK | MB_ICONWARNING);
+                        SetFocus(GetDlgItem(hDlg, IDD_FILTER));
+                        break;
+                    }
+                    lstrcpy(SearchInfo.szFilter, szFilter);
+
                     GetDlgItemText(hDlg, IDD_DIR, SearchInfo.szSearch, COUNTOF(SearchInfo.szSearch));
                     QualifyPath(SearchInfo.szSearch);
 
@@ -488,6 +512,17 @@ SuperDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 
                     break;
 
+                case IDM_DELETE:
+
+                    if (bDeletePermanent) {
+                        LoadString(hAppInstance, IDS_DELETEPERMANENTTITLE, szTitle, COUNTOF(szTitle));
+                        SetWindowText(hDlg, szTitle);
+                        LoadString(hAppInstance, IDS_DELETEPERMANENTTEXT, szStr, COUNTOF(szStr));
+                        SetDlgItemText(hDlg, IDD_TEXT1, szStr);
+                    }
+                    p = GetSelection(0, NULL);
+                    break;
+
                 default:
 
                     p = GetSelection(0, NULL);
@@ -603,8 +638,10 @@ SuperDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 
                 case IDCANCEL:
 
-                    if (pCopyInfo)
+                    if (pCopyInfo) {
                         pCopyInfo->bUserAbort = TRUE;
+                        CopyJobQueue().cancel(pCopyInfo->jobId);
+                    }
 
                 SuperDlgExit:
 
@@ -702,6 +739,7 @@ SuperDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam) {
                                 break;
                             case IDM_DELETE:
                                 pCopyInfo->dwFunc = FUNC_DELETE;
+                                pCopyInfo->bPermanent = bDeletePermanent;
                                 break;
                             case IDM_RENAME:
                                 pCopyInfo->dwFunc = FUNC_RENAME;
@@ -17,6 +17,9 @@
 #include "wfsearch.h"
 #include "stringconstants.h"
 #include <shlobj.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
 
 #define LABEL_NTFS_MAX 32
 #define LABEL_FAT_MAX 11
@@ -30,6 +33,13 @@ void MDIClientSizeChange(HWND hwndActive, int iFlags);
 
 BOOL GetProductVersion(WORD* pwMajor, WORD* pwMinor, WORD* pwBuild, WORD* pwRevision);
 
+// The copy status gauges count to this, and the per-file gauge appears for
+// files at least HUGE_FILE_SIZE bytes long.
+#define GAUGE_RANGE 1000
+#define HUGE_FILE_SIZE (256ull * 1024 * 1024)
+#define PROGRESS_TIMER 1
+#define PROGRESS_INTERVAL 250
+
 /*--------------------------------------------------------------------------*/
 /*                                                                          */
 /*  AboutDlgProc() -  DialogProc callback function for ABOUTDLG             */
@@ -86,12 +96,12 @@ CopyDiskette(IN PVOID ThreadParameter) {
 //
 // Name:     ProgressDialogProc
 //
-// Synopsis: Modal dialog box for mouse move/copy progress
-//
-//
-//
-//
+// Synopsis: Modeless window for a move/copy job's progress.  Each job
+//           has its own, so several can run at once; the queue decides
+//           which of them wait for the others on the same disks.
 //
+//           Pause stops the job where it is, holding its disks; Run
+//           First moves a waiting job ahead of the others.
 //
 // Return:
 //
@@ -105,10 +115,214 @@ CopyDiskette(IN PVOID ThreadParameter) {
 //
 /////////////////////////////////////////////////////////////////////
 
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     ProgressDlgHideGauges
+//
+// Synopsis: Removes the copy progress gauges from DMSTATUSDLG, moving
+//           the status line and the buttons up and shrinking the dialog
+//           to match, for operations that don't count bytes.  The status
+//           line stays to say when the job is waiting or paused.
+//
+/////////////////////////////////////////////////////////////////////
+
+static void ProgressDlgHideGauges(HWND hDlg) {
+    static const int rgButtons[] = {IDD_PAUSE, IDD_RUNFIRST, IDCANCEL};
+    HWND hwndText = GetDlgItem(hDlg, IDD_MYTEXT);
+    RECT rcGauge, rcText, rcButton, rcDlg;
+    int dyText, dy;
+    UINT i;
+
+    GetWindowRect(GetDlgItem(hDlg, IDD_GASGAUGE), &rcGauge);
+    GetWindowRect(hwndText, &rcText);
+    GetWindowRect(GetDlgItem(hDlg, IDCANCEL), &rcButton);
+    GetWindowRect(hDlg, &rcDlg);
+    dyText = rcText.top - rcGauge.top;
+    dy = rcButton.top - rcText.top;
+
+    ShowWindow(GetDlgItem(hDlg, IDD_GASGAUGE), SW_HIDE);
+    ShowWindow(GetDlgItem(hDlg, IDD_FILEGAUGE), SW_HIDE);
+
+    MapWindowPoints(NULL, hDlg, (LPPOINT)&rcText, 2);
+    SetWindowPos(hwndText, NULL, rcText.left, rcText.top - dyText, 0, 0, SWP_NOSIZE | SWP_NOZORDER);
+
+    for (i = 0; i < COUNTOF(rgButtons); i++) {
+        HWND hwndButton = GetDlgItem(hDlg, rgButtons[i]);
+
+        GetWindowRect(hwndButton, &rcButton);
+        MapWindowPoints(NULL, hDlg, (LPPOINT)&rcButton, 2);
+        SetWindowPos(hwndButton, NULL, rcButton.left, rcButton.top - dy, 0, 0, SWP_NOSIZE | SWP_NOZORDER);
+    }
+    SetWindowPos(
+        hDlg, NULL, 0, 0, rcDlg.right - rcDlg.left, rcDlg.bottom - rcDlg.top - dy, SWP_NOMOVE | SWP_NOZORDER);
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     ProgressDlgShowState
+//
+// Synopsis: Says in DMSTATUSDLG when its job is waiting for its turn or
+//           is paused, and enables Run First only while it waits.
+//
+// Return:   TRUE if the job is waiting or paused, so that there is no
+//           progress to show.
+//
+/////////////////////////////////////////////////////////////////////
+
+static BOOL ProgressDlgShowState(HWND hDlg, PCOPYINFO pCopyInfo) {
+    libwinfile::CopyQueue::State state = CopyJobQueue().state(pCopyInfo->jobId);
+    WCHAR szText[MAXMESSAGELEN];
+
+    EnableWindow(GetDlgItem(hDlg, IDD_RUNFIRST), state == libwinfile::CopyQueue::State::Queued);
+
+    switch (state) {
+        case libwinfile::CopyQueue::State::Queued:
+            LoadString(hAppInstance, IDS_COPYWAITING, szText, COUNTOF(szText));
+            break;
+        case libwinfile::CopyQueue::State::Paused:
+            LoadString(hAppInstance, IDS_COPYPAUSED, szText, COUNTOF(szText));
+            break;
+        default:
+            return FALSE;
+    }
+    SetDlgItemText(hDlg, IDD_MYTEXT, szText);
+    return TRUE;
+}
+
+//
+// The job windows open, for IsProgressDlgMessage.  Only the UI thread
+// changes the list; the lock is for the copy threads reading it.
+//
+static std::vector<HWND> rgProgressDlgs;
+static std::mutex mutexProgressDlgs;
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     IsProgressDlgMessage
+//
+// Synopsis: Gives a message for one of the modeless job windows, or any
+//           of their controls, its dialog keyboard handling.
+//
+// Return:   TRUE if the message was handled.
+//
+/////////////////////////////////////////////////////////////////////
+
+BOOL IsProgressDlgMessage(LPMSG lpMsg) {
+    HWND hwndRoot;
+
+    if (!lpMsg->hwnd)
+        return FALSE;
+
+    hwndRoot = GetAncestor(lpMsg->hwnd, GA_ROOT);
+    {
+        std::lock_guard<std::mutex> lock(mutexProgressDlgs);
+        if (std::find(rgProgressDlgs.begin(), rgProgressDlgs.end(), hwndRoot) == rgProgressDlgs.end())
+            return FALSE;
+    }
+
+    return IsDialogMessage(hwndRoot, lpMsg);
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     CancelProgressDlgs
+//
+// Synopsis: Before exiting, cancels every job that is still running, as
+//           its window's Cancel button does, and waits for their threads
+//           to end, so none is cut off in the middle of a file.  With
+//           bAsk, the user is asked first.
+//
+// Return:   FALSE if the user would rather let the jobs run, so winfile
+//           must not exit.
+//
+/////////////////////////////////////////////////////////////////////
+
+BOOL CancelProgressDlgs(HWND hwnd, BOOL bAsk) {
+    WCHAR szMessage[MAXMESSAGELEN];
+    WCHAR szTitle[MAXTITLELEN];
+
+    if (!rgProgressDlgs.empty() && bAsk) {
+        LoadString(hAppInstance, IDS_CANCELJOBSTITLE, szTitle, COUNTOF(szTitle));
+        LoadString(hAppInstance, IDS_CANCELJOBS, szMessage, COUNTOF(szMessage));
+
+        if (MessageBox(hwnd, szMessage, szTitle, MB_YESNO | MB_ICONQUESTION) != IDYES)
+            return FALSE;
+    }
+
+    //
+    // Each window takes itself out of rgProgressDlgs as it closes.
+    //
+    std::vector<HWND> rgDlgs = rgProgressDlgs;
+    for (HWND hDlg : rgDlgs) {
+        SendMessage(hDlg, WM_COMMAND, GET_WM_COMMAND_MPS(IDCANCEL, NULL, 0));
+    }
+
+    //
+    // Jobs cancelled earlier may still be on their way out too.
+    //
+    CopyJobsWait();
+
+    return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     ProgressDlgUpdate
+//
+// Synopsis: Shows a copy's progress in DMSTATUSDLG: bytes done out of
+//           the total, the rate, the time left once the scan has counted
+//           everything, and a second gauge while a huge file is copied.
+//
+/////////////////////////////////////////////////////////////////////
+
+static void ProgressDlgUpdate(HWND hDlg, libwinfile::CopyProgress* pProgress) {
+    libwinfile::CopyProgressSnapshot snapshot = pProgress->sample(libwinfile::CopyProgress::Clock::now());
+    WCHAR szDone[40];
+    WCHAR szTotal[40];
+    WCHAR szRate[40];
+    WCHAR szFormat[MAXMESSAGELEN];
+    WCHAR szText[MAXMESSAGELEN];
+    LARGE_INTEGER qw;
+    DWORD dwSeconds;
+    BOOL bHuge;
+
+    qw.QuadPart = snapshot.bytesDone;
+    ShortSizeFormatInternal(szDone, qw);
+    qw.QuadPart = snapshot.bytesTotal;
+    ShortSizeFormatInternal(szTotal, qw);
+    qw.QuadPart = (LONGLONG)snapshot.bytesPerSecond;
+    ShortSizeFormatInternal(szRate, qw);
+
+    if (!snapshot.scanned) {
+        LoadString(hAppInstance, IDS_COPYSCANNING, szFormat, COUNTOF(szFormat));
+        wsprintf(szText, szFormat, szDone, szTotal, szRate);
+    } else if (snapshot.secondsLeft < 0) {
+        LoadString(hAppInstance, IDS_COPYPROGRESS, szFormat, COUNTOF(szFormat));
+        wsprintf(szText, szFormat, szDone, szTotal, szRate);
+    } else {
+        dwSeconds = (DWORD)(snapshot.secondsLeft + 0.5);
+        LoadString(hAppInstance, IDS_COPYPROGRESSETA, szFormat, COUNTOF(szFormat));
+        wsprintf(szText, szFormat, szDone, szTotal, szRate, dwSeconds / 3600, dwSeconds / 60 % 60, dwSeconds % 60);
+    }
+    SetDlgItemText(hDlg, IDD_MYTEXT, szText);
+
+    SendDlgItemMessage(
+        hDlg, IDD_GASGAUGE, PBM_SETPOS,
+        snapshot.bytesTotal ? (WPARAM)(snapshot.bytesDone * GAUGE_RANGE / snapshot.bytesTotal) : 0, 0L);
+
+    bHuge = snapshot.largestFileSize >= HUGE_FILE_SIZE;
+    if (bHuge) {
+        SendDlgItemMessage(
+            hDlg, IDD_FILEGAUGE, PBM_SETPOS,
+            (WPARAM)(snapshot.largestFileDone * GAUGE_RANGE / snapshot.largestFileSize), 0L);
+    }
+    ShowWindow(GetDlgItem(hDlg, IDD_FILEGAUGE), bHuge ? SW_SHOWNA : SW_HIDE);
+}
+
 INT_PTR
 CALLBACK
 ProgressDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam) {
-    static PCOPYINFO pCopyInfo;
+    PCOPYINFO pCopyInfo = (PCOPYINFO)GetWindowLongPtr(hDlg, GWLP_USERDATA);
     WCHAR szTitle[MAXTITLELEN];
 
     switch (wMsg) {
@@ -116,6 +330,11 @@ ProgressDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 
             hdlgProgress = hDlg;
             pCopyInfo = (PCOPYINFO)lParam;
+            SetWindowLongPtr(hDlg, GWLP_USERDATA, (LONG_PTR)pCopyInfo);
+            {
+                std::lock_guard<std::mutex> lock(mutexProgressDlgs);
+                rgProgressDlgs.push_back(hDlg);
+            }
 
             // Set the destination directory in the dialog.
             // use IDD_TONAME 'cause IDD_TO gets disabled....
@@ -136,37 +355,93 @@ ProgressDlgProc(HWND hDlg, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 
             if (WFMoveCopyDriver(pCopyInfo)) {
                 //
-                // Error message!!
+                // Error message!!  WFMoveCopyDriver has freed pCopyInfo.
                 //
 
-                EndDialog(hDlg, GetLastError());
+                SetWindowLongPtr(hDlg, GWLP_USERDATA, 0);
+                DestroyWindow(hDlg);
+                break;
             }
+
+            //
+            // Copies show their bytes; the thread doesn't free pProgress
+            // until we have handled FS_COPYDONE.  Every job shows when it
+            // is waiting or paused.
+            //
+            if (pCopyInfo->pProgress) {
+                SendDlgItemMessage(hDlg, IDD_GASGAUGE, PBM_SETRANGE32, 0, GAUGE_RANGE);
+                SendDlgItemMessage(hDlg, IDD_FILEGAUGE, PBM_SETRANGE32, 0, GAUGE_RANGE);
+            } else {
+                ProgressDlgHideGauges(hDlg);
+            }
+            ProgressDlgShowState(hDlg, pCopyInfo);
+            SetTimer(hDlg, PROGRESS_TIMER, PROGRESS_INTERVAL, NULL);
+            break;
+
+        case WM_TIMER:
+
+            if (pCopyInfo && !ProgressDlgShowState(hDlg, pCopyInfo) && pCopyInfo->pProgress)
+                ProgressDlgUpdate(hDlg, pCopyInfo->pProgress);
             break;
 
         case FS_COPYDONE:
 
             //
-            // Only cancel out if pCopyInfo == lParam
+            // Only close if pCopyInfo == lParam
             // This indicates that the proper thread quit.
             //
             // wParam holds return value
             //
 
-            if (lParam == (LPARAM)pCopyInfo) {
-                EndDialog(hDlg, wParam);
+            if (pCopyInfo && lParam == (LPARAM)pCopyInfo) {
+                SetWindowLongPtr(hDlg, GWLP_USERDATA, 0);
+                DestroyWindow(hDlg);
+            }
+            break;
+
+        case WM_DESTROY:
+
+            KillTimer(hDlg, PROGRESS_TIMER);
+            {
+                std::lock_guard<std::mutex> lock(mutexProgressDlgs);
+                rgProgressDlgs.erase(
+                    std::remove(rgProgressDlgs.begin(), rgProgressDlgs.end(), hDlg), rgProgressDlgs.end());
             }
             break;
 
         case WM_COMMAND:
+            if (!pCopyInfo)
+                return FALSE;
+
             switch (GET_WM_COMMAND_ID(wParam, lParam)) {
-                case IDCANCEL:
+                case IDD_PAUSE:
+
+                    if (CopyJobQueue().state(pCopyInfo->jobId) == libwinfile::CopyQueue::State::Paused) {
+                        CopyJobQueue().resume(pCopyInfo->jobId);
+                        LoadString(hAppInstance, IDS_COPYPAUSE, szTitle, COUNTOF(szTitle));
+                    } else {
+                        CopyJobQueue().pause(pCopyInfo->jobId);
+                        LoadString(hAppInstance, IDS_COPYRESUME, szTitle, COUNTOF(szTitle));
+                    }
+                    SetDlgItemText(hDlg, IDD_PAUSE, szTitle);
+                    ProgressDlgShowState(hDlg, pCopyInfo);
+                    break;
 
-                    pCopyInfo->bUserAbort = TRUE;
+                case IDD_RUNFIRST:
+
+                    CopyJobQueue().moveToFront(pCopyInfo->jobId);
+                    break;
+
+                case IDCANCEL:
 
                     //
-                    // What should be the return value??
+                    // The thread goes on to its end on its own, releasing
+                    // a wait or a pause, and frees pCopyInfo there.
                     //
-                    EndDialog(hDlg, 0);
+                    pCopyInfo->bUserAbort = TRUE;
+                    CopyJobQueue().cancel(pCopyInfo->jobId);
+                    SetWindowLongPtr(hDlg, GWLP_USERDATA, 0);
+                    DestroyWindow(hDlg);
 
                     break;
 
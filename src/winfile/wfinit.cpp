@@ -178,6 +178,7 @@ void GetSettings() {
 
     /* Get the flags out of the INI file. */
     bMinOnRun = GetPrivateProfileInt(kSettings, kMinOnRun, bMinOnRun, szTheINIFile);
+    bVerifyCopies = GetPrivateProfileInt(kSettings, kVerifyCopies, bVerifyCopies, szTheINIFile);
     wTextAttribs = (WORD)GetPrivateProfileInt(kSettings, kLowerCase, wTextAttribs, szTheINIFile);
     bStatusBar = GetPrivateProfileInt(kSettings, kStatusBar, bStatusBar, szTheINIFile);
 
@@ -191,6 +192,8 @@ void GetSettings() {
     bConfirmFormat = GetPrivateProfileInt(kSettings, kConfirmFormat, bConfirmFormat, szTheINIFile);
     bConfirmReadOnly = GetPrivateProfileInt(kSettings, kConfirmReadOnly, bConfirmReadOnly, szTheINIFile);
     uChangeNotifyTime = GetPrivateProfileInt(kSettings, kChangeNotifyTime, uChangeNotifyTime, szTheINIFile);
+    uUnbufferedCopyMB = GetPrivateProfileInt(kSettings, kUnbufferedCopyMB, uUnbufferedCopyMB, szTheINIFile);
+    uCopyBufferKB = GetPrivateProfileInt(kSettings, kCopyBufferKB, uCopyBufferKB, szTheINIFile);
     bScrollOnExpand = GetPrivateProfileInt(kSettings, kScrollOnExpand, bScrollOnExpand, szTheINIFile);
 
     // Load global column selection
@@ -907,7 +910,7 @@ BOOL InitFileManager(HINSTANCE hInstance, LPWSTR lpCmdLine, int nCmdShow) {
     wndClass.style = CS_DBLCLKS;
     wndClass.lpfnWndProc = TreeControlWndProc;
     // wndClass.cbClsExtra     = 0;
-    wndClass.cbWndExtra = 2 * sizeof(LONG_PTR);  // GWL_READLEVEL, GWL_XTREEMAX
+    wndClass.cbWndExtra = 4 * sizeof(LONG_PTR);  // GWL_READLEVEL, GWL_XTREEMAX, GWL_TREEASYNC, GWL_TREEINDEX
                                                  // wndClass.hInstance      = hInstance;
                                                  // wndClass.hIcon          = NULL;
     wndClass.hCursor = hcurArrow;
@@ -1181,6 +1184,12 @@ BOOL InitFileManager(HINSTANCE hInstance, LPWSTR lpCmdLine, int nCmdShow) {
         }
     }
 
+    //
+    // Offer to finish any copies that were cut short last time, once the
+    // windows are up.
+    //
+    PostMessage(hwndFrame, FS_RESUMECOPIES, 0, 0L);
+
     SetThreadPriority(hThread, THREAD_PRIORITY_NORMAL);
 
     return TRUE;
@@ -108,8 +108,16 @@ int SearchList(
     BOOL bRecurse,
     BOOL bIncludeSubdirs,
     LPXDTALINK* plpStart,
+    int iFileCount);
+int SearchDirectory(
+    HWND hwndLB,
+    LPCWSTR szPath,
+    LPWSTR szFileSpec,
+    BOOL bIncludeSubdirs,
+    LPXDTALINK* plpStart,
     int iFileCount,
-    BOOL bRoot);
+    BOOL bRoot,
+    int iDepth);
 void ClearSearchLB(BOOL bWorkerCall);
 DWORD WINAPI SearchDrive(LPVOID lpParameter);
 
@@ -119,7 +127,8 @@ DWORD WINAPI SearchDrive(LPVOID lpParameter);
 //
 // Name:     SearchList
 //
-// Synopsis: Recursive search
+// Synopsis: Searches szPath, and with bRecurse the directories below
+//           it, walking them without recursion
 //
 //
 // Return:   int, # of files found
@@ -130,7 +139,8 @@ DWORD WINAPI SearchDrive(LPVOID lpParameter);
 // Effects:
 //
 //
-// Notes:
+// Notes:    Junctions and links to directories are walked into, as
+//           they always have been.
 //
 /////////////////////////////////////////////////////////////////////
 
@@ -141,9 +151,88 @@ int SearchList(
     BOOL bRecurse,
     BOOL bIncludeSubdirs,
     LPXDTALINK* plpStart,
+    int iFileCount) {
+    libwinfile::TreeWalker walker;
+    libwinfile::TreeWalker::Visit visit;
+    LFNDTA lfndta;
+
+    iFileCount = SearchDirectory(hwndLB, szPath, szFileSpec, bIncludeSubdirs, plpStart, iFileCount, TRUE, 0);
+
+    //
+    // Nothing below this depth can match the filter
+    //
+    if (!bRecurse || SearchInfo.filter.maxDepth() <= 0)
+        return iFileCount;
+
+    if (SearchInfo.bCancel || _SEARCH_INFO::SEARCH_ERROR == SearchInfo.eStatus)
+        return iFileCount;
+
+    //
+    // Now walk the subdirectories, searching each on the way in.  Short
+    // names let directories whose long paths are too long be searched too.
+    //
+    if (WFWalkStart(
+            &walker, szPath, kStarDotStar,
+            libwinfile::TreeWalker::kDirectoriesOnly | libwinfile::TreeWalker::kFollowLinks |
+                libwinfile::TreeWalker::kShortNames)) {
+        return iFileCount;
+    }
+
+    while ((visit = WFWalkNext(&walker, &lfndta)) != libwinfile::TreeWalker::Visit::End) {
+        //
+        // A directory whose path is too long isn't walked into; skip it too
+        //
+        if (visit != libwinfile::TreeWalker::Visit::Enter || lfndta.err)
+            continue;
+
+        //
+        // Yes, search and add files in this directory
+        //
+        iFileCount = SearchDirectory(
+            hwndLB, walker.path().c_str(), szFileSpec, bIncludeSubdirs, plpStart, iFileCount, FALSE,
+            (int)walker.depth());
+
+        //
+        // allow escape to exit
+        //
+        if (SearchInfo.bCancel || _SEARCH_INFO::SEARCH_ERROR == SearchInfo.eStatus)
+            break;
+
+        if ((int)walker.depth() >= SearchInfo.filter.maxDepth())
+            walker.skip();
+    }
+
+    return iFileCount;
+}
+
+/////////////////////////////////////////////////////////////////////
+//
+// Name:     SearchDirectory
+//
+// Synopsis: Adds what in szPath matches szFileSpec and the filter
+//
+//
+// Return:   int, # of files found
+//
+//
+// Assumes:
+//
+// Effects:
+//
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////
+
+int SearchDirectory(
+    HWND hwndLB,
+    LPCWSTR szPath,
+    LPWSTR szFileSpec,
+    BOOL bIncludeSubdirs,
+    LPXDTALINK* plpStart,
     int iFileCount,
-    BOOL bRoot) {
-    int iRetVal;
+    BOOL bRoot,
+    int iDepth) {
     SIZE size;
     BOOL bFound;
     LPWSTR pszNewPath;
@@ -233,7 +322,6 @@ int SearchList(
              ERROR_SYMLINK_CLASS_DISABLED != lfndta.err && ERROR_INVALID_NAME != lfndta.err)) {
         SearchInfo.eStatus = _SEARCH_INFO::SEARCH_ERROR;
         SearchInfo.dwError = lfndta.err;
-        bRecurse = FALSE;
 
         goto SearchCleanup;
     }
@@ -243,7 +331,6 @@ int SearchList(
         // allow escape to exit
         //
         if (SearchInfo.bCancel) {
-            bRecurse = FALSE;
             break;
         }
 
@@ -255,6 +342,21 @@ int SearchList(
             bFound = FALSE;
         }
 
+        //
+        // Apply the filter expression using only what FindNextFile already returned
+        //
+        if (bFound && !SearchInfo.filter.empty()) {
+            libwinfile::SearchCandidate candidate;
+            candidate.name = lfndta.fd.cFileName;
+            candidate.attributes = lfndta.fd.dwFileAttributes;
+            candidate.size = ((ULONGLONG)lfndta.fd.nFileSizeHigh << 32) | lfndta.fd.nFileSizeLow;
+            candidate.lastWriteTime = ((ULONGLONG)lfndta.fd.ftLastWriteTime.dwHighDateTime << 32) |
+                lfndta.fd.ftLastWriteTime.dwLowDateTime;
+            candidate.depth = iDepth;
+
+            bFound = SearchInfo.filter.matches(candidate);
+        }
+
         //
         // Make sure this matches date (if specified) and is not a "." or ".." directory
         //
@@ -282,7 +384,6 @@ int SearchList(
             lpxdta = MemAdd(plpStart, lstrlen(pszNewPath), 0);
 
             if (!lpxdta) {
-                bRecurse = FALSE;  // simulate an abort
                 SearchInfo.dwError = ERROR_NOT_ENOUGH_MEMORY;
                 SearchInfo.eStatus = _SEARCH_INFO::SEARCH_ERROR;
 
@@ -337,53 +438,6 @@ SearchCleanup:
         SelectObject(hdc, hOld);
     ReleaseDC(hwndLB, hdc);
 
-    if (!bRecurse)
-        goto SearchEnd;
-
-    //
-    // Now see if there are any subdirectories here
-    //
-    lstrcpy(pszNextFile, kStarDotStar);
-
-    bFound = WFFindFirst(&lfndta, pszNewPath, ATTR_DIR | ATTR_HS);
-
-    while (bFound) {
-        //
-        // allow escape to exit
-        //
-        if (SearchInfo.bCancel) {
-            bRecurse = FALSE;
-            break;
-        }
-
-        //
-        // Make sure this is not a "." or ".." directory.
-        //
-        if (!ISDOTDIR(lfndta.fd.cFileName) && (lfndta.fd.dwFileAttributes & ATTR_DIR)) {
-            //
-            // Yes, search and add files in this directory
-            //
-            lstrcpy(pszNextFile, lfndta.fd.cFileName);
-
-            //
-            // Add all files in this subdirectory.
-            //
-            iRetVal =
-                SearchList(hwndLB, pszNewPath, szFileSpec, bRecurse, bIncludeSubdirs, plpStart, iFileCount, FALSE);
-
-            iFileCount = iRetVal;
-
-            if (_SEARCH_INFO::SEARCH_ERROR == SearchInfo.eStatus) {
-                break;
-            }
-        }
-        bFound = WFFindNext(&lfndta);
-    }
-
-    WFFindClose(&lfndta);
-
-SearchEnd:
-
     //
     // Save the number of files in the xdtahead structure.
     //
@@ -483,7 +537,7 @@ int FillSearchLB(HWND hwndLB, LPWSTR szSearchFileSpec, BOOL bRecurse, BOOL bIncl
 
         FixUpFileSpec(szWildCard);
 
-        iRet = SearchList(hwndLB, szPathName, szWildCard, bRecurse, bIncludeSubdirs, &lpStart, iFileCount, TRUE);
+        iRet = SearchList(hwndLB, szPathName, szWildCard, bRecurse, bIncludeSubdirs, &lpStart, iFileCount);
 
         iFileCount = iRet;
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <windows.h>
+#include "libwinfile/SearchFilter.h"
 
 typedef struct _SEARCH_INFO {
     HWND hSearchDlg;
@@ -19,6 +20,8 @@ typedef struct _SEARCH_INFO {
     enum _SEARCH_STATUS { SEARCH_NULL = 0, SEARCH_CANCEL, SEARCH_ERROR, SEARCH_MDICLOSE } eStatus;
     WCHAR szSearch[MAXPATHLEN + 1];
     FILETIME ftSince;  // UTC
+    WCHAR szFilter[MAXPATHLEN + 1];
+    libwinfile::SearchFilter filter;  // compiled from szFilter
 } SEARCH_INFO, *PSEARCH_INFO;
 
 void GetSearchPath(HWND hwnd, LPWSTR szTemp);
@@ -1043,7 +1043,7 @@ void CleanupMessages() {
     MSG msg;
 
     while (PeekMessage(&msg, NULL, 0, 0, TRUE)) {
-        if (!IsDialogMessage(hdlgProgress, &msg))
+        if (!IsProgressDlgMessage(&msg))
             DispatchMessage(&msg);
     }
     return;
@@ -18,6 +18,7 @@
 #include "wfdirrd.h"
 #include "wfinit.h"
 #include "wfsearch.h"
+#include "treectl.h"
 #include "stringconstants.h"
 #include "bookmark.h"
 #include "wfminbar.h"
@@ -94,7 +95,7 @@ int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR pszCmdLineA, in
     }
 
     while (TRUE) {
-        vWaitMessage();
+        WaitMessage();
 
         while (PeekMessage(&msg, (HWND)NULL, 0, 0, PM_REMOVE)) {
             if (msg.message == WM_QUIT) {
@@ -111,6 +112,9 @@ int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR pszCmdLineA, in
             if (msg.message == WM_SYSKEYDOWN && msg.wParam == VK_RETURN && IsIconic(hwndFrame)) {
                 ShowWindow(hwndFrame, SW_NORMAL);
 
+            } else if (IsProgressDlgMessage(&msg)) {
+                // Keyboard navigation in a copy job's progress window.
+
             } else if (
                 !TranslateMDISysAccel(hwndMDIClient, &msg) &&
                 (shouldSkipAccelerator(&msg) || !hwndFrame || !TranslateAccelerator(hwndFrame, hAccel, &msg))) {
@@ -470,10 +474,19 @@ FrameWndProc(HWND hwnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
                 break;
 
             for (hwndTree = GetWindow(hwndMDIClient, GW_CHILD); hwndTree; hwndTree = GetWindow(hwndTree, GW_HWNDNEXT)) {
+                if (GetWindow(hwndTree, GW_OWNER))
+                    continue;
+
+                //
+                // apply what the watch saw; sets GWL_FSCFLAG if that
+                // can't be done in place
+                //
+                NotifyApplyChanges(hwndTree);
+
                 //
                 // a tree or search window
                 //
-                if (!GetWindow(hwndTree, GW_OWNER) && GetWindowLongPtr(hwndTree, GWL_FSCFLAG)) {
+                if (GetWindowLongPtr(hwndTree, GWL_FSCFLAG)) {
                     SendMessage(hwndTree, WM_FSC, FSC_REFRESH, 0L);
                 }
             }
@@ -489,6 +502,11 @@ FrameWndProc(HWND hwnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
             BuildDocumentStringWorker();
             break;
 
+        case FS_RESUMECOPIES:
+
+            ResumeCopyJobs();
+            break;
+
         case FS_UPDATEDRIVETYPECOMPLETE:
             //
             // wParam = new cDrives
@@ -698,6 +716,7 @@ FrameWndProc(HWND hwnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
         case WM_DESTROY:
 
             DestroyMinimizedWindowBar();
+            StopTreeThreads();
             hwndFrame = NULL;
             PostQuitMessage(0);
             DestroyWindow(hwndDriveBar);
@@ -820,8 +839,10 @@ FrameWndProc(HWND hwnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
                 // Simulate an exit command to clean up, but don't display
                 // the "are you sure you want to exit", since somebody should
                 // have already taken care of that, and hitting Cancel has no
-                // effect anyway.
+                // effect anyway.  Likewise running jobs are cancelled
+                // without asking.
 
+                CancelProgressDlgs(hwnd, FALSE);
                 AppCommandProc(IDM_EXIT);
                 bExitWindows = bSaveExit;
             }
@@ -47,6 +47,12 @@
 #include <filesystem>
 #include <system_error>
 #include "libheirloom/cancel.h"
+#include "libwinfile/CopyProgress.h"
+#include "libwinfile/CopyJournal.h"
+#include "libwinfile/CopyQueue.h"
+#include "libwinfile/MovePlanner.h"
+#include "libwinfile/TreeDeleter.h"
+#include "libwinfile/TreeWalker.h"
 
 #define STKCHK()
 
@@ -76,7 +82,6 @@ int atoiW(LPCWSTR sz);
 #define MAXERRORLEN (MAXPATHLEN + MAXSUGGESTLEN)
 #define MAXMESSAGELEN (MAXPATHLEN * 2 + MAXSUGGESTLEN)
 
-#define MAX_WINDOWS 27
 #define MAX_DRIVES 26
 
 // struct for volume info
@@ -194,6 +199,11 @@ typedef struct _COPYINFO {
     LPWSTR pTo;
     DWORD dwFunc;
     BOOL bUserAbort;
+    libwinfile::CopyProgress* pProgress;  // FUNC_COPY only; freed by thread
+    libwinfile::CopyJournal* pJournal;    // FUNC_COPY only; freed by thread
+    libwinfile::CopyQueue::JobId jobId;   // In CopyJobQueue() until the thread ends
+    HWND hDlg;                            // Progress window the thread reports to
+    BOOL bPermanent;                      // FUNC_DELETE: delete for good, not to the recycle bin
 } COPYINFO, *PCOPYINFO;
 
 typedef enum eISELTYPE {
@@ -313,6 +323,8 @@ BOOL shouldSkipAccelerator(MSG* pMsg);
 
 #define GWL_READLEVEL (0 * sizeof(LONG_PTR))  // iReadLevel for each tree control window
 #define GWL_XTREEMAX (1 * sizeof(LONG_PTR))   // max text extent for each tree control window
+#define GWL_TREEASYNC (2 * sizeof(LONG_PTR))  // TREEASYNC* of background level reads for each tree control window
+#define GWL_TREEINDEX (3 * sizeof(LONG_PTR))  // libwinfile::TreePathIndex* of nodes by path for each tree control window
 
 // GWL_TYPE numbers
 
@@ -347,6 +359,9 @@ BOOL shouldSkipAccelerator(MSG* pMsg);
 #define TC_SETDIRECTORY 0x949
 #define TC_TOGGLELEVEL 0x950
 #define TC_RECALC_EXTENT 0x951
+#define TC_LEVELREAD 0x952
+#define TC_PROBEVISIBLE 0x953
+#define TC_PROBED 0x954
 
 #define FS_CHANGEDISPLAY (WM_USER + 0x100)
 #define FS_CHANGEDRIVES (WM_USER + 0x101)
@@ -376,6 +391,7 @@ BOOL shouldSkipAccelerator(MSG* pMsg);
 
 #define FS_ENABLEFSC (WM_USER + 0x121)
 #define FS_DISABLEFSC (WM_USER + 0x122)
+#define FS_RESUMECOPIES (WM_USER + 0x123)
 
 #define ATTR_READWRITE 0x0000
 #define ATTR_READONLY FILE_ATTRIBUTE_READONLY                // == 0x0001
@@ -404,8 +420,6 @@ BOOL shouldSkipAccelerator(MSG* pMsg);
      ATTR_ENCRYPTED | ATTR_REPARSE_POINT)
 #define ATTR_HS (ATTR_HIDDEN | ATTR_SYSTEM)
 
-#define ATTR_RETURNED 0x8000 /* used in DTA's by copy */
-
 #define CD_PATH 0x0001
 #define CD_VIEW 0x0002
 #define CD_SORT 0x0003
@@ -638,6 +652,14 @@ Extern WCHAR chFirstDrive;  // 'A' or 'a'
 
 Extern UINT uChangeNotifyTime EQ(3000);
 
+// Files this big or bigger are copied around the system cache, through
+// buffers this big (0 MB copies everything through the cache).
+Extern UINT uUnbufferedCopyMB EQ(256);
+Extern UINT uCopyBufferKB EQ(4096);
+
+// Copied files are read back and checked against their sources.
+Extern BOOL bVerifyCopies EQ(FALSE);
+
 Extern WCHAR szDirsRead[32];
 Extern WCHAR szCurrentFileSpec[14] EQ(L"*.*");
 
@@ -706,7 +728,9 @@ Extern HICON hicoTree EQ(NULL);
 Extern HICON hicoTreeDir EQ(NULL);
 Extern HICON hicoDir EQ(NULL);
 
-Extern HWND hdlgProgress;
+// The progress window of the operation on this thread.  Each copy thread
+// has its own, so that copies in separate windows can run at once.
+Extern thread_local HWND hdlgProgress;
 Extern HWND hwndFrame EQ(NULL);
 Extern HWND hwndMDIClient EQ(NULL);
 Extern HWND hwndSearch EQ(NULL);
@@ -721,6 +745,7 @@ Extern BOOL bCancelTree;
 
 Extern WORD wTextAttribs EQ(0);
 Extern DWORD dwSuperDlgMode;
+Extern BOOL bDeletePermanent EQ(FALSE);  // IDM_DELETE with Shift held
 
 Extern UINT wHelpMessage;
 Extern UINT wBrowseMessage;